@@ -0,0 +1,115 @@
+// Measure the throughput of a parser generated by wpg, to
+// compare the recursive descent backend with the table
+// driven one (the '--backend' option).
+//
+// This file is compiled with the files wpg generated for a
+// grammar from "gen_grammar.sh -p", whose starting rule is
+// "R0", and with the "use_node_arena = yes;" option, so
+// that the parse tree of each iteration is freed at once.
+// Each iteration scans and parses the whole input with a
+// new frontend. The input is a series of sentences of "R0"
+// from gen_sentence.sh, so that the grammar should have no
+// left recursive or empty alternatives (the -L and -n
+// options of gen_grammar.sh): the decisions they make look
+// at the tokens after "R0", which start the next sentence.
+//
+// run_depth_benchmark.sh uses it with its own grammar, and
+// defines START_RULE to its starting rule.
+//
+// usage: backend_benchmark input_file iterations
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "frontend.hpp"
+
+#ifndef START_RULE
+#define START_RULE R0
+#endif
+
+#define PARSE_START_RULE_REAL(rule) parse_##rule
+#define PARSE_START_RULE(rule) PARSE_START_RULE_REAL(rule)
+#define CAN_START_START_RULE_REAL(rule) can_start_##rule
+#define CAN_START_START_RULE(rule) CAN_START_START_RULE_REAL(rule)
+
+int
+main(int argc, char **argv)
+{
+  if (argc != 3)
+  {
+    std::fprintf(stderr, "usage: backend_benchmark input_file iterations\n");
+    return 1;
+  }
+
+  std::string input;
+
+  {
+    std::ifstream file(argv[1], std::ios_base::in | std::ios_base::binary);
+
+    if (!file)
+    {
+      std::fprintf(stderr, "backend_benchmark: can not open %s.\n", argv[1]);
+      return 1;
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    input = ss.str();
+  }
+
+  unsigned int const iterations = std::atoi(argv[2]);
+
+  // The tokens are separated by white spaces.
+  unsigned int token_count = 0;
+
+  {
+    std::istringstream words(input);
+    std::string word;
+
+    while (words >> word)
+    {
+      ++token_count;
+    }
+  }
+
+  if ((0 == iterations) || (0 == token_count))
+  {
+    std::fprintf(stderr, "backend_benchmark: nothing to parse.\n");
+    return 1;
+  }
+
+  std::clock_t const start = std::clock();
+
+  try
+  {
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+      std::istringstream in(input);
+      frontend parser(in);
+
+      while (true == parser.CAN_START_START_RULE(START_RULE)(1))
+      {
+        parser.PARSE_START_RULE(START_RULE)();
+      }
+
+      parser.free_nodes();
+    }
+  }
+  catch (std::exception const &)
+  {
+    std::fprintf(stderr, "backend_benchmark: syntax error.\n");
+    return 1;
+  }
+
+  double const seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+  std::printf("%u,%u,%.3f,%.2f\n", token_count, iterations,
+              seconds * 1000, seconds * 1e9 / (static_cast<double>(token_count) * iterations));
+
+  return 0;
+}
@@ -0,0 +1,274 @@
+#!/bin/bash
+
+# Generate a synthetic grammar for wpg to standard output.
+#
+# The rules are "R0" (the starting rule) .. "R<n-1>". An
+# alternative of "Ri" only refers to the rules after "Ri",
+# and the first alternative of "Ri" refers to "R<i+1>", so
+# that every rule is reachable and the grammar has no cycle
+# and no left recursion except the ones asked for by -L.
+#
+# The left recursive alternative of "Ri" continues with its
+# own terminal "li", and every reference to a left recursive
+# or nullable "Ri" is followed by its own terminal "ei", so
+# that neither of them adds a conflict the lookahead can not
+# resolve. "R0" is neither, so that the sentences from
+# gen_sentence.sh can follow each other.
+#
+# When k > 1, all the alternatives of a rule start with
+# the same k-1 terminals and differ in the k-th one, so
+# that the grammar needs exactly k lookahead terminals.
+#
+# With -p, the terminal "ti" has the pattern "ti", and the
+# white spaces are skipped, so that the sentences from
+# gen_sentence.sh can be parsed by the generated frontend.
+
+usage()
+{
+  cat <<USAGE
+usage: gen_grammar.sh [options]
+  -r <number>   number of rules (default 10)
+  -a <number>   alternatives per rule (default 3)
+  -l <number>   symbols per alternative (default 4)
+  -L <percent>  rules with a left recursive alternative, needs -e 0 (default 0)
+  -n <percent>  rules with an empty alternative, needs -e 0 (default 0)
+  -e <number>   EBNF nesting depth, 0 for pure BNF (default 0)
+  -k <number>   lookahead depth the grammar needs (default 1)
+  -t <number>   number of terminals (default 16)
+  -s <number>   random seed (default 1)
+  -p            give each terminal a token pattern
+USAGE
+}
+
+RULES=10
+ALTERNATIVES=3
+LENGTH=4
+LEFT_RECURSION=0
+NULLABLE=0
+EBNF_DEPTH=0
+K=1
+TERMINALS=16
+SEED=1
+PATTERNS=0
+
+while getopts "r:a:l:L:n:e:k:t:s:ph" opt
+do
+  case $opt in
+    r) RULES=$OPTARG ;;
+    a) ALTERNATIVES=$OPTARG ;;
+    l) LENGTH=$OPTARG ;;
+    L) LEFT_RECURSION=$OPTARG ;;
+    n) NULLABLE=$OPTARG ;;
+    e) EBNF_DEPTH=$OPTARG ;;
+    k) K=$OPTARG ;;
+    t) TERMINALS=$OPTARG ;;
+    s) SEED=$OPTARG ;;
+    p) PATTERNS=1 ;;
+    *) usage; exit 1 ;;
+  esac
+done
+
+# Paull's algorithm, which is the only way wpg can accept a
+# left recursive grammar, only works on pure BNF grammars.
+if [ $LEFT_RECURSION -gt 0 ] && [ $EBNF_DEPTH -gt 0 ]
+then
+  echo "gen_grammar.sh: -L needs a pure BNF grammar (-e 0)." >&2
+  exit 1
+fi
+
+# wpg does not accept "...epsilon..." in an EBNF grammar.
+if [ $NULLABLE -gt 0 ] && [ $EBNF_DEPTH -gt 0 ]
+then
+  echo "gen_grammar.sh: -n needs a pure BNF grammar (-e 0)." >&2
+  exit 1
+fi
+
+# Each alternative of a rule needs its own k-th terminal.
+if [ $TERMINALS -lt $ALTERNATIVES ]
+then
+  echo "gen_grammar.sh: -t must be at least -a." >&2
+  exit 1
+fi
+
+awk -v rules=$RULES \
+    -v alternatives=$ALTERNATIVES \
+    -v alternative_length=$LENGTH \
+    -v left_recursion=$LEFT_RECURSION \
+    -v nullable=$NULLABLE \
+    -v ebnf_depth=$EBNF_DEPTH \
+    -v k=$K \
+    -v terminals=$TERMINALS \
+    -v seed=$SEED \
+    -v patterns=$PATTERNS '
+function terminal(idx)
+{
+  return "\"t" idx "\"";
+}
+
+function rule(idx)
+{
+  return "\"R" idx "\"";
+}
+
+# A reference to the rule "idx", followed by its own
+# terminal if the rule is left recursive or nullable.
+function rule_reference(idx)
+{
+  if (is_left_recursive[idx] || is_nullable[idx])
+  {
+    return rule(idx) " \"e" idx "\"";
+  }
+  return rule(idx);
+}
+
+function print_terminal(name)
+{
+  if (patterns)
+  {
+    print name " [pattern = " name "]";
+  }
+  else
+  {
+    print name;
+  }
+}
+
+# A random symbol for an alternative of the rule "curr":
+# either a terminal or one of the rules after "curr".
+function random_symbol(curr)
+{
+  if ((curr + 1 < rules) && (rand() < 0.3))
+  {
+    return rule_reference(curr + 1 + int(rand() * (rules - curr - 1)));
+  }
+  return terminal(int(rand() * terminals));
+}
+
+# "count" symbols, the innermost "depth" levels of them are
+# wrapped in EBNF groups.
+function sequence(curr, count, depth,    str, i, inner, op)
+{
+  str = "";
+  
+  if ((depth > 0) && (count > 1))
+  {
+    inner = int(count / 2);
+    count -= inner;
+  }
+  else
+  {
+    inner = 0;
+  }
+  
+  for (i = 0; i < count; ++i)
+  {
+    str = str " " random_symbol(curr);
+  }
+  
+  if (inner > 0)
+  {
+    op = substr("*+?", 1 + int(rand() * 3), 1);
+    # sequence() puts a space before each symbol.
+    str = str " (" substr(sequence(curr, inner, depth - 1), 2) ")" op;
+  }
+  
+  return str;
+}
+
+BEGIN {
+  srand(seed);
+  
+  print "{";
+  print "  k = " k ";";
+  if (0 == ebnf_depth)
+  {
+    print "  use_paull_algo = yes;";
+    print "  enable_left_factor = yes;";
+    print "  using_pure_BNF = yes;";
+  }
+  print "}";
+  print "";
+  
+  for (r = 1; r < rules; ++r)
+  {
+    is_left_recursive[r] = (rand() * 100 < left_recursion);
+    is_nullable[r] = (rand() * 100 < nullable);
+  }
+  
+  for (i = 0; i < terminals; ++i)
+  {
+    print_terminal(terminal(i));
+  }
+  for (r = 0; r < rules; ++r)
+  {
+    if (is_left_recursive[r])
+    {
+      print_terminal("\"l" r "\"");
+    }
+    if (is_left_recursive[r] || is_nullable[r])
+    {
+      print_terminal("\"e" r "\"");
+    }
+  }
+  if (patterns)
+  {
+    print "\"blank\" [pattern = \"[\\s]+\"; skip = yes]";
+  }
+  print ";";
+  
+  for (r = 0; r < rules; ++r)
+  {
+    print "";
+    print rule(r);
+    
+    for (a = 0; a < alternatives; ++a)
+    {
+      # The shared prefix of k-1 terminals, then the
+      # terminal choosing this alternative.
+      alt = "";
+      for (i = 0; i < k - 1; ++i)
+      {
+        alt = alt " " terminal(i);
+      }
+      alt = alt " " terminal(a);
+      
+      rest = alternative_length - k;
+      
+      if ((0 == a) && (r + 1 < rules))
+      {
+        --rest;
+      }
+      
+      if (rest > 0)
+      {
+        alt = alt sequence(r, rest, ebnf_depth);
+      }
+      
+      if ((0 == a) && (r + 1 < rules))
+      {
+        alt = alt " " rule_reference(r + 1);
+      }
+      
+      print ((0 == a) ? ":" : "|") alt;
+    }
+    
+    if (is_left_recursive[r])
+    {
+      alt = " \"l" r "\"";
+      
+      if (alternative_length > 2)
+      {
+        alt = alt sequence(r, alternative_length - 2, 0);
+      }
+      
+      print "| " rule(r) alt;
+    }
+    
+    if (is_nullable[r])
+    {
+      print "| \"...epsilon...\"";
+    }
+    
+    print ";";
+  }
+}'
@@ -0,0 +1,195 @@
+#!/bin/bash
+
+# Generate random sentences of a grammar from gen_grammar.sh
+# (read from standard input) to standard output, one token
+# in a line.
+#
+# Each sentence is a random leftmost derivation of "R0", and
+# I generate sentences one after another until the input has
+# the given number of tokens. A rule chooses a random
+# alternative which still fits in the budget, or the
+# shortest one if none fits.
+#
+# ex:
+#
+#   ./gen_grammar.sh -p -r 50 | ./gen_sentence.sh -n 100000 > input.txt
+
+usage()
+{
+  cat <<USAGE
+usage: gen_sentence.sh [-n token budget] [-s seed] < grammar
+  -n <number>   number of tokens (default 100000)
+  -s <number>   random seed (default 1)
+USAGE
+}
+
+BUDGET=100000
+SEED=1
+
+while getopts "n:s:h" opt
+do
+  case $opt in
+    n) BUDGET=$OPTARG ;;
+    s) SEED=$OPTARG ;;
+    *) usage; exit 1 ;;
+  esac
+done
+
+awk -v budget=$BUDGET \
+    -v seed=$SEED '
+# The rule block starts after the ";" ending the terminal
+# name block.
+!in_rules {
+  if ($0 ~ /^;/)
+  {
+    in_rules = 1;
+  }
+  next;
+}
+
+/^"R[0-9]+"$/ {
+  gsub(/"/, "", $0);
+  rule = $0;
+  alternative_count[rule] = 0;
+  next;
+}
+
+/^[:|]/ {
+  line = substr($0, 2);
+  gsub(/"/, "", line);
+
+  alt = alternative_count[rule]++;
+  length_of[rule, alt] = split(line, symbols, " ");
+
+  for (i = 1; i <= length_of[rule, alt]; ++i)
+  {
+    symbol[rule, alt, i] = symbols[i];
+  }
+
+  next;
+}
+
+function is_rule(sym)
+{
+  return (sym in alternative_count);
+}
+
+function symbol_min_length(sym)
+{
+  if (sym == "...epsilon...")
+  {
+    return 0;
+  }
+  else if (is_rule(sym))
+  {
+    return min_length[sym];
+  }
+  return 1;
+}
+
+function alternative_min_length(rule, alt,    i, sum)
+{
+  sum = 0;
+
+  for (i = 1; i <= length_of[rule, alt]; ++i)
+  {
+    sum += symbol_min_length(symbol[rule, alt, i]);
+  }
+
+  return sum;
+}
+
+END {
+  srand(seed);
+
+  # The shortest sentence of each rule, by a fixpoint.
+  INFINITY = 1000000000;
+
+  for (rule in alternative_count)
+  {
+    min_length[rule] = INFINITY;
+  }
+
+  do
+  {
+    changed = 0;
+
+    for (rule in alternative_count)
+    {
+      for (alt = 0; alt < alternative_count[rule]; ++alt)
+      {
+        len = alternative_min_length(rule, alt);
+
+        if (len < min_length[rule])
+        {
+          min_length[rule] = len;
+          changed = 1;
+        }
+      }
+    }
+  } while (changed);
+
+  # The symbols to derive, the top is the last one, and
+  # the sum of their shortest sentences.
+  top = 0;
+  pending = 0;
+  count = 0;
+
+  while ((top > 0) || (count < budget))
+  {
+    if (0 == top)
+    {
+      stack[++top] = "R0";
+      pending = min_length["R0"];
+    }
+
+    sym = stack[top--];
+    pending -= symbol_min_length(sym);
+
+    if (sym == "...epsilon...")
+    {
+      continue;
+    }
+
+    if (!is_rule(sym))
+    {
+      print sym;
+      ++count;
+      continue;
+    }
+
+    # The alternatives which still fit in the budget.
+    candidate_count = 0;
+    shortest = 0;
+
+    for (alt = 0; alt < alternative_count[sym]; ++alt)
+    {
+      len = alternative_min_length(sym, alt);
+
+      if (len < alternative_min_length(sym, shortest))
+      {
+        shortest = alt;
+      }
+
+      if ((count + pending + len) <= budget)
+      {
+        candidate[candidate_count++] = alt;
+      }
+    }
+
+    if (0 == candidate_count)
+    {
+      chosen = shortest;
+    }
+    else
+    {
+      chosen = candidate[int(rand() * candidate_count)];
+    }
+
+    for (i = length_of[sym, chosen]; i >= 1; --i)
+    {
+      stack[++top] = symbol[sym, chosen, i];
+      pending += symbol_min_length(symbol[sym, chosen, i]);
+    }
+  }
+}'
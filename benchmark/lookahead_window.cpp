@@ -0,0 +1,307 @@
+// Measure the cost of peeking and consuming tokens through
+// the lookahead window of a frontend generated by wpg.
+//
+// The generated parser peeks the next 1..k tokens at each
+// decision, and then consumes one. This program replays
+// that access pattern on 2 windows:
+//
+//   deque  The window wpg generated before: a std::deque
+//          of token_t pointers, one new/delete per token.
+//   ring   The window wpg generates now: a ring of
+//          token_t by value, its size is the smallest
+//          power of 2 not less than k.
+//
+// Both scan their tokens from the same input, and the
+// tokens carry a copy of their text like the tokens of
+// the generated DFA scanner did before they became views
+// into the input.
+//
+// usage: lookahead_window k token_count
+
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace
+{
+  class token_t
+  {
+  private:
+
+    int m_type;
+    std::string m_text;
+
+  public:
+
+    token_t()
+      : m_type(0)
+    { }
+
+    token_t(
+      int const type,
+      char const * const begin,
+      char const * const end)
+      : m_type(type),
+        m_text(begin, end)
+    { }
+
+    void assign(
+      int const type,
+      char const * const begin,
+      char const * const end)
+    {
+      m_type = type;
+      m_text.assign(begin, end);
+    }
+
+    int get_type() const
+    { return m_type; }
+  };
+
+  /// The input of both windows: the tokens are the words
+  /// of 'm_text', and the type of a token is its length.
+  class input_t
+  {
+  private:
+
+    std::string m_text;
+    char const *mp_curr;
+
+  public:
+
+    explicit input_t(
+      unsigned int const token_count)
+    {
+      char const * const words[] =
+      {
+        "let", "x", "=", "12", "+", "foo", "*", "(", "bar_baz", ")", ";"
+      };
+
+      std::srand(1);
+
+      for (unsigned int i = 0; i < token_count; ++i)
+      {
+        m_text += words[std::rand() % (sizeof(words) / sizeof(words[0]))];
+        m_text += ' ';
+      }
+
+      mp_curr = m_text.data();
+    }
+
+    void rewind()
+    { mp_curr = m_text.data(); }
+
+    void next(
+      char const *&begin,
+      char const *&end)
+    {
+      begin = mp_curr;
+
+      while (*mp_curr != ' ')
+      {
+        ++mp_curr;
+      }
+
+      end = mp_curr;
+
+      ++mp_curr;
+    }
+  };
+
+  class deque_window_t
+  {
+  private:
+
+    input_t &m_input;
+    std::deque<token_t *> m_lookahead_queue;
+
+  public:
+
+    explicit deque_window_t(
+      input_t &input)
+      : m_input(input)
+    { }
+
+    token_t *peek(
+      std::deque<token_t *>::size_type const lookahead_count)
+    {
+      while (m_lookahead_queue.size() < lookahead_count)
+      {
+        char const *begin;
+        char const *end;
+
+        m_input.next(begin, end);
+
+        m_lookahead_queue.push_back(
+          new token_t(static_cast<int>(end - begin), begin, end));
+      }
+
+      return m_lookahead_queue[lookahead_count - 1];
+    }
+
+    void consume()
+    {
+      token_t * const token = peek(1);
+
+      m_lookahead_queue.pop_front();
+      delete token;
+    }
+  };
+
+  template<unsigned int size>
+  class ring_window_t
+  {
+  private:
+
+    enum
+    {
+      LOOKAHEAD_WINDOW_MASK = size - 1
+    };
+
+    input_t &m_input;
+    token_t m_lookahead_window[size];
+    unsigned int m_lookahead_first;
+    unsigned int m_lookahead_count;
+
+  public:
+
+    explicit ring_window_t(
+      input_t &input)
+      : m_input(input),
+        m_lookahead_first(0),
+        m_lookahead_count(0)
+    { }
+
+    token_t *peek(
+      unsigned int const lookahead_count)
+    {
+      assert(lookahead_count <= size);
+
+      while (m_lookahead_count < lookahead_count)
+      {
+        char const *begin;
+        char const *end;
+
+        m_input.next(begin, end);
+
+        m_lookahead_window[(m_lookahead_first + m_lookahead_count) & LOOKAHEAD_WINDOW_MASK].assign(
+          static_cast<int>(end - begin), begin, end);
+
+        ++m_lookahead_count;
+      }
+
+      return &m_lookahead_window[(m_lookahead_first + lookahead_count - 1) & LOOKAHEAD_WINDOW_MASK];
+    }
+
+    void consume()
+    {
+      peek(1);
+
+      m_lookahead_first = (m_lookahead_first + 1) & LOOKAHEAD_WINDOW_MASK;
+      --m_lookahead_count;
+    }
+  };
+
+  /// Peek 1..k tokens and consume one, for every token of
+  /// the input except the last k - 1 ones, and return the
+  /// CPU time in seconds.
+  template<typename window_type>
+  double
+  run(
+    input_t &input,
+    unsigned int const k,
+    unsigned int const token_count,
+    unsigned int &checksum)
+  {
+    input.rewind();
+
+    window_type window(input);
+
+    std::clock_t const start = std::clock();
+
+    for (unsigned int i = 0; i + k <= token_count; ++i)
+    {
+      for (unsigned int depth = 1; depth <= k; ++depth)
+      {
+        checksum += window.peek(depth)->get_type();
+      }
+
+      window.consume();
+    }
+
+    return static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+  }
+
+  template<unsigned int size>
+  double
+  run_ring(
+    input_t &input,
+    unsigned int const k,
+    unsigned int const token_count,
+    unsigned int &checksum)
+  {
+    return run<ring_window_t<size> >(input, k, token_count, checksum);
+  }
+}
+
+int
+main(int argc, char **argv)
+{
+  if (argc != 3)
+  {
+    std::fprintf(stderr, "usage: lookahead_window k token_count\n");
+    return 1;
+  }
+
+  unsigned int const k = std::atoi(argv[1]);
+  unsigned int const token_count = std::atoi(argv[2]);
+
+  if ((0 == k) || (k > 8) || (token_count < k))
+  {
+    std::fprintf(stderr, "lookahead_window: k should be 1..8, and token_count not less than k.\n");
+    return 1;
+  }
+
+  input_t input(token_count);
+
+  unsigned int deque_checksum = 0;
+  unsigned int ring_checksum = 0;
+
+  double const deque_seconds = run<deque_window_t>(input, k, token_count, deque_checksum);
+  double ring_seconds;
+
+  if (1 == k)
+  {
+    ring_seconds = run_ring<1>(input, k, token_count, ring_checksum);
+  }
+  else if (2 == k)
+  {
+    ring_seconds = run_ring<2>(input, k, token_count, ring_checksum);
+  }
+  else if (k <= 4)
+  {
+    ring_seconds = run_ring<4>(input, k, token_count, ring_checksum);
+  }
+  else
+  {
+    ring_seconds = run_ring<8>(input, k, token_count, ring_checksum);
+  }
+
+  // Both windows should see the same tokens.
+  if (deque_checksum != ring_checksum)
+  {
+    std::fprintf(stderr, "lookahead_window: the windows disagree.\n");
+    return 1;
+  }
+
+  std::printf("%u,%u,deque,%.3f,%.2f\n", k, token_count,
+              deque_seconds * 1000, deque_seconds * 1e9 / token_count);
+  std::printf("%u,%u,ring,%.3f,%.2f\n", k, token_count,
+              ring_seconds * 1000, ring_seconds * 1e9 / token_count);
+
+  return 0;
+}
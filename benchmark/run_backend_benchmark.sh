@@ -0,0 +1,128 @@
+#!/bin/bash
+
+# Generate the parser of a synthetic grammar with both
+# backends of wpg (--backend=recursive_descent and
+# --backend=table), build each one with backend_benchmark.cpp,
+# and record the compile time, the binary size, and the
+# parsing throughput on the same random sentence into a CSV
+# file.
+#
+# The grammar size grows by the number of rules; the other
+# options are passed to gen_grammar.sh as they are.
+#
+# ex:
+#
+#   WPG=../release/wpg.exe CXX=g++ ./run_backend_benchmark.sh -R "20 50 100" -n 200000 -- -a 4 -k 2
+
+usage()
+{
+  cat <<USAGE
+usage: run_backend_benchmark.sh [-R "rule counts"] [-n token count] [-i iterations] [-o result file] [-- gen_grammar.sh options]
+  -R <list>     rule counts to run (default "10 20 50 100")
+  -n <number>   tokens in the input sentence (default 100000)
+  -i <number>   times to parse the sentence (default 10)
+  -o <file>     where the results go (default backend_results.csv)
+  WPG           environment variable, the wpg executable
+                (default ../release/wpg.exe)
+  CXX           environment variable, the C++ compiler
+                (default g++)
+USAGE
+}
+
+BENCHMARK_DIR=$(cd $(dirname $0) && pwd)
+WPG=${WPG:-$BENCHMARK_DIR/../release/wpg.exe}
+CXX=${CXX:-g++}
+RULE_COUNTS="10 20 50 100"
+TOKEN_COUNT=100000
+ITERATIONS=10
+RESULT=backend_results.csv
+
+while getopts "R:n:i:o:h" opt
+do
+  case $opt in
+    R) RULE_COUNTS=$OPTARG ;;
+    n) TOKEN_COUNT=$OPTARG ;;
+    i) ITERATIONS=$OPTARG ;;
+    o) RESULT=$OPTARG ;;
+    *) usage; exit 1 ;;
+  esac
+done
+shift $((OPTIND - 1))
+
+if [ ! -x "$WPG" ]
+then
+  echo "run_backend_benchmark.sh: can not find wpg at $WPG, set WPG." >&2
+  exit 1
+fi
+
+case $RESULT in
+  /*) ;;
+  *) RESULT=$(pwd)/$RESULT ;;
+esac
+
+echo "rules,options,backend,compile_s,binary_bytes,tokens,iterations,cpu_ms,ns_per_token" > $RESULT
+
+for rules in $RULE_COUNTS
+do
+  work_dir=$BENCHMARK_DIR/work/backend_r$rules
+  rm -rf $work_dir
+  mkdir -p $work_dir
+
+  # The parse trees are freed by the node arena.
+  $BENCHMARK_DIR/gen_grammar.sh -p -r $rules "$@" |
+    sed 's/^{$/{\n  use_node_arena = yes;/' > $work_dir/grammar.gra || exit 1
+  $BENCHMARK_DIR/gen_sentence.sh -n $TOKEN_COUNT < $work_dir/grammar.gra > $work_dir/input.txt || exit 1
+
+  for backend in recursive_descent table
+  do
+    backend_dir=$work_dir/$backend
+    mkdir -p $backend_dir
+
+    echo -n "$rules rules, $backend ... "
+
+    # wpg writes the generated parser into the current
+    # directory, and its main.cpp is an empty main().
+    (cd $backend_dir && "$WPG" --backend=$backend ../grammar.gra > wpg.log 2>&1)
+    status=$?
+
+    if [ $status != 0 ]
+    then
+      echo "wpg failed ($status), see $backend_dir/wpg.log"
+      echo "$rules,\"$*\",$backend,,,,,," >> $RESULT
+      continue
+    fi
+
+    rm -f $backend_dir/main.cpp
+
+    start=$(date +%s.%N)
+    $CXX -O2 -DNDEBUG -I$backend_dir -o $backend_dir/backend_benchmark \
+      $BENCHMARK_DIR/backend_benchmark.cpp $backend_dir/*.cpp > $backend_dir/build.log 2>&1
+    status=$?
+    end=$(date +%s.%N)
+
+    if [ $status != 0 ]
+    then
+      echo "build failed ($status), see $backend_dir/build.log"
+      echo "$rules,\"$*\",$backend,,,,,," >> $RESULT
+      continue
+    fi
+
+    compile_s=$(echo "$start $end" | awk '{ printf("%.2f", $2 - $1) }')
+    binary_bytes=$(wc -c < $backend_dir/backend_benchmark)
+
+    line=$($backend_dir/backend_benchmark $work_dir/input.txt $ITERATIONS)
+
+    if [ $? != 0 ]
+    then
+      echo "parsing failed"
+      echo "$rules,\"$*\",$backend,$compile_s,$binary_bytes,,,," >> $RESULT
+      continue
+    fi
+
+    echo "$rules,\"$*\",$backend,$compile_s,$binary_bytes,$line" >> $RESULT
+    echo "$line" | awk -F, -v compile_s=$compile_s -v binary_bytes=$binary_bytes '
+      { printf("compile %s s, binary %d KB, %s ns/token\n", compile_s, binary_bytes / 1024, $4); }'
+  done
+done
+
+echo "results are in $RESULT"
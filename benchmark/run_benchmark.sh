@@ -0,0 +1,107 @@
+#!/bin/bash
+
+# Run wpg on synthetic grammars of growing size, and record
+# the cost of each phase (from the --time-report-json
+# option of wpg) into a CSV file, so that the time and
+# memory curves of each phase can be plotted against the
+# grammar size.
+#
+# The grammar size grows by the number of rules; the other
+# options are passed to gen_grammar.sh as they are.
+#
+# ex:
+#
+#   WPG=../release/wpg.exe ./run_benchmark.sh -R "50 100 200 400" -- -a 4 -k 2 -n 20
+
+usage()
+{
+  cat <<USAGE
+usage: run_benchmark.sh [-R "rule counts"] [-o result file] [-- gen_grammar.sh options]
+  -R <list>     rule counts to run (default "10 20 40 80 160 320")
+  -o <file>     where the results go (default results.csv)
+  WPG           environment variable, the wpg executable
+                (default ../release/wpg.exe)
+USAGE
+}
+
+BENCHMARK_DIR=$(cd $(dirname $0) && pwd)
+WPG=${WPG:-$BENCHMARK_DIR/../release/wpg.exe}
+RULE_COUNTS="10 20 40 80 160 320"
+RESULT=results.csv
+
+while getopts "R:o:h" opt
+do
+  case $opt in
+    R) RULE_COUNTS=$OPTARG ;;
+    o) RESULT=$OPTARG ;;
+    *) usage; exit 1 ;;
+  esac
+done
+shift $((OPTIND - 1))
+
+if [ ! -x "$WPG" ]
+then
+  echo "run_benchmark.sh: can not find wpg at $WPG, set WPG." >&2
+  exit 1
+fi
+
+case $RESULT in
+  /*) ;;
+  *) RESULT=$(pwd)/$RESULT ;;
+esac
+
+echo "rules,options,status,phase,wall_ms,cpu_ms,peak_rss_delta_bytes,peak_rss_bytes,nodes,alternatives" > $RESULT
+
+for rules in $RULE_COUNTS
+do
+  work_dir=$BENCHMARK_DIR/work/r$rules
+  rm -rf $work_dir
+  mkdir -p $work_dir
+  
+  $BENCHMARK_DIR/gen_grammar.sh -r $rules "$@" > $work_dir/grammar.gra || exit 1
+  
+  echo -n "$rules rules ... "
+  
+  # wpg writes the generated parser into the current
+  # directory.
+  (cd $work_dir && "$WPG" --time-report-json time.json grammar.gra > wpg.log 2>&1)
+  status=$?
+  
+  if [ ! -f $work_dir/time.json ]
+  then
+    echo "failed ($status), see $work_dir/wpg.log"
+    echo "$rules,\"$*\",$status,,,,,,," >> $RESULT
+    continue
+  fi
+  
+  # One phase per line in time.json:
+  #
+  #   {"name": "read_grammar", "wall_ms": 1.5, ...},
+  awk -v rules=$rules -v options="$*" -v status=$status '
+    /"name"/ {
+      line = $0;
+      gsub(/[{}" ]/, "", line);
+      sub(/,$/, "", line);
+      
+      n = split(line, fields, ",");
+      for (i = 1; i <= n; ++i)
+      {
+        split(fields[i], pair, ":");
+        value[pair[1]] = pair[2];
+      }
+      
+      printf("%s,\"%s\",%s,%s,%s,%s,%s,%s,%s,%s\n",
+             rules, options, status,
+             value["name"], value["wall_ms"], value["cpu_ms"],
+             value["peak_rss_delta_bytes"], value["peak_rss_bytes"],
+             value["nodes"], value["alternatives"]);
+      
+      total_wall_ms += value["wall_ms"];
+      peak_rss_bytes = value["peak_rss_bytes"];
+    }
+    END {
+      printf("%.3f ms, peak RSS %d KB\n", total_wall_ms, peak_rss_bytes / 1024) > "/dev/stderr";
+    }' $work_dir/time.json >> $RESULT
+done
+
+echo "results are in $RESULT"
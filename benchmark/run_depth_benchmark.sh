@@ -0,0 +1,188 @@
+#!/bin/bash
+
+# Parse deeply nested and very long inputs with the parsers
+# both backends of wpg generate for the same small grammar,
+# and record into a CSV file whether each one survives and
+# how fast it goes.
+#
+# The recursive descent parser calls itself once for each
+# level of parentheses, and once for each statement because
+# the left recursion of "program" becomes the right recursive
+# "program_apostrophe" rule, so that it overflows the thread
+# stack at some depth. The table driven parser keeps the
+# rules it is parsing on a std::vector, and goes as deep as
+# the memory allows. The table backend only takes pure BNF,
+# so that the grammar here is pure BNF; the parser of an
+# EBNF grammar is always recursive descent.
+#
+# ex:
+#
+#   WPG=../release/wpg.exe CXX=g++ ./run_depth_benchmark.sh -D "1000 100000 1000000" -L "1000 1000000"
+
+usage()
+{
+  cat <<USAGE
+usage: run_depth_benchmark.sh [-D "depths"] [-L "lengths"] [-i iterations] [-o result file]
+  -D <list>     levels of nested parentheses (default "1000 10000 100000 1000000")
+  -L <list>     numbers of statements in a list (default "1000 1000000")
+  -i <number>   times to parse each input (default 3)
+  -o <file>     where the results go (default depth_results.csv)
+  WPG           environment variable, the wpg executable
+                (default ../release/wpg.exe)
+  CXX           environment variable, the C++ compiler
+                (default g++)
+USAGE
+}
+
+BENCHMARK_DIR=$(cd $(dirname $0) && pwd)
+WPG=${WPG:-$BENCHMARK_DIR/../release/wpg.exe}
+CXX=${CXX:-g++}
+DEPTHS="1000 10000 100000 1000000"
+LENGTHS="1000 1000000"
+ITERATIONS=3
+RESULT=depth_results.csv
+
+while getopts "D:L:i:o:h" opt
+do
+  case $opt in
+    D) DEPTHS=$OPTARG ;;
+    L) LENGTHS=$OPTARG ;;
+    i) ITERATIONS=$OPTARG ;;
+    o) RESULT=$OPTARG ;;
+    *) usage; exit 1 ;;
+  esac
+done
+
+if [ ! -x "$WPG" ]
+then
+  echo "run_depth_benchmark.sh: can not find wpg at $WPG, set WPG." >&2
+  exit 1
+fi
+
+case $RESULT in
+  /*) ;;
+  *) RESULT=$(pwd)/$RESULT ;;
+esac
+
+work_dir=$BENCHMARK_DIR/work/depth
+rm -rf $work_dir
+mkdir -p $work_dir
+
+cat > $work_dir/grammar.gra <<'GRAMMAR'
+{
+  k = 1;
+  using_pure_BNF = yes;
+  use_paull_algo = yes;
+  enable_left_factor = yes;
+  use_node_arena = yes;
+}
+
+"number" [pattern = "[0-9]+"]
+"plus" [pattern = "\+"]
+"lparen" [pattern = "\("]
+"rparen" [pattern = "\)"]
+"semi" [pattern = ";"]
+"blank" [pattern = "[\s]+"; skip = yes]
+;
+
+"program"
+: "program" "stmt"
+| "stmt"
+;
+
+"stmt"
+: "expr" "semi"
+;
+
+"expr"
+: "expr" "plus" "term"
+| "term"
+;
+
+"term"
+: "lparen" "expr" "rparen"
+| "number"
+;
+GRAMMAR
+
+for backend in recursive_descent table
+do
+  backend_dir=$work_dir/$backend
+  mkdir -p $backend_dir
+
+  (cd $backend_dir && "$WPG" --backend=$backend ../grammar.gra > wpg.log 2>&1)
+
+  if [ $? != 0 ]
+  then
+    echo "wpg failed, see $backend_dir/wpg.log"
+    exit 1
+  fi
+
+  rm -f $backend_dir/main.cpp
+
+  $CXX -O2 -DNDEBUG -DSTART_RULE=program -I$backend_dir -o $backend_dir/backend_benchmark \
+    $BENCHMARK_DIR/backend_benchmark.cpp $backend_dir/*.cpp > $backend_dir/build.log 2>&1
+
+  if [ $? != 0 ]
+  then
+    echo "build failed, see $backend_dir/build.log"
+    exit 1
+  fi
+done
+
+echo "input,size,backend,result,tokens,iterations,cpu_ms,ns_per_token" > $RESULT
+
+# Write an input of 'depth' nested parentheses around a
+# number, followed by 'length' statements.
+gen_input()
+{
+  awk -v depth=$1 -v length_=$2 'BEGIN {
+    for (i = 0; i < depth; ++i) printf("( ");
+    printf("1 ");
+    for (i = 0; i < depth; ++i) printf(") ");
+    printf(";\n");
+    for (i = 0; i < length_; ++i) printf("1 ;\n");
+  }'
+}
+
+run_input()
+{
+  local kind=$1
+  local size=$2
+
+  for backend in recursive_descent table
+  do
+    echo -n "$kind $size, $backend ... "
+
+    line=$($work_dir/$backend/backend_benchmark $work_dir/input.txt $ITERATIONS 2> /dev/null)
+    status=$?
+
+    if [ $status -gt 128 ]
+    then
+      # Most likely a stack overflow.
+      echo "crashed (signal $((status - 128)))"
+      echo "$kind,$size,$backend,crashed,,,," >> $RESULT
+    elif [ $status != 0 ]
+    then
+      echo "failed"
+      echo "$kind,$size,$backend,failed,,,," >> $RESULT
+    else
+      echo "$line" | awk -F, '{ printf("%s ns/token\n", $4); }'
+      echo "$kind,$size,$backend,ok,$line" >> $RESULT
+    fi
+  done
+}
+
+for depth in $DEPTHS
+do
+  gen_input $depth 0 > $work_dir/input.txt
+  run_input depth $depth
+done
+
+for length in $LENGTHS
+do
+  gen_input 0 $length > $work_dir/input.txt
+  run_input length $length
+done
+
+echo "results are in $RESULT"
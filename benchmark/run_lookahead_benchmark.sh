@@ -0,0 +1,53 @@
+#!/bin/bash
+
+# Build lookahead_window.cpp, and measure the cost of
+# peeking and consuming tokens through the lookahead window
+# of the generated frontend for several k, comparing the
+# old std::deque window with the ring wpg generates now.
+#
+# ex:
+#
+#   CXX=g++ ./run_lookahead_benchmark.sh -K "1 2 3 4" -n 10000000
+
+usage()
+{
+  cat <<USAGE
+usage: run_lookahead_benchmark.sh [-K "k values"] [-n token count] [-o result file]
+  -K <list>     lookahead depths to run (default "1 2 3 4 8")
+  -n <number>   number of tokens to go through (default 5000000)
+  -o <file>     where the results go (default lookahead_results.csv)
+  CXX           environment variable, the C++ compiler
+                (default g++)
+USAGE
+}
+
+BENCHMARK_DIR=$(cd $(dirname $0) && pwd)
+CXX=${CXX:-g++}
+K_VALUES="1 2 3 4 8"
+TOKEN_COUNT=5000000
+RESULT=lookahead_results.csv
+
+while getopts "K:n:o:h" opt
+do
+  case $opt in
+    K) K_VALUES=$OPTARG ;;
+    n) TOKEN_COUNT=$OPTARG ;;
+    o) RESULT=$OPTARG ;;
+    *) usage; exit 1 ;;
+  esac
+done
+
+mkdir -p $BENCHMARK_DIR/work
+
+PROGRAM=$BENCHMARK_DIR/work/lookahead_window
+
+$CXX -O2 -DNDEBUG -o $PROGRAM $BENCHMARK_DIR/lookahead_window.cpp || exit 1
+
+echo "k,tokens,window,cpu_ms,ns_per_token" > $RESULT
+
+for k in $K_VALUES
+do
+  $PROGRAM $k $TOKEN_COUNT | tee -a $RESULT || exit 1
+done
+
+echo "results are in $RESULT"
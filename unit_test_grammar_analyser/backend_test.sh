@@ -0,0 +1,81 @@
+#!/bin/bash
+
+# Build the parsers of both backends of wpg for the same
+# BNF grammars with "--benchmark", and parse the same random
+# token streams with each of them. Both have to accept every
+# stream to its end, ex: the recursive descent parser and the
+# table driver both have to go on parsing an alternative
+# which shares its first tokens with another one.
+#
+# The grammars are the unit_test_should_pass_N ones which
+# are not ambiguous and have finite token streams; the
+# others can not be parsed to the end by either backend.
+#
+# ex:
+#
+#   WPG=../release/wpg.exe CXX=g++ ./backend_test.sh
+
+TEST_DIR=$(cd $(dirname $0) && pwd)
+WPG=${WPG:-$TEST_DIR/../release/wpg.exe}
+CXX=${CXX:-g++}
+GRAMMARS="2 3 4 5 6 7 8 15 16 21 22 24 26 28 29 30 31 36 37 43 46 48 49 50 51"
+STREAMS=20
+TOKENS=100
+
+if [ ! -x "$WPG" ]
+then
+  echo "backend_test.sh: can not find wpg at $WPG, set WPG." >&2
+  exit 1
+fi
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+# Print the "streams:" and "tokens:" lines of the benchmark
+# of a grammar with a backend, or nothing if it can not be
+# built.
+run_backend()
+{
+  local grammar=$1
+  local backend=$2
+  local dir=$WORK_DIR/$backend
+
+  rm -rf "$dir"
+  mkdir "$dir"
+  cp "$grammar" "$dir/grammar.gra"
+
+  (
+    cd "$dir" &&
+    "$WPG" --benchmark --backend=$backend grammar.gra >/dev/null 2>&1 &&
+    $CXX -I. -o benchmark benchmark.cpp frontend.cpp $(ls parser_node*.cpp parser_tables.cpp 2>/dev/null) >/dev/null 2>&1 &&
+    ./benchmark -n $STREAMS -t $TOKENS -r 1 -s 1 | grep -E "^(streams|tokens):"
+  )
+}
+
+FAILED=0
+
+for i in $GRAMMARS
+do
+  echo -n "unit_test_should_pass_$i ... "
+
+  RD=$(run_backend "$TEST_DIR/unit_test_should_pass_$i/grammar.gra" recursive_descent)
+  TABLE=$(run_backend "$TEST_DIR/unit_test_should_pass_$i/grammar.gra" table)
+
+  if [ -z "$RD" ] || [ -z "$TABLE" ]
+  then
+    echo "Can not build"
+    FAILED=1
+  elif ! echo "$RD" | grep -q "^streams: $STREAMS parsed, 0 rejected, 0 unfinished$"
+  then
+    echo "Failed (recursive_descent: $(echo "$RD" | head -1))"
+    FAILED=1
+  elif [ "$RD" != "$TABLE" ]
+  then
+    echo "Failed (table: $(echo "$TABLE" | head -1))"
+    FAILED=1
+  else
+    echo "Pass"
+  fi
+done
+
+exit $FAILED
@@ -1,7 +1,7 @@
 #!/bin/sh
 
-SHOULD_PASS_COUNT=45
-SHOULD_FAIL_COUNT=4
+SHOULD_PASS_COUNT=51
+SHOULD_FAIL_COUNT=10
 
 for (( i = 1 ; i <= $SHOULD_PASS_COUNT; i++ ))
 do
@@ -23,7 +23,7 @@
 #include "global.hpp"
 #include "lookahead.hpp"
 #include "hash.hpp"
-#include "stack_elem_for_left_recursion_detection.hpp"
+#include "scanner.hpp"
 
 class node_t;
 enum parse_answer_state_t;
@@ -42,6 +42,15 @@ private:
   
 public:
   
+  /// How the generated parser decides and parses (the
+  /// '--backend' option).
+  enum backend_t
+  {
+    BACKEND_RECURSIVE_DESCENT,
+    BACKEND_TABLE
+  };
+  typedef enum backend_t backend_t;
+  
   analyser_environment_t();
   ~analyser_environment_t();
   
@@ -51,14 +60,28 @@ public:
   std::list<node_t *> const &top_level_nodes() const
   { return m_top_level_nodes; }
   
+  node_t const *starting_rule_node() const;
+  
   node_t *last_rule_end_node();
   
   node_t *last_rule_node();
   
+  node_t *create_node(
+    node_t * const rule_node,
+    std::wstring const &str = std::wstring());
+  
+  node_t *create_node_copy(
+    node_t const * const node);
+  
   bool parse_command_line(
     int argc,
     char **argv);
   
+  bool read_profile(
+    char const * const filename);
+  
+  void log_profile_matches() const;
+  
   void read_grammar(
     std::list<keyword_t> const &keywords);
   
@@ -86,9 +109,6 @@ public:
                                void *param),
     void * const param) const;
   
-  void merge_relative_set_into_final_set(
-    std::list<std::list<node_t *> > &set);
-  
   void dump_grammar(
     std::wstring const &filename) const;
   
@@ -99,6 +119,17 @@ public:
   bool check_grammar_not_all_right_recursion();
   
   void compute_lookahead_set();
+  
+  void compute_lookahead_set_for_one_rule(
+    node_t * const rule_node);
+  
+  void compute_lookahead_set_worker(
+    std::vector<node_t *> const &rules,
+    std::vector<std::wstring> &logs,
+    size_t &next_rule,
+    size_t &first_failed_rule,
+    std::pair<size_t, unsigned int> &first_k_cache_count,
+    boost::mutex &mutex);
 
   void left_factoring();
 
@@ -120,6 +151,8 @@ public:
     size_t const depth) const;
   
   void log(wchar_t const * const fmt, ...) const;
+  
+  void log_node_pool_statistics() const;
 
   void remove_duplicated_alternatives_for_all_rule();
 
@@ -151,6 +184,12 @@ public:
   void dump_gen_parser_nodes_hpp(
     std::wfstream &file);
 
+  void dump_gen_node_arena(
+    std::wfstream &file) const;
+  
+  void dump_gen_node_arena_operators(
+    std::wfstream &file) const;
+  
   void dump_gen_parser_basic_types_hpp(
     std::wfstream &file) const;
 
@@ -165,9 +204,33 @@ public:
   void dump_gen_token_hpp(
     std::wfstream &file) const;
   
+  void dump_gen_mapped_file_hpp(
+    std::wfstream &file) const;
+  
   void dump_gen_main_cpp(
     std::wfstream &file) const;
   
+  void dump_gen_scanner_tables(
+    std::wfstream &file) const;
+  
+  void dump_gen_scanner_functions(
+    std::wfstream &file) const;
+  
+  void dump_gen_can_start_functions(
+    std::wfstream &file) const;
+  
+  void dump_gen_stats_functions(
+    std::wfstream &file) const;
+  
+  void dump_gen_parser_tables_cpp(
+    std::wfstream &file) const;
+  
+  void dump_gen_incremental_functions(
+    std::wfstream &file) const;
+  
+  void dump_gen_benchmark_cpp(
+    std::wfstream &file) const;
+  
   bool is_terminal(
     std::wstring const &str) const;
 
@@ -189,6 +252,12 @@ public:
   node_t *find_answer(
     node_t * const node) const;
   
+  symbol_id_t intern_symbol(
+    std::wstring const &str);
+  
+  symbol_id_t symbol_count() const
+  { return static_cast<symbol_id_t>(m_symbol_hash_table.size()); }
+  
   std::wstring const &grammar_file_name() const
   { return m_grammar_file_name; }
   
@@ -199,6 +268,21 @@ public:
   lexer_get_grammar_string(
     std::list<wchar_t> const &delimiter);
   
+  boost::shared_ptr<std::wstring>
+  lexer_get_token_pattern_string();
+  
+  void build_scanner();
+  
+  /// The terminals in the order they are declared, with
+  /// their patterns if any.
+  std::list<token_pattern_t> const &token_patterns() const
+  { return m_token_patterns; }
+  
+  /// 0 if no terminal has a pattern, then the user writes
+  /// the scanner.
+  scanner_dfa_t const *scanner_dfa() const
+  { return mp_scanner_dfa.get(); }
+  
   void restore_regex_info() const;
 
   void fill_regex_info_to_relative_nodes_for_each_regex_group() const;
@@ -219,6 +303,77 @@ public:
   bool using_pure_BNF() const
   { return m_using_pure_BNF; }
   
+  bool use_node_arena() const
+  { return m_use_node_arena; }
+  
+  unsigned int job_count() const
+  { return m_job_count; }
+  
+  backend_t backend() const
+  { return m_backend; }
+  
+  bool push_parser() const
+  { return m_push_parser; }
+  
+  bool incremental() const
+  { return m_incremental; }
+  
+  bool stats() const
+  { return m_stats; }
+  
+  bool benchmark() const
+  { return m_benchmark; }
+  
+  bool profile() const
+  { return m_profile; }
+  
+  /// The count of a decision case, named like the ones
+  /// of add_stats_case(), in the profile of the
+  /// '--profile' option, 0 if the profile does not have
+  /// it.
+  unsigned long profile_case_count(
+    std::wstring const &description) const
+  {
+    std::map<std::wstring, unsigned long>::const_iterator const iter =
+      m_profile_cases.find(description);
+    
+    if (iter == m_profile_cases.end())
+    {
+      return 0;
+    }
+    
+    m_matched_profile_cases.insert(description);
+    
+    return iter->second;
+  }
+  
+  /// The number of the token types of the generated
+  /// parser, the terminals and EOF.
+  size_t token_type_count() const
+  { return m_terminal_hash_table.size() + 1; }
+  
+  /// The value of the wds_token_type enumerator of a
+  /// terminal, 0 (EOF) for an empty name.
+  size_t token_type_value(
+    std::wstring const &name) const;
+  
+  /// Register a case of a decision in the generated
+  /// parser for the '--stats' option, and return the
+  /// index of its counter.
+  unsigned int add_stats_case(
+    std::wstring const &description) const
+  {
+    m_stats_cases.push_back(description);
+    
+    return static_cast<unsigned int>(m_stats_cases.size() - 1);
+  }
+  
+  bool time_report() const
+  { return m_time_report; }
+  
+  std::wstring const &time_report_json_filename() const
+  { return m_time_report_json_filename; }
+  
   bool detect_left_recursion(
     std::list<std::list<node_t *> > &left_recursion_set);
   
@@ -248,20 +403,7 @@ private:
     node_t * const rule_node,
     std::wstring const &str);
   
-  void mark_number_for_all_nodes() const;
-  
-  /// 
-  /// detect nullable
-  ///
-  /// @param node 
-  ///
-  /// @return 
-  ///
-  bool detect_nullable_nonterminal_for_one_alternative(
-    node_t * const node) const;
-  
-  bool detect_nullable_nonterminal_for_one_rule(
-    node_t * const node) const;
+  unsigned int mark_number_for_all_nodes() const;
   
   /// 
   /// handle optional & nullable nodes
@@ -291,11 +433,6 @@ private:
     node_t * const rule_node,
     bool const after_link_nonterminal);
   
-  void detect_cyclic_nonterminal_for_one_rule(
-    node_t * const node,
-    std::list<node_t *> &stack,
-    std::list<std::list<node_t *> > &cyclic_set);
-  
   void replace_first_smaller_index_nonterminal(
     node_t * const rule_node,
     node_t * const target_rule_node);
@@ -331,9 +468,42 @@ private:
     std::list<last_symbol_t> &last_symbol_stack,
     unsigned int const curr_last_symbol_level) const;
   
+  first_k_cache_t &first_k_cache() const
+  {
+    first_k_cache_t * const cache = m_thread_first_k_cache.get();
+    
+    return (0 == cache) ? m_first_k_cache : *cache;
+  }
+  
+  lookahead_set_t const *first_k_fragments(
+    node_t * const rule_node,
+    size_t const depth) const;
+  
+  bool collect_first_k_fragments(
+    node_t * const node,
+    lookahead_set_t * const fragments,
+    size_t const depth) const;
+  
+  bool splice_first_k_fragments(
+    node_t * const node,
+    lookahead_set_t const * const rule_fragments,
+    lookahead_set_t * const fragments,
+    size_t const depth) const;
+  
+  void append_first_k_fragments(
+    node_t * const node,
+    lookahead_set_t const * const fragments,
+    lookahead_set_t * const lookahead_set,
+    unsigned int * const prev_level_walk_count,
+    size_t const cur_level,
+    size_t const max_level,
+    std::list<recur_lookahead_t> &recur_parent_stack,
+    std::list<last_symbol_t> &last_symbol_stack,
+    unsigned int const curr_last_symbol_level) const;
+  
   LOOKAHEAD_COMPARE_RESULT compare_lookahead_set(
-    std::list<lookahead_set_t> const &lookahead_a,
-    std::list<lookahead_set_t> const &lookahead_b) const;
+    lookahead_level_t const &lookahead_a,
+    lookahead_level_t const &lookahead_b) const;
   
   LOOKAHEAD_COMPARE_RESULT compare_lookahead_set_for_node(
     node_t const * const node_a,
@@ -373,16 +543,73 @@ private:
     node_t * const alternative_start_node,
     std::list<node_t *> &nodes_in_regex);
   
-  void detect_left_recursion_nonterminal_for_one_rule(
-    node_t * const node,
-    std::list<stack_elem_for_left_recursion_detection> &stack,
-    std::list<std::list<node_t *> > &left_recursion_set);
+  void find_nullable_rules(
+    std::vector<bool> &nullable) const;
   
   unsigned int m_max_lookahead_searching_depth;
   bool m_use_paull_algo_to_remove_left_recursion;
   bool m_enable_left_factor;
   bool m_using_pure_BNF;
   
+  /// If it is true, the generated parser allocates the
+  /// parse tree nodes from an arena owned by the
+  /// frontend (the 'use_node_arena' option).
+  bool m_use_node_arena;
+  
+  /// The number of threads used to compute the lookahead
+  /// sets (the '-j' option).
+  unsigned int m_job_count;
+  
+  /// The '--backend' option. With BACKEND_TABLE, wpg
+  /// emits the decisions and the productions into tables
+  /// run by one generic driver, instead of a parse_XXX
+  /// function of nested switches for each rule.
+  backend_t m_backend;
+  
+  /// If it is true, the generated frontend also has
+  /// feed() and finish() to parse the starting rule from
+  /// the input in chunks (the '--push-parser' option).
+  bool m_push_parser;
+  
+  /// If it is true, each parse tree node has its span in
+  /// the input, and the generated frontend has
+  /// incremental_parse() to parse the starting rule again
+  /// after an edit, reusing the subtrees the edit does not
+  /// touch (the '--incremental' option).
+  bool m_incremental;
+  
+  /// If it is true, the generated parser counts the calls
+  /// of each rule, the peeks at each lookahead depth, and
+  /// the cases taken by each decision (the '--stats'
+  /// option). 'm_stats_cases' describes each case counter,
+  /// it is filled while the parser is dumped.
+  bool m_stats;
+  std::vector<std::wstring> mutable m_stats_cases;
+  
+  /// If it is true, wpg also generates 'benchmark.cpp',
+  /// which parses random token streams of the grammar,
+  /// and the frontend can parse an array of tokens (the
+  /// '--benchmark' option).
+  bool m_benchmark;
+  
+  /// The decision cases and their counts in the output of
+  /// dump_stats() of a parser generated with '--stats'
+  /// (the '--profile' option). With it, I put the hot
+  /// cases of each decision first.
+  bool m_profile;
+  std::map<std::wstring, unsigned long> m_profile_cases;
+  
+  /// The cases of 'm_profile_cases' which a decision of
+  /// the generated parser has looked up.
+  std::set<std::wstring> mutable m_matched_profile_cases;
+  
+  /// Whether to report the cost of each phase (the
+  /// '--time-report' option), and where to write it in JSON
+  /// (the '--time-report-json' option, empty if not
+  /// specified).
+  bool m_time_report;
+  std::wstring m_time_report_json_filename;
+  
   state_t m_state;
   
   bool m_indicate_terminal_rule;
@@ -392,14 +619,31 @@ private:
   std::wstring m_output_filename;
   std::wfstream *mp_output_file;
   
+  /// Every node_t is allocated from this pool, see
+  /// create_node().
+  node_pool_t m_node_pool;
+  
   std::list<node_t *> m_top_level_nodes;
   std::list<node_t *> m_answer_nodes;
   node_t *mp_last_created_node_during_parsing;
   node_t *mp_curr_parsing_alternative_head;
   
   terminal_hash_table_t m_terminal_hash_table;
+  std::list<token_pattern_t> m_token_patterns;
+  boost::scoped_ptr<scanner_dfa_t> mp_scanner_dfa;
   rule_head_hash_table_t m_rule_head_hash_table;
   answer_node_hash_table_t m_answer_node_hash_table;
+  symbol_hash_table_t m_symbol_hash_table;
+  
+  first_k_cache_t mutable m_first_k_cache;
+  
+  /// Used by the threads of the parallel lookahead
+  /// computation. If 'm_thread_log_buffer' is set, 'log()'
+  /// appends to it instead of writing to the output file,
+  /// and if 'm_thread_first_k_cache' is set, it is used
+  /// instead of 'm_first_k_cache'.
+  boost::thread_specific_ptr<std::wstring> mutable m_thread_log_buffer;
+  boost::thread_specific_ptr<first_k_cache_t> mutable m_thread_first_k_cache;
   
   unsigned int mutable m_curr_output_filename_idx;
   
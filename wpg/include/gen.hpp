@@ -35,6 +35,15 @@ enum check_regex_group_pos_t
 };
 typedef enum check_regex_group_pos_t check_regex_group_pos_t;
 
+extern void go_further_one_node(
+  std::list<node_with_order_t> &nodes);
+
+extern nodes_have_lookahead_rel_t all_nodes_have_lookahead(
+  std::list<node_with_order_t> const &nodes);
+
+extern void check_ambiguity(
+  std::list<node_with_order_t> const &nodes);
+
 extern void dump_gen_parser_src_real(
   std::wfstream &file,
   node_t const * const rule_node,
@@ -45,6 +54,55 @@ extern void dump_gen_parser_src_real(
 extern std::wstring indent_line(
   unsigned int const indent_level);
 
+extern wchar_t const *table_entry_type(
+  size_t const count);
+
+extern void dump_table_row(
+  std::wfstream &file,
+  std::vector<size_t> const &entries,
+  unsigned int const indent_level);
+
+extern std::wstring new_node_expression(
+  analyser_environment_t const * const ae,
+  wchar_t const * const node_arena);
+
+extern void dump_gen_recycle(
+  std::wfstream &file,
+  std::wstring const &class_name,
+  bool const has_prod_node);
+
+extern std::wstring stats_case_description(
+  std::wstring const &decision_name,
+  arranged_lookahead_t const * const arranged_lookahead,
+  node_t const * const default_node);
+
+extern void dump_stats_case_counter(
+  std::wfstream &file,
+  analyser_environment_t const * const ae,
+  std::wstring const &decision_name,
+  arranged_lookahead_t const * const arranged_lookahead,
+  node_t const * const default_node,
+  unsigned int const indent_depth);
+
+extern void dump_stats_rule_counter(
+  std::wfstream &file,
+  node_t const * const rule_node);
+
+extern void order_arranged_lookahead_by_profile(
+  analyser_environment_t const * const ae,
+  std::wstring const &decision_name,
+  arranged_lookahead_t * const arranged_lookahead,
+  node_t const * const default_node);
+
+extern arranged_lookahead_t const *dominant_case_in_profile(
+  analyser_environment_t const * const ae,
+  std::wstring const &decision_name,
+  arranged_lookahead_t const * const arranged_lookahead,
+  node_t const * const default_node);
+
+extern std::wstring member_variable_name_for_one_node(
+  node_t const * const node);
+
 extern void dump_class_member_variable_for_one_node(
   std::wfstream &file,
   node_t const * const node,
@@ -71,11 +129,13 @@ extern void dump_pt_XXX_prodn_node_t_class_header(
 extern void dump_pt_XXX_prodn_node_t_class_footer(
   std::wfstream &file,
   std::wstring const &rule_node_name,
-  int const alternative_id);
+  int const alternative_id,
+  node_t const * const alternative_start);
 
-extern void dump_add_node_to_nodes_for_one_node_in_parse_XXX(
+extern void dump_parse_one_node_in_parse_XXX(
   std::wfstream &file,
   node_t const * const node,
+  std::wstring const &destination,
   unsigned int const indent_depth);
 
 #endif
@@ -22,6 +22,17 @@
 
 class node_t;
 
+/// Every grammar symbol (terminal or nonterminal) is
+/// interned into a dense integer ID when the node is
+/// created, so that the analysis passes can compare two
+/// symbols by ID rather than by their name strings. The
+/// names are only used for diagnostics and code emission.
+typedef boost::uint32_t symbol_id_t;
+
+/// The empty name is used by the rule end node and by the
+/// EOF symbol in the lookahead set, and it always gets ID 0.
+#define EOF_SYMBOL_ID (0)
+
 enum node_rel_t
 {
   NODE_REL_NORMAL,
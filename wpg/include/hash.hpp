@@ -27,6 +27,21 @@ using namespace boost::multi_index;
 class terminal_name {};
 class node_name {};
 class node_overall_idx {};
+class symbol_name {};
+
+struct symbol_t
+{
+  std::wstring m_name;
+  symbol_id_t m_id;
+  
+  symbol_t(
+    std::wstring const &name,
+    symbol_id_t const id)
+    : m_name(name),
+      m_id(id)
+  { }
+};
+typedef struct symbol_t symbol_t;
 
 typedef boost::multi_index_container<
   std::wstring,
@@ -55,4 +70,14 @@ typedef boost::multi_index_container<
     >
   > answer_node_hash_table_t;
 
+typedef boost::multi_index_container<
+  symbol_t,
+  indexed_by<
+    hashed_unique<tag<symbol_name>,
+                  member<symbol_t,
+                         std::wstring,
+                         &symbol_t::m_name> >
+    >
+  > symbol_hash_table_t;
+
 #endif
@@ -56,18 +56,137 @@ public:
 };
 typedef class recur_lookahead_t recur_lookahead_t;
 
+/// Iterator over the children of one lookahead trie node,
+/// i.e. it walks the 'mp_next_sibling' chain.
+template<typename T>
+class lookahead_level_iterator_t
+{
+public:
+  
+  typedef std::forward_iterator_tag iterator_category;
+  typedef T value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef T *pointer;
+  typedef T &reference;
+  
+  explicit lookahead_level_iterator_t(
+    T * const node = 0)
+    : mp_node(node)
+  { }
+  
+  template<typename U>
+  lookahead_level_iterator_t(
+    lookahead_level_iterator_t<U> const &iter)
+    : mp_node(iter.get())
+  { }
+  
+  T *get() const { return mp_node; }
+  
+  T &operator*() const { return *mp_node; }
+  T *operator->() const { return mp_node; }
+  
+  lookahead_level_iterator_t &operator++()
+  {
+    mp_node = mp_node->mp_next_sibling;
+    return *this;
+  }
+  
+  lookahead_level_iterator_t operator++(int)
+  {
+    lookahead_level_iterator_t const tmp(*this);
+    mp_node = mp_node->mp_next_sibling;
+    return tmp;
+  }
+  
+  bool operator==(lookahead_level_iterator_t const &iter) const
+  { return mp_node == iter.mp_node; }
+  
+  bool operator!=(lookahead_level_iterator_t const &iter) const
+  { return mp_node != iter.mp_node; }
+  
+private:
+  
+  T *mp_node;
+};
+
+/// The children of one lookahead trie node.
+///
+/// The children are not owned by this object, they all
+/// live in the lookahead_arena_t of the rule, and they are
+/// chained through their 'mp_next_sibling' field in the
+/// order they are inserted. The insertion order matters,
+/// because the dumpper and the code generator emit the
+/// lookahead symbols in this order.
+///
+/// 'm_id_mask' has one bit set for each (symbol ID % 64) of
+/// the children, so that most of the failed look ups are
+/// answered by a single bit test without walking the
+/// chain.
+class lookahead_level_t
+{
+public:
+  
+  typedef lookahead_level_iterator_t<lookahead_set_t> iterator;
+  typedef lookahead_level_iterator_t<lookahead_set_t const> const_iterator;
+  
+  lookahead_level_t()
+    : mp_first(0),
+      mp_last(0),
+      m_size(0),
+      m_id_mask(0)
+  { }
+  
+  iterator begin() { return iterator(mp_first); }
+  iterator end() { return iterator(); }
+  const_iterator begin() const { return const_iterator(mp_first); }
+  const_iterator end() const { return const_iterator(); }
+  
+  size_t size() const { return m_size; }
+  bool empty() const { return 0 == m_size; }
+  
+  void push_back(
+    lookahead_set_t * const lookahead_set);
+  
+  lookahead_set_t *find(
+    symbol_id_t const id) const;
+  
+private:
+  
+  static boost::uint64_t id_bit(symbol_id_t const id)
+  { return static_cast<boost::uint64_t>(1) << (id & 63); }
+  
+  lookahead_set_t *mp_first;
+  lookahead_set_t *mp_last;
+  size_t m_size;
+  boost::uint64_t m_id_mask;
+};
+typedef class lookahead_level_t lookahead_level_t;
+
+class lookahead_arena_t;
+
 struct lookahead_set_t
 {
 private:
 
+  lookahead_set_t(lookahead_set_t const &);
   lookahead_set_t &operator=(lookahead_set_t const &);
 
 public:
 
   node_t * mp_orig_node; /* original grammar node for lookahead search */
-  node_t * const mp_node; /* lookahead terminal */
-  unsigned int const m_level;
-  std::list<lookahead_set_t> m_next_level; /* next level lookahead terminals */
+  node_t * mp_node; /* lookahead terminal */
+  unsigned int m_level;
+  lookahead_level_t m_next_level; /* next level lookahead terminals */
+  lookahead_set_t *mp_next_sibling;
+  
+  // Only used by lookahead_arena_t, which allocates the
+  // trie nodes in blocks and fills them by 'reset()'.
+  lookahead_set_t()
+    : mp_orig_node(0),
+      mp_node(0),
+      m_level(0),
+      mp_next_sibling(0)
+  { }
   
   lookahead_set_t(
     node_t * const orig_node,
@@ -75,14 +194,146 @@ public:
     unsigned int const level)
     : mp_orig_node(orig_node),
       mp_node(node),
-      m_level(level)
+      m_level(level),
+      mp_next_sibling(0)
   { }
   
+  void reset(
+    node_t * const orig_node,
+    node_t * const node,
+    unsigned int const level)
+  {
+    mp_orig_node = orig_node;
+    mp_node = node;
+    m_level = level;
+    m_next_level = lookahead_level_t();
+    mp_next_sibling = 0;
+  }
+  
   lookahead_set_t *find_lookahead(node_t * const node);
-  lookahead_set_t *insert_lookahead(node_t * const node);
+  lookahead_set_t *insert_lookahead(lookahead_arena_t &arena,
+                                    node_t * const node);
 };
 typedef struct lookahead_set_t lookahead_set_t;
 
+/// Bump allocator for the lookahead trie nodes of one rule.
+///
+/// Each rule head owns one of these, and every
+/// lookahead_set_t below the root 'm_lookahead_set' of the
+/// nodes in that rule is allocated from it. The trie nodes
+/// are never freed one by one, the whole arena is released
+/// when the rule head is destroyed.
+class lookahead_arena_t
+{
+private:
+  
+  lookahead_arena_t(lookahead_arena_t const &);
+  lookahead_arena_t &operator=(lookahead_arena_t const &);
+  
+  enum { BLOCK_SIZE = 256 };
+  
+public:
+  
+  lookahead_arena_t()
+    : m_used_in_last_block(BLOCK_SIZE),
+      m_size(0)
+  { }
+  
+  ~lookahead_arena_t();
+  
+  lookahead_set_t *allocate(
+    node_t * const orig_node,
+    node_t * const node,
+    unsigned int const level);
+  
+  size_t size() const { return m_size; }
+  
+private:
+  
+  std::vector<lookahead_set_t *> m_blocks;
+  size_t m_used_in_last_block;
+  size_t m_size;
+};
+typedef class lookahead_arena_t lookahead_arena_t;
+
+/// Memo table of the FIRST_k fragments of the rules.
+///
+/// The entry for (rule, k) is a lookahead trie holding
+/// every terminal sequence of length k which can be derived
+/// from that rule, plus every shorter sequence which
+/// reaches the end of that rule. The latter ends with the
+/// rule end node (i.e. an empty name), which means "the
+/// remaining lookahead terminals come from whatever follows
+/// this rule".
+///
+/// Ex:
+///
+/// A
+///   b c
+///   d
+///
+/// The FIRST_2 fragments of A are {b c; d A_END}.
+///
+/// These fragments do not depend on where the rule is
+/// referenced from, so that each of them is computed once
+/// and then spliced into every lookahead set which walks
+/// through that rule.
+class first_k_cache_t
+{
+private:
+  
+  first_k_cache_t(first_k_cache_t const &);
+  first_k_cache_t &operator=(first_k_cache_t const &);
+  
+public:
+  
+  enum state_t
+  {
+    STATE_NONE,
+    STATE_COMPUTING,
+    STATE_DONE,
+    STATE_UNCACHABLE
+  };
+  typedef enum state_t state_t;
+  
+  struct entry_t
+  {
+    state_t m_state;
+    lookahead_set_t *mp_fragments;
+    
+    entry_t()
+      : m_state(STATE_NONE),
+        mp_fragments(0)
+    { }
+  };
+  typedef struct entry_t entry_t;
+  
+  first_k_cache_t()
+    : m_hit_count(0)
+  { }
+  
+  entry_t &entry(
+    node_t const * const rule_node,
+    unsigned int const depth)
+  { return m_table[std::make_pair(rule_node, depth)]; }
+  
+  lookahead_arena_t &arena()
+  { return m_arena; }
+  
+  unsigned int &hit_count()
+  { return m_hit_count; }
+  
+  size_t size() const
+  { return m_table.size(); }
+  
+private:
+  
+  std::map<std::pair<node_t const *, unsigned int>, entry_t> m_table;
+  lookahead_arena_t m_arena;
+  unsigned int m_hit_count;
+};
+typedef class first_k_cache_t first_k_cache_t;
+
 struct todo_lookahead_t
 {
 private:
@@ -37,10 +37,92 @@ enum rule_contain_regex_t
 };
 typedef enum rule_contain_regex_t rule_contain_regex_t;
 
+/// Slab allocator for node_t.
+///
+/// The analyser environment owns one of these, and every
+/// node_t of it takes a slot by 'new (pool) node_t', see
+/// analyser_environment_t::create_node(). A deleted node
+/// puts its slot back onto the free list, and the whole
+/// slabs are released when the pool is destroyed.
+///
+/// Each slot starts with a header pointing back to its
+/// pool, so that 'delete' does not need to know where the
+/// node came from.
+///
+/// Nodes are only created and deleted in the serial phases
+/// (the parallel lookahead computation does not touch the
+/// grammar), thus this is not thread safe.
+class node_pool_t
+{
+private:
+  
+  node_pool_t(node_pool_t const &);
+  node_pool_t &operator=(node_pool_t const &);
+  
+  enum { SLOTS_PER_SLAB = 1024 };
+  
+  struct slot_header_t
+  {
+    node_pool_t *mp_pool;
+    slot_header_t *mp_next_free;
+  };
+  typedef struct slot_header_t slot_header_t;
+  
+public:
+  
+  node_pool_t();
+  ~node_pool_t();
+  
+  void *allocate(
+    size_t const size);
+  
+  static void deallocate(
+    void * const ptr);
+  
+  size_t allocation_count() const { return m_allocation_count; }
+  size_t free_count() const { return m_free_count; }
+  size_t live_count() const { return m_allocation_count - m_free_count; }
+  size_t peak_live_count() const { return m_peak_live_count; }
+  size_t slot_size() const { return m_slot_size; }
+  size_t slab_count() const { return m_slabs.size(); }
+  
+  size_t peak_bytes() const
+  { return m_peak_live_count * m_slot_size; }
+  
+  size_t reserved_bytes() const
+  { return m_slabs.size() * SLOTS_PER_SLAB * m_slot_size; }
+  
+private:
+  
+  std::vector<char *> m_slabs;
+  size_t m_slot_size;
+  size_t m_used_in_last_slab;
+  slot_header_t *mp_free_list;
+  
+  size_t m_allocation_count;
+  size_t m_free_count;
+  size_t m_peak_live_count;
+};
+typedef class node_pool_t node_pool_t;
+
 class node_t
 {
 public:
   
+  /// A node is only created in a pool, ex:
+  /// 'new (pool) node_t(...)'.
+  static void *operator new(
+    size_t const size,
+    node_pool_t &pool);
+  
+  /// For a constructor which throws.
+  static void operator delete(
+    void * const ptr,
+    node_pool_t &pool);
+  
+  static void operator delete(
+    void * const ptr);
+  
   node_t(
     analyser_environment_t * const ae,
     node_t * const rule_node,
@@ -105,8 +187,13 @@ public:
     wchar_t const * const str);
   
   void set_name(
-    std::wstring const &str)
-  { m_name = str; }
+    std::wstring const &str);
+  
+  /// The dense ID of this symbol. Two nodes refer to the
+  /// same grammar symbol iff they have the same ID, so use
+  /// this instead of comparing 'name()' in any hot path.
+  symbol_id_t symbol_id() const
+  { return m_symbol_id; }
 
   void set_node_before_the_rule_end_node(
     node_t * const node);
@@ -166,7 +253,7 @@ public:
     node_t const * const node) const;
 
   std::list<node_t *> const &refer_to_me_nodes() const
-  { return m_refer_to_me_nodes; }
+  { return cold_part().m_refer_to_me_nodes; }
   
   node_t *nonterminal_rule_node() const
   { return mp_nonterminal_rule_node; }
@@ -175,10 +262,10 @@ public:
     node_t * const node);
 
   void clear_same_rule_nodes()
-  { m_same_rule_nodes.clear(); }
+  { if (mp_cold_part.get() != 0) { mp_cold_part->m_same_rule_nodes.clear(); } }
 
   std::list<node_t *> const &same_rule_nodes() const
-  { return m_same_rule_nodes; }
+  { return cold_part().m_same_rule_nodes; }
 
   node_t *rule_node() const
   { return mp_rule_node; }
@@ -191,10 +278,10 @@ public:
   { return m_is_nullable; }
   
   bool is_cyclic() const
-  { return (m_cyclic_set.size() > 0) ? true : false; }
+  { return (cold_part().m_cyclic_set.size() > 0) ? true : false; }
   
   bool is_left_recursion() const
-  { return (m_left_recursion_set.size() > 0) ? true : false; }
+  { return (cold_part().m_left_recursion_set.size() > 0) ? true : false; }
   
   void set_nullable(
     bool const nullable)
@@ -206,10 +293,10 @@ public:
   void init();
 
   std::list<node_t *> const &temp_append_to_rule_node() const
-  { return m_temp_append_to_rule_node; }
+  { return cold_part().m_temp_append_to_rule_node; }
 
   std::list<node_t *> const &temp_prepend_to_end_node() const
-  { return m_temp_prepend_to_end_node; }
+  { return cold_part().m_temp_prepend_to_end_node; }
   
   void
   add_temp_append_to_rule_node(
@@ -218,40 +305,56 @@ public:
     assert(true == m_is_rule_head);
     
     node->alternative_start() = node;
-    m_temp_append_to_rule_node.push_back(node);
+    mutable_cold_part().m_temp_append_to_rule_node.push_back(node);
   }
   
   void add_temp_prepend_to_end_node(
     node_t * const node)
-  { assert(m_is_rule_head); m_temp_prepend_to_end_node.push_back(node); }
+  { assert(m_is_rule_head); mutable_cold_part().m_temp_prepend_to_end_node.push_back(node); }
   
   void clear_temp_append_to_rule_node()
-  { assert(m_is_rule_head); m_temp_append_to_rule_node.clear(); }
+  {
+    assert(m_is_rule_head);
+    
+    if (mp_cold_part.get() != 0)
+    {
+      mp_cold_part->m_temp_append_to_rule_node.clear();
+    }
+  }
 
   void clear_temp_prepend_to_end_node()
-  { assert(m_is_rule_head); m_temp_prepend_to_end_node.clear(); }
+  {
+    assert(m_is_rule_head);
+    
+    if (mp_cold_part.get() != 0)
+    {
+      mp_cold_part->m_temp_prepend_to_end_node.clear();
+    }
+  }
 
   void assign_cyclic_set(
     std::list<node_t *> const &set);
 
   std::list<node_t *> const &cyclic_set() const
-  { return m_cyclic_set; }
+  { return cold_part().m_cyclic_set; }
 
   std::list<node_t *> &cyclic_set()
-  { return m_cyclic_set; }
+  { return mutable_cold_part().m_cyclic_set; }
   
   void assign_left_recursion_set(
     std::list<node_t *> const &set);
   
   std::list<node_t *> const &left_recursion_set() const
-  { return m_left_recursion_set; }
+  { return cold_part().m_left_recursion_set; }
 
   std::list<node_t *> &left_recursion_set()
-  { return m_left_recursion_set; }
+  { return mutable_cold_part().m_left_recursion_set; }
   
-  void clear_cyclic_set() { m_cyclic_set.clear(); }
+  void clear_cyclic_set()
+  { if (mp_cold_part.get() != 0) { mp_cold_part->m_cyclic_set.clear(); } }
   
-  void clear_left_recursion_set() { m_left_recursion_set.clear(); }
+  void clear_left_recursion_set()
+  { if (mp_cold_part.get() != 0) { mp_cold_part->m_left_recursion_set.clear(); } }
 
   void set_apostrophe_node(
     node_t * const node)
@@ -272,13 +375,16 @@ public:
 
   lookahead_set_t const &lookahead_set() const
   { return m_lookahead_set; }
+  
+  /// This function is only meaningful in the rule node.
+  lookahead_arena_t &lookahead_arena();
 
   void add_left_corner_set(
     node_t * const node)
-  { m_left_corner_set.push_back(node); }
+  { mutable_cold_part().m_left_corner_set.push_back(node); }
 
   std::list<node_t *> const &left_corner_set() const
-  { return m_left_corner_set; }
+  { return cold_part().m_left_corner_set; }
 
   node_t *find_alternative_last_node();
 
@@ -289,10 +395,10 @@ public:
     node_t * const node) const;
 
   bool is_ambigious() const
-  { return (0 == m_ambigious_set.size()) ? false : true; }
+  { return (0 == cold_part().m_ambigious_set.size()) ? false : true; }
 
   std::list<node_t *> const &ambigious_set() const
-  { return m_ambigious_set; }
+  { return cold_part().m_ambigious_set; }
   
   void set_lookahead_depth(
     unsigned int const depth)
@@ -473,10 +579,10 @@ public:
   /// forking production.
   ///
   std::list<node_t *> const &corresponding_node_between_fork() const
-  { return mp_corresponding_node_between_fork; }
+  { return cold_part().mp_corresponding_node_between_fork; }
   
   std::list<node_t *> &corresponding_node_between_fork()
-  { return mp_corresponding_node_between_fork; }
+  { return mutable_cold_part().mp_corresponding_node_between_fork; }
   /** @} */
   
   node_t_ptr const &brother_node_to_update_regex() const
@@ -492,10 +598,10 @@ public:
   { return mp_corresponding_node_in_main_regex_alternative; }
   
   std::list<node_t *> const &refer_to_me_nodes_in_regex_expansion_alternatives() const
-  { return mp_refer_to_me_nodes_in_regex_expansion_alternatives; }
+  { return cold_part().mp_refer_to_me_nodes_in_regex_expansion_alternatives; }
   
   std::list<node_t *> &refer_to_me_nodes_in_regex_expansion_alternatives()
-  { return mp_refer_to_me_nodes_in_regex_expansion_alternatives; }
+  { return mutable_cold_part().mp_refer_to_me_nodes_in_regex_expansion_alternatives; }
   
   bool const &is_in_regex_OR_group() const
   { return m_is_in_regex_OR_group; }
@@ -520,10 +626,10 @@ public:
   { return mp_main_regex_alternative; }
   
   std::list<regex_info_t> &regex_OR_info()
-  { return m_regex_OR_info; }
+  { return mutable_cold_part().m_regex_OR_info; }
   
   std::list<regex_info_t> const &regex_OR_info() const
-  { return m_regex_OR_info; }
+  { return cold_part().m_regex_OR_info; }
   
   template<typename T_traits>
   regex_info_t const *find_regex_info_is_started_by_me(
@@ -535,19 +641,110 @@ public:
   bool &contains_ambigious()
   { return m_contains_ambigious; }
   
+  /// Whether this node has written one of its rarely used
+  /// members, see cold_part_t.
+  bool has_cold_part() const
+  { return mp_cold_part.get() != 0; }
+  
+  static size_t cold_part_size()
+  { return sizeof(cold_part_t); }
+  
 private:
   
+  /// The members that almost every node leaves empty. They
+  /// are kept out of node_t, so that walking the grammar
+  /// does not drag them through the cache, and allocated on
+  /// the first write, see mutable_cold_part().
+  struct cold_part_t
+  {
+    /// This field is only useful in rule nodes.
+    ///
+    /// In the rule nodes:
+    ///
+    /// A : a | b | c
+    ///
+    /// B : A | C
+    ///     ^
+    ///
+    /// Then the 'refer_to_me_nodes' of the rule node 'A'
+    /// will contain the node 'A' pointed by '^'. The inverse
+    /// relationship of this idea is the
+    /// 'nonterminal_rule_node' field.
+    std::list<node_t *> m_refer_to_me_nodes;
+    
+    std::list<node_t *> m_same_rule_nodes;
+    std::list<node_t *> m_cyclic_set;
+    std::list<node_t *> m_left_recursion_set;
+    std::list<node_t *> m_left_corner_set;
+    std::list<node_t *> m_temp_append_to_rule_node;
+    std::list<node_t *> m_temp_prepend_to_end_node;
+    std::list<node_t *> m_ambigious_set;
+    
+    std::list<std::wstring> m_token_name_as_terminal_during_lookahead;
+    
+    ///
+    /// Used for code gen.
+    ///
+    std::list<regex_info_t> m_regex_OR_info;
+    
+    std::list<node_t *> mp_refer_to_me_nodes_in_regex_expansion_alternatives;
+    std::list<node_t *> mp_corresponding_node_between_fork;
+  };
+  typedef struct cold_part_t cold_part_t;
+  
+  /// Shared by every node which has not allocated its own
+  /// cold part yet, so that reading never allocates.
+  static cold_part_t const s_empty_cold_part;
+  
+  cold_part_t const &cold_part() const
+  { return (0 == mp_cold_part.get()) ? s_empty_cold_part : *mp_cold_part; }
+  
+  cold_part_t &mutable_cold_part();
+  
+  // The hot part: the members read by every traversal of
+  // the grammar come first.
+  
   analyser_environment_t *mp_ae;
+  node_t *mp_rule_node;
+  node_t *mp_rule_end_node;
+  node_t *mp_alternative_start;
+  node_t *mp_nonterminal_rule_node;
+  node_t *mp_node_before_the_rule_end_node;
+  symbol_id_t m_symbol_id;
+  
   bool m_is_rule_head;
   bool m_is_terminal;
   bool m_is_eof;
-  std::wstring m_name;
-  std::list<node_t *> m_prev_nodes;
-  std::list<node_t *> m_next_nodes;
+  bool m_is_nullable;
+  bool m_optional;
+  bool m_traversed;
+  bool m_create_dot_node_line;
+  bool m_starting_rule;
+  bool m_is_in_regex_OR_group;
+  
+  /// Only useful for rule node.
+  bool m_contains_ambigious;
   
   /// This variable is only meaningful in the rule node.
   rule_contain_regex_t m_rule_contain_regex;
   
+  unsigned int m_overall_idx;
+  unsigned int m_name_postfix_by_appear_times;
+  unsigned int m_lookahead_depth;
+  unsigned int m_distance_from_rule_head;
+  unsigned int m_distance_to_rule_end_node;
+  unsigned int m_alternative_length;
+  
+  std::list<node_t *> m_prev_nodes;
+  std::list<node_t *> m_next_nodes;
+  
+  std::wstring m_name;
+  
+  lookahead_set_t m_lookahead_set;
+  
+  std::list<regex_info_t> m_regex_info;
+  std::list<regex_info_t> m_tmp_regex_info;
+  
   /// This variable is used to remember the main regex
   /// alternative. Ex:
   ///
@@ -580,78 +777,16 @@ private:
   /// codes according to it.
   node_t *mp_main_regex_alternative;
   
-  bool m_traversed;
-  bool m_create_dot_node_line;
-  
-  unsigned int m_overall_idx;
-  unsigned int m_name_postfix_by_appear_times;
-  
-  node_t *mp_rule_node;
-  node_t *mp_rule_end_node;
-  node_t *mp_alternative_start;
-  bool m_is_nullable;
-  
-  unsigned int m_lookahead_depth;
-  lookahead_set_t m_lookahead_set;
-  
-  node_t *mp_last_edge_last_node;
   node_t *mp_apostrophe_node;
   node_t *mp_apostrophe_orig_node;
   
-  /// This field is only useful in rule nodes.
-  ///
-  /// In the rule nodes:
-  ///
-  /// A : a | b | c
-  ///
-  /// B : A | C
-  ///     ^
-  ///
-  /// Then the 'refer_to_me_nodes' of the rule node 'A' will
-  /// contain the node 'A' pointed by '^'. The inverse
-  /// relationship of this idea is the
-  /// 'nonterminal_rule_node' field.
-  std::list<node_t *> m_refer_to_me_nodes;
-  
-  std::list<node_t *> m_same_rule_nodes;
-  std::list<node_t *> m_cyclic_set;
-  std::list<node_t *> m_left_recursion_set;
-  std::list<node_t *> m_left_corner_set;
-  std::list<node_t *> m_temp_append_to_rule_node;
-  std::list<node_t *> m_temp_prepend_to_end_node;
-  std::list<node_t *> m_ambigious_set;
-  
-  /// Only useful for rule node.
-  bool m_contains_ambigious;
-  
-  node_t *mp_nonterminal_rule_node;
-  node_t *mp_node_before_the_rule_end_node;
-  bool m_optional;
-  
-  bool m_starting_rule;
-  
-  std::list<std::wstring> m_token_name_as_terminal_during_lookahead;
-  
-  unsigned int m_distance_from_rule_head;
-  unsigned int m_distance_to_rule_end_node;
-  
-  std::list<regex_info_t> m_regex_info;
-  std::list<regex_info_t> m_tmp_regex_info;
-  
-  ///
-  /// Used for code gen.
-  ///
-  std::list<regex_info_t> m_regex_OR_info;
-  
-  unsigned int m_alternative_length;
-  
   node_t *mp_corresponding_node_in_main_regex_alternative;
-  std::list<node_t *> mp_refer_to_me_nodes_in_regex_expansion_alternatives;
-  
-  std::list<node_t *> mp_corresponding_node_between_fork;
   node_t *mp_brother_node_to_update_regex;
   
-  bool m_is_in_regex_OR_group;
+  /// This variable is only meaningful in the rule node.
+  boost::scoped_ptr<lookahead_arena_t> mp_lookahead_arena;
+  
+  boost::scoped_ptr<cold_part_t> mp_cold_part;
   
   void dump_gen_parser_header_for_regex_alternative(
     std::wfstream &file,
@@ -664,12 +799,6 @@ private:
     std::wstring const &rule_node_name,
     int const alternative_id) const;
   
-  void dump_gen_parser_src__fill_nodes__for_regex_alternative(
-    std::wfstream &file) const;
-  
-  void dump_gen_parser_src__fill_nodes__for_node_range(
-    std::wfstream &file) const;
-
   void dump_gen_parser_src__parse_XXX__for_node_range(
     std::wfstream &file) const;
   
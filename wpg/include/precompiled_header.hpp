@@ -10,16 +10,19 @@
 
 #include <list>
 #include <map>
+#include <bitset>
 #include <vector>
 #include <string>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <exception>
 #include <algorithm>
 #include <functional>
 
 #include <windows.h>
+#include <psapi.h>
 
 #include <boost/smart_ptr.hpp>
 #include <boost/foreach.hpp>
@@ -37,7 +40,11 @@
 #include <boost/multi_index/ordered_index.hpp>
 
 #include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
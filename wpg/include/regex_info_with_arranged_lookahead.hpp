@@ -42,7 +42,8 @@ public:
   regex_info_with_arranged_lookahead_t(
     regex_info_t const * const regex_info)
     : mp_regex_info(regex_info),
-      m_first_enter_this_regex(true)
+      m_first_enter_this_regex(true),
+      mp_curr_node(0)
   { }
 };
 typedef struct regex_info_with_arranged_lookahead_t regex_info_with_arranged_lookahead_t;
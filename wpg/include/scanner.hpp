@@ -0,0 +1,107 @@
+// wpg - an LL(k) parser generator
+// Copyright (C) <2007>  Wei Hu <wei.hu.tw@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __scanner_hpp__
+#define __scanner_hpp__
+
+class analyser_environment_t;
+
+/// A token pattern declared in the terminal block:
+///
+/// "number" [pattern = "[0-9]+"]
+/// "blank" [pattern = "[\s]+"; skip = yes]
+///
+/// The generated scanner drops the tokens of a pattern
+/// marked 'skip'.
+struct token_pattern_t
+{
+  std::wstring m_terminal_name;
+  std::wstring m_pattern;
+  bool m_skip;
+  
+  token_pattern_t(
+    std::wstring const &terminal_name)
+    : m_terminal_name(terminal_name),
+      m_skip(false)
+  { }
+};
+typedef struct token_pattern_t token_pattern_t;
+
+/// The minimized DFA recognizing the token patterns of a
+/// grammar, which the generated scanner runs over its
+/// input bytes.
+///
+/// The input bytes are grouped into character classes,
+/// two bytes are in the same class iff every state moves
+/// to the same state on them. Hence the transition table is
+/// dense: one row per state, and one column per character
+/// class.
+///
+/// State 0 is the dead state, and state 1 is the start
+/// state.
+class scanner_dfa_t
+{
+public:
+  
+  enum
+  {
+    DEAD_STATE = 0,
+    START_STATE = 1,
+    NO_TOKEN = -1
+  };
+  
+  /// Compile 'patterns' into a minimized DFA. When more
+  /// than one pattern matches the longest token, the
+  /// earlier declared one wins.
+  ///
+  /// Throw ga_exception_t after logging the reason if a
+  /// pattern is malformed or matches the empty string.
+  scanner_dfa_t(
+    analyser_environment_t const * const ae,
+    std::list<token_pattern_t> const &patterns);
+  
+  size_t state_count() const
+  { return m_accept.size(); }
+  
+  size_t char_class_count() const
+  { return m_char_class_count; }
+  
+  size_t char_class(
+    unsigned char const c) const
+  { return m_char_class[c]; }
+  
+  size_t transition(
+    size_t const state,
+    size_t const char_class) const
+  { return m_transition[(state * m_char_class_count) + char_class]; }
+  
+  /// The index (in the pattern list) of the pattern
+  /// accepted in 'state', or NO_TOKEN.
+  int accept(
+    size_t const state) const
+  { return m_accept[state]; }
+  
+private:
+  
+  size_t m_char_class_count;
+  size_t m_char_class[256];
+  std::vector<size_t> m_transition;
+  std::vector<int> m_accept;
+};
+typedef class scanner_dfa_t scanner_dfa_t;
+
+#endif
@@ -0,0 +1,68 @@
+// wpg - an LL(k) parser generator
+// Copyright (C) <2007>  Wei Hu <wei.hu.tw@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __scc_hpp__
+#define __scc_hpp__
+
+#include "global.hpp"
+
+class node_t;
+
+/// A directed graph whose vertices are the rule heads of
+/// the grammar. The cyclic detection adds an edge 'A->B'
+/// for every unit production 'A -> B', and the left
+/// recursion detection adds an edge 'A->B' for every
+/// left corner 'B' of 'A'. A rule is then cyclic (or left
+/// recursive) iff it belongs to a strongly connected
+/// component with more than one rule, or it has an edge to
+/// itself.
+class rule_graph_t
+{
+public:
+
+  explicit rule_graph_t(
+    std::list<node_t *> const &rule_nodes);
+
+  void add_edge(
+    node_t * const from,
+    node_t * const to);
+
+  /// Compute the recursive strongly connected components
+  /// with Tarjan's algorithm, in O(V+E).
+  ///
+  /// Each component lists its rules in the order of the
+  /// rule list passed to the constructor, and the
+  /// components are ordered by their first rule.
+  void find_recursive_components(
+    std::list<std::list<node_t *> > &components) const;
+
+private:
+
+  size_t vertex_of(
+    node_t * const rule_node) const;
+
+  std::vector<node_t *> m_rule_nodes;
+
+  /// symbol ID of a rule head -> its vertex index.
+  std::vector<size_t> m_vertex_of_symbol;
+
+  std::vector<std::vector<size_t> > m_edges;
+  std::vector<bool> m_self_loop;
+};
+typedef class rule_graph_t rule_graph_t;
+
+#endif
@@ -0,0 +1,99 @@
+// wpg - an LL(k) parser generator
+// Copyright (C) <2007>  Wei Hu <wei.hu.tw@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __time_report_hpp__
+#define __time_report_hpp__
+
+class analyser_environment_t;
+
+/// Collect the cost of each phase of the wpg pipeline (the
+/// '--time-report' option).
+///
+/// main() calls start_phase() at the beginning of each
+/// phase, which also ends the previous one, and stop()
+/// after the last one. For each phase I record the wall
+/// time, the CPU time of the whole process, how much the
+/// peak working set grew, and the number of nodes and
+/// alternatives in the grammar when the phase ends.
+///
+/// If it is not enabled, every function here does nothing,
+/// so that a normal run does not pay for counting the
+/// nodes.
+class time_report_t
+{
+public:
+  
+  time_report_t(
+    analyser_environment_t const * const ae,
+    bool const enabled);
+  
+  void start_phase(
+    wchar_t const * const name);
+  
+  void stop();
+  
+  /// Write the table to the log of the analyser
+  /// environment.
+  void log() const;
+  
+  bool dump_json(
+    std::wstring const &filename) const;
+  
+private:
+  
+  struct sample_t
+  {
+    boost::posix_time::ptime m_wall_time;
+    
+    /// in 100 nanoseconds, user + kernel.
+    boost::uint64_t m_cpu_time;
+    
+    size_t m_peak_working_set;
+  };
+  typedef struct sample_t sample_t;
+  
+  struct phase_t
+  {
+    std::wstring m_name;
+    double m_wall_ms;
+    double m_cpu_ms;
+    size_t m_peak_working_set_delta;
+    size_t m_peak_working_set;
+    size_t m_node_count;
+    size_t m_alternative_count;
+  };
+  typedef struct phase_t phase_t;
+  
+  static void take_sample(
+    sample_t &sample);
+  
+  analyser_environment_t const * const mp_ae;
+  bool const m_enabled;
+  
+  /// The name of the running phase, empty if there is no
+  /// running phase.
+  std::wstring m_curr_phase_name;
+  sample_t m_curr_phase_start;
+  
+  std::list<phase_t> m_phases;
+  
+  time_report_t(time_report_t const &);
+  time_report_t &operator=(time_report_t const &);
+};
+typedef class time_report_t time_report_t;
+
+#endif
@@ -26,6 +26,24 @@
 
 #include "wcl_memory_debugger\memory_debugger.h"
 
+namespace
+{
+  // The objects pointed by the thread specific pointers of
+  // analyser_environment_t are owned by the threads which
+  // set them, see compute_lookahead_set_worker().
+  void
+  do_not_delete_log_buffer(
+    std::wstring * const /* buffer */)
+  {
+  }
+  
+  void
+  do_not_delete_first_k_cache(
+    first_k_cache_t * const /* cache */)
+  {
+  }
+}
+
 analyser_environment_t::analyser_environment_t()
   : m_state(STATE_READ_TERMINAL),
     m_indicate_terminal_rule(false),
@@ -40,8 +58,23 @@ analyser_environment_t::analyser_environment_t()
     m_max_lookahead_searching_depth(2),
     m_use_paull_algo_to_remove_left_recursion(false),
     m_enable_left_factor(false),
-    m_using_pure_BNF(false)
+    m_using_pure_BNF(false),
+    m_use_node_arena(false),
+    m_job_count(1),
+    m_backend(BACKEND_RECURSIVE_DESCENT),
+    m_push_parser(false),
+    m_incremental(false),
+    m_stats(false),
+    m_benchmark(false),
+    m_profile(false),
+    m_time_report(false),
+    m_thread_log_buffer(do_not_delete_log_buffer),
+    m_thread_first_k_cache(do_not_delete_first_k_cache)
 {
+  // Reserve ID 0 for the empty name, i.e. the rule end node
+  // and the EOF symbol.
+  symbol_id_t const id = intern_symbol(std::wstring());
+  assert(EOF_SYMBOL_ID == id);
 }
 
 analyser_environment_t::~analyser_environment_t()
@@ -82,6 +115,9 @@ analyser_environment_t::~analyser_environment_t()
   {
     boost::checked_delete(node);
   }
+  
+  // The slabs of 'm_node_pool' are released as a whole
+  // when it is destroyed.
 }
 
 namespace
@@ -296,8 +332,8 @@ analyser_environment_t::parse_rule_head(
     throw ga_exception_t();
   }
   
-  node_t * const node = new node_t(this, 0, str);
-  node_t * const rule_end_node = new node_t(this, node);
+  node_t * const node = create_node(0, str);
+  node_t * const rule_end_node = create_node(node);
   
   mp_last_created_node_during_parsing = node;
   
@@ -317,12 +353,32 @@ analyser_environment_t::parse_rule_head(
   return true;
 }
 
+/// Create a node in 'm_node_pool'. 'rule_node' is 0 for a
+/// rule node.
+node_t *
+analyser_environment_t::create_node(
+  node_t * const rule_node,
+  std::wstring const &str)
+{
+  return new (m_node_pool) node_t(this, rule_node, str);
+}
+
+/// Create a copy of 'node' in 'm_node_pool'.
+node_t *
+analyser_environment_t::create_node_copy(
+  node_t const * const node)
+{
+  assert(this == node->ae());
+  
+  return new (m_node_pool) node_t(node);
+}
+
 node_t *
 analyser_environment_t::create_node_by_name(
   node_t * const rule_node,
   std::wstring const &str)
 {
-  node_t * const node = new node_t(this, rule_node, str);
+  node_t * const node = create_node(rule_node, str);
   mp_last_created_node_during_parsing = node;
   return node;
 }
@@ -626,7 +682,9 @@ analyser_environment_t::last_rule_node()
 enum PARSING_CTRL_CMD_ENUM
 {
   PARSING_CTRL_CMD_NONE,
-  PARSING_CTRL_CMD_AS_TERMINAL
+  PARSING_CTRL_CMD_AS_TERMINAL,
+  PARSING_CTRL_CMD_PATTERN,
+  PARSING_CTRL_CMD_SKIP
 };
 
 enum PARSING_OPTION_CMD_ENUM
@@ -635,7 +693,8 @@ enum PARSING_OPTION_CMD_ENUM
   PARSING_OPTION_CMD_K,
   PARSING_OPTION_CMD_USE_PAULL_ALGO,
   PARSING_OPTION_CMD_ENABLE_LEFT_FACTOR,
-  PARSING_OPTION_CMD_USING_PURE_BNF
+  PARSING_OPTION_CMD_USING_PURE_BNF,
+  PARSING_OPTION_CMD_USE_NODE_ARENA
 };
 
 enum PARSING_STATE_ENUM
@@ -859,11 +918,62 @@ analyser_environment_t::read_grammar(
           {
             assert(ctrl_cmd != PARSING_CTRL_CMD_NONE);
             ctrl_value_start = true;
+            
+            if (PARSING_CTRL_CMD_PATTERN == ctrl_cmd)
+            {
+              // The pattern may contain the delimiters of
+              // this state, so that I read it as a quoted
+              // string here.
+              m_token_patterns.back().m_pattern =
+                *(lexer_get_token_pattern_string().get());
+              
+              if (true == m_token_patterns.back().m_pattern.empty())
+              {
+                log(L"<ERROR>: the pattern of the terminal \"%s\" is empty.\n",
+                    m_token_patterns.back().m_terminal_name.c_str());
+                throw ga_exception_t();
+              }
+            }
           }
           else if (0 == ctrl_str->compare(L"as_terminal"))
           {
             ctrl_cmd = PARSING_CTRL_CMD_AS_TERMINAL;
           }
+          else if ((0 == ctrl_str->compare(L"pattern")) ||
+                   (0 == ctrl_str->compare(L"skip")))
+          {
+            // Ex:
+            //
+            // "number" [pattern = "[0-9]+"]
+            // "blank" [pattern = "[\s]+"; skip = yes]
+            if ((m_state != STATE_READ_TERMINAL) ||
+                (true == m_token_patterns.empty()))
+            {
+              log(L"<ERROR>: '%s' can only follow a terminal in the terminal name block.\n",
+                  ctrl_str->c_str());
+              throw ga_exception_t();
+            }
+            
+            ctrl_cmd = (0 == ctrl_str->compare(L"pattern")) ?
+              PARSING_CTRL_CMD_PATTERN : PARSING_CTRL_CMD_SKIP;
+          }
+          else if (PARSING_CTRL_CMD_SKIP == ctrl_cmd)
+          {
+            assert(true == ctrl_value_start);
+            
+            if (0 == ctrl_str->compare(L"yes"))
+            {
+              m_token_patterns.back().m_skip = true;
+            }
+            else if (0 == ctrl_str->compare(L"no"))
+            {
+              m_token_patterns.back().m_skip = false;
+            }
+            else
+            {
+              throw ga_exception_t();
+            }
+          }
           else
           {
             assert(mp_last_created_node_during_parsing != 0);
@@ -1313,6 +1423,10 @@ analyser_environment_t::read_grammar(
           {
             option_cmd = PARSING_OPTION_CMD_USING_PURE_BNF;
           }
+          else if (0 == option_str->compare(L"use_node_arena"))
+          {
+            option_cmd = PARSING_OPTION_CMD_USE_NODE_ARENA;
+          }
           else if (0 == option_str->compare(L";"))
           {
             option_value_start = false;
@@ -1386,6 +1500,21 @@ analyser_environment_t::read_grammar(
               }
               break;
               
+            case PARSING_OPTION_CMD_USE_NODE_ARENA:
+              if (0 == option_str->compare(L"yes"))
+              {
+                m_use_node_arena = true;
+              }
+              else if (0 == option_str->compare(L"no"))
+              {
+                m_use_node_arena = false;
+              }
+              else
+              {
+                assert(0);
+              }
+              break;
+              
             default:
               assert(0);
               break;
@@ -1730,7 +1859,87 @@ analyser_environment_t::close_output_file()
   {
     mp_output_file->close();
     boost::checked_delete(mp_output_file);
+    mp_output_file = 0;
+  }
+}
+
+namespace
+{
+  bool
+  count_node_with_cold_part(
+    analyser_environment_t const * const /* ae */,
+    node_t * const node,
+    void * const param)
+  {
+    std::pair<unsigned int, unsigned int> * const count =
+      reinterpret_cast<std::pair<unsigned int, unsigned int> *>(param);
+    
+    ++(count->first);
+    
+    if (true == node->has_cold_part())
+    {
+      ++(count->second);
+    }
+    
+    return true;
+  }
+}
+
+size_t
+analyser_environment_t::token_type_value(
+  std::wstring const &name) const
+{
+  if (0 == name.size())
+  {
+    return 0;
+  }
+  
+  // The terminals are enumerated in the order of
+  // dump_gen_parser_basic_types_hpp(), from 1.
+  typedef terminal_hash_table_t::index<terminal_name>::type node_by_name;
+  
+  size_t value = 1;
+  
+  for (node_by_name::iterator iter = m_terminal_hash_table.get<terminal_name>().begin();
+       iter != m_terminal_hash_table.get<terminal_name>().end();
+       ++iter)
+  {
+    if (name == *iter)
+    {
+      return value;
+    }
+    
+    ++value;
   }
+  
+  assert(0 && "unknown terminal");
+  
+  return 0;
+}
+
+void
+analyser_environment_t::log_node_pool_statistics() const
+{
+  // first: nodes in the grammar, second: those of them
+  // having a cold part.
+  std::pair<unsigned int, unsigned int> count(0, 0);
+  
+  (void)traverse_all_nodes(count_node_with_cold_part, 0, &count);
+  
+  log(L"<INFO>: node_t pool: %u allocations, %u frees, %u live nodes.\n",
+      static_cast<unsigned int>(m_node_pool.allocation_count()),
+      static_cast<unsigned int>(m_node_pool.free_count()),
+      static_cast<unsigned int>(m_node_pool.live_count()));
+  log(L"<INFO>: node_t pool: peak %u nodes (%u bytes), %u slabs (%u bytes).\n",
+      static_cast<unsigned int>(m_node_pool.peak_live_count()),
+      static_cast<unsigned int>(m_node_pool.peak_bytes()),
+      static_cast<unsigned int>(m_node_pool.slab_count()),
+      static_cast<unsigned int>(m_node_pool.reserved_bytes()));
+  log(L"<INFO>: node_t is %u bytes, its cold part %u bytes; %u of %u nodes in the grammar have a cold part.\n",
+      static_cast<unsigned int>(sizeof(node_t)),
+      static_cast<unsigned int>(node_t::cold_part_size()),
+      count.second,
+      count.first);
 }
 
 void
@@ -1743,6 +1952,14 @@ analyser_environment_t::log(wchar_t const * const fmt, ...) const
   str.reset(fmtstr_new_valist(fmt, &ap), fmtstr_delete);
   va_end(ap);
   
+  std::wstring * const log_buffer = m_thread_log_buffer.get();
+  
+  if (log_buffer != 0)
+  {
+    log_buffer->append(str.get());
+    return;
+  }
+  
   if (0 == mp_output_file)
   {
     std::wcerr << str.get() << std::flush;
@@ -1788,12 +2005,18 @@ namespace
   }
 }
 
-void
+/// Number all the nodes by 'overall_idx()' from 0.
+///
+/// \return The number of the nodes.
+///
+unsigned int
 analyser_environment_t::mark_number_for_all_nodes() const
 {
   unsigned int idx = 0;
   
   traverse_all_nodes(mark_number_for_one_node, 0, &idx);
+  
+  return idx;
 }
 
 void
@@ -1867,6 +2090,21 @@ analyser_environment_t::check_nonterminal_linking() const
 #endif
 }
 
+node_t const *
+analyser_environment_t::starting_rule_node() const
+{
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    if (true == node->is_starting_rule())
+    {
+      return node;
+    }
+  }
+  
+  assert(0);
+  return 0;
+}
+
 void
 analyser_environment_t::determine_node_position()
 {
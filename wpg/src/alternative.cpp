@@ -55,7 +55,7 @@ namespace
       assert(1 == node1->next_nodes().size());
       assert(1 == node2->next_nodes().size());
       
-      if (node1->name().compare(node2->name()) != 0)
+      if (node1->symbol_id() != node2->symbol_id())
       {
         return false;
       }
@@ -234,7 +234,7 @@ fork_alternative(
     else
     {
       // create a new node according to the original one.
-      node_t * const new_node = new node_t(node_in_orig_alternative);
+      node_t * const new_node = node_in_orig_alternative->ae()->create_node_copy(node_in_orig_alternative);
       assert(new_node != 0);
       
       create_new_node = true;
@@ -615,7 +615,7 @@ fork_alternative_with_some_duplicated_nodes(
   
   while (duplicate_source_node != real_dup_range_end)
   {
-    node_t * const new_node = new node_t(duplicate_source_node);
+    node_t * const new_node = duplicate_source_node->ae()->create_node_copy(duplicate_source_node);
     assert(new_node != 0);
     
     new_dup_nodes.push_back(new_node);
@@ -686,7 +686,12 @@ count_alternative_length(
   node_t * const alternative_start)
 {
   assert(alternative_start != 0);
-  assert(alternative_start->alternative_start() == alternative_start);
+  
+  // An epsilon alternative links the rule node to its rule
+  // end node directly, so that the rule end node is its
+  // 'alternative start', and it has no symbol.
+  assert((0 == alternative_start->name().size()) ||
+         (alternative_start->alternative_start() == alternative_start));
   
   unsigned int count = 0;
   
@@ -49,6 +49,8 @@ analyser_environment_t::parse_answer_lookahead(node_t * const node,
   curr_lookahead_set = &(node->lookahead_set());
   assert(curr_lookahead_set != 0);
   
+  lookahead_arena_t &lookahead_arena = node->rule_node()->lookahead_arena();
+  
   std::wstring src_str_i = src_str;
   
   for (;;)
@@ -92,11 +94,11 @@ analyser_environment_t::parse_answer_lookahead(node_t * const node,
       if (0 == str->compare(L"...EOF..."))
       {
         /// use rule end node to represent EOF.
-        node = new node_t(this, 0);
+        node = create_node(0);
       }
       else
       {
-        node = new node_t(this, 0, *(str.get()));
+        node = create_node(0, *(str.get()));
       }
       
       assert(node != 0);
@@ -106,7 +108,7 @@ analyser_environment_t::parse_answer_lookahead(node_t * const node,
       if (0 == result_lookahead_set)
       {
         result_lookahead_set =
-          curr_lookahead_set->insert_lookahead(node);
+          curr_lookahead_set->insert_lookahead(lookahead_arena, node);
       }
     }
   }
@@ -156,11 +158,11 @@ analyser_environment_t::parse_answer(std::wstring const &str,
         /// a[4] means a normal node whose dot number is 4.
         /// [4] means a rule end node whose dot number is 4.
         ///
-        new_node = new node_t(this, 0);
+        new_node = create_node(0);
       }
       else
       {
-        new_node = new node_t(this, 0, str.substr(0, pos));
+        new_node = create_node(0, str.substr(0, pos));
       }
       assert(new_node != 0);
       m_answer_nodes.push_back(new_node);
@@ -200,8 +200,8 @@ namespace
       {
         assert(1 == (*iter).lookahead_nodes().size());
         
-        if (0 == (*iter).lookahead_nodes().front()->name().compare(
-              la.mp_node->name()))
+        if ((*iter).lookahead_nodes().front()->symbol_id() ==
+            la.mp_node->symbol_id())
         {
           child_arranged_lookahead = &(*iter);
           find = true;
@@ -254,10 +254,27 @@ namespace
         // If there are no more lookahead node, then I can
         // finish the searching this time.
         
-        // The size of 'target_nodes' should
-        // be 1. If it is greater than 1, it means an
+        // The alternatives which start with the same symbol
+        // share this leaf, and they will be decided by the
+        // lookahead of their following nodes.
+        //
+        // Ex:
+        //
+        // S : a A a
+        //   | a a
+        //
+        // Both 'a' have the lookahead {a}, so that this
+        // leaf has both of them.
+        //
+        // If the symbols are different, the lookahead can
+        // not decide between them, and it means an
         // ambiguity is happened, and this rule node should
         // not be dumpped.
+        //
+        // In an EBNF rule, the same symbol comes from the
+        // same node in the main regex alternative, and the
+        // regex levels are decided by the first one.
+        if (false == orig_node.mp_node->ae()->using_pure_BNF())
         {
           assert(target_arranged_lookahead->target_nodes().size() <= 1);
           
@@ -270,11 +287,41 @@ namespace
             node_t const * const existed_node =
               target_arranged_lookahead->target_nodes().front().mp_node;
             
-            assert(0 == existed_node->name().compare(orig_node.mp_node->name()));
+            assert(existed_node->symbol_id() == orig_node.mp_node->symbol_id());
           }
           
           assert(1 == target_arranged_lookahead->target_nodes().size());
         }
+        else
+        {
+          if (target_arranged_lookahead->target_nodes().size() != 0)
+          {
+            node_t const * const existed_node =
+              target_arranged_lookahead->target_nodes().front().mp_node;
+            
+            if (existed_node->symbol_id() != orig_node.mp_node->symbol_id())
+            {
+              throw ga_exception_meet_ambiguity_t();
+            }
+          }
+          
+          bool is_added = false;
+          
+          BOOST_FOREACH(node_with_order_t const &node,
+                        target_arranged_lookahead->target_nodes())
+          {
+            if (node.mp_node == orig_node.mp_node)
+            {
+              is_added = true;
+              break;
+            }
+          }
+          
+          if (false == is_added)
+          {
+            target_arranged_lookahead->add_target_node(orig_node);
+          }
+        }
         
 #if defined(_DEBUG)
         std::list<node_with_order_t> const &tmp =
@@ -285,7 +332,7 @@ namespace
           // the node's name in the
           // 'm_target_nodes' should be the
           // same.
-          if (node1.mp_node->name().compare(tmp.front().mp_node->name()) != 0)
+          if (node1.mp_node->symbol_id() != tmp.front().mp_node->symbol_id())
           {
             throw ga_exception_meet_ambiguity_t();
           }
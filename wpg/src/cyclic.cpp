@@ -19,6 +19,7 @@
 
 #include "ae.hpp"
 #include "node.hpp"
+#include "scc.hpp"
 
 #include "wcl_memory_debugger\memory_debugger.h"
 
@@ -66,189 +67,42 @@
 /// S -> a | Xb | SS
 /// X -> Xb | SS | a
 
+/// Every unit production 'A -> B' is an edge 'A->B' of the
+/// rule graph, thus the cyclic nonterminals are exactly
+/// the rules of the recursive strongly connected
+/// components of that graph.
 void
-analyser_environment_t::detect_cyclic_nonterminal_for_one_rule(
-  node_t * const node,
-  std::list<node_t *> &stack,
-  std::list<std::list<node_t *> > &cyclic_set)
+analyser_environment_t::detect_cyclic_nonterminal()
 {
-  assert(true == node->is_rule_head());
+  rule_graph_t graph(m_top_level_nodes);
   
-  BOOST_FOREACH(node_t * const alternative_start, node->next_nodes())
+  BOOST_FOREACH(node_t * const rule_node, m_top_level_nodes)
   {
-    bool find_a_cyclic = false;
-    
-    // Try to find an alternative like 'A->B'.
-    if ((false == alternative_start->is_terminal()) &&
-        (alternative_start->is_my_next_node(
-          alternative_start->rule_node()->rule_end_node()
-                                            )))
+    BOOST_FOREACH(node_t * const alternative_start, rule_node->next_nodes())
     {
-      assert(alternative_start->nonterminal_rule_node() != 0);
-      
-      // search the nodes in 'stack' to see if one of
-      // them is the nonterminal node of the current
-      // alternative start node.
-      for (std::list<node_t *>::const_iterator iter2 = stack.begin();
-           iter2 != stack.end();
-           ++iter2)
+      // Try to find an alternative like 'A->B'.
+      if ((false == alternative_start->is_terminal()) &&
+          (alternative_start->is_my_next_node(rule_node->rule_end_node())))
       {
-        assert(true == (*iter2)->is_rule_head());
-        
-        if ((*iter2) == alternative_start->nonterminal_rule_node())
-        {
-          // If yes, this means:
-          //
-          // Ex:
-          //
-          // The current rule and the alternative are of
-          // the form 'A->B', and the stack contains node
-          // 'B'.
-          //
-          // This means I found a cyclic condition.
-          //
-          // Ex:
-          // 
-          // A -> B   ------ put 'B' into the stack
-          //   -> D e ------ this alternative will never be
-          //                 part of a cyclic, hence I will
-          //                 not examine this alternative.
-          // B -> C   ------ put 'C' into the stack.
-          // C -> B   ------ find a cyclic condition
-          //                 between 'B' & 'C'
-          std::list<node_t *> cyclic;
-            
-          for (std::list<node_t *>::const_iterator iter3 = iter2;
-               iter3 != stack.end();
-               ++iter3)
-          {
-            cyclic.push_back(*iter3);
-          }
-            
-          cyclic_set.push_back(cyclic);
-          
-          find_a_cyclic = true;
-        }
-      }
-      
-      if (true == find_a_cyclic)
-      {
-        // continue to scan the next alternative of this
-        // rule.
-        continue;
-      }
-      else
-      {
-        // If I traverse a _new_ nonterminal alternative
-        // start node, then put this node into the stack.
-        //
-        // Ex:
-        //
-        // A -> B   ------ put 'B' into the stack
-        //   -> D e ------ this alternative will never be
-        //                 part of a cyclic, hence I will
-        //                 not examine this alternative.
-        // B -> C   ------ put 'C' into the stack.
-        stack.push_back(alternative_start->nonterminal_rule_node());
+        assert(alternative_start->nonterminal_rule_node() != 0);
         
-        detect_cyclic_nonterminal_for_one_rule(
-          alternative_start->nonterminal_rule_node(),
-          stack,
-          cyclic_set);
-          
-        assert(stack.back() == alternative_start->nonterminal_rule_node());
-          
-        stack.pop_back();
+        graph.add_edge(rule_node, alternative_start->nonterminal_rule_node());
       }
     }
   }
-}
-
-void
-analyser_environment_t::merge_relative_set_into_final_set(
-  std::list<std::list<node_t *> > &set)
-{
-  for (std::list<std::list<node_t *> >::iterator iter = set.begin();
-       iter != set.end();
-       ++iter)
-  {
-    bool find_intersection = false;
-    
-    std::list<std::list<node_t *> >::iterator iter2 = iter;
-    
-    ++iter2;
-    
-    for (;
-         iter2 != set.end();
-         )
-    {
-      BOOST_FOREACH(node_t * const node, *(iter))
-      {
-        std::list<node_t *>::iterator check_iter =
-          check_if_one_node_is_belong_to_set_and_match_some_condition(
-            (*iter2),
-            node,
-            std::vector<check_node_func>());
-        
-        if (check_iter == (*iter2).end())
-        {
-          continue;
-        }
-        else
-        {
-          (*iter2).erase(check_iter);
-          
-          find_intersection = true;
-          
-          break;
-        }
-      }
-      
-      if (true == find_intersection)
-      {
-        (*iter).splice((*iter).end(), (*iter2));
-        iter2 = set.erase(iter2);
-      }
-      else
-      {
-        ++iter2;
-      }
-    }
-  }
-}
-
-void
-analyser_environment_t::detect_cyclic_nonterminal()
-{
-  BOOST_FOREACH(node_t * const rule_node, m_top_level_nodes)
+  
+  std::list<std::list<node_t *> > cyclic_set;
+  
+  graph.find_recursive_components(cyclic_set);
+  
+  BOOST_FOREACH(std::list<node_t *> &cyclic, cyclic_set)
   {
-    if (false == rule_node->is_cyclic())
+    BOOST_FOREACH(node_t * const node, cyclic)
     {
-      std::list<std::list<node_t *> > cyclic_set;
-      std::list<node_t *> stack;
+      assert(true == node->is_rule_head());
       
-      stack.push_back(rule_node);
-      
-      (void)detect_cyclic_nonterminal_for_one_rule(rule_node, stack, cyclic_set);
-      
-      merge_relative_set_into_final_set(cyclic_set);
-      
-      if (0 == cyclic_set.size())
-      {
-        // It is not a cyclic nonterminal.
-      }
-      else
-      {
-        BOOST_FOREACH(std::list<node_t *> &cyclic, cyclic_set)
-        {
-          BOOST_FOREACH(node_t * const node, cyclic)
-          {
-            assert(true == node->is_rule_head());
-            
-            node->assign_cyclic_set(cyclic);
-          }
-        }
-      }
+      node->clear_cyclic_set();
+      node->assign_cyclic_set(cyclic);
     }
   }
 }
@@ -318,7 +172,7 @@ namespace
       }
       else
       {
-        node_t * const node = new node_t(node2_child);
+        node_t * const node = node2_child->ae()->create_node_copy(node2_child);
         assert(node != 0);
       
         node->set_rule_node(node1->rule_node());
@@ -345,13 +345,13 @@ namespace
   void
   construct_path_and_dump(std::wfstream &fp,
                           std::vector<node_t *> &path,
-                          std::list<lookahead_set_t> const &lookahead_set)
+                          lookahead_level_t const &lookahead_set)
   {
 #if defined(_DEBUG)
     std::vector<node_t *>::size_type const level = path.size();
 #endif
     
-    for (std::list<lookahead_set_t>::const_iterator iter = lookahead_set.begin();
+    for (lookahead_level_t::const_iterator iter = lookahead_set.begin();
          iter != lookahead_set.end();
          ++iter)
     {
@@ -30,97 +30,118 @@
 
 typedef node_t *node_t_ptr;
 
-namespace
-{    
-  void
-  go_further_one_node(std::list<node_with_order_t> &nodes)
+void
+go_further_one_node(std::list<node_with_order_t> &nodes)
+{
+  for (std::list<node_with_order_t>::iterator iter = nodes.begin();
+       iter != nodes.end();
+       )
   {
-    for (std::list<node_with_order_t>::iterator iter = nodes.begin();
-         iter != nodes.end();
-         )
+    if (0 == (*iter).mp_node->next_nodes().size())
     {
-      if (0 == (*iter).mp_node->next_nodes().size())
-      {
-        /* This is a rule end node, I can not trace
-         * further from this node, thus kick it out
-         * from the tracing list.
-         */
-        assert(0 == (*iter).mp_node->name().size());
-        iter = nodes.erase(iter);
-      }
-      else
-      {
-        /* I have finish this node in one
-         * alternative, thus walk to the next node.
-         */
-        assert(1 == (*iter).mp_node->next_nodes().size());
-        
-        (*iter).mp_node = (*iter).mp_node->next_nodes().front();
-        
-        ++iter;
-      }
+      /* This is a rule end node, I can not trace
+       * further from this node, thus kick it out
+       * from the tracing list.
+       */
+      assert(0 == (*iter).mp_node->name().size());
+      iter = nodes.erase(iter);
     }
-  }
-  
-  void
-  go_further_one_node(node_t_ptr &node)
-  {
-    assert(1 == node->next_nodes().size());
-    node = node->next_nodes().front();
-  }
-      
-  nodes_have_lookahead_rel_t
-  all_nodes_have_lookahead(std::list<node_with_order_t> const &nodes)
-  {
-    std::list<node_with_order_t>::size_type have_lk_node_count = 0;
-    std::list<node_with_order_t>::size_type havent_lk_node_count = 0;
-    
-    BOOST_FOREACH(node_with_order_t const &node, nodes)
+    else
     {
-      if (node.mp_node->lookahead_depth() != 0)
-      {
-        ++have_lk_node_count;
-      }
-      else
-      {
-        ++havent_lk_node_count;
-      }
+      /* I have finish this node in one
+       * alternative, thus walk to the next node.
+       */
+      assert(1 == (*iter).mp_node->next_nodes().size());
+      
+      (*iter).mp_node = (*iter).mp_node->next_nodes().front();
+      
+      ++iter;
     }
+  }
+}
+
+void
+go_further_one_node(node_t_ptr &node)
+{
+  assert(1 == node->next_nodes().size());
+  node = node->next_nodes().front();
+}
     
-    assert(nodes.size() == (have_lk_node_count + havent_lk_node_count));
-    
-    if (0 == have_lk_node_count)
-    {
-      return NO_NODES_HAVE_LOOKAHEAD;
-    }
-    else if (0 == havent_lk_node_count)
+nodes_have_lookahead_rel_t
+all_nodes_have_lookahead(std::list<node_with_order_t> const &nodes)
+{
+  std::list<node_with_order_t>::size_type have_lk_node_count = 0;
+  std::list<node_with_order_t>::size_type havent_lk_node_count = 0;
+  
+  BOOST_FOREACH(node_with_order_t const &node, nodes)
+  {
+    if (node.mp_node->lookahead_depth() != 0)
     {
-      return ALL_NODES_HAVE_LOOKAHEAD;
+      ++have_lk_node_count;
     }
     else
     {
-      return PART_NODES_HAVE_LOOKAHEAD;
+      ++havent_lk_node_count;
     }
   }
   
-  void
-  check_ambiguity(std::list<node_with_order_t> const &nodes)
+  assert(nodes.size() == (have_lk_node_count + havent_lk_node_count));
+  
+  if (0 == have_lk_node_count)
   {
-    BOOST_FOREACH(node_with_order_t const &node, nodes)
-    {    
-      if (true == node.mp_node->is_ambigious())
-      {
-        throw ga_exception_meet_ambiguity_t();
-      }
+    return NO_NODES_HAVE_LOOKAHEAD;
+  }
+  else if (0 == havent_lk_node_count)
+  {
+    return ALL_NODES_HAVE_LOOKAHEAD;
+  }
+  else
+  {
+    return PART_NODES_HAVE_LOOKAHEAD;
+  }
+}
+
+void
+check_ambiguity(std::list<node_with_order_t> const &nodes)
+{
+  BOOST_FOREACH(node_with_order_t const &node, nodes)
+  {    
+    if (true == node.mp_node->is_ambigious())
+    {
+      throw ga_exception_meet_ambiguity_t();
     }
   }
+}
+
+namespace
+{
+  /// The name of the local variable in parse_XXX holding
+  /// 'node' before I know which alternative it belongs to,
+  /// ex: XXX_node_0.
+  std::wstring
+  local_variable_name_for_one_node(
+    node_t const * const node)
+  {
+    std::wstringstream ss;
     
+    ss << node->name() << "_node_" << node->name_postfix_by_appear_times();
+    
+    return ss.str();
+  }
+  
   // \brief Dump leaf node group in the arranged lookahead
   // tree
   //
   // All nodes in this node group must have the same name
   // and equal lookahead depth and symbols.
   //
+  // If there is only one node in this node group, I have
+  // already known which alternative I am parsing, and
+  // constructed its production node, so that the parsed
+  // node is assigned to its member directly. Otherwise, the
+  // parsed node is kept in a local variable until I know
+  // the alternative.
+  //
   // \param file
   // \param tmp
   // \param indent_depth
@@ -143,7 +164,73 @@ namespace
     }
 #endif
     
-    dump_add_node_to_nodes_for_one_node_in_parse_XXX(file, nodes.front().mp_node, indent_depth);
+    node_t const * const node = nodes.front().mp_node;
+    std::wstringstream destination;
+    
+    if (1 == nodes.size())
+    {
+      destination << "prod" << nodes.front().m_idx << "_node->"
+                  << member_variable_name_for_one_node(node);
+    }
+    else
+    {
+      destination << "pt_" << node->name() << "_node_t * const "
+                  << local_variable_name_for_one_node(node);
+    }
+    
+    dump_parse_one_node_in_parse_XXX(file, node, destination.str(), indent_depth);
+  }
+  
+  // \brief Dump the construction of the production node
+  //
+  // I call this function when 'node' becomes the only
+  // node in its node group, that is to say, I know which
+  // alternative I am parsing now. The nodes before 'node'
+  // in this alternative are shared with other alternatives,
+  // and they have been parsed into local variables, so that
+  // I move them into the production node here.
+  //
+  // \param file
+  // \param rule_node
+  // \param node
+  // \param indent_depth
+  void
+  dump_prod_node_construction(
+    std::wfstream &file,
+    node_t const * const rule_node,
+    node_with_order_t const &node,
+    unsigned int const indent_depth)
+  {
+    assert(node.m_idx < rule_node->next_nodes().size());
+    
+    std::list<node_t *>::const_iterator iter = rule_node->next_nodes().begin();
+    std::advance(iter, node.m_idx);
+    
+    file << indent_line(indent_depth) << "pt_" << rule_node->name() << "_prod" << node.m_idx
+         << "_node_t * const prod" << node.m_idx << "_node = "
+         << new_node_expression(rule_node->ae(), L"m_node_arena")
+         << "pt_" << rule_node->name() << "_prod" << node.m_idx << "_node_t;" << std::endl
+         << indent_line(indent_depth) << "assert(prod" << node.m_idx << "_node != 0);" << std::endl
+         << std::endl
+         << indent_line(indent_depth) << "assert(0 == prod_node);" << std::endl
+         << indent_line(indent_depth) << "prod_node = prod" << node.m_idx << "_node;" << std::endl;
+    
+    for (node_t const *curr_node = *iter;
+         curr_node != node.mp_node;
+         curr_node = curr_node->next_nodes().front())
+    {
+      assert(1 == curr_node->next_nodes().size());
+      
+      file << indent_line(indent_depth) << "prod" << node.m_idx << "_node->"
+           << member_variable_name_for_one_node(curr_node) << " = "
+           << local_variable_name_for_one_node(curr_node) << ";" << std::endl;
+    }
+    
+    // Nothing follows the rule end node.
+    if (node.mp_node->name().size() != 0)
+    {
+      file << std::endl;
+    }
   }
       
   void
@@ -168,14 +255,11 @@ namespace
         // EOF
         file << "EOF:" << std::endl;
         
-        // if one of the last lookahead symbol is EOF, then
-        // 'target_nodes()' should be 1,
-        // otherwise, this will result a duplicate
-        // alternative error.
-        assert(1 == child_arranged_lookahead.lookahead_nodes().size());
-        assert(0 == child_arranged_lookahead.lookahead_nodes().
-               front()->name().size());
-        
+        // EOF may share this case with other terminals which
+        // can follow the same alternative, ex: the FOLLOW set
+        // of a rule after Paull's algorithm, "A: a A' | a"
+        // where "A" is followed by "a" or EOF.
+        //
         // If there is an EOF node here, then the nodes
         // which can be merged with EOF node can not have
         // any children nodes, because an EOF node should
@@ -192,6 +276,103 @@ namespace
     }
   }
     
+  /// The smallest token class of a case which I test by a
+  /// mask instead of 'case' labels.
+  size_t const TOKEN_CLASS_MASK_MIN_SIZE = 4;
+  
+  /// The number of the 32 bits words of a token class
+  /// mask, for 64, 128, or 256 token types; 0 if there are
+  /// more token types, and I use 'case' labels only.
+  size_t
+  token_class_mask_word_count(
+    analyser_environment_t const * const ae)
+  {
+    size_t const token_type_count = ae->token_type_count();
+    
+    if (token_type_count <= 64)
+    {
+      return 2;
+    }
+    else if (token_type_count <= 128)
+    {
+      return 4;
+    }
+    else if (token_type_count <= 256)
+    {
+      return 8;
+    }
+    else
+    {
+      return 0;
+    }
+  }
+  
+  /// The enumerator of the token type of a lookahead node,
+  /// ex: WDS_TOKEN_TYPE_IDENT.
+  std::wstring
+  token_type_enumerator(
+    node_t const * const node)
+  {
+    // An empty name is EOF.
+    std::wstring name = (0 == node->name().size()) ? std::wstring(L"EOF") : node->name();
+    
+    // transform it to all capital letters.
+    std::transform(name.begin(), name.end(), name.begin(), towupper);
+    
+    return L"WDS_TOKEN_TYPE_" + name;
+  }
+  
+  /// Dump the mask of the token class of a case of the
+  /// arranged lookahead tree, ex:
+  ///
+  ///   // lparen|ident|number|minus
+  ///   static wds_uint32 const token_1_class_0[2] = { 0x000000d2U, 0x00000000U };
+  ///
+  /// The bit 'n' of the mask is set if the token type of
+  /// value 'n' is in the class.
+  void
+  dump_token_class_mask(
+    std::wfstream &file,
+    analyser_environment_t const * const ae,
+    arranged_lookahead_t const &arranged_lookahead,
+    size_t const mask_word_count,
+    unsigned int const lookahead_depth,
+    size_t const class_index,
+    unsigned int const indent_depth)
+  {
+    std::vector<unsigned long> mask(mask_word_count, 0);
+    
+    file << indent_line(indent_depth) << "// ";
+    
+    BOOST_FOREACH(node_t const * const node, arranged_lookahead.lookahead_nodes())
+    {
+      size_t const value = ae->token_type_value(node->name());
+      
+      assert((value >> 5) < mask_word_count);
+      
+      mask[value >> 5] |= (1UL << (value & 31));
+      
+      if (node != arranged_lookahead.lookahead_nodes().front())
+      {
+        file << "|";
+      }
+      
+      file << ((0 == node->name().size()) ? std::wstring(L"EOF") : node->name());
+    }
+    
+    file << std::endl
+         << indent_line(indent_depth) << "static wds_uint32 const token_" << lookahead_depth
+         << "_class_" << class_index << "[" << mask_word_count << "] = {";
+    
+    for (size_t i = 0; i < mask_word_count; ++i)
+    {
+      file << ((0 == i) ? " " : ", ") << "0x" << std::hex << std::setw(8) << std::setfill(L'0')
+           << mask[i] << std::dec << std::setfill(L' ') << "U";
+    }
+    
+    file << " };" << std::endl;
+  }
+  
   void
   traverse_arranged_lookahead(
     std::wfstream &file,
@@ -201,261 +382,458 @@ namespace
     arranged_lookahead_t const * const arranged_lookahead,
     unsigned int const indent_depth,
     unsigned int const lookahead_depth,
+    node_t const * const default_node);
+  
+  /// Dump the statements of the case of a lookahead
+  /// token, except the 'default' one, in the arranged
+  /// lookahead tree, at 'indent_depth'. They are the same
+  /// in a 'case' of the switch and in the early 'if' of
+  /// the '--profile' option.
+  void
+  dump_arranged_lookahead_case(
+    std::wfstream &file,
+    std::list<node_with_order_t> &nodes,
+    node_t const * const rule_node,
+    arranged_lookahead_t const * const arranged_lookahead_top,
+    arranged_lookahead_t const &child_arranged_lookahead,
+    unsigned int const indent_depth,
+    unsigned int const lookahead_depth,
     node_t const * const default_node)
   {
-    // If I meet an ambiguious situation, I have to return.
-    check_ambiguity(nodes);
-    
-    // emit token fetching string & the 'switch' statement head.
-    file << indent_line(indent_depth) << "token_t * const token_" << lookahead_depth
-         << " = lexer_peek_token(" << lookahead_depth << ");" << std::endl
-         << indent_line(indent_depth) << "switch (token_" << lookahead_depth << "->get_type())" << std::endl
-         << indent_line(indent_depth) << "{" << std::endl;
-    
-    // emit 'case' statement string for each lookahead token.
-    BOOST_FOREACH(arranged_lookahead_t const &child_arranged_lookahead,
-                  arranged_lookahead->children())
+    // Check if I am the following situation.
+    // Ex:
+    // lookahead tree:
+    //
+    // A - B
+    //   \ C
+    //   \ D
+    //
+    // This should be emitted as
+    //
+    // switch ()
+    // {
+    // case A:
+    //   switch ()
+    //   {
+    //   case B:
+    //   case C:
+    //   case D:
+    //
+    // And I am in 'A' now.
+    //
+    if (child_arranged_lookahead.children().size() > 0)
     {
-      // Check if this is a 'default' node, if yes, then
-      // emit the 'default:' string.
-      if (child_arranged_lookahead.lookahead_nodes().front() == default_node)
+      assert(0 == child_arranged_lookahead.target_nodes().size());
+      
+      // emit another fetching token string & another
+      // switch statement for the child lookahead.
+      traverse_arranged_lookahead(file,
+                                  nodes,
+                                  rule_node,
+                                  arranged_lookahead_top,
+                                  &(child_arranged_lookahead),
+                                  indent_depth,
+                                  lookahead_depth + 1,
+                                  default_node);
+    }
+    else
+    {
+      // This is a leaf node of the arranged
+      // lookahead tree.
+      std::list<node_with_order_t> same_lookahead_nodes =
+        child_arranged_lookahead.target_nodes();
+      
+      assert(same_lookahead_nodes.size() > 0);
+      
+      dump_stats_case_counter(file,
+                              rule_node->ae(),
+                              rule_node->name(),
+                              &child_arranged_lookahead,
+                              default_node,
+                              indent_depth);
+      
+      // The lookahead symbols have decided the
+      // alternative.
+      if (1 == same_lookahead_nodes.size())
       {
-        // the number of the 'default' node should be 1.
-        assert(1 == child_arranged_lookahead.lookahead_nodes().size());
-        
-        file << indent_line(indent_depth) << "default:" << std::endl
-             << indent_line(indent_depth + 1) << "throw std::exception();" << std::endl;
+        dump_prod_node_construction(
+          file,
+          rule_node,
+          same_lookahead_nodes.front(),
+          indent_depth);
       }
-      else
+      
+      // Nothing more to dump if this alternative
+      // finishes.
+      if ((same_lookahead_nodes.size() != 1) ||
+          (same_lookahead_nodes.front().mp_node->name().size() != 0))
       {
-        // the number of the other nodes could be greater
-        // than 1.
-        //
-        // emit 'case xxx:' string for each lookahead token.
-        dump_case_stmt_for_node(file, child_arranged_lookahead,
-                                default_node, indent_depth);
-        
-        file << indent_line(indent_depth + 1) << "{" << std::endl;
+        // If there are more than 1 node in the
+        // 'target_nodes()', then these
+        // nodes' must have the same name, otherwise this
+        // means that I meet an ambigious situation.
+        BOOST_FOREACH(node_with_order_t const &node, same_lookahead_nodes)
+        {
+          if (node.mp_node->name().compare(
+                same_lookahead_nodes.front().mp_node->name()
+                                           ) != 0)
+          {
+            // ambigious
+            throw ga_exception_meet_ambiguity_t();
+          }
+        }
+                    
+        // dump string now.
+        dump_leaf_node_group_in_lookahead_tree(
+          file,
+          same_lookahead_nodes,
+          indent_depth);
         
-        // Check if I am the following situation.
-        // Ex:
-        // lookahead tree:
-        //
-        // A - B
-        //   \ C
-        //   \ D
-        //
-        // This should be emitted as
-        //
-        // switch ()
-        // {
-        // case A:
-        //   switch ()
-        //   {
-        //   case B:
-        //   case C:
-        //   case D:
+        // go further one step.
+        go_further_one_node(same_lookahead_nodes);
+      
+        // dump generated string according to equal nodes.
         //
-        // And I am in 'A' now.
+        // Ex:
+        // A B C D
+        // A B E F
+        // A B G H
         //
-        if (child_arranged_lookahead.children().size() > 0)
-        {
-          assert(0 == child_arranged_lookahead.target_nodes().size());
-          
-          // emit another fetching token string & another
-          // switch statement for the child lookahead.
-          traverse_arranged_lookahead(file,
-                                      nodes,
-                                      rule_node,
-                                      arranged_lookahead_top,
-                                      &(child_arranged_lookahead),
-                                      indent_depth + 2,
-                                      lookahead_depth + 1,
-                                      default_node);
-        }
-        else
+        // Then I have to dump strings for 'A B' now.
+        for (;;)
         {
-          // This is a leaf node of the arranged
-          // lookahead tree.
-          std::list<node_with_order_t> same_lookahead_nodes =
-            child_arranged_lookahead.target_nodes();
-          
-          assert(same_lookahead_nodes.size() > 0);
-          
-          if ((1 == same_lookahead_nodes.size()) &&
-              (0 == same_lookahead_nodes.front().mp_node->name().size()))
-          {
-            file << indent_line(indent_depth + 2) << "if (true == consume)" << std::endl
-                 << indent_line(indent_depth + 2) << "{" << std::endl
-                 << indent_line(indent_depth + 3) << "assert(0 == prod_node);" << std::endl
-                 << indent_line(indent_depth + 3) << "prod_node = new pt_" << rule_node->name() << "_prod" << same_lookahead_nodes.front().m_idx << "_node_t;" << std::endl
-                 << indent_line(indent_depth + 3) << "assert(prod_node != 0);" << std::endl
-                 << indent_line(indent_depth + 2) << "}" << std::endl;
-          }
-          else
+          bool finish = false;
+        
+          switch (all_nodes_have_lookahead(same_lookahead_nodes))
           {
-            // If there are more than 1 node in the
-            // 'target_nodes()', then these
-            // nodes' must have the same name, otherwise this
-            // means that I meet an ambigious situation.
-            BOOST_FOREACH(node_with_order_t const &node, same_lookahead_nodes)
+          case NO_NODES_HAVE_LOOKAHEAD:
+            // no lookahead means I can dump strings
+            // immediately, and do not need to arrange and go
+            // through the lookahead tree.
+            if ((1 == same_lookahead_nodes.size()) &&
+                (0 == same_lookahead_nodes.front().mp_node->name().size()))
             {
-              if (node.mp_node->name().compare(
-                    same_lookahead_nodes.front().mp_node->name()
-                                               ) != 0)
-              {
-                // ambigious
-                throw ga_exception_meet_ambiguity_t();
-              }
-            }
-                        
-            // dump string now.
-            dump_leaf_node_group_in_lookahead_tree(
-              file,
-              same_lookahead_nodes,
-              indent_depth + 2);
+              // If we are checking only one node, and this is a
+              // rule end node, then this means we have finish
+              // this alternative, thus just return.
             
-            // go further one step.
-            go_further_one_node(same_lookahead_nodes);
-          
-            // dump generated string according to equal nodes.
-            //
-            // Ex:
-            // A B C D
-            // A B E F
-            // A B G H
-            //
-            // Then I have to dump strings for 'A B' now.
-            for (;;)
+              // If this is a one alternative rule, then finish
+              // this function.
+            
+              // If this alternative finishes, its
+              // production node has been constructed when
+              // the node group had only one node.
+              finish = true;
+              break;
+            }
+            else
             {
-              bool finish = false;
+              // dump string now.
+              dump_leaf_node_group_in_lookahead_tree(
+                file,
+                same_lookahead_nodes,
+                indent_depth);
+            }
+            break;
             
-              switch (all_nodes_have_lookahead(same_lookahead_nodes))
+          case ALL_NODES_HAVE_LOOKAHEAD:
+            if (1 == same_lookahead_nodes.size())
+            {
+              // The lookahead of this node decides between
+              // other alternatives, not this one, so that
+              // I go on parsing this alternative.
+              if (0 == same_lookahead_nodes.front().mp_node->name().size())
               {
-              case NO_NODES_HAVE_LOOKAHEAD:
-                // no lookahead means I can dump strings
-                // immediately, and do not need to arrange and go
-                // through the lookahead tree.
-                if ((1 == same_lookahead_nodes.size()) &&
-                    (0 == same_lookahead_nodes.front().mp_node->name().size()))
-                {
-                  // If we are checking only one node, and this is a
-                  // rule end node, then this means we have finish
-                  // this alternative, thus just return.
-                
-                  // If this is a one alternative rule, then finish
-                  // this function.
-                
-                  // If this alternative finishes...
-                  file << std::endl
-                       << indent_line(indent_depth + 2) << "if (true == consume)" << std::endl
-                       << indent_line(indent_depth + 2) << "{" << std::endl
-                       << indent_line(indent_depth + 3) << "assert(0 == prod_node);" << std::endl
-                       << indent_line(indent_depth + 3) << "prod_node = new pt_" << rule_node->name() << "_prod" << same_lookahead_nodes.front().m_idx << "_node_t;" << std::endl
-                       << indent_line(indent_depth + 3) << "assert(prod_node != 0);" << std::endl
-                       << indent_line(indent_depth + 2) << "}" << std::endl;
-                
-                  finish = true;
-                  break;
-                }
-                else
-                {
-                  // dump string now.
-                  dump_leaf_node_group_in_lookahead_tree(
-                    file,
-                    same_lookahead_nodes,
-                    indent_depth + 2);
-                }
-                break;
-                
-              case ALL_NODES_HAVE_LOOKAHEAD:
-                if (1 == same_lookahead_nodes.size())
-                {
-                  if (0 == same_lookahead_nodes.front().mp_node->name().size())
-                  {
-                    file << std::endl
-                         << indent_line(indent_depth + 2) << "if (true == consume)" << std::endl
-                         << indent_line(indent_depth + 2) << "{" << std::endl
-                         << indent_line(indent_depth + 3) << "assert(0 == prod_node);" << std::endl
-                         << indent_line(indent_depth + 3) << "prod_node = new pt_" << rule_node->name() << "_prod" << same_lookahead_nodes.front().m_idx << "_node_t;" << std::endl
-                         << indent_line(indent_depth + 3) << "assert(prod_node != 0);" << std::endl
-                         << indent_line(indent_depth + 2) << "}" << std::endl;
-                    
-                    finish = true;
-                    break;
-                  }
-                  else
-                  {
-                    dump_leaf_node_group_in_lookahead_tree(
-                      file,
-                      same_lookahead_nodes,
-                      indent_depth + 2);
-                  }
-                }
-                else
-                {
-                  boost::shared_ptr<arranged_lookahead_t> new_arranged_lookahead(
-                    collect_lookahead_into_arrange_lookahead(same_lookahead_nodes,
-                                                             default_node));
-                  
-                  merge_arranged_lookahead_tree_leaf_node_if_they_have_same_target_node(
-                    new_arranged_lookahead.get(),
-                    default_node);
-                  
-                  traverse_arranged_lookahead(file,
-                                              same_lookahead_nodes,
-                                              rule_node,
-                                              new_arranged_lookahead.get(),
-                                              new_arranged_lookahead.get(),
-                                              indent_depth + 2,
-                                              lookahead_depth + 1,
-                                              default_node);
-                }
-                
                 finish = true;
-                break;
-              
-              case PART_NODES_HAVE_LOOKAHEAD:
-                // Should not reach here.
-              default:
-                assert(0);
-                break;
-              }
-              
-              if (true == finish)
-              {
-                break;
               }
               else
               {
-                // go further one step.
-                go_further_one_node(same_lookahead_nodes);
+                dump_leaf_node_group_in_lookahead_tree(
+                  file,
+                  same_lookahead_nodes,
+                  indent_depth);
               }
+              break;
+            }
+            else
+            {
+              boost::shared_ptr<arranged_lookahead_t> new_arranged_lookahead(
+                collect_lookahead_into_arrange_lookahead(same_lookahead_nodes,
+                                                         default_node));
+              
+              merge_arranged_lookahead_tree_leaf_node_if_they_have_same_target_node(
+                new_arranged_lookahead.get(),
+                default_node);
+              
+              order_arranged_lookahead_by_profile(rule_node->ae(),
+                                                  rule_node->name(),
+                                                  new_arranged_lookahead.get(),
+                                                  default_node);
+              
+              traverse_arranged_lookahead(file,
+                                          same_lookahead_nodes,
+                                          rule_node,
+                                          new_arranged_lookahead.get(),
+                                          new_arranged_lookahead.get(),
+                                          indent_depth,
+                                          lookahead_depth + 1,
+                                          default_node);
             }
+            
+            finish = true;
+            break;
+          
+          case PART_NODES_HAVE_LOOKAHEAD:
+            // Should not reach here.
+          default:
+            assert(0);
+            break;
+          }
+          
+          if (true == finish)
+          {
+            break;
+          }
+          else
+          {
+            // go further one step.
+            go_further_one_node(same_lookahead_nodes);
           }
         }
-        
-        file << indent_line(indent_depth + 1) << "}" << std::endl
-             << indent_line(indent_depth + 1) << "break;" << std::endl << std::endl;
       }
     }
-    
-    file << indent_line(indent_depth) << "}" << std::endl;
   }
-}
-
-void
-dump_gen_parser_src_real(
-  std::wfstream &file,
-  node_t const * const rule_node,
-  node_t const * const default_node,
-  std::list<node_with_order_t> &nodes,
-  unsigned int const indent_depth)
-{
-  // If I meet an ambiguious situation, I have to return.
-  check_ambiguity(nodes);
+  
+  void
+  traverse_arranged_lookahead(
+    std::wfstream &file,
+    std::list<node_with_order_t> &nodes,
+    node_t const * const rule_node,
+    arranged_lookahead_t const * const arranged_lookahead_top,
+    arranged_lookahead_t const * const arranged_lookahead,
+    unsigned int const indent_depth,
+    unsigned int const lookahead_depth,
+    node_t const * const default_node)
+  {
+    // If I meet an ambiguious situation, I have to return.
+    check_ambiguity(nodes);
     
-  // dump generated string according to equal nodes.
+    // 'lookahead_depth' keeps the token variables of the
+    // nested switches apart, but a switch after some
+    // shared nodes have been parsed peeks from the next
+    // token again, so that the token to peek is the level
+    // of 'arranged_lookahead' in its own tree.
+    unsigned int peek_depth = 1;
+    
+    for (arranged_lookahead_t const *level = arranged_lookahead;
+         level != arranged_lookahead_top;
+         level = level->parent())
+    {
+      ++peek_depth;
+    }
+    
+    // emit token fetching string.
+    file << indent_line(indent_depth) << "token_t * const token_" << lookahead_depth
+         << " = lexer_peek_token(" << peek_depth << ");" << std::endl;
+    
+    // Before the switch, I test the cases which need no
+    // switch by 'if': with the '--profile' option, the case
+    // taking most of this level, and then each leaf case
+    // with a large token class, by a bit test in the mask
+    // of its class. The switch of the other cases, if any,
+    // becomes the 'else' (cold) path.
+    arranged_lookahead_t const * const dominant_case =
+      dominant_case_in_profile(rule_node->ae(),
+                               rule_node->name(),
+                               arranged_lookahead,
+                               default_node);
+    size_t const mask_word_count = token_class_mask_word_count(rule_node->ae());
+    std::list<arranged_lookahead_t const *> if_cases;
+    size_t switch_case_count = 0;
+    bool has_default_case = false;
+    
+    if (dominant_case != 0)
+    {
+      if_cases.push_back(dominant_case);
+    }
+    
+    BOOST_FOREACH(arranged_lookahead_t const &child_arranged_lookahead,
+                  arranged_lookahead->children())
+    {
+      if (child_arranged_lookahead.lookahead_nodes().front() == default_node)
+      {
+        has_default_case = true;
+      }
+      else if (&child_arranged_lookahead == dominant_case)
+      {
+        // It is tested already.
+      }
+      else if ((mask_word_count != 0) &&
+               (0 == child_arranged_lookahead.children().size()) &&
+               (child_arranged_lookahead.lookahead_nodes().size() >= TOKEN_CLASS_MASK_MIN_SIZE))
+      {
+        if_cases.push_back(&child_arranged_lookahead);
+      }
+      else
+      {
+        ++switch_case_count;
+      }
+    }
+    
+    unsigned int switch_indent_depth = indent_depth;
+    size_t class_count = 0;
+    
+    BOOST_FOREACH(arranged_lookahead_t const * const if_case, if_cases)
+    {
+      if (if_case != dominant_case)
+      {
+        dump_token_class_mask(file,
+                              rule_node->ae(),
+                              *if_case,
+                              mask_word_count,
+                              lookahead_depth,
+                              class_count,
+                              indent_depth);
+        ++class_count;
+      }
+    }
+    
+    class_count = 0;
+    
+    BOOST_FOREACH(arranged_lookahead_t const * const if_case, if_cases)
+    {
+      file << indent_line(indent_depth) << ((if_case == if_cases.front()) ? "if (" : "else if (");
+      
+      if (if_case == dominant_case)
+      {
+        file << "WDS_LIKELY(";
+        
+        BOOST_FOREACH(node_t const * const node, if_case->lookahead_nodes())
+        {
+          if (node != if_case->lookahead_nodes().front())
+          {
+            file << " || ";
+          }
+          
+          file << "(" << token_type_enumerator(node) << " == token_" << lookahead_depth << "->get_type())";
+        }
+        
+        file << ")";
+      }
+      else
+      {
+        file << "WDS_TOKEN_IN_CLASS(token_" << lookahead_depth << "_class_" << class_count
+             << ", token_" << lookahead_depth << "->get_type())";
+        ++class_count;
+      }
+      
+      file << ")" << std::endl
+           << indent_line(indent_depth) << "{" << std::endl;
+      
+      dump_arranged_lookahead_case(file,
+                                   nodes,
+                                   rule_node,
+                                   arranged_lookahead_top,
+                                   *if_case,
+                                   indent_depth + 1,
+                                   lookahead_depth,
+                                   default_node);
+      
+      file << indent_line(indent_depth) << "}" << std::endl;
+    }
+    
+    if (if_cases.size() != 0)
+    {
+      if (0 == switch_case_count)
+      {
+        if (true == has_default_case)
+        {
+          file << indent_line(indent_depth) << "else" << std::endl
+               << indent_line(indent_depth) << "{" << std::endl
+               << indent_line(indent_depth + 1) << "throw std::exception();" << std::endl
+               << indent_line(indent_depth) << "}" << std::endl;
+        }
+        
+        return;
+      }
+      
+      file << indent_line(indent_depth) << "else" << std::endl
+           << indent_line(indent_depth) << "{" << std::endl;
+      
+      switch_indent_depth = indent_depth + 1;
+    }
+    
+    // emit the 'switch' statement head.
+    file << indent_line(switch_indent_depth) << "switch (token_" << lookahead_depth << "->get_type())" << std::endl
+         << indent_line(switch_indent_depth) << "{" << std::endl;
+    
+    // emit 'case' statement string for each lookahead token.
+    BOOST_FOREACH(arranged_lookahead_t const &child_arranged_lookahead,
+                  arranged_lookahead->children())
+    {
+      // Check if this is a 'default' node, if yes, then
+      // emit the 'default:' string.
+      if (child_arranged_lookahead.lookahead_nodes().front() == default_node)
+      {
+        // the number of the 'default' node should be 1.
+        assert(1 == child_arranged_lookahead.lookahead_nodes().size());
+        
+        file << indent_line(switch_indent_depth) << "default:" << std::endl
+             << indent_line(switch_indent_depth + 1) << "throw std::exception();" << std::endl;
+      }
+      else if (if_cases.end() == std::find(if_cases.begin(), if_cases.end(), &child_arranged_lookahead))
+      {
+        // the number of the other nodes could be greater
+        // than 1.
+        //
+        // emit 'case xxx:' string for each lookahead token.
+        dump_case_stmt_for_node(file, child_arranged_lookahead,
+                                default_node, switch_indent_depth);
+        
+        file << indent_line(switch_indent_depth + 1) << "{" << std::endl;
+        
+        dump_arranged_lookahead_case(file,
+                                     nodes,
+                                     rule_node,
+                                     arranged_lookahead_top,
+                                     child_arranged_lookahead,
+                                     switch_indent_depth + 2,
+                                     lookahead_depth,
+                                     default_node);
+        
+        file << indent_line(switch_indent_depth + 1) << "}" << std::endl
+             << indent_line(switch_indent_depth + 1) << "break;" << std::endl << std::endl;
+      }
+    }
+    
+    file << indent_line(switch_indent_depth) << "}" << std::endl;
+    
+    if (if_cases.size() != 0)
+    {
+      file << indent_line(indent_depth) << "}" << std::endl;
+    }
+  }
+}
+
+void
+dump_gen_parser_src_real(
+  std::wfstream &file,
+  node_t const * const rule_node,
+  node_t const * const default_node,
+  std::list<node_with_order_t> &nodes,
+  unsigned int const indent_depth)
+{
+  // If I meet an ambiguious situation, I have to return.
+  check_ambiguity(nodes);
+  
+  // If this rule has only one alternative, I can construct
+  // its production node first.
+  if (1 == nodes.size())
+  {
+    dump_prod_node_construction(file, rule_node, nodes.front(), indent_depth);
+  }
+    
+  // dump generated string according to equal nodes.
   //
   // Ex:
   // A B C D
@@ -484,15 +862,8 @@ dump_gen_parser_src_real(
         // If this is a one alternative rule, then finish
         // this function.
         
-        // If this alternative finishes...
-        file << std::endl
-             << indent_line(indent_depth) << "if (true == consume)" << std::endl
-             << indent_line(indent_depth) << "{" << std::endl
-             << indent_line(indent_depth + 1) << "assert(0 == prod_node);" << std::endl
-             << indent_line(indent_depth + 1) << "prod_node = new pt_" << rule_node->name() << "_prod" << nodes.front().m_idx << "_node_t;" << std::endl
-             << indent_line(indent_depth + 1) << "assert(prod_node != 0);" << std::endl
-             << indent_line(indent_depth) << "}" << std::endl;
-        
+        // If this alternative finishes, its production
+        // node has been constructed above.
         return;
       }
       else
@@ -544,6 +915,11 @@ dump_gen_parser_src_real(
     arranged_lookahead.get(),
     default_node);
   
+  order_arranged_lookahead_by_profile(rule_node->ae(),
+                                      rule_node->name(),
+                                      arranged_lookahead.get(),
+                                      default_node);
+  
   traverse_arranged_lookahead(file,
                               nodes,
                               rule_node,
@@ -570,6 +946,307 @@ indent_line(unsigned int const indent_level)
   return str;
 }
 
+/// The beginning of a 'new' expression for a parse tree
+/// node in the generated code. With the 'use_node_arena'
+/// option, the node is constructed in 'node_arena'.
+std::wstring
+new_node_expression(
+  analyser_environment_t const * const ae,
+  wchar_t const * const node_arena)
+{
+  if (true == ae->use_node_arena())
+  {
+    return std::wstring(L"new (") + node_arena + L") ";
+  }
+  else
+  {
+    return L"new ";
+  }
+}
+
+/// Dump recycle() of the parse tree node class
+/// 'class_name' for the '--incremental' option. The
+/// memory goes back to the node arena, and a rule node
+/// ('has_prod_node') gives back its production node
+/// first.
+void
+dump_gen_recycle(
+  std::wfstream &file,
+  std::wstring const &class_name,
+  bool const has_prod_node)
+{
+  file << "  virtual void recycle(pt_arena_t &arena)" << std::endl
+       << "  {" << std::endl;
+  
+  if (true == has_prod_node)
+  {
+    file << "    if (mp_prod_node != 0)" << std::endl
+         << "    {" << std::endl
+         << "      mp_prod_node->recycle(arena);" << std::endl
+         << "    }" << std::endl
+         << std::endl;
+  }
+  
+  file << "    this->~" << class_name << "();" << std::endl
+       << "    arena.recycle(this, sizeof(" << class_name << "));" << std::endl
+       << "  }" << std::endl;
+}
+
+/// The description of a case of a decision for the
+/// '--stats' option: the name of the decision, and the
+/// lookahead tokens from the root of the arranged
+/// lookahead tree to 'arranged_lookahead', ex:
+///
+///   stmt: ident assign|lparen
+std::wstring
+stats_case_description(
+  std::wstring const &decision_name,
+  arranged_lookahead_t const * const arranged_lookahead,
+  node_t const * const default_node)
+{
+  std::list<std::wstring> levels;
+  
+  for (arranged_lookahead_t const *curr = arranged_lookahead;
+       curr->parent() != 0;
+       curr = curr->parent())
+  {
+    std::wstring level;
+    
+    BOOST_FOREACH(node_t const * const node, curr->lookahead_nodes())
+    {
+      if (level.size() != 0)
+      {
+        level.append(L"|");
+      }
+      
+      if (node == default_node)
+      {
+        level.append(L"default");
+      }
+      else if (0 == node->name().size())
+      {
+        level.append(L"EOF");
+      }
+      else
+      {
+        level.append(node->name());
+      }
+    }
+    
+    levels.push_front(level);
+  }
+  
+  std::wstring description = decision_name + L":";
+  
+  BOOST_FOREACH(std::wstring const &level, levels)
+  {
+    description.append(L" ").append(level);
+  }
+  
+  return description;
+}
+
+/// Dump the counter of the case 'arranged_lookahead' of a
+/// decision with the '--stats' option.
+void
+dump_stats_case_counter(
+  std::wfstream &file,
+  analyser_environment_t const * const ae,
+  std::wstring const &decision_name,
+  arranged_lookahead_t const * const arranged_lookahead,
+  node_t const * const default_node,
+  unsigned int const indent_depth)
+{
+  if (false == ae->stats())
+  {
+    return;
+  }
+  
+  file << indent_line(indent_depth) << "++m_stats_cases["
+       << ae->add_stats_case(stats_case_description(decision_name,
+                                                    arranged_lookahead,
+                                                    default_node))
+       << "];" << std::endl;
+}
+
+/// Dump the counter of the calls of parse_XXX with the
+/// '--stats' option.
+void
+dump_stats_rule_counter(
+  std::wfstream &file,
+  node_t const * const rule_node)
+{
+  if (false == rule_node->ae()->stats())
+  {
+    return;
+  }
+  
+  file << indent_line(1) << "++m_stats_rule_calls[STATS_RULE_" << rule_node->name()
+       << "];" << std::endl
+       << std::endl;
+}
+
+namespace
+{
+  typedef std::map<arranged_lookahead_t const *, unsigned long> profile_weights_t;
+  
+  /// The count of 'arranged_lookahead' in the profile, the
+  /// sum of its leaves, which are the cases of the decision.
+  unsigned long
+  collect_profile_weights(
+    analyser_environment_t const * const ae,
+    std::wstring const &decision_name,
+    arranged_lookahead_t const * const arranged_lookahead,
+    node_t const * const default_node,
+    profile_weights_t &weights)
+  {
+    unsigned long weight = 0;
+    
+    if (0 == arranged_lookahead->children().size())
+    {
+      weight = ae->profile_case_count(stats_case_description(decision_name,
+                                                             arranged_lookahead,
+                                                             default_node));
+    }
+    else
+    {
+      BOOST_FOREACH(arranged_lookahead_t const &child_arranged_lookahead,
+                    arranged_lookahead->children())
+      {
+        weight += collect_profile_weights(ae,
+                                          decision_name,
+                                          &child_arranged_lookahead,
+                                          default_node,
+                                          weights);
+      }
+    }
+    
+    weights[arranged_lookahead] = weight;
+    
+    return weight;
+  }
+  
+  class heavier_in_profile_t
+  {
+  private:
+    
+    profile_weights_t const &m_weights;
+    
+  public:
+    
+    explicit heavier_in_profile_t(
+      profile_weights_t const &weights)
+      : m_weights(weights)
+    { }
+    
+    bool operator()(
+      arranged_lookahead_t const &a,
+      arranged_lookahead_t const &b) const
+    {
+      return m_weights.find(&a)->second > m_weights.find(&b)->second;
+    }
+  };
+  
+  void
+  sort_arranged_lookahead_by_profile_weights(
+    arranged_lookahead_t * const arranged_lookahead,
+    profile_weights_t const &weights)
+  {
+    // std::list::sort() is stable, and it moves no
+    // elements, so that the parent pointers of the
+    // children stay valid.
+    arranged_lookahead->children().sort(heavier_in_profile_t(weights));
+    
+    BOOST_FOREACH(arranged_lookahead_t &child_arranged_lookahead,
+                  arranged_lookahead->children())
+    {
+      sort_arranged_lookahead_by_profile_weights(&child_arranged_lookahead, weights);
+    }
+  }
+}
+
+/// Sort the children of each level of the arranged
+/// lookahead tree of a decision by their counts in the
+/// profile of the '--profile' option, the hot cases first.
+/// The lookahead tokens of the children of a level are
+/// disjoint, so that the order does not change which
+/// alternative the parser chooses. The cases not in the
+/// profile keep their order after the others.
+void
+order_arranged_lookahead_by_profile(
+  analyser_environment_t const * const ae,
+  std::wstring const &decision_name,
+  arranged_lookahead_t * const arranged_lookahead,
+  node_t const * const default_node)
+{
+  if (false == ae->profile())
+  {
+    return;
+  }
+  
+  profile_weights_t weights;
+  
+  collect_profile_weights(ae, decision_name, arranged_lookahead, default_node, weights);
+  sort_arranged_lookahead_by_profile_weights(arranged_lookahead, weights);
+}
+
+/// The case of a level of the arranged lookahead tree of a
+/// decision which takes at least 3/4 of the count of the
+/// level in the profile of the '--profile' option, and has
+/// at most 3 lookahead tokens, so that an 'if' tests it
+/// faster than the switch; 0 if there is none.
+arranged_lookahead_t const *
+dominant_case_in_profile(
+  analyser_environment_t const * const ae,
+  std::wstring const &decision_name,
+  arranged_lookahead_t const * const arranged_lookahead,
+  node_t const * const default_node)
+{
+  if (false == ae->profile())
+  {
+    return 0;
+  }
+  
+  profile_weights_t weights;
+  unsigned long const total = collect_profile_weights(ae,
+                                                      decision_name,
+                                                      arranged_lookahead,
+                                                      default_node,
+                                                      weights);
+  
+  if (0 == total)
+  {
+    return 0;
+  }
+  
+  BOOST_FOREACH(arranged_lookahead_t const &child_arranged_lookahead,
+                arranged_lookahead->children())
+  {
+    if ((child_arranged_lookahead.lookahead_nodes().front() != default_node) &&
+        (child_arranged_lookahead.lookahead_nodes().size() <= 3) &&
+        (weights[&child_arranged_lookahead] >= (total - (total / 4))))
+    {
+      return &child_arranged_lookahead;
+    }
+  }
+  
+  return 0;
+}
+
+/// The name of the member variable holding 'node' in a
+/// production node class or a regex struct, ex:
+/// mp_XXX_node_0.
+std::wstring
+member_variable_name_for_one_node(
+  node_t const * const node)
+{
+  std::wstringstream ss;
+  
+  ss << "mp_" << node->name() << "_node_" << node->name_postfix_by_appear_times();
+  
+  return ss.str();
+}
+
 namespace
 {
   void
@@ -663,55 +1340,119 @@ analyser_environment_t::dump_gen_parser_nodes_hpp(
        << "#define __parser_nodes_hpp__" << std::endl << std::endl;
   
   // Dump included header files
-  file << "#include <list>" << std::endl
-       << "#include <vector>" << std::endl
-       << "#include \"parser_basic_types.hpp\"" << std::endl
+  file << "#include <vector>" << std::endl;
+  
+  if (true == m_use_node_arena)
+  {
+    file << "#include <cstddef>" << std::endl
+         << "#include <new>" << std::endl
+         << "#include <utility>" << std::endl;
+  }
+  
+  file << "#include \"parser_basic_types.hpp\"" << std::endl
+       << "#include \"token.hpp\"" << std::endl
        << std::endl;
   
+  if (true == m_use_node_arena)
+  {
+    dump_gen_node_arena(file);
+  }
+  
   // Dump base class 'pt_node_t'
   file << "class pt_node_t" << std::endl
        << "{" << std::endl
        << "public:" << std::endl
        << std::endl
-       << "  virtual ~pt_node_t() {}" << std::endl
-       << "};" << std::endl 
-       << "typedef class pt_node_t pt_node_t;" << std::endl
-       << std::endl;
+       << "  virtual ~pt_node_t() {}" << std::endl;
   
-  if (false == m_using_pure_BNF)
+  dump_gen_node_arena_operators(file);
+  
+  if (true == m_incremental)
   {
-    // Dump base class 'pt_regex_t' for each regex_info.
-    file << "struct pt_regex_t" << std::endl
-         << "{" << std::endl
-         << "  virtual ~pt_regex_t() {}" << std::endl
-         << "};" << std::endl 
-         << "typedef struct pt_regex_t pt_regex_t;" << std::endl
-         << std::endl;
-    
-    // Dump class pt_regex_chooser_t for each
-    // regex_chooser.
-    file << "struct pt_regex_chooser_t : public pt_node_t" << std::endl
-         << "{" << std::endl
-         << "public:" << std::endl
+    // frontend::incremental_parse() walks the old tree by
+    // these, without knowing the class of each node. The
+    // offsets are relative, so that the nodes after an edit
+    // are moved by changing the offset of one node on each
+    // level above them, not of every node of a subtree.
+    file << std::endl
+         << "  pt_node_t()" << std::endl
+         << "    : m_offset(0)," << std::endl
+         << "      m_length(0)," << std::endl
+         << "      m_lookahead(0)," << std::endl
+         << "      m_head(0)" << std::endl
+         << "  { }" << std::endl
          << std::endl
-         << "  bool bypass;" << std::endl
-         << "};" << std::endl 
-         << "typedef struct pt_regex_chooser_t pt_regex_chooser_t;" << std::endl
-         << std::endl;
-    
-    // Dump class pt_regex_OR_chooser_t for each
-    // regex_OR_chooser.
-    file << "struct pt_regex_OR_chooser_t : public pt_node_t" << std::endl
-         << "{" << std::endl
-         << "public:" << std::endl
+         << "  // The node covers 'length()' bytes of the input from" << std::endl
+         << "  // 'offset()', which is from the beginning of its parent" << std::endl
+         << "  // rule node, or of the input for the root. The parser" << std::endl
+         << "  // looked at the input up to 'lookahead()' from the" << std::endl
+         << "  // beginning of the node to parse it, and up to 'head()'" << std::endl
+         << "  // before it started the node." << std::endl
+         << "  wds_uint32 offset() const" << std::endl
+         << "  { return m_offset; }" << std::endl
+         << "  wds_uint32 length() const" << std::endl
+         << "  { return m_length; }" << std::endl
+         << "  wds_uint32 lookahead() const" << std::endl
+         << "  { return m_lookahead; }" << std::endl
+         << "  wds_uint32 head() const" << std::endl
+         << "  { return m_head; }" << std::endl
          << std::endl
-         << "  wds_uint32 regex_typename_id;" << std::endl
-         << "};" << std::endl 
-         << "typedef struct pt_regex_OR_chooser_t pt_regex_OR_chooser_t;" << std::endl
+         << "  virtual void set_offset(wds_uint32 const offset)" << std::endl
+         << "  { m_offset = offset; }" << std::endl
+         << "  void set_length(wds_uint32 const length)" << std::endl
+         << "  { m_length = length; }" << std::endl
+         << "  void set_lookahead(wds_uint32 const lookahead)" << std::endl
+         << "  { m_lookahead = lookahead; }" << std::endl
+         << "  void set_head(wds_uint32 const head)" << std::endl
+         << "  { m_head = head; }" << std::endl
+         << std::endl
+         << "  // The RULE_ID of a rule node, the other nodes are not" << std::endl
+         << "  // rules." << std::endl
+         << "  virtual wds_uint32 rule_id() const" << std::endl
+         << "  { return static_cast<wds_uint32>(-1); }" << std::endl
+         << std::endl
+         << "  // The children of a rule node in order, a child which" << std::endl
+         << "  // is not parsed is 0." << std::endl
+         << "  virtual unsigned int child_count() const" << std::endl
+         << "  { return 0; }" << std::endl
+         << "  virtual pt_node_t *child(unsigned int const) const" << std::endl
+         << "  { return 0; }" << std::endl
+         << "  virtual void set_child(unsigned int const, pt_node_t * const)" << std::endl
+         << "  { }" << std::endl
+         << std::endl
+         << "  // Destroy the node, and give its memory back to" << std::endl
+         << "  // 'arena' for the next nodes. A rule node recycles its" << std::endl
+         << "  // production node too, but not its children." << std::endl
+         << "  virtual void recycle(pt_arena_t &arena) = 0;" << std::endl
+         << std::endl
+         << "private:" << std::endl
+         << std::endl
+         << "  wds_uint32 m_offset;" << std::endl
+         << "  wds_uint32 m_length;" << std::endl
+         << "  wds_uint32 m_lookahead;" << std::endl
+         << "  wds_uint32 m_head;" << std::endl;
+  }
+  
+  file << "};" << std::endl 
+       << "typedef class pt_node_t pt_node_t;" << std::endl
+       << std::endl;
+  
+  if (false == m_using_pure_BNF)
+  {
+    // Dump base class 'pt_regex_t' for each regex_info.
+    file << "struct pt_regex_t" << std::endl
+         << "{" << std::endl
+         << "  virtual ~pt_regex_t() {}" << std::endl;
+    
+    dump_gen_node_arena_operators(file);
+    
+    file << "};" << std::endl 
+         << "typedef struct pt_regex_t pt_regex_t;" << std::endl
          << std::endl;
   }
   
-  // Dump terminal node class
+  // Dump terminal node class, it keeps the token it is
+  // made from, which is a view into the input.
   typedef terminal_hash_table_t::index<terminal_name>::type node_by_name;
   
   node_by_name::iterator iter = m_terminal_hash_table.get<terminal_name>().begin();
@@ -719,7 +1460,52 @@ analyser_environment_t::dump_gen_parser_nodes_hpp(
   {
     file << "class pt_" << (*iter) << "_node_t : public pt_node_t" << std::endl
          << "{" << std::endl
-         << "};" << std::endl 
+         << "private:" << std::endl
+         << std::endl
+         << "  token_t m_token;" << std::endl
+         << std::endl
+         << "public:" << std::endl
+         << std::endl
+         << "  explicit pt_" << (*iter) << "_node_t(" << std::endl
+         << "    token_t const &token)" << std::endl
+         << "    : m_token(token)" << std::endl;
+    
+    if (true == m_incremental)
+    {
+      file << "  {" << std::endl
+           << "    pt_node_t::set_offset(token.get_offset());" << std::endl
+           << "    set_length(token.get_length());" << std::endl
+           << "    set_lookahead(token.get_length());" << std::endl
+           << "  }" << std::endl
+           << std::endl
+           << "  // Use frontend::token_text() with the beginning of" << std::endl
+           << "  // the parent rule node to get its text." << std::endl;
+    }
+    else
+    {
+      file << "  { }" << std::endl
+           << std::endl
+           << "  // Use frontend::token_text() to get its text." << std::endl;
+    }
+    
+    file << "  token_t const &token() const" << std::endl
+         << "  { return m_token; }" << std::endl;
+    
+    if (true == m_incremental)
+    {
+      // The offset of the token is the offset of the node.
+      file << std::endl
+           << "  virtual void set_offset(wds_uint32 const offset)" << std::endl
+           << "  {" << std::endl
+           << "    pt_node_t::set_offset(offset);" << std::endl
+           << "    m_token.assign(m_token.get_type(), offset, m_token.get_length());" << std::endl
+           << "  }" << std::endl
+           << std::endl;
+      
+      dump_gen_recycle(file, L"pt_" + *iter + L"_node_t", false);
+    }
+    
+    file << "};" << std::endl 
          << "typedef class pt_" << (*iter) << "_node_t pt_" << (*iter) << "_node_t;"
          << std::endl << std::endl;
     
@@ -745,7 +1531,7 @@ analyser_environment_t::dump_gen_parser_nodes_hpp(
   
   BOOST_FOREACH(node_t const *node, m_top_level_nodes)
   {
-    file << "pt_node_t *parse_" << node->name() << "(bool const consume);" << std::endl;
+    file << "pt_" << node->name() << "_node_t *parse_" << node->name() << "();" << std::endl;
   }
   
   file << "////////////////////// Cut end here //////////////////////"
@@ -782,152 +1568,1723 @@ analyser_environment_t::dump_gen_parser_cpp() const
   }
 }
 
+/// Dump the batch driver 'main.cpp', which parses the
+/// starting rule from each file given on its command line
+/// with a pool of worker threads, and reports the files
+/// and the tokens per second.
+///
+/// The generated files only use the standard C++ library,
+/// so that, like 'mapped_file.hpp', the driver uses the
+/// threads of Win32 or of POSIX directly.
 void
 analyser_environment_t::dump_gen_main_cpp(
   std::wfstream &file) const
 {
+  std::wstring const &starting_rule = starting_rule_node()->name();
+  
+  file << "// Parse the starting rule (" << starting_rule << ") from each file, ex:" << std::endl
+       << "//" << std::endl
+       << "//   main [-j threads] file ... [@list_file ...]" << std::endl
+       << "//" << std::endl
+       << "// A list file has one file name per line. The files" << std::endl
+       << "// are parsed by 'threads' workers (the number of the" << std::endl
+       << "// processors by default), each with its own frontend and" << std::endl
+       << "// node arena, and the driver reports the files and the" << std::endl
+       << "// tokens per second. It returns 1 if a file can not be" << std::endl
+       << "// parsed." << std::endl
+       << std::endl
+       << "#include <cstdlib>" << std::endl
+       << "#include <cstring>" << std::endl
+       << "#include <exception>" << std::endl
+       << "#include <fstream>" << std::endl
+       << "#include <iostream>" << std::endl
+       << "#include <string>" << std::endl
+       << "#include <vector>" << std::endl
+       << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << "#include <windows.h>" << std::endl
+       << "#include <process.h>" << std::endl
+       << "#else" << std::endl
+       << "#include <pthread.h>" << std::endl
+       << "#include <unistd.h>" << std::endl
+       << "#include <sys/time.h>" << std::endl
+       << "#endif" << std::endl
+       << std::endl
+       << "#include \"frontend.hpp\"" << std::endl
+       << "#include \"mapped_file.hpp\"" << std::endl
+       << std::endl;
+  
+  file << "namespace" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "// The workers take the next file from here one at a" << std::endl
+       << indent_line(1) << "// time, so that a worker with small files takes more" << std::endl
+       << indent_line(1) << "// of them." << std::endl
+       << indent_line(1) << "std::vector<std::string> g_filenames;" << std::endl
+       << indent_line(1) << "size_t g_next_filename = 0;" << std::endl
+       << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(1) << "CRITICAL_SECTION g_lock;" << std::endl
+       << "#else" << std::endl
+       << indent_line(1) << "pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;" << std::endl
+       << "#endif" << std::endl
+       << std::endl
+       << indent_line(1) << "void" << std::endl
+       << indent_line(1) << "lock()" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(2) << "EnterCriticalSection(&g_lock);" << std::endl
+       << "#else" << std::endl
+       << indent_line(2) << "pthread_mutex_lock(&g_lock);" << std::endl
+       << "#endif" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "void" << std::endl
+       << indent_line(1) << "unlock()" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(2) << "LeaveCriticalSection(&g_lock);" << std::endl
+       << "#else" << std::endl
+       << indent_line(2) << "pthread_mutex_unlock(&g_lock);" << std::endl
+       << "#endif" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "// The seconds since some fixed time." << std::endl
+       << indent_line(1) << "double" << std::endl
+       << indent_line(1) << "wall_time()" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(2) << "LARGE_INTEGER frequency;" << std::endl
+       << indent_line(2) << "LARGE_INTEGER counter;" << std::endl
+       << std::endl
+       << indent_line(2) << "QueryPerformanceFrequency(&frequency);" << std::endl
+       << indent_line(2) << "QueryPerformanceCounter(&counter);" << std::endl
+       << std::endl
+       << indent_line(2) << "return static_cast<double>(counter.QuadPart) / frequency.QuadPart;" << std::endl
+       << "#else" << std::endl
+       << indent_line(2) << "timeval now;" << std::endl
+       << std::endl
+       << indent_line(2) << "gettimeofday(&now, 0);" << std::endl
+       << std::endl
+       << indent_line(2) << "return now.tv_sec + (now.tv_usec / 1000000.0);" << std::endl
+       << "#endif" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "unsigned int" << std::endl
+       << indent_line(1) << "processor_count()" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(2) << "SYSTEM_INFO info;" << std::endl
+       << std::endl
+       << indent_line(2) << "GetSystemInfo(&info);" << std::endl
+       << std::endl
+       << indent_line(2) << "return info.dwNumberOfProcessors;" << std::endl
+       << "#else" << std::endl
+       << indent_line(2) << "long const count = sysconf(_SC_NPROCESSORS_ONLN);" << std::endl
+       << std::endl
+       << indent_line(2) << "return (count > 0) ? static_cast<unsigned int>(count) : 1;" << std::endl
+       << "#endif" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "bool" << std::endl
+       << indent_line(1) << "next_filename(" << std::endl
+       << indent_line(2) << "std::string &filename)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "lock();" << std::endl
+       << std::endl
+       << indent_line(2) << "bool const found = (g_next_filename < g_filenames.size());" << std::endl
+       << std::endl
+       << indent_line(2) << "if (true == found)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "filename = g_filenames[g_next_filename];" << std::endl
+       << indent_line(3) << "++g_next_filename;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "unlock();" << std::endl
+       << std::endl
+       << indent_line(2) << "return found;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "// The counters of one worker, added up by main() after" << std::endl
+       << indent_line(1) << "// all the workers end." << std::endl
+       << indent_line(1) << "struct worker_t" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "unsigned long m_parsed_files;" << std::endl
+       << indent_line(2) << "unsigned long m_failed_files;" << std::endl
+       << indent_line(2) << "double m_tokens;" << std::endl
+       << indent_line(2) << "double m_bytes;" << std::endl
+       << indent_line(1) << "};" << std::endl
+       << indent_line(1) << "typedef struct worker_t worker_t;" << std::endl
+       << std::endl
+       << indent_line(1) << "// One frontend scans all the files of a worker, so that" << std::endl
+       << indent_line(1) << "// its node arena keeps its blocks from file to file." << std::endl
+       << indent_line(1) << "void" << std::endl
+       << indent_line(1) << "run_worker(" << std::endl
+       << indent_line(2) << "worker_t &worker)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "frontend parser(0, 0);" << std::endl
+       << indent_line(2) << "std::string filename;" << std::endl
+       << std::endl
+       << indent_line(2) << "while (true == next_filename(filename))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "try" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "mapped_file_t const input(filename.c_str());" << std::endl
+       << std::endl
+       << indent_line(4) << "parser.reset_input(input.begin(), input.end());" << std::endl
+       << std::endl;
+  
+  // The starting rule may end before the input does, so
+  // that a file is parsed only if it ends at EOF.
+  if (true == m_use_node_arena)
+  {
+    file << indent_line(4) << "parser.parse_" << starting_rule << "();" << std::endl
+         << std::endl
+         << indent_line(4) << "bool const parsed = parser.at_end();" << std::endl
+         << std::endl
+         << indent_line(4) << "parser.free_nodes();" << std::endl;
+  }
+  else
+  {
+    file << indent_line(4) << "pt_" << starting_rule << "_node_t * const tree = parser.parse_" << starting_rule << "();" << std::endl
+         << std::endl
+         << indent_line(4) << "bool const parsed = parser.at_end();" << std::endl
+         << std::endl
+         << indent_line(4) << "delete tree;" << std::endl;
+  }
+  
+  file << std::endl
+       << indent_line(4) << "if (false == parsed)" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "throw std::exception();" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << std::endl
+       << indent_line(4) << "++worker.m_parsed_files;" << std::endl
+       << indent_line(4) << "worker.m_tokens += parser.consumed_token_count();" << std::endl
+       << indent_line(4) << "worker.m_bytes += input.end() - input.begin();" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(3) << "catch (std::exception &)" << std::endl
+       << indent_line(3) << "{" << std::endl;
+  
+  if (true == m_use_node_arena)
+  {
+    // The nodes of the failed parse are not in any tree.
+    file << indent_line(4) << "parser.free_nodes();" << std::endl
+         << std::endl;
+  }
+  
+  file << indent_line(4) << "++worker.m_failed_files;" << std::endl
+       << std::endl
+       << indent_line(4) << "lock();" << std::endl
+       << indent_line(4) << "std::cerr << filename << \": can not be read or parsed\" << std::endl;" << std::endl
+       << indent_line(4) << "unlock();" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(1) << "unsigned int __stdcall" << std::endl
+       << "#else" << std::endl
+       << indent_line(1) << "void *" << std::endl
+       << "#endif" << std::endl
+       << indent_line(1) << "worker_entry(" << std::endl
+       << indent_line(2) << "void *worker)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "run_worker(*static_cast<worker_t *>(worker));" << std::endl
+       << std::endl
+       << indent_line(2) << "return 0;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
   file << "int" << std::endl
        << "main(int argc, char **argv)" << std::endl
        << "{" << std::endl
-       << indent_line(1) << "return 0;" << std::endl
-       << "}" << std::endl;
+       << indent_line(1) << "unsigned int thread_count = processor_count();" << std::endl
+       << std::endl
+       << indent_line(1) << "for (int i = 1; i < argc; ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "if ((0 == strcmp(argv[i], \"-j\")) && ((i + 1) < argc))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "++i;" << std::endl
+       << indent_line(3) << "thread_count = atoi(argv[i]);" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(2) << "else if ('@' == argv[i][0])" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "std::ifstream list(argv[i] + 1);" << std::endl
+       << indent_line(3) << "std::string line;" << std::endl
+       << std::endl
+       << indent_line(3) << "if (!list)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "std::cerr << (argv[i] + 1) << \": can not be read\" << std::endl;" << std::endl
+       << indent_line(4) << "return 1;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl
+       << indent_line(3) << "while (std::getline(list, line))" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "if (false == line.empty())" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "g_filenames.push_back(line);" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(2) << "else" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "g_filenames.push_back(argv[i]);" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "if (true == g_filenames.empty())" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "std::cerr << \"usage: \" << argv[0] << \" [-j threads] file ... [@list_file ...]\" << std::endl;" << std::endl
+       << indent_line(2) << "return 1;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "if (0 == thread_count)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "thread_count = 1;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << indent_line(1) << "else if (thread_count > g_filenames.size())" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "thread_count = static_cast<unsigned int>(g_filenames.size());" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(1) << "InitializeCriticalSection(&g_lock);" << std::endl
+       << "#endif" << std::endl
+       << std::endl
+       << indent_line(1) << "std::vector<worker_t> workers(thread_count);" << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(1) << "std::vector<HANDLE> threads;" << std::endl
+       << "#else" << std::endl
+       << indent_line(1) << "std::vector<pthread_t> threads;" << std::endl
+       << "#endif" << std::endl
+       << std::endl
+       << indent_line(1) << "double const start_time = wall_time();" << std::endl
+       << std::endl
+       << indent_line(1) << "// The main thread is the first worker. If a thread can" << std::endl
+       << indent_line(1) << "// not be created, the other workers take its files." << std::endl
+       << indent_line(1) << "for (unsigned int i = 1; i < thread_count; ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(2) << "HANDLE const thread = reinterpret_cast<HANDLE>(" << std::endl
+       << indent_line(2) << "  _beginthreadex(0, 0, worker_entry, &workers[i], 0, 0));" << std::endl
+       << std::endl
+       << indent_line(2) << "if (0 == thread)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "break;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << "#else" << std::endl
+       << indent_line(2) << "pthread_t thread;" << std::endl
+       << std::endl
+       << indent_line(2) << "if (pthread_create(&thread, 0, worker_entry, &workers[i]) != 0)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "break;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << "#endif" << std::endl
+       << std::endl
+       << indent_line(2) << "threads.push_back(thread);" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "run_worker(workers[0]);" << std::endl
+       << std::endl
+       << indent_line(1) << "for (size_t i = 0; i < threads.size(); ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(2) << "WaitForSingleObject(threads[i], INFINITE);" << std::endl
+       << indent_line(2) << "CloseHandle(threads[i]);" << std::endl
+       << "#else" << std::endl
+       << indent_line(2) << "pthread_join(threads[i], 0);" << std::endl
+       << "#endif" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "double const seconds = wall_time() - start_time;" << std::endl
+       << std::endl
+       << indent_line(1) << "worker_t total = { 0, 0, 0, 0 };" << std::endl
+       << std::endl
+       << indent_line(1) << "for (size_t i = 0; i < workers.size(); ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "total.m_parsed_files += workers[i].m_parsed_files;" << std::endl
+       << indent_line(2) << "total.m_failed_files += workers[i].m_failed_files;" << std::endl
+       << indent_line(2) << "total.m_tokens += workers[i].m_tokens;" << std::endl
+       << indent_line(2) << "total.m_bytes += workers[i].m_bytes;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "std::cout << \"threads: \" << (threads.size() + 1) << std::endl" << std::endl
+       << indent_line(1) << "          << \"files: \" << total.m_parsed_files << \" parsed, \"" << std::endl
+       << indent_line(1) << "          << total.m_failed_files << \" failed\" << std::endl" << std::endl
+       << indent_line(1) << "          << \"tokens: \" << total.m_tokens << std::endl" << std::endl
+       << indent_line(1) << "          << \"bytes: \" << total.m_bytes << std::endl" << std::endl
+       << indent_line(1) << "          << \"seconds: \" << seconds << std::endl;" << std::endl
+       << std::endl
+       << indent_line(1) << "if (seconds > 0)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "std::cout << \"files/s: \" << (total.m_parsed_files / seconds) << std::endl" << std::endl
+       << indent_line(2) << "          << \"tokens/s: \" << (total.m_tokens / seconds) << std::endl" << std::endl
+       << indent_line(2) << "          << \"MB/s: \" << (total.m_bytes / seconds / (1024 * 1024)) << std::endl;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(1) << "DeleteCriticalSection(&g_lock);" << std::endl
+       << "#endif" << std::endl
+       << std::endl
+       << indent_line(1) << "return (0 == total.m_failed_files) ? 0 : 1;" << std::endl
+       << "}" << std::endl;
+}
+
+void
+analyser_environment_t::dump_gen_frontend_hpp(
+  std::wfstream &file) const
+{
+  file << "#include <cassert>" << std::endl
+       << "#include <exception>" << std::endl
+       << "#include <string>" << std::endl;
+  
+  if (mp_scanner_dfa.get() != 0)
+  {
+    file << "#include <istream>" << std::endl;
+  }
+  
+  if (true == m_stats)
+  {
+    file << "#include <ostream>" << std::endl;
+  }
+  
+  if ((BACKEND_TABLE == m_backend) ||
+      (true == m_incremental))
+  {
+    file << "#include <vector>" << std::endl;
+  }
+  
+  file << "#include \"parser_nodes.hpp\"" << std::endl
+       << "#include \"parser_basic_types.hpp\"" << std::endl
+       << "#include \"token.hpp\"" << std::endl;
+  
+  file << std::endl;
+  
+  file << "class frontend" << std::endl
+       << "{" << std::endl
+       << "public:" << std::endl
+       << std::endl;
+  
+  if (mp_scanner_dfa.get() != 0)
+  {
+    file << indent_line(1) << "// Read the whole input into the frontend." << std::endl
+         << indent_line(1) << "explicit frontend(" << std::endl
+         << indent_line(2) << "std::istream &input);" << std::endl
+         << std::endl;
+  }
+  else
+  {
+    file << indent_line(1) << "frontend();" << std::endl
+         << std::endl;
+  }
+  
+  // The tokens are views into the input, so that scanning
+  // a buffer of the caller, ex: a mapped_file_t, copies
+  // nothing.
+  file << indent_line(1) << "// Scan [begin, end) in place. The input is not" << std::endl
+       << indent_line(1) << "// copied, and it has to outlive the frontend and" << std::endl
+       << indent_line(1) << "// the parse trees." << std::endl
+       << indent_line(1) << "frontend(" << std::endl
+       << indent_line(2) << "char const * const begin," << std::endl
+       << indent_line(2) << "char const * const end);" << std::endl
+       << std::endl;
+  
+  // A frontend can scan one input after another, so that
+  // a batch of inputs reuses its lookahead window and its
+  // node arena.
+  file << indent_line(1) << "// Scan [begin, end) from its beginning, like the" << std::endl
+       << indent_line(1) << "// constructor above, ex: for the next file of a batch." << std::endl
+       << indent_line(1) << "// The parse tree nodes made so far are not freed." << std::endl
+       << indent_line(1) << "void reset_input(" << std::endl
+       << indent_line(2) << "char const * const begin," << std::endl
+       << indent_line(2) << "char const * const end);" << std::endl
+       << std::endl
+       << indent_line(1) << "// The tokens consumed since the input was given." << std::endl
+       << indent_line(1) << "wds_uint32 consumed_token_count() const" << std::endl
+       << indent_line(1) << "{ return m_consumed_token_count; }" << std::endl
+       << std::endl
+       << indent_line(1) << "// Whether the next token is EOF, ex: after parse_XXX()," << std::endl
+       << indent_line(1) << "// which stops at the end of its rule, even if there is" << std::endl
+       << indent_line(1) << "// more input." << std::endl
+       << indent_line(1) << "bool at_end()" << std::endl
+       << indent_line(1) << "{ return (WDS_TOKEN_TYPE_EOF == lexer_peek_token(1)->get_type()); }" << std::endl
+       << std::endl;
+  
+  if (true == m_benchmark)
+  {
+    file << indent_line(1) << "// Parse the tokens [begin, end) instead of scanning an" << std::endl
+         << indent_line(1) << "// input, ex: the random token streams of benchmark.cpp." << std::endl
+         << indent_line(1) << "// The tokens have no text, and they have to outlive" << std::endl
+         << indent_line(1) << "// the parse." << std::endl
+         << indent_line(1) << "void reset_tokens(" << std::endl
+         << indent_line(2) << "token_t const * const begin," << std::endl
+         << indent_line(2) << "token_t const * const end);" << std::endl
+         << std::endl;
+  }
+  
+  if (true == m_push_parser)
+  {
+    std::wstring const &starting_rule = starting_rule_node()->name();
+    
+    file << indent_line(1) << "// Push parsing of the starting rule, for the input" << std::endl
+         << indent_line(1) << "// which arrives in chunks: feed() each chunk as it" << std::endl
+         << indent_line(1) << "// arrives, and call finish() at the end of the input" << std::endl
+         << indent_line(1) << "// to get the parse tree. feed() parses as far as the" << std::endl
+         << indent_line(1) << "// input so far goes, and both throw std::exception on" << std::endl
+         << indent_line(1) << "// a syntax error." << std::endl
+         << indent_line(1) << "frontend();" << std::endl
+         << std::endl
+         << indent_line(1) << "void feed(" << std::endl
+         << indent_line(2) << "char const * const begin," << std::endl
+         << indent_line(2) << "char const * const end);" << std::endl
+         << std::endl
+         << indent_line(1) << "pt_" << starting_rule << "_node_t *finish();" << std::endl
+         << std::endl;
+  }
+  
+  if (true == m_incremental)
+  {
+    std::wstring const &starting_rule = starting_rule_node()->name();
+    
+    file << indent_line(1) << "// An edit replaced the 'm_old_length' bytes of the" << std::endl
+         << indent_line(1) << "// input at 'm_offset' by 'm_new_length' bytes." << std::endl
+         << indent_line(1) << "struct edit_t" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "wds_uint32 m_offset;" << std::endl
+         << indent_line(2) << "wds_uint32 m_old_length;" << std::endl
+         << indent_line(2) << "wds_uint32 m_new_length;" << std::endl
+         << indent_line(1) << "};" << std::endl
+         << std::endl
+         << indent_line(1) << "// Parse the edited input [begin, end) again from" << std::endl
+         << indent_line(1) << "// 'old_tree', the tree of the starting rule this" << std::endl
+         << indent_line(1) << "// frontend parsed from the input before 'edit'. Only" << std::endl
+         << indent_line(1) << "// the rules around the edit are parsed again, the" << std::endl
+         << indent_line(1) << "// other subtrees are moved into the new tree, and the" << std::endl
+         << indent_line(1) << "// old nodes which are not are recycled, so that" << std::endl
+         << indent_line(1) << "// 'old_tree' can not be used any more. The input is" << std::endl
+         << indent_line(1) << "// not copied, and it has to outlive the frontend and" << std::endl
+         << indent_line(1) << "// the parse trees. It throws std::exception on a" << std::endl
+         << indent_line(1) << "// syntax error, and leaves 'old_tree' as it was, so" << std::endl
+         << indent_line(1) << "// that the next edit is from the input of 'old_tree'." << std::endl
+         << indent_line(1) << "pt_" << starting_rule << "_node_t *incremental_parse(" << std::endl
+         << indent_line(2) << "pt_" << starting_rule << "_node_t * const old_tree," << std::endl
+         << indent_line(2) << "edit_t const &edit," << std::endl
+         << indent_line(2) << "char const * const begin," << std::endl
+         << indent_line(2) << "char const * const end);" << std::endl
+         << std::endl
+         << indent_line(1) << "// The text of a token of this frontend, where" << std::endl
+         << indent_line(1) << "// 'parent_begin' is the offset of the parent rule node" << std::endl
+         << indent_line(1) << "// of the token in the input. Only token_text() copies" << std::endl
+         << indent_line(1) << "// it." << std::endl
+         << indent_line(1) << "char const *token_begin(" << std::endl
+         << indent_line(2) << "token_t const &token," << std::endl
+         << indent_line(2) << "wds_uint32 const parent_begin) const" << std::endl
+         << indent_line(1) << "{ return mp_input_begin + parent_begin + token.get_offset(); }" << std::endl
+         << std::endl
+         << indent_line(1) << "std::string token_text(" << std::endl
+         << indent_line(2) << "token_t const &token," << std::endl
+         << indent_line(2) << "wds_uint32 const parent_begin) const" << std::endl
+         << indent_line(1) << "{ return std::string(token_begin(token, parent_begin), token.get_length()); }" << std::endl
+         << std::endl;
+  }
+  else
+  {
+    file << indent_line(1) << "// The text of a token of this frontend, only" << std::endl
+         << indent_line(1) << "// token_text() copies it." << std::endl
+         << indent_line(1) << "char const *token_begin(" << std::endl
+         << indent_line(2) << "token_t const &token) const" << std::endl
+         << indent_line(1) << "{ return mp_input_begin + token.get_offset(); }" << std::endl
+         << std::endl
+         << indent_line(1) << "std::string token_text(" << std::endl
+         << indent_line(2) << "token_t const &token) const" << std::endl
+         << indent_line(1) << "{ return std::string(token_begin(token), token.get_length()); }" << std::endl
+         << std::endl;
+  }
+  
+  file << indent_line(1) << "// Parse the rule from the next tokens, and return" << std::endl
+       << indent_line(1) << "// its parse tree. They throw std::exception on a" << std::endl
+       << indent_line(1) << "// syntax error." << std::endl;
+  
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    file << indent_line(1) << "pt_" << node->name() << "_node_t *parse_" << node->name()
+         << "();" << std::endl;
+  }
+  
+  file << std::endl;
+  
+  // The predicates only peek the tokens, so that a caller
+  // can check what comes next before parsing it.
+  file << indent_line(1) << "// Whether the next 'depth' (1 ~ " << m_max_lookahead_searching_depth << ") tokens can start" << std::endl
+       << indent_line(1) << "// the rule, without consuming any token." << std::endl;
+  
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    file << indent_line(1) << "bool can_start_" << node->name()
+         << "(unsigned int const depth);" << std::endl;
+  }
+  
+  file << std::endl;
+  
+  if (true == m_use_node_arena)
+  {
+    file << indent_line(1) << "// Free all the parse tree nodes made by this" << std::endl
+         << indent_line(1) << "// frontend at once." << std::endl
+         << indent_line(1) << "void free_nodes()" << std::endl
+         << indent_line(1) << "{ m_node_arena.reset(); }" << std::endl
+         << std::endl;
+  }
+  
+  if (true == m_stats)
+  {
+    file << indent_line(1) << "// The calls of each rule, the peeks at each lookahead" << std::endl
+         << indent_line(1) << "// depth, and the cases taken by each decision since" << std::endl
+         << indent_line(1) << "// the construction or reset_stats(). The counters" << std::endl
+         << indent_line(1) << "// belong to this frontend, so that the frontends of" << std::endl
+         << indent_line(1) << "// different threads count without any lock." << std::endl
+         << indent_line(1) << "void dump_stats(" << std::endl
+         << indent_line(2) << "std::ostream &out) const;" << std::endl
+         << std::endl
+         << indent_line(1) << "void reset_stats();" << std::endl
+         << std::endl;
+  }
+  
+  // The lookahead window is a ring of tokens, and the
+  // parser never looks further than k tokens, so that the
+  // smallest power of 2 which is not less than k is
+  // enough, and the index of a token in the ring is just
+  // masked instead of divided.
+  unsigned int lookahead_window_size = 1;
+  
+  while (lookahead_window_size < m_max_lookahead_searching_depth)
+  {
+    lookahead_window_size <<= 1;
+  }
+  
+  file << "private:" << std::endl
+       << std::endl
+       << indent_line(1) << "enum" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "LOOKAHEAD_WINDOW_SIZE = " << lookahead_window_size << "," << std::endl
+       << indent_line(2) << "LOOKAHEAD_WINDOW_MASK = LOOKAHEAD_WINDOW_SIZE - 1";
+  
+  if (true == m_push_parser)
+  {
+    file << "," << std::endl
+         << indent_line(2) << "LOOKAHEAD_DEPTH = " << m_max_lookahead_searching_depth;
+  }
+  
+  file << std::endl
+       << indent_line(1) << "};" << std::endl
+       << std::endl;
+  
+  if (mp_scanner_dfa.get() != 0)
+  {
+    // The input of an std::istream is read into 'm_input'
+    // at once, and scanned by the pointers into it, so
+    // that the frontend can not be copied.
+    file << indent_line(1) << "frontend(frontend const &);" << std::endl
+         << indent_line(1) << "frontend &operator=(frontend const &);" << std::endl
+         << std::endl
+         << indent_line(1) << "std::string m_input;" << std::endl;
+  }
+  
+  // The offset of a token is from 'mp_input_begin'.
+  file << indent_line(1) << "char const *mp_input_begin;" << std::endl
+       << indent_line(1) << "char const *mp_input_curr;" << std::endl
+       << indent_line(1) << "char const *mp_input_end;" << std::endl;
+  
+  if (true == m_push_parser)
+  {
+    // feed() appends to 'm_input', and the pointers into
+    // it are moved after each chunk.
+    file << indent_line(1) << "bool m_input_finished;" << std::endl;
+  }
+  
+  file << std::endl;
+  
+  file << indent_line(1) << "token_t m_lookahead_window[LOOKAHEAD_WINDOW_SIZE];" << std::endl
+       << indent_line(1) << "unsigned int m_lookahead_first;" << std::endl
+       << indent_line(1) << "unsigned int m_lookahead_count;" << std::endl
+       << std::endl
+       << indent_line(1) << "wds_uint32 m_consumed_token_count;" << std::endl
+       << std::endl;
+  
+  if (true == m_benchmark)
+  {
+    file << indent_line(1) << "// The tokens of reset_tokens(), 'mp_token_curr' is 0" << std::endl
+         << indent_line(1) << "// when the scanner gives the tokens." << std::endl
+         << indent_line(1) << "token_t const *mp_token_curr;" << std::endl
+         << indent_line(1) << "token_t const *mp_token_end;" << std::endl
+         << std::endl;
+  }
+  
+  if (true == m_incremental)
+  {
+    // The spans of the rule nodes are made of these, the
+    // scanner looks at the end of the input as the byte
+    // after it, because appending to the input may change
+    // the last token.
+    file << indent_line(1) << "// The end of the last token consumed, and the end of" << std::endl
+         << indent_line(1) << "// the input the scanner looked at." << std::endl
+         << indent_line(1) << "wds_uint32 m_consumed_end;" << std::endl
+         << indent_line(1) << "wds_uint32 m_examined_end;" << std::endl
+         << std::endl
+         << indent_line(1) << "// The path from the root of the old tree down to the" << std::endl
+         << indent_line(1) << "// edit, see incremental_find_path()." << std::endl
+         << indent_line(1) << "struct edit_path_entry_t" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "pt_node_t *mp_node;" << std::endl
+         << indent_line(2) << "wds_uint32 m_begin;" << std::endl
+         << indent_line(2) << "unsigned int m_child;" << std::endl
+         << indent_line(2) << "wds_uint32 m_head;" << std::endl
+         << indent_line(2) << "wds_uint32 m_next;" << std::endl
+         << indent_line(2) << "wds_uint32 m_prev_end;" << std::endl
+         << indent_line(2) << "bool m_after_token;" << std::endl
+         << indent_line(1) << "};" << std::endl
+         << std::endl
+         << indent_line(1) << "std::vector<edit_path_entry_t> m_edit_path;" << std::endl
+         << indent_line(1) << "wds_uint32 m_next_after_tree;" << std::endl
+         << std::endl
+         << indent_line(1) << "// The path from the old node being parsed again to the" << std::endl
+         << indent_line(1) << "// node at the next token, with the offsets of the" << std::endl
+         << indent_line(1) << "// nodes in the old input. The edit replaced" << std::endl
+         << indent_line(1) << "// [m_reuse_edit_begin, m_reuse_edit_end) of the old" << std::endl
+         << indent_line(1) << "// input by [m_reuse_edit_begin, m_reuse_new_end) of" << std::endl
+         << indent_line(1) << "// the new one." << std::endl
+         << indent_line(1) << "struct reuse_entry_t" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "pt_node_t *mp_node;" << std::endl
+         << indent_line(2) << "wds_uint32 m_begin;" << std::endl
+         << indent_line(2) << "unsigned int m_next_child;" << std::endl
+         << indent_line(1) << "};" << std::endl
+         << std::endl
+         << indent_line(1) << "std::vector<reuse_entry_t> m_reuse_path;" << std::endl
+         << indent_line(1) << "wds_uint32 m_reuse_edit_begin;" << std::endl
+         << indent_line(1) << "wds_uint32 m_reuse_edit_end;" << std::endl
+         << indent_line(1) << "wds_uint32 m_reuse_new_end;" << std::endl
+         << std::endl
+         << indent_line(1) << "// The old nodes reused by the parse, with their old" << std::endl
+         << indent_line(1) << "// offset and head, so that a failed parse can put them" << std::endl
+         << indent_line(1) << "// back." << std::endl
+         << indent_line(1) << "struct reused_node_t" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "pt_node_t *mp_node;" << std::endl
+         << indent_line(2) << "wds_uint32 m_offset;" << std::endl
+         << indent_line(2) << "wds_uint32 m_head;" << std::endl
+         << indent_line(1) << "};" << std::endl
+         << std::endl
+         << indent_line(1) << "std::vector<reused_node_t> m_reused_nodes;" << std::endl
+         << indent_line(1) << "std::vector<pt_node_t *> m_kept_nodes;" << std::endl
+         << indent_line(1) << "std::vector<pt_node_t *> m_recycled_nodes;" << std::endl
+         << std::endl
+         << indent_line(1) << "// An offset of the old input in the new one, the" << std::endl
+         << indent_line(1) << "// offsets in the replaced text go to the end of the" << std::endl
+         << indent_line(1) << "// new text." << std::endl
+         << indent_line(1) << "wds_uint32 incremental_map(" << std::endl
+         << indent_line(2) << "wds_uint32 const offset) const" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "if (offset < m_reuse_edit_begin)" << std::endl
+         << indent_line(2) << "{" << std::endl
+         << indent_line(3) << "return offset;" << std::endl
+         << indent_line(2) << "}" << std::endl
+         << std::endl
+         << indent_line(2) << "return ((offset > m_reuse_edit_end) ? offset : m_reuse_edit_end) - m_reuse_edit_end + m_reuse_new_end;" << std::endl
+         << indent_line(1) << "}" << std::endl
+         << std::endl
+         << indent_line(1) << "void incremental_find_path(" << std::endl
+         << indent_line(2) << "pt_node_t * const old_tree);" << std::endl
+         << std::endl
+         << indent_line(1) << "pt_node_t *incremental_reparse(" << std::endl
+         << indent_line(2) << "size_t const depth);" << std::endl
+         << std::endl
+         << indent_line(1) << "pt_node_t *incremental_parse_rule(" << std::endl
+         << indent_line(2) << "wds_uint32 const rule);" << std::endl
+         << std::endl
+         << indent_line(1) << "pt_node_t *incremental_reuse(" << std::endl
+         << indent_line(2) << "wds_uint32 const rule);" << std::endl
+         << std::endl
+         << indent_line(1) << "void incremental_finish(" << std::endl
+         << indent_line(2) << "pt_node_t * const node," << std::endl
+         << indent_line(2) << "wds_uint32 const head);" << std::endl
+         << std::endl
+         << indent_line(1) << "void incremental_rollback();" << std::endl
+         << std::endl
+         << indent_line(1) << "pt_node_t *incremental_splice(" << std::endl
+         << indent_line(2) << "size_t const depth," << std::endl
+         << indent_line(2) << "pt_node_t * const node);" << std::endl
+         << std::endl
+         << indent_line(1) << "void incremental_recycle(" << std::endl
+         << indent_line(2) << "pt_node_t * const node);" << std::endl
+         << std::endl;
+  }
+  
+  if (true == m_use_node_arena)
+  {
+    file << indent_line(1) << "pt_arena_t m_node_arena;" << std::endl
+         << std::endl;
+  }
+  
+  if (true == m_stats)
+  {
+    // The rules are counted in the order of
+    // 'm_top_level_nodes', which is also the order of
+    // PARSER_RULE_XXX of the table backend. The cases
+    // were registered while the parser was dumped.
+    file << indent_line(1) << "enum" << std::endl
+         << indent_line(1) << "{" << std::endl;
+    
+    unsigned int rule_id = 0;
+    
+    BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+    {
+      file << indent_line(2) << "STATS_RULE_" << node->name() << " = " << rule_id << "," << std::endl;
+      
+      ++rule_id;
+    }
+    
+    file << indent_line(2) << "STATS_RULE_COUNT = " << rule_id << "," << std::endl
+         << indent_line(2) << "STATS_CASE_COUNT = " << m_stats_cases.size() << std::endl
+         << indent_line(1) << "};" << std::endl
+         << std::endl
+         << indent_line(1) << "unsigned long m_stats_rule_calls[STATS_RULE_COUNT];" << std::endl
+         << indent_line(1) << "unsigned long m_stats_peeks[LOOKAHEAD_WINDOW_SIZE];" << std::endl;
+    
+    if (m_stats_cases.size() != 0)
+    {
+      file << indent_line(1) << "unsigned long m_stats_cases[STATS_CASE_COUNT];" << std::endl;
+    }
+    
+    file << std::endl;
+  }
+  
+  if (BACKEND_TABLE == m_backend)
+  {
+    // The driver in parser_tables.cpp keeps the rules it
+    // is parsing and their children on these stacks
+    // instead of the C++ stack.
+    file << indent_line(1) << "struct table_frame_t" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "wds_uint32 m_pc;" << std::endl
+         << indent_line(2) << "wds_uint32 m_children_base;" << std::endl
+         << indent_line(2) << "wds_uint32 m_production;" << std::endl;
+    
+    if (true == m_incremental)
+    {
+      file << indent_line(2) << "wds_uint32 m_head;" << std::endl;
+    }
+    
+    file << indent_line(1) << "};" << std::endl
+         << std::endl
+         << indent_line(1) << "std::vector<table_frame_t> m_table_frames;" << std::endl
+         << indent_line(1) << "std::vector<pt_node_t *> m_table_children;" << std::endl
+         << std::endl
+         << indent_line(1) << "pt_node_t *table_parse(" << std::endl
+         << indent_line(2) << "wds_uint32 const rule);" << std::endl
+         << std::endl
+         << indent_line(1) << "void table_start(" << std::endl
+         << indent_line(2) << "wds_uint32 const rule);" << std::endl
+         << std::endl
+         << indent_line(1) << "pt_node_t *table_run();" << std::endl
+         << std::endl;
+    
+    if (false == use_node_arena())
+    {
+      file << indent_line(1) << "pt_node_t *table_loop();" << std::endl
+           << indent_line(1) << "void table_discard();" << std::endl
+           << std::endl;
+    }
+    
+    file << indent_line(1) << "wds_uint32 table_decide(" << std::endl
+         << indent_line(2) << "wds_uint32 const decision);" << std::endl
+         << std::endl
+         << indent_line(1) << "pt_node_t *table_build_node(" << std::endl
+         << indent_line(2) << "wds_uint32 const production," << std::endl
+         << indent_line(2) << "wds_uint32 const children_base);" << std::endl
+         << std::endl;
+    
+    if (true == m_push_parser)
+    {
+      file << indent_line(1) << "// The tree of the starting rule once feed() or" << std::endl
+           << indent_line(1) << "// finish() has parsed all of it." << std::endl
+           << indent_line(1) << "pt_node_t *mp_push_tree;" << std::endl
+           << std::endl
+           << indent_line(1) << "void table_push();" << std::endl
+           << std::endl;
+    }
+  }
+  
+  file << indent_line(1) << "pt_node_t *ensure_next_token_is(" << std::endl
+       << indent_line(2) << "wds_token_type const type);" << std::endl;
+  
+  file << std::endl;
+  
+  file << indent_line(1) << "bool next_token_is(" << std::endl
+       << indent_line(2) << "unsigned int const lookahead_count," << std::endl
+       << indent_line(2) << "wds_token_type const type);" << std::endl;
+  
+  file << std::endl;
+  
+  file << indent_line(1) << "token_t *lexer_peek_token(" << std::endl
+       << indent_line(2) << "unsigned int const lookahead_count);" << std::endl;
+  
+  file << std::endl;
+  
+  file << indent_line(1) << "pt_node_t *lexer_consume_token();" << std::endl;
+  
+  file << std::endl;
+  
+  file << indent_line(1) << "void lexer_scan_token(" << std::endl
+       << indent_line(2) << "token_t &token);" << std::endl;
+  
+  if (true == m_push_parser)
+  {
+    file << std::endl;
+    
+    file << indent_line(1) << "bool lexer_fill_window();" << std::endl;
+    
+    file << std::endl;
+    
+    file << indent_line(1) << "bool lexer_try_scan_token(" << std::endl
+         << indent_line(2) << "token_t &token);" << std::endl;
+  }
+  
+  file << "};" << std::endl
+       << "typedef class frontend frontend;" << std::endl;
+}
+
+void
+analyser_environment_t::dump_gen_frontend_cpp(
+  std::wfstream &file) const
+{
+  file << "#include <cassert>" << std::endl
+       << "#include <exception>" << std::endl;
+  
+  if (mp_scanner_dfa.get() != 0)
+  {
+    file << "#include <string>" << std::endl
+         << "#include <iterator>" << std::endl;
+  }
+  
+  if ((true == m_stats) ||
+      (true == m_incremental))
+  {
+    file << "#include <algorithm>" << std::endl;
+  }
+  
+  if (true == m_stats)
+  {
+    file << "#include <ostream>" << std::endl;
+  }
+  
+  file << "#include \"parser_nodes.hpp\"" << std::endl
+       << "#include \"frontend.hpp\"" << std::endl
+       << "#include \"token.hpp\"" << std::endl;
+  
+  file << std::endl;
+  
+  if (mp_scanner_dfa.get() != 0)
+  {
+    dump_gen_scanner_tables(file);
+    
+    file << std::endl;
+  }
+  
+  file << "pt_node_t *" << std::endl
+       << "frontend::ensure_next_token_is(" << std::endl
+       << indent_line(1) << "wds_token_type const type)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "if (true == next_token_is(1, type))" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "return lexer_consume_token();" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << indent_line(1) << "else" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "throw std::exception();" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl;
+  
+  file << std::endl;
+  
+  file << "bool" << std::endl
+       << "frontend::next_token_is(" << std::endl
+       << indent_line(1) << "unsigned int const lookahead_count," << std::endl
+       << indent_line(1) << "wds_token_type const type)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "token_t *token = lexer_peek_token(lookahead_count);" << std::endl
+       << indent_line(1) << "if (type == token->get_type())" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "return true;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << indent_line(1) << "else" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "return false;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl;
+  
+  file << std::endl;
+  
+  file << "token_t *" << std::endl
+       << "frontend::lexer_peek_token(" << std::endl
+       << indent_line(1) << "unsigned int const lookahead_count)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "assert(lookahead_count > 0);" << std::endl
+       << indent_line(1) << "assert(lookahead_count <= LOOKAHEAD_WINDOW_SIZE);" << std::endl
+       << std::endl;
+  
+  if (true == m_stats)
+  {
+    file << indent_line(1) << "++m_stats_peeks[lookahead_count - 1];" << std::endl
+         << std::endl;
+  }
+  
+  file << indent_line(1) << "while (m_lookahead_count < lookahead_count)" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  if (true == m_benchmark)
+  {
+    // The end of the tokens is followed by EOF, like the
+    // end of an input.
+    file << indent_line(2) << "token_t &token = m_lookahead_window[(m_lookahead_first + m_lookahead_count) & LOOKAHEAD_WINDOW_MASK];" << std::endl
+         << std::endl
+         << indent_line(2) << "if (0 == mp_token_curr)" << std::endl
+         << indent_line(2) << "{" << std::endl
+         << indent_line(3) << "lexer_scan_token(token);" << std::endl
+         << indent_line(2) << "}" << std::endl
+         << indent_line(2) << "else if (mp_token_curr != mp_token_end)" << std::endl
+         << indent_line(2) << "{" << std::endl
+         << indent_line(3) << "token = *mp_token_curr;" << std::endl
+         << indent_line(3) << "++mp_token_curr;" << std::endl
+         << indent_line(2) << "}" << std::endl
+         << indent_line(2) << "else" << std::endl
+         << indent_line(2) << "{" << std::endl
+         << indent_line(3) << "token = token_t(WDS_TOKEN_TYPE_EOF);" << std::endl
+         << indent_line(2) << "}" << std::endl
+         << std::endl;
+  }
+  else
+  {
+    file << indent_line(2) << "lexer_scan_token(m_lookahead_window[(m_lookahead_first + m_lookahead_count) & LOOKAHEAD_WINDOW_MASK]);" << std::endl;
+  }
+  
+  file << indent_line(2) << "++m_lookahead_count;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "return &m_lookahead_window[(m_lookahead_first + lookahead_count - 1) & LOOKAHEAD_WINDOW_MASK];" << std::endl
+       << "}" << std::endl;
+  
+  file << std::endl;
+  
+  file << "pt_node_t *" << std::endl
+       << "frontend::lexer_consume_token()" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "token_t * const token = lexer_peek_token(1);" << std::endl
+       << indent_line(1) << "pt_node_t *node = 0;" << std::endl
+       << std::endl
+       << indent_line(1) << "switch (token->get_type())" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  BOOST_FOREACH(token_pattern_t const &pattern, m_token_patterns)
+  {
+    std::wstring terminal_name = pattern.m_terminal_name;
+    
+    // transform it to all capital letters.
+    std::transform(terminal_name.begin(), terminal_name.end(),
+                   terminal_name.begin(),
+                   towupper);
+    
+    file << indent_line(1) << "case WDS_TOKEN_TYPE_" << terminal_name << ":" << std::endl
+         << indent_line(2) << "node = " << new_node_expression(this, L"m_node_arena") << "pt_" << pattern.m_terminal_name << "_node_t(*token);" << std::endl
+         << indent_line(2) << "break;" << std::endl
+         << std::endl;
+  }
+  
+  file << indent_line(1) << "default:" << std::endl
+       << indent_line(2) << "throw std::exception();" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl;
+  
+  if (true == m_incremental)
+  {
+    file << indent_line(1) << "m_consumed_end = token->get_offset() + token->get_length();" << std::endl
+         << std::endl;
+  }
+  
+  file << indent_line(1) << "m_lookahead_first = (m_lookahead_first + 1) & LOOKAHEAD_WINDOW_MASK;" << std::endl
+       << indent_line(1) << "--m_lookahead_count;" << std::endl
+       << indent_line(1) << "++m_consumed_token_count;" << std::endl
+       << std::endl
+       << indent_line(1) << "return node;" << std::endl
+       << "}" << std::endl;
+  
+  file << std::endl;
+  
+  // The same members as the constructor from [begin, end)
+  // initializes, the statistics go on counting.
+  file << "void" << std::endl
+       << "frontend::reset_input(" << std::endl
+       << indent_line(1) << "char const * const begin," << std::endl
+       << indent_line(1) << "char const * const end)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "mp_input_begin = begin;" << std::endl
+       << indent_line(1) << "mp_input_curr = begin;" << std::endl
+       << indent_line(1) << "mp_input_end = end;" << std::endl;
+  
+  if (true == m_push_parser)
+  {
+    file << indent_line(1) << "m_input_finished = true;" << std::endl;
+  }
+  
+  file << std::endl
+       << indent_line(1) << "m_lookahead_first = 0;" << std::endl
+       << indent_line(1) << "m_lookahead_count = 0;" << std::endl
+       << indent_line(1) << "m_consumed_token_count = 0;" << std::endl;
+  
+  if (true == m_incremental)
+  {
+    file << indent_line(1) << "m_consumed_end = 0;" << std::endl
+         << indent_line(1) << "m_examined_end = 0;" << std::endl;
+  }
+  
+  if (true == m_benchmark)
+  {
+    file << indent_line(1) << "mp_token_curr = 0;" << std::endl
+         << indent_line(1) << "mp_token_end = 0;" << std::endl;
+  }
+  
+  if (true == m_push_parser)
+  {
+    file << indent_line(1) << "mp_push_tree = 0;" << std::endl;
+  }
+  
+  file << "}" << std::endl;
+  
+  file << std::endl;
+  
+  if (true == m_benchmark)
+  {
+    file << "void" << std::endl
+         << "frontend::reset_tokens(" << std::endl
+         << indent_line(1) << "token_t const * const begin," << std::endl
+         << indent_line(1) << "token_t const * const end)" << std::endl
+         << "{" << std::endl
+         << indent_line(1) << "reset_input(0, 0);" << std::endl
+         << std::endl
+         << indent_line(1) << "mp_token_curr = begin;" << std::endl
+         << indent_line(1) << "mp_token_end = end;" << std::endl
+         << "}" << std::endl;
+    
+    file << std::endl;
+  }
+  
+  dump_gen_can_start_functions(file);
+  
+  if (true == m_stats)
+  {
+    dump_gen_stats_functions(file);
+  }
+  
+  if (true == m_incremental)
+  {
+    dump_gen_incremental_functions(file);
+  }
+  
+  if (mp_scanner_dfa.get() != 0)
+  {
+    dump_gen_scanner_functions(file);
+    
+    return;
+  }
+  
+  // No terminal has a pattern, the user will write the
+  // scanner, which scans from 'mp_input_curr' to
+  // 'mp_input_end' if the input is given to the
+  // constructor.
+  std::wstring const tokens_initializer =
+    (true == m_benchmark) ? L",\n    mp_token_curr(0),\n    mp_token_end(0)" : L"";
+  std::wstring const reset_stats_call =
+    (true == m_stats) ? L"  reset_stats();\n" : L"";
+  
+  file << "frontend::frontend()" << std::endl
+       << indent_line(1) << ": mp_input_begin(0)," << std::endl
+       << indent_line(1) << "  mp_input_curr(0)," << std::endl
+       << indent_line(1) << "  mp_input_end(0)," << std::endl
+       << indent_line(1) << "  m_lookahead_first(0)," << std::endl
+       << indent_line(1) << "  m_lookahead_count(0)," << std::endl
+       << indent_line(1) << "  m_consumed_token_count(0)" << tokens_initializer << std::endl
+       << "{" << std::endl
+       << reset_stats_call
+       << "}" << std::endl;
+  
+  file << std::endl;
+  
+  file << "frontend::frontend(" << std::endl
+       << indent_line(1) << "char const * const begin," << std::endl
+       << indent_line(1) << "char const * const end)" << std::endl
+       << indent_line(1) << ": mp_input_begin(begin)," << std::endl
+       << indent_line(1) << "  mp_input_curr(begin)," << std::endl
+       << indent_line(1) << "  mp_input_end(end)," << std::endl
+       << indent_line(1) << "  m_lookahead_first(0)," << std::endl
+       << indent_line(1) << "  m_lookahead_count(0)," << std::endl
+       << indent_line(1) << "  m_consumed_token_count(0)" << tokens_initializer << std::endl
+       << "{" << std::endl
+       << reset_stats_call
+       << "}" << std::endl;
+  
+  file << std::endl;
+  
+  file << "void" << std::endl
+       << "frontend::lexer_scan_token(" << std::endl
+       << indent_line(1) << "token_t &token)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "token = token_t(WDS_TOKEN_TYPE_EOF);" << std::endl
+       << "}" << std::endl;
+}
+
+namespace
+{
+  void
+  dump_case_stmt_for_fragment(
+    std::wfstream &file,
+    lookahead_set_t const &fragment,
+    unsigned int const indent_depth)
+  {
+    std::wstring name = fragment.mp_node->name();
+    
+    // transform it to all capital letters.
+    std::transform(name.begin(), name.end(), name.begin(), towupper);
+    
+    file << indent_line(indent_depth) << "case WDS_TOKEN_TYPE_" << name << ":" << std::endl;
+  }
+  
+  /// Whether a fragment can stop after 'fragment', i.e.
+  /// it is the last token, or the rule can end after it.
+  bool
+  fragment_can_stop_after(
+    lookahead_set_t const &fragment)
+  {
+    if (0 == fragment.m_next_level.size())
+    {
+      return true;
+    }
+    
+    BOOST_FOREACH(lookahead_set_t const &next_fragment, fragment.m_next_level)
+    {
+      if (true == next_fragment.mp_node->name().empty())
+      {
+        return true;
+      }
+    }
+    
+    return false;
+  }
+  
+  /// Dump the codes checking the token at 'level' against
+  /// the children of 'fragments', which is one level of
+  /// the FIRST_k trie of a rule (see first_k_fragments()).
+  void
+  dump_can_start_level(
+    std::wfstream &file,
+    lookahead_set_t const &fragments,
+    unsigned int const level,
+    unsigned int const indent_depth)
+  {
+    BOOST_FOREACH(lookahead_set_t const &fragment, fragments.m_next_level)
+    {
+      if (true == fragment.mp_node->name().empty())
+      {
+        // The rule can end before this token, and I don't
+        // know what follows the rule here, so that any
+        // token is fine.
+        file << indent_line(indent_depth) << "return true;" << std::endl;
+        
+        return;
+      }
+    }
+    
+    file << indent_line(indent_depth) << "switch (lexer_peek_token(" << level << ")->get_type())" << std::endl
+         << indent_line(indent_depth) << "{" << std::endl;
+    
+    // The tokens which a fragment can stop after share one
+    // 'return'.
+    bool has_last_token = false;
+    
+    BOOST_FOREACH(lookahead_set_t const &fragment, fragments.m_next_level)
+    {
+      if (true == fragment_can_stop_after(fragment))
+      {
+        dump_case_stmt_for_fragment(file, fragment, indent_depth);
+        
+        has_last_token = true;
+      }
+    }
+    
+    if (true == has_last_token)
+    {
+      file << indent_line(indent_depth + 1) << "return true;" << std::endl
+           << std::endl;
+    }
+    
+    BOOST_FOREACH(lookahead_set_t const &fragment, fragments.m_next_level)
+    {
+      if (false == fragment_can_stop_after(fragment))
+      {
+        dump_case_stmt_for_fragment(file, fragment, indent_depth);
+        
+        file << indent_line(indent_depth + 1) << "if (depth <= " << level << ")" << std::endl
+             << indent_line(indent_depth + 1) << "{" << std::endl
+             << indent_line(indent_depth + 2) << "return true;" << std::endl
+             << indent_line(indent_depth + 1) << "}" << std::endl
+             << std::endl;
+        
+        dump_can_start_level(file, fragment, level + 1, indent_depth + 1);
+        
+        file << std::endl;
+      }
+    }
+    
+    file << indent_line(indent_depth) << "default:" << std::endl
+         << indent_line(indent_depth + 1) << "return false;" << std::endl
+         << indent_line(indent_depth) << "}" << std::endl;
+  }
+}
+
+/// Dump 'can_start_XXX(depth)' for each rule, which tells
+/// whether the next 'depth' tokens are the first tokens of
+/// some XXX. The generated parser always consumes what it
+/// parses, so that a caller uses these predicates instead
+/// of a parsing dry run to see if the input fits.
+///
+/// The predicates are built from the same FIRST_k sets as
+/// the lookahead search (see first_k_fragments()).
+void
+analyser_environment_t::dump_gen_can_start_functions(
+  std::wfstream &file) const
+{
+  BOOST_FOREACH(node_t * const node, m_top_level_nodes)
+  {
+    file << "bool" << std::endl
+         << "frontend::can_start_" << node->name() << "(" << std::endl
+         << indent_line(1) << "unsigned int const depth)" << std::endl
+         << "{" << std::endl
+         << indent_line(1) << "assert(depth > 0);" << std::endl
+         << indent_line(1) << "assert(depth <= " << m_max_lookahead_searching_depth << ");" << std::endl
+         << std::endl;
+    
+    lookahead_set_t const * const fragments =
+      first_k_fragments(node, m_max_lookahead_searching_depth);
+    
+    if (0 == fragments)
+    {
+      // This rule is left recursive through a nullable
+      // prefix, so that its FIRST_k set can not be
+      // computed, the predicate accepts anything.
+      log(L"<WARNING>: can not compute the FIRST_k set of %s, can_start_%s always returns true.\n",
+          node->name().c_str(),
+          node->name().c_str());
+      
+      file << indent_line(1) << "return true;" << std::endl;
+    }
+    else
+    {
+      dump_can_start_level(file, *fragments, 1, 1);
+    }
+    
+    file << "}" << std::endl
+         << std::endl;
+  }
+}
+
+/// Dump frontend::dump_stats() and frontend::reset_stats()
+/// of the '--stats' option, with the names of the rules
+/// and of the decision cases they count.
+void
+analyser_environment_t::dump_gen_stats_functions(
+  std::wfstream &file) const
+{
+  assert(true == m_stats);
+  
+  file << "namespace" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "char const * const stats_rule_names[] =" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    file << indent_line(2) << "\"" << node->name() << "\"," << std::endl;
+  }
+  
+  file << indent_line(1) << "};" << std::endl;
+  
+  if (m_stats_cases.size() != 0)
+  {
+    file << std::endl
+         << indent_line(1) << "char const * const stats_case_names[] =" << std::endl
+         << indent_line(1) << "{" << std::endl;
+    
+    BOOST_FOREACH(std::wstring const &description, m_stats_cases)
+    {
+      file << indent_line(2) << "\"" << description << "\"," << std::endl;
+    }
+    
+    file << indent_line(1) << "};" << std::endl;
+  }
+  
+  file << "}" << std::endl
+       << std::endl;
+  
+  file << "void" << std::endl
+       << "frontend::dump_stats(" << std::endl
+       << indent_line(1) << "std::ostream &out) const" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "out << \"rule calls:\" << std::endl;" << std::endl
+       << std::endl
+       << indent_line(1) << "for (unsigned int i = 0; i < STATS_RULE_COUNT; ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "out << \"  \" << stats_rule_names[i] << \": \" << m_stats_rule_calls[i] << std::endl;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "out << \"peeks:\" << std::endl;" << std::endl
+       << std::endl
+       << indent_line(1) << "for (unsigned int i = 0; i < " << m_max_lookahead_searching_depth << "; ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "out << \"  token \" << (i + 1) << \": \" << m_stats_peeks[i] << std::endl;" << std::endl
+       << indent_line(1) << "}" << std::endl;
+  
+  if (m_stats_cases.size() != 0)
+  {
+    file << std::endl
+         << indent_line(1) << "out << \"decision cases:\" << std::endl;" << std::endl
+         << std::endl
+         << indent_line(1) << "for (unsigned int i = 0; i < STATS_CASE_COUNT; ++i)" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "out << \"  \" << stats_case_names[i] << \": \" << m_stats_cases[i] << std::endl;" << std::endl
+         << indent_line(1) << "}" << std::endl;
+  }
+  
+  file << "}" << std::endl
+       << std::endl;
+  
+  file << "void" << std::endl
+       << "frontend::reset_stats()" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "std::fill(m_stats_rule_calls, m_stats_rule_calls + STATS_RULE_COUNT, 0UL);" << std::endl
+       << indent_line(1) << "std::fill(m_stats_peeks, m_stats_peeks + LOOKAHEAD_WINDOW_SIZE, 0UL);" << std::endl;
+  
+  if (m_stats_cases.size() != 0)
+  {
+    file << indent_line(1) << "std::fill(m_stats_cases, m_stats_cases + STATS_CASE_COUNT, 0UL);" << std::endl;
+  }
+  
+  file << "}" << std::endl
+       << std::endl;
 }
 
+/// Dump 'pt_arena_t', the bump allocator of the parse tree
+/// nodes used with the 'use_node_arena' option.
+///
+/// The arena gets its memory in blocks, and 'reset()'
+/// just rewinds to the first block, and keeps all the
+/// blocks for the next parse. The destructors of the
+/// nodes are not called, except the ones registered by
+/// 'destroy_on_reset()', which are the nodes of regexes
+/// owning std::vector members.
+///
+/// With the '--incremental' option, the nodes replaced by
+/// incremental_parse() are given back by 'recycle()' to a
+/// free list of their size, and the memory allocated by a
+/// parse which has to be undone is logged, so that it can
+/// be recycled at once.
 void
-analyser_environment_t::dump_gen_frontend_hpp(
+analyser_environment_t::dump_gen_node_arena(
   std::wfstream &file) const
 {
-  file << "#include <cassert>" << std::endl
-       << "#include <exception>" << std::endl
-       << "#include <deque>" << std::endl
-       << "#include \"parser_nodes.hpp\"" << std::endl
-       << "#include \"parser_basic_types.hpp\"" << std::endl;
-  
-  file << std::endl;
-  
-  file << "class token_t;" << std::endl;
+  assert(true == m_use_node_arena);
   
-  file << std::endl;
-  
-  file << "class frontend" << std::endl
+  file << "class pt_arena_t" << std::endl
        << "{" << std::endl
        << "private:" << std::endl
        << std::endl
-       << indent_line(1) << "typedef std::deque<token_t *> lookahead_queue_type;" << std::endl
-       << std::endl;
+       << "  struct block_t" << std::endl
+       << "  {" << std::endl
+       << "    block_t *mp_next;" << std::endl
+       << "    std::size_t m_size;" << std::endl
+       << "  };" << std::endl
+       << std::endl
+       << "  union align_t" << std::endl
+       << "  {" << std::endl
+       << "    double m_double;" << std::endl
+       << "    long m_long;" << std::endl
+       << "    void *mp_pointer;" << std::endl
+       << "  };" << std::endl
+       << std::endl
+       << "  enum" << std::endl
+       << "  {" << std::endl
+       << "    ALIGNMENT = sizeof(align_t)," << std::endl
+       << "    HEADER_SIZE = (sizeof(block_t) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT," << std::endl
+       << "    DEFAULT_BLOCK_SIZE = 64 * 1024";
   
-  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  if (true == m_incremental)
   {
-    file << indent_line(1) << "pt_node_t *parse_" << node->name()
-         << "(bool const consume);" << std::endl;
+    file << "," << std::endl
+         << "    FREE_LIST_COUNT = 32";
   }
   
-  file << std::endl;
-  
-  file << indent_line(1) << "void add_node_to_nodes(" << std::endl
-       << indent_line(2) << "std::list<pt_node_t *> &nodes," << std::endl
-       << indent_line(2) << "pt_node_t * const node);" << std::endl;
-  
-  file << std::endl;
+  file << std::endl
+       << "  };" << std::endl
+       << std::endl
+       << "  typedef void (*destroy_func_t)(void *);" << std::endl
+       << std::endl
+       << "  block_t *mp_first_block;" << std::endl
+       << "  block_t *mp_curr_block;" << std::endl
+       << "  char *mp_curr;" << std::endl
+       << "  char *mp_end;" << std::endl
+       << "  std::vector<std::pair<void *, destroy_func_t> > m_objects_to_destroy;" << std::endl
+       << std::endl;
   
-  file << indent_line(1) << "pt_node_t *ensure_next_token_is(" << std::endl
-       << indent_line(2) << "wds_token_type const type," << std::endl
-       << indent_line(2) << "bool const consume);" << std::endl;
+  if (true == m_incremental)
+  {
+    // The memory of a free list links to the next one, a
+    // size of FREE_LIST_COUNT * ALIGNMENT or more is not
+    // recycled, which no node is.
+    file << "  // The recycled memory by its size in ALIGNMENT, and the" << std::endl
+         << "  // memory allocated while 'm_logging'." << std::endl
+         << "  void *mp_free_lists[FREE_LIST_COUNT];" << std::endl
+         << "  bool m_logging;" << std::endl
+         << "  std::vector<std::pair<void *, std::size_t> > m_log;" << std::endl
+         << std::endl;
+  }
   
-  file << std::endl;
+  file << "  pt_arena_t(pt_arena_t const &);" << std::endl
+       << "  pt_arena_t &operator=(pt_arena_t const &);" << std::endl
+       << std::endl
+       << "  template<typename T>" << std::endl
+       << "  static void destroy(void * const object)" << std::endl
+       << "  { static_cast<T *>(object)->~T(); }" << std::endl
+       << std::endl
+       << "  // Move to the next block which is big enough, or" << std::endl
+       << "  // insert a new block after the current one." << std::endl
+       << "  void *allocate_from_next_block(std::size_t const size)" << std::endl
+       << "  {" << std::endl
+       << "    block_t *block = (mp_curr_block != 0) ? mp_curr_block->mp_next : mp_first_block;" << std::endl
+       << std::endl
+       << "    if ((0 == block) || (block->m_size < size))" << std::endl
+       << "    {" << std::endl
+       << "      std::size_t const default_block_size = static_cast<std::size_t>(DEFAULT_BLOCK_SIZE);" << std::endl
+       << "      std::size_t const block_size = (size > default_block_size) ? size : default_block_size;" << std::endl
+       << "      block_t * const new_block = static_cast<block_t *>(::operator new(HEADER_SIZE + block_size));" << std::endl
+       << std::endl
+       << "      new_block->mp_next = block;" << std::endl
+       << "      new_block->m_size = block_size;" << std::endl
+       << std::endl
+       << "      if (0 == mp_curr_block)" << std::endl
+       << "      {" << std::endl
+       << "        mp_first_block = new_block;" << std::endl
+       << "      }" << std::endl
+       << "      else" << std::endl
+       << "      {" << std::endl
+       << "        mp_curr_block->mp_next = new_block;" << std::endl
+       << "      }" << std::endl
+       << std::endl
+       << "      block = new_block;" << std::endl
+       << "    }" << std::endl
+       << std::endl
+       << "    mp_curr_block = block;" << std::endl
+       << "    mp_curr = reinterpret_cast<char *>(block) + HEADER_SIZE;" << std::endl
+       << "    mp_end = mp_curr + block->m_size;" << std::endl
+       << std::endl
+       << "    char * const object = mp_curr;" << std::endl
+       << "    mp_curr += size;" << std::endl
+       << "    return object;" << std::endl
+       << "  }" << std::endl
+       << std::endl
+       << "public:" << std::endl
+       << std::endl
+       << "  pt_arena_t()" << std::endl
+       << "    : mp_first_block(0)," << std::endl
+       << "      mp_curr_block(0)," << std::endl
+       << "      mp_curr(0)," << std::endl
+       << "      mp_end(0)";
   
-  file << indent_line(1) << "bool next_token_is(" << std::endl
-       << indent_line(2) << "lookahead_queue_type::size_type const lookahead_count," << std::endl
-       << indent_line(2) << "wds_token_type const type);" << std::endl;
+  if (true == m_incremental)
+  {
+    file << "," << std::endl
+         << "      m_logging(false)" << std::endl
+         << "  {" << std::endl
+         << "    reset();" << std::endl
+         << "  }" << std::endl;
+  }
+  else
+  {
+    file << std::endl
+         << "  { }" << std::endl;
+  }
   
-  file << std::endl;
+  file << std::endl
+       << "  ~pt_arena_t()" << std::endl
+       << "  {" << std::endl
+       << "    reset();" << std::endl
+       << std::endl
+       << "    while (mp_first_block != 0)" << std::endl
+       << "    {" << std::endl
+       << "      block_t * const next_block = mp_first_block->mp_next;" << std::endl
+       << "      ::operator delete(mp_first_block);" << std::endl
+       << "      mp_first_block = next_block;" << std::endl
+       << "    }" << std::endl
+       << "  }" << std::endl
+       << std::endl
+       << "  void *allocate(std::size_t size)" << std::endl
+       << "  {" << std::endl
+       << "    size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;" << std::endl
+       << std::endl;
   
-  file << indent_line(1) << "token_t *lexer_peek_token(" << std::endl
-       << indent_line(2) << "lookahead_queue_type::size_type const lookahead_count);" << std::endl;
+  if (true == m_incremental)
+  {
+    file << "    void *object;" << std::endl
+         << std::endl
+         << "    if ((size / ALIGNMENT < FREE_LIST_COUNT) && (mp_free_lists[size / ALIGNMENT] != 0))" << std::endl
+         << "    {" << std::endl
+         << "      object = mp_free_lists[size / ALIGNMENT];" << std::endl
+         << "      mp_free_lists[size / ALIGNMENT] = *static_cast<void **>(object);" << std::endl
+         << "    }" << std::endl
+         << "    else if (static_cast<std::size_t>(mp_end - mp_curr) < size)" << std::endl
+         << "    {" << std::endl
+         << "      object = allocate_from_next_block(size);" << std::endl
+         << "    }" << std::endl
+         << "    else" << std::endl
+         << "    {" << std::endl
+         << "      object = mp_curr;" << std::endl
+         << "      mp_curr += size;" << std::endl
+         << "    }" << std::endl
+         << std::endl
+         << "    if (true == m_logging)" << std::endl
+         << "    {" << std::endl
+         << "      m_log.push_back(std::make_pair(object, size));" << std::endl
+         << "    }" << std::endl
+         << std::endl
+         << "    return object;" << std::endl
+         << "  }" << std::endl
+         << std::endl
+         << "  // Give the memory of an object back, the next" << std::endl
+         << "  // allocation of the same size takes it." << std::endl
+         << "  void recycle(void * const object, std::size_t size)" << std::endl
+         << "  {" << std::endl
+         << "    size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;" << std::endl
+         << std::endl
+         << "    if (size / ALIGNMENT < FREE_LIST_COUNT)" << std::endl
+         << "    {" << std::endl
+         << "      *static_cast<void **>(object) = mp_free_lists[size / ALIGNMENT];" << std::endl
+         << "      mp_free_lists[size / ALIGNMENT] = object;" << std::endl
+         << "    }" << std::endl
+         << "  }" << std::endl
+         << std::endl
+         << "  // Log the memory allocated from now on, until" << std::endl
+         << "  // stop_log() or recycle_log()." << std::endl
+         << "  void start_log()" << std::endl
+         << "  {" << std::endl
+         << "    m_log.clear();" << std::endl
+         << "    m_logging = true;" << std::endl
+         << "  }" << std::endl
+         << std::endl
+         << "  void stop_log()" << std::endl
+         << "  {" << std::endl
+         << "    m_log.clear();" << std::endl
+         << "    m_logging = false;" << std::endl
+         << "  }" << std::endl
+         << std::endl
+         << "  // Recycle the memory allocated since start_log(), the" << std::endl
+         << "  // objects in it are not destroyed." << std::endl
+         << "  void recycle_log()" << std::endl
+         << "  {" << std::endl
+         << "    m_logging = false;" << std::endl
+         << std::endl
+         << "    for (size_t i = 0; i < m_log.size(); ++i)" << std::endl
+         << "    {" << std::endl
+         << "      recycle(m_log[i].first, m_log[i].second);" << std::endl
+         << "    }" << std::endl
+         << std::endl
+         << "    m_log.clear();" << std::endl
+         << "  }" << std::endl
+         << std::endl;
+  }
+  else
+  {
+    file << "    if (static_cast<std::size_t>(mp_end - mp_curr) < size)" << std::endl
+         << "    {" << std::endl
+         << "      return allocate_from_next_block(size);" << std::endl
+         << "    }" << std::endl
+         << std::endl
+         << "    char * const object = mp_curr;" << std::endl
+         << "    mp_curr += size;" << std::endl
+         << "    return object;" << std::endl
+         << "  }" << std::endl
+         << std::endl;
+  }
   
-  file << std::endl;
+  file << "  // Call the destructor of 'object' when the arena is" << std::endl
+       << "  // reset, for the objects owning memory out of the" << std::endl
+       << "  // arena." << std::endl
+       << "  template<typename T>" << std::endl
+       << "  void destroy_on_reset(T * const object)" << std::endl
+       << "  {" << std::endl
+       << "    m_objects_to_destroy.push_back(" << std::endl
+       << "      std::make_pair(static_cast<void *>(object), &pt_arena_t::destroy<T>));" << std::endl
+       << "  }" << std::endl
+       << std::endl
+       << "  // Free all the objects in the arena at once." << std::endl
+       << "  void reset()" << std::endl
+       << "  {" << std::endl
+       << "    while (false == m_objects_to_destroy.empty())" << std::endl
+       << "    {" << std::endl
+       << "      m_objects_to_destroy.back().second(m_objects_to_destroy.back().first);" << std::endl
+       << "      m_objects_to_destroy.pop_back();" << std::endl
+       << "    }" << std::endl
+       << std::endl
+       << "    mp_curr_block = 0;" << std::endl
+       << "    mp_curr = 0;" << std::endl
+       << "    mp_end = 0;" << std::endl;
   
-  file << indent_line(1) << "pt_node_t *lexer_consume_token(" << std::endl
-       << indent_line(2) << "bool const consume);" << std::endl;
+  if (true == m_incremental)
+  {
+    file << std::endl
+         << "    for (unsigned int i = 0; i < FREE_LIST_COUNT; ++i)" << std::endl
+         << "    {" << std::endl
+         << "      mp_free_lists[i] = 0;" << std::endl
+         << "    }" << std::endl
+         << std::endl
+         << "    m_log.clear();" << std::endl;
+  }
   
-  file << "};" << std::endl
-       << "typedef class frontend frontend;" << std::endl;
+  file << "  }" << std::endl
+       << "};" << std::endl
+       << "typedef class pt_arena_t pt_arena_t;" << std::endl
+       << std::endl;
 }
 
+/// Dump the 'operator new' and 'operator delete' of the
+/// base classes of the parse tree nodes, which construct
+/// the nodes in the arena with a placement new, ex:
+///
+///   new (m_node_arena) pt_XXX_node_t
+///
+/// The usual 'operator new' is hidden by them, so that a
+/// node can not be put on the heap by mistake, and
+/// deleting a node only calls its destructor.
 void
-analyser_environment_t::dump_gen_frontend_cpp(
+analyser_environment_t::dump_gen_node_arena_operators(
   std::wfstream &file) const
 {
-  file << "#include <cassert>" << std::endl
-       << "#include <list>" << std::endl
-       << "#include <exception>" << std::endl
-       << "#include \"parser_nodes.hpp\"" << std::endl
-       << "#include \"frontend.hpp\"" << std::endl
-       << "#include \"token.hpp\"" << std::endl;
-  
-  file << std::endl;
-  
-  file << "void" << std::endl
-       << "frontend::add_node_to_nodes(" << std::endl
-       << "  std::list<pt_node_t *> &nodes," << std::endl
-       << "  pt_node_t * const node)" << std::endl
-       << "{" << std::endl
-       << "  assert(node != 0);" << std::endl
-       << "  nodes.push_back(node);" << std::endl
-       << "}" << std::endl;
-  
-  file << std::endl;
-  
-  file << "pt_node_t *" << std::endl
-       << "frontend::ensure_next_token_is(" << std::endl
-       << indent_line(1) << "wds_token_type const type," << std::endl
-       << indent_line(1) << "bool const consume)" << std::endl
-       << "{" << std::endl
-       << indent_line(1) << "if (true == next_token_is(1, type))" << std::endl
-       << indent_line(1) << "{" << std::endl
-       << indent_line(2) << "return lexer_consume_token(consume);" << std::endl
-       << indent_line(1) << "}" << std::endl
-       << indent_line(1) << "else" << std::endl
-       << indent_line(1) << "{" << std::endl
-       << indent_line(2) << "throw std::exception();" << std::endl
-       << indent_line(1) << "}" << std::endl
-       << "}" << std::endl;
-  
-  file << std::endl;
-  
-  file << "bool" << std::endl
-       << "frontend::next_token_is(" << std::endl
-       << indent_line(1) << "lookahead_queue_type::size_type const lookahead_count," << std::endl
-       << indent_line(1) << "wds_token_type const type)" << std::endl
-       << "{" << std::endl
-       << indent_line(1) << "token_t *token = lexer_peek_token(lookahead_count);" << std::endl
-       << indent_line(1) << "if (type == token->get_type())" << std::endl
-       << indent_line(1) << "{" << std::endl
-       << indent_line(2) << "return true;" << std::endl
-       << indent_line(1) << "}" << std::endl
-       << indent_line(1) << "else" << std::endl
-       << indent_line(1) << "{" << std::endl
-       << indent_line(2) << "return false;" << std::endl
-       << indent_line(1) << "}" << std::endl
-       << "}" << std::endl;
-  
-  file << std::endl;
-  
-  file << "token_t *" << std::endl
-       << "frontend::lexer_peek_token(" << std::endl
-       << indent_line(1) << "lookahead_queue_type::size_type const lookahead_count)" << std::endl
-       << "{" << std::endl
-       << indent_line(1) << "return 0;" << std::endl
-       << "}" << std::endl;
-  
-  file << std::endl;
+  if (false == m_use_node_arena)
+  {
+    return;
+  }
   
-  file << "pt_node_t *" << std::endl
-       << "frontend::lexer_consume_token(" << std::endl
-       << indent_line(1) << "bool const consume)" << std::endl
-       << "{" << std::endl
-       << indent_line(1) << "return 0;" << std::endl
-       << "}" << std::endl;
+  file << std::endl
+       << "  static void *operator new(std::size_t const size, pt_arena_t &arena)" << std::endl
+       << "  { return arena.allocate(size); }" << std::endl
+       << "  static void operator delete(void *, pt_arena_t &) {}" << std::endl
+       << "  static void operator delete(void *) {}" << std::endl;
 }
 
 void
@@ -975,6 +3332,25 @@ analyser_environment_t::dump_gen_parser_basic_types_hpp(
        << "typedef unsigned short wds_uint16;" << std::endl
        << "typedef unsigned int   wds_uint32;" << std::endl << std::endl;
   
+  if (true == m_profile)
+  {
+    // The hint of the hot cases of the '--profile' option.
+    file << "#if defined(__GNUC__)" << std::endl
+         << "#define WDS_LIKELY(x) __builtin_expect(!!(x), 1)" << std::endl
+         << "#else" << std::endl
+         << "#define WDS_LIKELY(x) (x)" << std::endl
+         << "#endif" << std::endl
+         << std::endl;
+  }
+  
+  if (token_class_mask_word_count(this) != 0)
+  {
+    // The test of a token type against a token class
+    // mask, see dump_token_class_mask().
+    file << "#define WDS_TOKEN_IN_CLASS(mask, type) ((((mask)[(type) >> 5]) >> ((type) & 31)) & 1)" << std::endl
+         << std::endl;
+  }
+  
   file << "#endif" << std::endl;
 }
 
@@ -986,16 +3362,61 @@ analyser_environment_t::dump_gen_token_hpp(
        << "#define __token_hpp__" << std::endl
        << std::endl;
   
+  file << "#include \"parser_basic_types.hpp\"" << std::endl;
+  
+  // The tokens live in the lookahead window of the
+  // frontend by value, so that token_t needs a default
+  // constructor. A token does not own its text, it is
+  // the offset and the length of the text in the input of
+  // the frontend, so that copying a token copies no
+  // bytes of the input.
+  file << std::endl;
+  
   file << "class token_t" << std::endl
        << "{" << std::endl
        << "private:" << std::endl
        << std::endl
        << indent_line(1) << "wds_token_type m_type;" << std::endl
+       << indent_line(1) << "wds_uint32 m_offset;" << std::endl
+       << indent_line(1) << "wds_uint32 m_length;" << std::endl
        << std::endl
        << "public:" << std::endl
        << std::endl
+       << indent_line(1) << "token_t()" << std::endl
+       << indent_line(2) << ": m_type(WDS_TOKEN_TYPE_EOF)," << std::endl
+       << indent_line(3) << "m_offset(0)," << std::endl
+       << indent_line(3) << "m_length(0)" << std::endl
+       << indent_line(1) << "{ }" << std::endl
+       << std::endl
+       << indent_line(1) << "explicit token_t(" << std::endl
+       << indent_line(2) << "wds_token_type const type," << std::endl
+       << indent_line(2) << "wds_uint32 const offset = 0," << std::endl
+       << indent_line(2) << "wds_uint32 const length = 0)" << std::endl
+       << indent_line(2) << ": m_type(type)," << std::endl
+       << indent_line(3) << "m_offset(offset)," << std::endl
+       << indent_line(3) << "m_length(length)" << std::endl
+       << indent_line(1) << "{ }" << std::endl
+       << std::endl
+       << indent_line(1) << "void assign(" << std::endl
+       << indent_line(2) << "wds_token_type const type," << std::endl
+       << indent_line(2) << "wds_uint32 const offset," << std::endl
+       << indent_line(2) << "wds_uint32 const length)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "m_type = type;" << std::endl
+       << indent_line(2) << "m_offset = offset;" << std::endl
+       << indent_line(2) << "m_length = length;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
        << indent_line(1) << "wds_token_type get_type() const" << std::endl
        << indent_line(1) << "{ return m_type; }" << std::endl
+       << std::endl
+       << indent_line(1) << "// The text of the token in the input, see" << std::endl
+       << indent_line(1) << "// frontend::token_text()." << std::endl
+       << indent_line(1) << "wds_uint32 get_offset() const" << std::endl
+       << indent_line(1) << "{ return m_offset; }" << std::endl
+       << std::endl
+       << indent_line(1) << "wds_uint32 get_length() const" << std::endl
+       << indent_line(1) << "{ return m_length; }" << std::endl
        << "};" << std::endl
        << "typedef class token_t token_t;" << std::endl
        << std::endl;
@@ -1003,24 +3424,190 @@ analyser_environment_t::dump_gen_token_hpp(
   file << "#endif" << std::endl;
 }
 
+void
+analyser_environment_t::dump_gen_mapped_file_hpp(
+  std::wfstream &file) const
+{
+  // A frontend scans a mapped file in place. This is the
+  // only generated file using the API of the operating
+  // system, and only the caller includes it.
+  file << "#ifndef __mapped_file_hpp__" << std::endl
+       << "#define __mapped_file_hpp__" << std::endl
+       << std::endl
+       << "// Map a file into the memory for reading, ex:" << std::endl
+       << "//" << std::endl
+       << "//   mapped_file_t file(\"input.txt\");" << std::endl
+       << "//   frontend parser(file.begin(), file.end());" << std::endl
+       << "//" << std::endl
+       << "// The file has to outlive the frontend and the parse" << std::endl
+       << "// trees. It throws std::exception if the file can not" << std::endl
+       << "// be mapped." << std::endl
+       << std::endl
+       << "#include <exception>" << std::endl
+       << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << "#include <windows.h>" << std::endl
+       << "#else" << std::endl
+       << "#include <fcntl.h>" << std::endl
+       << "#include <unistd.h>" << std::endl
+       << "#include <sys/mman.h>" << std::endl
+       << "#include <sys/stat.h>" << std::endl
+       << "#endif" << std::endl
+       << std::endl;
+  
+  file << "class mapped_file_t" << std::endl
+       << "{" << std::endl
+       << "private:" << std::endl
+       << std::endl
+       << indent_line(1) << "char const *mp_begin;" << std::endl
+       << indent_line(1) << "char const *mp_end;" << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(1) << "HANDLE m_mapping;" << std::endl
+       << "#endif" << std::endl
+       << std::endl
+       << indent_line(1) << "mapped_file_t(mapped_file_t const &);" << std::endl
+       << indent_line(1) << "mapped_file_t &operator=(mapped_file_t const &);" << std::endl
+       << std::endl
+       << "public:" << std::endl
+       << std::endl
+       << indent_line(1) << "explicit mapped_file_t(" << std::endl
+       << indent_line(2) << "char const * const filename)" << std::endl
+       << indent_line(2) << ": mp_begin(0)," << std::endl
+       << indent_line(3) << "mp_end(0)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(2) << "m_mapping = 0;" << std::endl
+       << std::endl
+       << indent_line(2) << "HANDLE const handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0," << std::endl
+       << indent_line(2) << "                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);" << std::endl
+       << std::endl
+       << indent_line(2) << "if (INVALID_HANDLE_VALUE == handle)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "throw std::exception();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "LARGE_INTEGER size;" << std::endl
+       << std::endl
+       << indent_line(2) << "if (0 == GetFileSizeEx(handle, &size))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "CloseHandle(handle);" << std::endl
+       << indent_line(3) << "throw std::exception();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "if (0 == size.QuadPart)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "// An empty file can not be mapped." << std::endl
+       << indent_line(3) << "CloseHandle(handle);" << std::endl
+       << indent_line(3) << "return;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "// The mapping keeps the file open." << std::endl
+       << indent_line(2) << "m_mapping = CreateFileMappingA(handle, 0, PAGE_READONLY, 0, 0, 0);" << std::endl
+       << indent_line(2) << "CloseHandle(handle);" << std::endl
+       << std::endl
+       << indent_line(2) << "if (0 == m_mapping)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "throw std::exception();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "mp_begin = static_cast<char const *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));" << std::endl
+       << std::endl
+       << indent_line(2) << "if (0 == mp_begin)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "CloseHandle(m_mapping);" << std::endl
+       << indent_line(3) << "throw std::exception();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "mp_end = mp_begin + size.QuadPart;" << std::endl
+       << "#else" << std::endl
+       << indent_line(2) << "int const fd = open(filename, O_RDONLY);" << std::endl
+       << std::endl
+       << indent_line(2) << "if (fd < 0)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "throw std::exception();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "struct stat status;" << std::endl
+       << indent_line(2) << "void *address = 0;" << std::endl
+       << std::endl
+       << indent_line(2) << "if (fstat(fd, &status) != 0)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "address = MAP_FAILED;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(2) << "else if (status.st_size != 0)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "// An empty file can not be mapped." << std::endl
+       << indent_line(3) << "address = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "// The mapping keeps the file open." << std::endl
+       << indent_line(2) << "close(fd);" << std::endl
+       << std::endl
+       << indent_line(2) << "if (MAP_FAILED == address)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "throw std::exception();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "if (address != 0)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "mp_begin = static_cast<char const *>(address);" << std::endl
+       << indent_line(3) << "mp_end = mp_begin + status.st_size;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << "#endif" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "~mapped_file_t()" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "if (0 == mp_begin)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "return;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(2) << "UnmapViewOfFile(mp_begin);" << std::endl
+       << indent_line(2) << "CloseHandle(m_mapping);" << std::endl
+       << "#else" << std::endl
+       << indent_line(2) << "munmap(const_cast<char *>(mp_begin), mp_end - mp_begin);" << std::endl
+       << "#endif" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "char const *begin() const" << std::endl
+       << indent_line(1) << "{ return mp_begin; }" << std::endl
+       << std::endl
+       << indent_line(1) << "char const *end() const" << std::endl
+       << indent_line(1) << "{ return mp_end; }" << std::endl
+       << "};" << std::endl
+       << "typedef class mapped_file_t mapped_file_t;" << std::endl
+       << std::endl;
+  
+  file << "#endif" << std::endl;
+}
+
 void
 dump_pt_XXX_prodn_node_t_class_header(
   std::wfstream &file,
   std::wstring const &rule_node_name,
   int const alternative_id)
 {
+  // The members are assigned by the parser directly.
   file << "class pt_" << rule_node_name << "_prod" << alternative_id
        << "_node_t : public pt_" << rule_node_name << "_prod_node_t" << std::endl
        << "{" << std::endl
+       << "  friend class frontend;" << std::endl
+       << std::endl
        << "private:" << std::endl
        << std::endl;
 }
 
+/// 'alternative_start' is the first node of a BNF
+/// alternative, whose children are listed for the
+/// '--incremental' option, or 0 for a regex alternative.
 void
 dump_pt_XXX_prodn_node_t_class_footer(
   std::wfstream &file,
   std::wstring const &rule_node_name,
-  int const alternative_id)
+  int const alternative_id,
+  node_t const * const alternative_start)
 {
   file << std::endl
        << "public:" << std::endl
@@ -1030,9 +3617,42 @@ dump_pt_XXX_prodn_node_t_class_footer(
        << "  // destructor " << std::endl
        << "  ~pt_" << rule_node_name << "_prod" << alternative_id << "_node_t();" << std::endl
        << std::endl
-       << "  virtual void fill_nodes(std::list<pt_node_t *> const &nodes);" << std::endl
-       << "  virtual void check_semantic() const {};" << std::endl
-       << "};" << std::endl
+       << "  virtual void check_semantic() const {};" << std::endl;
+  
+  if ((alternative_start != 0) &&
+      (true == alternative_start->ae()->incremental()))
+  {
+    unsigned int child_count = 0;
+    
+    for (node_t const *curr_node = alternative_start;
+         curr_node->name().size() != 0;
+         curr_node = curr_node->next_nodes().front())
+    {
+      ++child_count;
+    }
+    
+    // The children of a rule node are forward declared
+    // only here, so that child() and set_child() are in
+    // parser_node_XXX.cpp.
+    if (child_count != 0)
+    {
+      file << std::endl
+           << "  virtual unsigned int child_count() const" << std::endl
+           << "  { return " << child_count << "; }" << std::endl
+           << "  virtual pt_node_t *child(unsigned int const i) const;" << std::endl
+           << "  virtual void set_child(unsigned int const i, pt_node_t * const node);" << std::endl;
+    }
+    
+    std::wstringstream class_name;
+    
+    class_name << "pt_" << rule_node_name << "_prod" << alternative_id << "_node_t";
+    
+    file << std::endl;
+    
+    dump_gen_recycle(file, class_name.str(), false);
+  }
+  
+  file << "};" << std::endl
        << "typedef class pt_" << rule_node_name << "_prod" << alternative_id
        << "_node_t pt_" << rule_node_name << "_prod" << alternative_id << "_node_t;"
        << std::endl << std::endl;
@@ -1050,7 +3670,6 @@ node_t::dump_gen_parser_header(
        << "{" << std::endl
        << "public:" << std::endl
        << std::endl
-       << "  virtual void fill_nodes(std::list<pt_node_t *> const &nodes) = 0;" << std::endl
        << "  virtual void check_semantic() const = 0;" << std::endl
        << "};" << std::endl
        << "typedef class pt_" << m_name << "_prod_node_t pt_" << m_name << "_prod_node_t;" << std::endl
@@ -1091,8 +3710,55 @@ node_t::dump_gen_parser_header(
        << std::endl
        << "  void set_prod_node(pt_" << m_name << "_prod_node_t *const &node)" << std::endl
        << "  { mp_prod_node = node; }" << std::endl
-       << "  void check_semantic() const { mp_prod_node->check_semantic(); }" << std::endl
-       << "};" << std::endl
+       << "  void check_semantic() const { mp_prod_node->check_semantic(); }" << std::endl;
+  
+  if (false == mp_ae->use_node_arena())
+  {
+    // Without the node arena, a tree owns its nodes, so that
+    // deleting the root frees all of it.
+    file << std::endl
+         << "  pt_" << m_name << "_node_t()" << std::endl
+         << "    : mp_prod_node(0)" << std::endl
+         << "  { }" << std::endl
+         << "  ~pt_" << m_name << "_node_t()" << std::endl
+         << "  { delete mp_prod_node; }" << std::endl;
+  }
+  
+  if (true == mp_ae->incremental())
+  {
+    // The rule id is the index in 'm_top_level_nodes',
+    // like PARSER_RULE_XXX.
+    unsigned int rule_id = 0;
+    
+    BOOST_FOREACH(node_t const * const node, mp_ae->top_level_nodes())
+    {
+      if (node == this)
+      {
+        break;
+      }
+      
+      ++rule_id;
+    }
+    
+    // A rule of an ambiguity has no production node with
+    // the recursive descent backend.
+    file << std::endl
+         << "  enum { RULE_ID = " << rule_id << " };" << std::endl
+         << std::endl
+         << "  virtual wds_uint32 rule_id() const" << std::endl
+         << "  { return RULE_ID; }" << std::endl
+         << "  virtual unsigned int child_count() const" << std::endl
+         << "  { return (mp_prod_node != 0) ? mp_prod_node->child_count() : 0; }" << std::endl
+         << "  virtual pt_node_t *child(unsigned int const i) const" << std::endl
+         << "  { return mp_prod_node->child(i); }" << std::endl
+         << "  virtual void set_child(unsigned int const i, pt_node_t * const node)" << std::endl
+         << "  { mp_prod_node->set_child(i, node); }" << std::endl
+         << std::endl;
+    
+    dump_gen_recycle(file, L"pt_" + m_name + L"_node_t", true);
+  }
+  
+  file << "};" << std::endl
        << "typedef class pt_" << m_name << "_node_t pt_" << m_name << "_node_t;" << std::endl
        << std::endl;
 }
@@ -1121,12 +3787,22 @@ node_t::dump_gen_parser_src(
   }
 }
 
+/// Dump the codes parsing 'node' in parse_XXX, and
+/// assigning the parsed node to 'destination', ex:
+///
+///   prod_node->mp_XXX_node_0 = parse_XXX();
+///
+/// The type of the parsed node is known here, so that it
+/// does not need any cast at runtime.
 void
-dump_add_node_to_nodes_for_one_node_in_parse_XXX(
+dump_parse_one_node_in_parse_XXX(
   std::wfstream &file,
   node_t const * const node,
+  std::wstring const &destination,
   unsigned int const indent_depth)
 {
+  file << indent_line(indent_depth) << destination << " = ";
+  
   if (true == node->is_terminal())
   {
     std::wstring terminal_name = node->name();
@@ -1136,17 +3812,12 @@ dump_add_node_to_nodes_for_one_node_in_parse_XXX(
                    terminal_name.begin(),
                    towupper);
     
-    file << indent_line(indent_depth)
-         << "add_node_to_nodes(nodes, ensure_next_token_is(WDS_TOKEN_TYPE_"
-         << terminal_name
-         << ", consume));" << std::endl;
+    file << "static_cast<pt_" << node->name() << "_node_t *>("
+         << "ensure_next_token_is(WDS_TOKEN_TYPE_" << terminal_name
+         << "));" << std::endl;
   }
   else
   {
-    std::wstring const &name = node->name();
-    
-    file << indent_line(indent_depth)
-         << "add_node_to_nodes(nodes, parse_" << name
-         << "(consume));" << std::endl;
+    file << "parse_" << node->name() << "();" << std::endl;
   }
 }
@@ -0,0 +1,1054 @@
+#include "precompiled_header.hpp"
+
+// wpg - an LL(k) parser generator
+// Copyright (C) <2007>  Wei Hu <wei.hu.tw@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+#include "ae.hpp"
+#include "node.hpp"
+#include "gen.hpp"
+#include "regex.hpp"
+
+#include "wcl_memory_debugger\memory_debugger.h"
+
+namespace
+{
+  /// The kinds of the items of the alternatives in the
+  /// tables of 'benchmark.cpp', the names are the same in
+  /// the generated code.
+  enum bench_item_kind_t
+  {
+    BENCH_ITEM_TOKEN,
+    BENCH_ITEM_RULE,
+    BENCH_ITEM_ZERO_OR_MORE,
+    BENCH_ITEM_ZERO_OR_ONE,
+    BENCH_ITEM_ONE_OR_MORE,
+    BENCH_ITEM_ONE
+  };
+  typedef enum bench_item_kind_t bench_item_kind_t;
+  
+  wchar_t const * const bench_item_kind_names[] =
+  {
+    L"BENCH_ITEM_TOKEN",
+    L"BENCH_ITEM_RULE",
+    L"BENCH_ITEM_ZERO_OR_MORE",
+    L"BENCH_ITEM_ZERO_OR_ONE",
+    L"BENCH_ITEM_ONE_OR_MORE",
+    L"BENCH_ITEM_ONE"
+  };
+  
+  /// An item of an alternative. The items of a group
+  /// follow the group item, and 'm_argument' of the group
+  /// item is the index of the first item after the group.
+  /// 'm_argument' of a rule item is the index of the rule,
+  /// and a token item has the name of its token type
+  /// instead.
+  struct bench_item_t
+  {
+    bench_item_kind_t m_kind;
+    size_t m_argument;
+    std::wstring m_token_type;
+  };
+  typedef struct bench_item_t bench_item_t;
+  
+  /// A regex group of an alternative, from the node at
+  /// 'm_begin' to the node at 'm_end' (both included).
+  /// The groups are sorted in the order they are opened:
+  /// an outer group before the inner groups starting at
+  /// the same node.
+  struct bench_group_t
+  {
+    size_t m_begin;
+    size_t m_end;
+    regex_type_t m_type;
+    
+    bool operator<(
+      bench_group_t const &group) const
+    {
+      if (m_begin != group.m_begin)
+      {
+        return m_begin < group.m_begin;
+      }
+      
+      if (m_end != group.m_end)
+      {
+        return m_end > group.m_end;
+      }
+      
+      return m_type < group.m_type;
+    }
+  };
+  typedef struct bench_group_t bench_group_t;
+  
+  size_t const INFINITE_HEIGHT = static_cast<size_t>(-1);
+  
+  std::wstring
+  token_type_name(
+    std::wstring const &terminal_name)
+  {
+    std::wstring name(terminal_name);
+    
+    std::transform(name.begin(), name.end(),
+                   name.begin(),
+                   towupper);
+    
+    return L"WDS_TOKEN_TYPE_" + name;
+  }
+  
+  bench_item_kind_t
+  group_item_kind(
+    regex_type_t const type)
+  {
+    switch (type)
+    {
+    case REGEX_TYPE_ZERO_OR_MORE: return BENCH_ITEM_ZERO_OR_MORE;
+    case REGEX_TYPE_ZERO_OR_ONE: return BENCH_ITEM_ZERO_OR_ONE;
+    case REGEX_TYPE_ONE_OR_MORE: return BENCH_ITEM_ONE_OR_MORE;
+    case REGEX_TYPE_ONE: return BENCH_ITEM_ONE;
+    
+    default:
+      // The OR groups were split into alternatives before
+      // the code generation.
+      assert(0);
+      return BENCH_ITEM_ONE;
+    }
+  }
+  
+  /// Append the items of the alternative starting at
+  /// 'alternative_start' to 'items'. The alternative is a
+  /// chain of nodes, and its regex groups are the ranges
+  /// of the nodes in 'regex_info()', like
+  /// dump_grammar_alternative() prints them.
+  void
+  compile_alternative(
+    node_t const * const alternative_start,
+    std::map<node_t const *, size_t> const &rule_ids,
+    std::vector<bench_item_t> &items)
+  {
+    std::vector<node_t const *> nodes;
+    std::map<node_t const *, size_t> positions;
+    
+    for (node_t const *node = alternative_start;
+         false == node->name().empty();
+         node = node->next_nodes().front())
+    {
+      assert(1 == node->next_nodes().size());
+      
+      positions[node] = nodes.size();
+      nodes.push_back(node);
+    }
+    
+    std::set<bench_group_t> groups;
+    
+    BOOST_FOREACH(node_t const * const node, nodes)
+    {
+      BOOST_FOREACH(regex_info_t const &regex_info, node->regex_info())
+      {
+        regex_range_t const &range = regex_info.m_ranges.front();
+        
+        assert(positions.find(range.mp_start_node) != positions.end());
+        assert(positions.find(range.mp_end_node) != positions.end());
+        
+        bench_group_t const group =
+          {
+            positions[range.mp_start_node],
+            positions[range.mp_end_node],
+            regex_info.m_type
+          };
+        
+        groups.insert(group);
+      }
+    }
+    
+    std::set<bench_group_t>::const_iterator next_group = groups.begin();
+    
+    // The end node and the group item of each group
+    // opened so far.
+    std::vector<std::pair<size_t, size_t> > open_groups;
+    
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+      while ((next_group != groups.end()) && (next_group->m_begin == i))
+      {
+        bench_item_t const item = { group_item_kind(next_group->m_type), 0, std::wstring() };
+        
+        open_groups.push_back(std::make_pair(next_group->m_end, items.size()));
+        items.push_back(item);
+        
+        ++next_group;
+      }
+      
+      if (true == nodes[i]->is_terminal())
+      {
+        bench_item_t const item = { BENCH_ITEM_TOKEN, 0, token_type_name(nodes[i]->name()) };
+        
+        items.push_back(item);
+      }
+      else
+      {
+        std::map<node_t const *, size_t>::const_iterator const iter =
+          rule_ids.find(nodes[i]->nonterminal_rule_node());
+        assert(iter != rule_ids.end());
+        
+        bench_item_t const item = { BENCH_ITEM_RULE, iter->second, std::wstring() };
+        
+        items.push_back(item);
+      }
+      
+      while ((false == open_groups.empty()) && (open_groups.back().first == i))
+      {
+        items[open_groups.back().second].m_argument = items.size();
+        open_groups.pop_back();
+      }
+    }
+    
+    assert(next_group == groups.end());
+    assert(true == open_groups.empty());
+  }
+  
+  /// The height of the lowest derivation tree of the items
+  /// [first, end), which skips the optional groups and
+  /// takes the other groups once.
+  size_t
+  items_height(
+    std::vector<bench_item_t> const &items,
+    size_t const first,
+    size_t const end,
+    std::vector<size_t> const &rule_heights)
+  {
+    size_t height = 0;
+    size_t i = first;
+    
+    while (i < end)
+    {
+      bench_item_t const &item = items[i];
+      
+      switch (item.m_kind)
+      {
+      case BENCH_ITEM_TOKEN:
+        ++i;
+        break;
+      
+      case BENCH_ITEM_RULE:
+        height = std::max(height, rule_heights[item.m_argument]);
+        ++i;
+        break;
+      
+      case BENCH_ITEM_ZERO_OR_MORE:
+      case BENCH_ITEM_ZERO_OR_ONE:
+        i = item.m_argument;
+        break;
+      
+      case BENCH_ITEM_ONE_OR_MORE:
+      case BENCH_ITEM_ONE:
+        height = std::max(height, items_height(items, i + 1, item.m_argument, rule_heights));
+        i = item.m_argument;
+        break;
+      
+      default:
+        assert(0);
+        break;
+      }
+    }
+    
+    return height;
+  }
+}
+
+/// Dump 'benchmark.cpp' of the '--benchmark' option.
+///
+/// I compile the alternatives of the final grammar, the
+/// one the generated parser parses, into the tables of
+/// the program, which expands them into random token
+/// streams of the starting rule at run time. Before the
+/// requested number of tokens, the outermost list of a
+/// stream takes the alternatives which can grow it; after
+/// that, a stream takes the alternative of each rule with
+/// the lowest derivation tree, and the least repetitions
+/// of each group, so that it finishes. I find both kinds
+/// of alternatives here.
+void
+analyser_environment_t::dump_gen_benchmark_cpp(
+  std::wfstream &file) const
+{
+  assert(true == m_benchmark);
+  
+  std::map<node_t const *, size_t> rule_ids;
+  
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    size_t const id = rule_ids.size();
+    
+    rule_ids[node] = id;
+  }
+  
+  std::vector<bench_item_t> items;
+  std::vector<std::pair<size_t, size_t> > alternatives;
+  std::vector<size_t> first_alternatives;
+  
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    first_alternatives.push_back(alternatives.size());
+    
+    BOOST_FOREACH(node_t const * const alternative_start, node->next_nodes())
+    {
+      size_t const first_item = items.size();
+      
+      compile_alternative(alternative_start, rule_ids, items);
+      alternatives.push_back(std::make_pair(first_item, items.size()));
+    }
+  }
+  
+  first_alternatives.push_back(alternatives.size());
+  
+  // The heights of the rules, by the fixed point of
+  // 1 + the lowest height of the alternatives. A rule
+  // without any finite derivation stays infinite.
+  std::vector<size_t> rule_heights(m_top_level_nodes.size(), INFINITE_HEIGHT);
+  std::vector<size_t> shortest_alternatives(first_alternatives.begin(), first_alternatives.end() - 1);
+  bool changed = true;
+  
+  while (true == changed)
+  {
+    changed = false;
+    
+    for (size_t rule = 0; rule < m_top_level_nodes.size(); ++rule)
+    {
+      for (size_t alternative = first_alternatives[rule];
+           alternative < first_alternatives[rule + 1];
+           ++alternative)
+      {
+        size_t const height = items_height(items,
+                                           alternatives[alternative].first,
+                                           alternatives[alternative].second,
+                                           rule_heights);
+        
+        if ((height != INFINITE_HEIGHT) && ((height + 1) < rule_heights[rule]))
+        {
+          rule_heights[rule] = height + 1;
+          shortest_alternatives[rule] = alternative;
+          changed = true;
+        }
+      }
+    }
+  }
+  
+  // The rules each rule derives, by the transitive
+  // closure of its rule items, and the alternatives
+  // with a repeated group.
+  std::vector<std::set<size_t> > derived_rules(m_top_level_nodes.size());
+  std::vector<bool> growing_alternatives(alternatives.size(), false);
+  
+  for (size_t rule = 0; rule < m_top_level_nodes.size(); ++rule)
+  {
+    for (size_t alternative = first_alternatives[rule];
+         alternative < first_alternatives[rule + 1];
+         ++alternative)
+    {
+      for (size_t i = alternatives[alternative].first; i < alternatives[alternative].second; ++i)
+      {
+        switch (items[i].m_kind)
+        {
+        case BENCH_ITEM_RULE:
+          derived_rules[rule].insert(items[i].m_argument);
+          break;
+        
+        case BENCH_ITEM_ZERO_OR_MORE:
+        case BENCH_ITEM_ONE_OR_MORE:
+          growing_alternatives[alternative] = true;
+          break;
+        
+        default:
+          break;
+        }
+      }
+    }
+  }
+  
+  changed = true;
+  
+  while (true == changed)
+  {
+    changed = false;
+    
+    for (size_t rule = 0; rule < m_top_level_nodes.size(); ++rule)
+    {
+      std::set<size_t> const direct_rules(derived_rules[rule]);
+      size_t const count = derived_rules[rule].size();
+      
+      BOOST_FOREACH(size_t const derived_rule, direct_rules)
+      {
+        derived_rules[rule].insert(derived_rules[derived_rule].begin(),
+                                   derived_rules[derived_rule].end());
+      }
+      
+      if (derived_rules[rule].size() != count)
+      {
+        changed = true;
+      }
+    }
+  }
+  
+  // An alternative also grows if it has a rule which
+  // derives its own rule again, ex: the right recursion
+  // of 'list : item list |'.
+  for (size_t rule = 0; rule < m_top_level_nodes.size(); ++rule)
+  {
+    for (size_t alternative = first_alternatives[rule];
+         alternative < first_alternatives[rule + 1];
+         ++alternative)
+    {
+      for (size_t i = alternatives[alternative].first; i < alternatives[alternative].second; ++i)
+      {
+        if ((BENCH_ITEM_RULE == items[i].m_kind) &&
+            ((items[i].m_argument == rule) ||
+             (derived_rules[items[i].m_argument].find(rule) != derived_rules[items[i].m_argument].end())))
+        {
+          growing_alternatives[alternative] = true;
+        }
+      }
+    }
+  }
+  
+  std::wstring const &starting_rule = starting_rule_node()->name();
+  
+  if (INFINITE_HEIGHT == rule_heights[rule_ids[starting_rule_node()]])
+  {
+    log(L"<WARN>: %s has no finite token stream, benchmark.cpp will not parse anything.\n",
+        starting_rule.c_str());
+  }
+  
+  file << "// Parse random token streams of the starting rule (" << starting_rule << ")," << std::endl
+       << "// and report the cost of the parser, ex:" << std::endl
+       << "//" << std::endl
+       << "//   benchmark [-n streams] [-t tokens] [-r repeats] [-s seed]" << std::endl
+       << "//" << std::endl
+       << "// makes 'streams' (100) streams from the grammar with the" << std::endl
+       << "// random seed 'seed' (1), and parses all of them 'repeats'" << std::endl
+       << "// (10) times. The outermost list of a stream, ex: the" << std::endl
+       << "// statements of a program, grows until the stream has" << std::endl
+       << "// 'tokens' (1000) tokens, so the streams are a little" << std::endl
+       << "// longer than that, and their average length is printed." << std::endl
+       << "// It counts the allocations by replacing the global" << std::endl
+       << "// operator new and operator delete. A stream of an" << std::endl
+       << "// ambiguous grammar may be parsed by another alternative" << std::endl
+       << "// and rejected, or only partly consumed, so that only the" << std::endl
+       << "// streams the parser accepts as a whole are measured." << std::endl
+       << std::endl
+       << "#include <cstdlib>" << std::endl
+       << "#include <cstring>" << std::endl
+       << "#include <exception>" << std::endl
+       << "#include <iostream>" << std::endl
+       << "#include <new>" << std::endl
+       << "#include <vector>" << std::endl
+       << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << "#include <windows.h>" << std::endl
+       << "#else" << std::endl
+       << "#include <sys/time.h>" << std::endl
+       << "#endif" << std::endl
+       << std::endl
+       << "#include \"frontend.hpp\"" << std::endl
+       << std::endl
+       << "#if __cplusplus >= 201103L" << std::endl
+       << "#define BENCH_THROW_BAD_ALLOC" << std::endl
+       << "#define BENCH_NO_THROW noexcept" << std::endl
+       << "#else" << std::endl
+       << "#define BENCH_THROW_BAD_ALLOC throw(std::bad_alloc)" << std::endl
+       << "#define BENCH_NO_THROW throw()" << std::endl
+       << "#endif" << std::endl
+       << std::endl;
+  
+  file << "namespace" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "// The size of each allocation is kept in front of it." << std::endl
+       << indent_line(1) << "union allocation_header_t" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "std::size_t m_size;" << std::endl
+       << indent_line(2) << "long double m_alignment;" << std::endl
+       << indent_line(1) << "};" << std::endl
+       << std::endl
+       << indent_line(1) << "std::size_t g_allocation_count = 0;" << std::endl
+       << indent_line(1) << "std::size_t g_allocated_bytes = 0;" << std::endl
+       << indent_line(1) << "std::size_t g_live_bytes = 0;" << std::endl
+       << indent_line(1) << "std::size_t g_peak_bytes = 0;" << std::endl
+       << std::endl
+       << indent_line(1) << "void *" << std::endl
+       << indent_line(1) << "counted_allocate(" << std::endl
+       << indent_line(2) << "std::size_t const size)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "allocation_header_t * const header =" << std::endl
+       << indent_line(2) << "  static_cast<allocation_header_t *>(std::malloc(sizeof(allocation_header_t) + size));" << std::endl
+       << std::endl
+       << indent_line(2) << "if (0 == header)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "throw std::bad_alloc();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "header->m_size = size;" << std::endl
+       << std::endl
+       << indent_line(2) << "++g_allocation_count;" << std::endl
+       << indent_line(2) << "g_allocated_bytes += size;" << std::endl
+       << indent_line(2) << "g_live_bytes += size;" << std::endl
+       << std::endl
+       << indent_line(2) << "if (g_live_bytes > g_peak_bytes)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "g_peak_bytes = g_live_bytes;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "return header + 1;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "void" << std::endl
+       << indent_line(1) << "counted_free(" << std::endl
+       << indent_line(2) << "void * const memory)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "if (0 == memory)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "return;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "allocation_header_t * const header = static_cast<allocation_header_t *>(memory) - 1;" << std::endl
+       << std::endl
+       << indent_line(2) << "g_live_bytes -= header->m_size;" << std::endl
+       << indent_line(2) << "std::free(header);" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl
+       << std::endl
+       << "void *operator new(std::size_t size) BENCH_THROW_BAD_ALLOC" << std::endl
+       << "{ return counted_allocate(size); }" << std::endl
+       << std::endl
+       << "void *operator new[](std::size_t size) BENCH_THROW_BAD_ALLOC" << std::endl
+       << "{ return counted_allocate(size); }" << std::endl
+       << std::endl
+       << "void operator delete(void *memory) BENCH_NO_THROW" << std::endl
+       << "{ counted_free(memory); }" << std::endl
+       << std::endl
+       << "void operator delete[](void *memory) BENCH_NO_THROW" << std::endl
+       << "{ counted_free(memory); }" << std::endl
+       << std::endl
+       << "#if defined(__cpp_sized_deallocation)" << std::endl
+       << "void operator delete(void *memory, std::size_t) BENCH_NO_THROW" << std::endl
+       << "{ counted_free(memory); }" << std::endl
+       << std::endl
+       << "void operator delete[](void *memory, std::size_t) BENCH_NO_THROW" << std::endl
+       << "{ counted_free(memory); }" << std::endl
+       << "#endif" << std::endl
+       << std::endl;
+  
+  // The tables of the grammar.
+  file << "namespace" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "enum bench_item_kind_t" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  for (size_t i = 0; i < (sizeof(bench_item_kind_names) / sizeof(bench_item_kind_names[0])); ++i)
+  {
+    file << indent_line(2) << bench_item_kind_names[i];
+    
+    if (i != ((sizeof(bench_item_kind_names) / sizeof(bench_item_kind_names[0])) - 1))
+    {
+      file << ",";
+    }
+    
+    file << std::endl;
+  }
+  
+  file << indent_line(1) << "};" << std::endl
+       << std::endl
+       << indent_line(1) << "// The items of a group follow the group item, and" << std::endl
+       << indent_line(1) << "// 'm_argument' of the group item is the index of the" << std::endl
+       << indent_line(1) << "// first item after the group. 'm_argument' of a token" << std::endl
+       << indent_line(1) << "// item is its type, and that of a rule item is the" << std::endl
+       << indent_line(1) << "// index of the rule." << std::endl
+       << indent_line(1) << "struct bench_item_t" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "bench_item_kind_t m_kind;" << std::endl
+       << indent_line(2) << "unsigned int m_argument;" << std::endl
+       << indent_line(1) << "};" << std::endl
+       << std::endl
+       << indent_line(1) << "// 'm_grows' is 1 if the alternative has a repeated" << std::endl
+       << indent_line(1) << "// group, or a rule which derives its own rule again." << std::endl
+       << indent_line(1) << "struct bench_alternative_t" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "unsigned int m_first_item;" << std::endl
+       << indent_line(2) << "unsigned int m_end_item;" << std::endl
+       << indent_line(2) << "unsigned int m_grows;" << std::endl
+       << indent_line(1) << "};" << std::endl
+       << std::endl
+       << indent_line(1) << "// 'm_shortest_alternative' has the lowest derivation" << std::endl
+       << indent_line(1) << "// tree of the rule." << std::endl
+       << indent_line(1) << "struct bench_rule_t" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "unsigned int m_first_alternative;" << std::endl
+       << indent_line(2) << "unsigned int m_end_alternative;" << std::endl
+       << indent_line(2) << "unsigned int m_shortest_alternative;" << std::endl
+       << indent_line(1) << "};" << std::endl
+       << std::endl;
+  
+  file << indent_line(1) << "// The last item is in no alternative, it keeps the" << std::endl
+       << indent_line(1) << "// array from being empty." << std::endl
+       << indent_line(1) << "bench_item_t const g_items[] =" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  BOOST_FOREACH(bench_item_t const &item, items)
+  {
+    file << indent_line(2) << "{ " << bench_item_kind_names[item.m_kind] << ", ";
+    
+    if (BENCH_ITEM_TOKEN == item.m_kind)
+    {
+      file << item.m_token_type;
+    }
+    else
+    {
+      file << item.m_argument;
+    }
+    
+    file << " }," << std::endl;
+  }
+  
+  file << indent_line(2) << "{ BENCH_ITEM_TOKEN, WDS_TOKEN_TYPE_EOF }" << std::endl
+       << indent_line(1) << "};" << std::endl
+       << std::endl;
+  
+  file << indent_line(1) << "bench_alternative_t const g_alternatives[] =" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  for (size_t i = 0; i < alternatives.size(); ++i)
+  {
+    file << indent_line(2) << "{ " << alternatives[i].first << ", " << alternatives[i].second
+         << ", " << ((true == growing_alternatives[i]) ? 1 : 0) << " }";
+    
+    if (i != (alternatives.size() - 1))
+    {
+      file << ",";
+    }
+    
+    file << std::endl;
+  }
+  
+  file << indent_line(1) << "};" << std::endl
+       << std::endl;
+  
+  file << indent_line(1) << "bench_rule_t const g_rules[] =" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  size_t i = 0;
+  
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    file << indent_line(2) << "{ " << first_alternatives[i] << ", " << first_alternatives[i + 1]
+         << ", " << shortest_alternatives[i] << " }";
+    
+    if (i != (m_top_level_nodes.size() - 1))
+    {
+      file << ",";
+    }
+    
+    file << " // " << node->name();
+    
+    if (INFINITE_HEIGHT == rule_heights[i])
+    {
+      file << ", no finite stream";
+    }
+    
+    file << std::endl;
+    
+    ++i;
+  }
+  
+  file << indent_line(1) << "};" << std::endl
+       << std::endl
+       << indent_line(1) << "unsigned int const STARTING_RULE = " << rule_ids[starting_rule_node()] << ";" << std::endl
+       << std::endl;
+  
+  // The random token streams.
+  file << indent_line(1) << "// A xorshift generator, so that a seed gives the same" << std::endl
+       << indent_line(1) << "// streams on every platform." << std::endl
+       << indent_line(1) << "class random_t" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(1) << "private:" << std::endl
+       << std::endl
+       << indent_line(2) << "wds_uint32 m_state;" << std::endl
+       << std::endl
+       << indent_line(1) << "public:" << std::endl
+       << std::endl
+       << indent_line(2) << "explicit random_t(" << std::endl
+       << indent_line(3) << "wds_uint32 const seed)" << std::endl
+       << indent_line(3) << ": m_state((0 == seed) ? 1 : seed)" << std::endl
+       << indent_line(2) << "{ }" << std::endl
+       << std::endl
+       << indent_line(2) << "// A number in [0, range)." << std::endl
+       << indent_line(2) << "wds_uint32 next(" << std::endl
+       << indent_line(3) << "wds_uint32 const range)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "m_state ^= m_state << 13;" << std::endl
+       << indent_line(3) << "m_state ^= m_state >> 17;" << std::endl
+       << indent_line(3) << "m_state ^= m_state << 5;" << std::endl
+       << std::endl
+       << indent_line(3) << "return m_state % range;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "};" << std::endl
+       << indent_line(1) << "typedef class random_t random_t;" << std::endl
+       << std::endl
+       << indent_line(1) << "// [m_first, m_end) of 'g_items' to expand. 'm_repeating'" << std::endl
+       << indent_line(1) << "// is true when the group at 'm_first' has been repeated" << std::endl
+       << indent_line(1) << "// at least once." << std::endl
+       << indent_line(1) << "struct bench_range_t" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "unsigned int m_first;" << std::endl
+       << indent_line(2) << "unsigned int m_end;" << std::endl
+       << indent_line(2) << "bool m_repeating;" << std::endl
+       << indent_line(1) << "};" << std::endl
+       << std::endl
+       << indent_line(1) << "// Push an alternative of 'rule': the shortest one, a" << std::endl
+       << indent_line(1) << "// random one which grows if 'grow' is true and the rule" << std::endl
+       << indent_line(1) << "// has one, or else any random one." << std::endl
+       << indent_line(1) << "void" << std::endl
+       << indent_line(1) << "push_alternative(" << std::endl
+       << indent_line(2) << "std::vector<bench_range_t> &todo," << std::endl
+       << indent_line(2) << "bench_rule_t const &rule," << std::endl
+       << indent_line(2) << "bool const shortest," << std::endl
+       << indent_line(2) << "bool const grow," << std::endl
+       << indent_line(2) << "random_t &random)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "unsigned int alternative = rule.m_shortest_alternative;" << std::endl
+       << indent_line(2) << "unsigned int growing_count = 0;" << std::endl
+       << std::endl
+       << indent_line(2) << "if ((false == shortest) && (true == grow))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "for (unsigned int i = rule.m_first_alternative; i < rule.m_end_alternative; ++i)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "growing_count += g_alternatives[i].m_grows;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "if (growing_count != 0)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "unsigned int nth = random.next(growing_count);" << std::endl
+       << std::endl
+       << indent_line(3) << "for (alternative = rule.m_first_alternative; ; ++alternative)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "if (g_alternatives[alternative].m_grows != 0)" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "if (0 == nth)" << std::endl
+       << indent_line(5) << "{" << std::endl
+       << indent_line(6) << "break;" << std::endl
+       << indent_line(5) << "}" << std::endl
+       << std::endl
+       << indent_line(5) << "--nth;" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(2) << "else if (false == shortest)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "alternative = rule.m_first_alternative + random.next(rule.m_end_alternative - rule.m_first_alternative);" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "bench_range_t const range =" << std::endl
+       << indent_line(2) << "  {" << std::endl
+       << indent_line(2) << "    g_alternatives[alternative].m_first_item," << std::endl
+       << indent_line(2) << "    g_alternatives[alternative].m_end_item," << std::endl
+       << indent_line(2) << "    false" << std::endl
+       << indent_line(2) << "  };" << std::endl
+       << std::endl
+       << indent_line(2) << "todo.push_back(range);" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "// Make a random stream of the starting rule in 'tokens'," << std::endl
+       << indent_line(1) << "// followed by EOF. The outermost list of the stream is" << std::endl
+       << indent_line(1) << "// made of the rules at the end of the alternatives of" << std::endl
+       << indent_line(1) << "// the starting rule, of those rules, and so on, and of" << std::endl
+       << indent_line(1) << "// their repeated groups. Before 'size' tokens, these" << std::endl
+       << indent_line(1) << "// rules take their growing alternatives and the groups" << std::endl
+       << indent_line(1) << "// repeat, so that a stream of 'program : stmt program |'" << std::endl
+       << indent_line(1) << "// or 'program : (stmt)*' gets close to 'size' tokens;" << std::endl
+       << indent_line(1) << "// the inner rules and groups are uniformly random." << std::endl
+       << indent_line(1) << "// After 'size' tokens, it takes the shortest way to" << std::endl
+       << indent_line(1) << "// finish the stream. It returns false if the stream" << std::endl
+       << indent_line(1) << "// grows too long, because of a rule without any finite" << std::endl
+       << indent_line(1) << "// stream." << std::endl
+       << indent_line(1) << "bool" << std::endl
+       << indent_line(1) << "generate_tokens(" << std::endl
+       << indent_line(2) << "std::vector<token_t> &tokens," << std::endl
+       << indent_line(2) << "size_t const size," << std::endl
+       << indent_line(2) << "random_t &random)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "std::vector<bench_range_t> todo;" << std::endl
+       << std::endl
+       << indent_line(2) << "tokens.clear();" << std::endl
+       << indent_line(2) << "push_alternative(todo, g_rules[STARTING_RULE], false, true, random);" << std::endl
+       << std::endl
+       << indent_line(2) << "while (false == todo.empty())" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "unsigned int const index = todo.back().m_first;" << std::endl
+       << std::endl
+       << indent_line(3) << "if (index == todo.back().m_end)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "todo.pop_back();" << std::endl
+       << indent_line(4) << "continue;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl
+       << indent_line(3) << "if ((tokens.size() + todo.size()) > ((size * 4) + 1024))" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "return false;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl
+       << indent_line(3) << "bool const shortest = ((tokens.size() + todo.size()) >= size);" << std::endl
+       << indent_line(3) << "bench_item_t const &item = g_items[index];" << std::endl
+       << indent_line(3) << "unsigned int count = 0;" << std::endl
+       << std::endl
+       << indent_line(3) << "// An inner group is repeated with the probability 3/4" << std::endl
+       << indent_line(3) << "// until the stream is long enough." << std::endl
+       << indent_line(3) << "switch (item.m_kind)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(3) << "case BENCH_ITEM_TOKEN:" << std::endl
+       << indent_line(4) << "tokens.push_back(token_t(static_cast<wds_token_type>(item.m_argument)," << std::endl
+       << indent_line(4) << "                         static_cast<wds_uint32>(tokens.size()), 1));" << std::endl
+       << indent_line(4) << "++todo.back().m_first;" << std::endl
+       << indent_line(4) << "continue;" << std::endl
+       << std::endl
+       << indent_line(3) << "case BENCH_ITEM_RULE:" << std::endl
+       << indent_line(4) << "++todo.back().m_first;" << std::endl
+       << std::endl
+       << indent_line(4) << "// The rule at the end of a range takes the place of" << std::endl
+       << indent_line(4) << "// the range, so that the outermost list stays in the" << std::endl
+       << indent_line(4) << "// first range." << std::endl
+       << indent_line(4) << "if (todo.back().m_first == todo.back().m_end)" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "todo.pop_back();" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << std::endl
+       << indent_line(4) << "push_alternative(todo, g_rules[item.m_argument], shortest, todo.empty(), random);" << std::endl
+       << indent_line(4) << "continue;" << std::endl
+       << std::endl
+       << indent_line(3) << "case BENCH_ITEM_ZERO_OR_MORE:" << std::endl
+       << indent_line(3) << "case BENCH_ITEM_ONE_OR_MORE:" << std::endl
+       << indent_line(4) << "// A group of the outermost list is repeated one at a" << std::endl
+       << indent_line(4) << "// time, until the stream has 'size' tokens." << std::endl
+       << indent_line(4) << "if (1 == todo.size())" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "if ((false == shortest) ||" << std::endl
+       << indent_line(5) << "    ((BENCH_ITEM_ONE_OR_MORE == item.m_kind) && (false == todo.back().m_repeating)))" << std::endl
+       << indent_line(5) << "{" << std::endl
+       << indent_line(6) << "bench_range_t const group = { index + 1, item.m_argument, false };" << std::endl
+       << std::endl
+       << indent_line(6) << "todo.back().m_repeating = true;" << std::endl
+       << indent_line(6) << "todo.push_back(group);" << std::endl
+       << indent_line(6) << "continue;" << std::endl
+       << indent_line(5) << "}" << std::endl
+       << std::endl
+       << indent_line(5) << "todo.back().m_repeating = false;" << std::endl
+       << indent_line(5) << "break;" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << std::endl
+       << indent_line(4) << "count = (BENCH_ITEM_ONE_OR_MORE == item.m_kind) ? 1 : 0;" << std::endl
+       << std::endl
+       << indent_line(4) << "while (((tokens.size() + todo.size() + count) < size) && (0 != random.next(4)))" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "++count;" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << indent_line(4) << "break;" << std::endl
+       << std::endl
+       << indent_line(3) << "case BENCH_ITEM_ZERO_OR_ONE:" << std::endl
+       << indent_line(4) << "count = (true == shortest) ? 0 : random.next(2);" << std::endl
+       << indent_line(4) << "break;" << std::endl
+       << std::endl
+       << indent_line(3) << "case BENCH_ITEM_ONE:" << std::endl
+       << indent_line(4) << "count = 1;" << std::endl
+       << indent_line(4) << "break;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl
+       << indent_line(3) << "// The repetitions of the group are expanded before" << std::endl
+       << indent_line(3) << "// the items after it." << std::endl
+       << indent_line(3) << "bench_range_t const group = { index + 1, item.m_argument, false };" << std::endl
+       << std::endl
+       << indent_line(3) << "todo.back().m_first = item.m_argument;" << std::endl
+       << indent_line(3) << "todo.insert(todo.end(), count, group);" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "tokens.push_back(token_t(WDS_TOKEN_TYPE_EOF));" << std::endl
+       << std::endl
+       << indent_line(2) << "return true;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl;
+  
+  file << indent_line(1) << "// The seconds since some fixed time." << std::endl
+       << indent_line(1) << "double" << std::endl
+       << indent_line(1) << "wall_time()" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << "#if defined(_WIN32)" << std::endl
+       << indent_line(2) << "LARGE_INTEGER frequency;" << std::endl
+       << indent_line(2) << "LARGE_INTEGER counter;" << std::endl
+       << std::endl
+       << indent_line(2) << "QueryPerformanceFrequency(&frequency);" << std::endl
+       << indent_line(2) << "QueryPerformanceCounter(&counter);" << std::endl
+       << std::endl
+       << indent_line(2) << "return static_cast<double>(counter.QuadPart) / frequency.QuadPart;" << std::endl
+       << "#else" << std::endl
+       << indent_line(2) << "timeval now;" << std::endl
+       << std::endl
+       << indent_line(2) << "gettimeofday(&now, 0);" << std::endl
+       << std::endl
+       << indent_line(2) << "return now.tv_sec + (now.tv_usec / 1000000.0);" << std::endl
+       << "#endif" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "// Parse 'tokens' once, and free the parse tree." << std::endl
+       << indent_line(1) << "void" << std::endl
+       << indent_line(1) << "parse_tokens(" << std::endl
+       << indent_line(2) << "frontend &parser," << std::endl
+       << indent_line(2) << "std::vector<token_t> const &tokens)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "parser.reset_tokens(&tokens[0], &tokens[0] + tokens.size());" << std::endl
+       << std::endl;
+  
+  if (true == m_use_node_arena)
+  {
+    file << indent_line(2) << "try" << std::endl
+         << indent_line(2) << "{" << std::endl
+         << indent_line(3) << "parser.parse_" << starting_rule << "();" << std::endl
+         << indent_line(2) << "}" << std::endl
+         << indent_line(2) << "catch (std::exception &)" << std::endl
+         << indent_line(2) << "{" << std::endl
+         << indent_line(3) << "parser.free_nodes();" << std::endl
+         << indent_line(3) << "throw;" << std::endl
+         << indent_line(2) << "}" << std::endl
+         << std::endl
+         << indent_line(2) << "parser.free_nodes();" << std::endl;
+  }
+  else
+  {
+    file << indent_line(2) << "delete parser.parse_" << starting_rule << "();" << std::endl;
+  }
+  
+  file << indent_line(1) << "}" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "int" << std::endl
+       << "main(int argc, char **argv)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "unsigned long stream_count = 100;" << std::endl
+       << indent_line(1) << "unsigned long stream_size = 1000;" << std::endl
+       << indent_line(1) << "unsigned long repeat_count = 10;" << std::endl
+       << indent_line(1) << "unsigned long seed = 1;" << std::endl
+       << std::endl
+       << indent_line(1) << "for (int i = 1; i < argc; ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "unsigned long *value = 0;" << std::endl
+       << std::endl
+       << indent_line(2) << "if (0 == strcmp(argv[i], \"-n\")) { value = &stream_count; }" << std::endl
+       << indent_line(2) << "else if (0 == strcmp(argv[i], \"-t\")) { value = &stream_size; }" << std::endl
+       << indent_line(2) << "else if (0 == strcmp(argv[i], \"-r\")) { value = &repeat_count; }" << std::endl
+       << indent_line(2) << "else if (0 == strcmp(argv[i], \"-s\")) { value = &seed; }" << std::endl
+       << std::endl
+       << indent_line(2) << "if ((0 == value) || ((i + 1) >= argc))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "std::cerr << \"usage: \" << argv[0] << \" [-n streams] [-t tokens] [-r repeats] [-s seed]\" << std::endl;" << std::endl
+       << indent_line(3) << "return 1;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "++i;" << std::endl
+       << indent_line(2) << "*value = strtoul(argv[i], 0, 10);" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "random_t random(static_cast<wds_uint32>(seed));" << std::endl
+       << indent_line(1) << "std::vector<std::vector<token_t> > streams;" << std::endl
+       << indent_line(1) << "std::vector<token_t> tokens;" << std::endl
+       << indent_line(1) << "unsigned long unfinished_count = 0;" << std::endl
+       << indent_line(1) << "unsigned long rejected_count = 0;" << std::endl
+       << indent_line(1) << "double stream_token_count = 0;" << std::endl
+       << indent_line(1) << "frontend parser(0, 0);" << std::endl
+       << std::endl
+       << indent_line(1) << "// This also warms up the parser, ex: the blocks of" << std::endl
+       << indent_line(1) << "// the node arena." << std::endl
+       << indent_line(1) << "for (unsigned long i = 0; i < stream_count; ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "if (false == generate_tokens(tokens, stream_size, random))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "++unfinished_count;" << std::endl
+       << indent_line(3) << "continue;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "try" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "parse_tokens(parser, tokens);" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(2) << "catch (std::exception &)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "++rejected_count;" << std::endl
+       << indent_line(3) << "continue;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "// The tokens before EOF must all be consumed." << std::endl
+       << indent_line(2) << "if (parser.consumed_token_count() != (tokens.size() - 1))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "++rejected_count;" << std::endl
+       << indent_line(3) << "continue;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "streams.push_back(tokens);" << std::endl
+       << indent_line(2) << "stream_token_count += tokens.size() - 1;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "std::cout << \"streams: \" << streams.size() << \" parsed, \"" << std::endl
+       << indent_line(1) << "          << rejected_count << \" rejected, \"" << std::endl
+       << indent_line(1) << "          << unfinished_count << \" unfinished\" << std::endl;" << std::endl
+       << std::endl
+       << indent_line(1) << "if (true == streams.empty())" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "return 1;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "std::cout << \"tokens/stream: \" << (stream_token_count / streams.size()) << std::endl;" << std::endl
+       << std::endl
+       << indent_line(1) << "double token_count = 0;" << std::endl
+       << indent_line(1) << "std::size_t const start_live_bytes = g_live_bytes;" << std::endl
+       << std::endl
+       << indent_line(1) << "g_allocation_count = 0;" << std::endl
+       << indent_line(1) << "g_allocated_bytes = 0;" << std::endl
+       << indent_line(1) << "g_peak_bytes = g_live_bytes;" << std::endl
+       << std::endl
+       << indent_line(1) << "double const start_time = wall_time();" << std::endl
+       << std::endl
+       << indent_line(1) << "for (unsigned long i = 0; i < repeat_count; ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "for (size_t j = 0; j < streams.size(); ++j)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "parse_tokens(parser, streams[j]);" << std::endl
+       << indent_line(3) << "token_count += parser.consumed_token_count();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "double const seconds = wall_time() - start_time;" << std::endl
+       << std::endl
+       << indent_line(1) << "std::cout << \"tokens: \" << token_count << std::endl" << std::endl
+       << indent_line(1) << "          << \"seconds: \" << seconds << std::endl;" << std::endl
+       << std::endl
+       << indent_line(1) << "if (token_count > 0)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "std::cout << \"ns/token: \" << (seconds * 1e9 / token_count) << std::endl" << std::endl
+       << indent_line(2) << "          << \"allocations/token: \" << (g_allocation_count / token_count) << std::endl" << std::endl
+       << indent_line(2) << "          << \"allocated bytes/token: \" << (g_allocated_bytes / token_count) << std::endl;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "std::cout << \"peak heap bytes: \" << g_peak_bytes" << std::endl
+       << indent_line(1) << "          << \" (\" << (g_peak_bytes - start_live_bytes) << \" more than the streams)\" << std::endl;" << std::endl
+       << std::endl
+       << indent_line(1) << "return 0;" << std::endl
+       << "}" << std::endl;
+}
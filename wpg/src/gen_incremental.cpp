@@ -0,0 +1,669 @@
+#include "precompiled_header.hpp"
+
+// wpg - an LL(k) parser generator
+// Copyright (C) <2007>  Wei Hu <wei.hu.tw@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+#include "ae.hpp"
+#include "node.hpp"
+#include "gen.hpp"
+
+#include "wcl_memory_debugger\memory_debugger.h"
+
+/// Dump frontend::incremental_parse() of the
+/// '--incremental' option, for both backends.
+///
+/// The offsets of the nodes are from their parent rule
+/// node, so that the edit moves the nodes after it by the
+/// offsets of the siblings after the path to the edit, one
+/// level at a time, and the nodes below them are not
+/// touched.
+///
+/// incremental_find_path() goes down from the root of the
+/// old tree to the deepest rule node which starts before
+/// the edit, and which can be parsed again on its own: the
+/// scanner had not looked at the edit when the parser
+/// started the node, and the first token after the node is
+/// not in the edit. incremental_reparse() scans and parses
+/// that node again from its old offset, with the nodes of
+/// its old subtree at the next token reused by
+/// incremental_reuse() as long as the parser did not look
+/// at the edit to parse them, so that only the input around
+/// the edit is scanned again. If the new node does not stop
+/// at the same token, or moves the beginning of its parent,
+/// it is undone, and the node above it is parsed again.
+/// incremental_splice() puts the new node into the old tree,
+/// fixes the spans of the nodes on the path and of the
+/// siblings after it, and recycles the old nodes which are
+/// not reused into the node arena.
+///
+/// A reparse scans and parses the input of the node parsed
+/// again, and walks the path from the root to it, which is
+/// as deep as a right recursive list is long before the
+/// edit, but nothing on the path is parsed or copied.
+void
+analyser_environment_t::dump_gen_incremental_functions(
+  std::wfstream &file) const
+{
+  assert(true == m_incremental);
+  
+  std::wstring const &starting_rule = starting_rule_node()->name();
+  
+  file << "namespace" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "// The first token after a node on the edit path is at" << std::endl
+       << indent_line(1) << "// an offset of the new input, or it is the first token" << std::endl
+       << indent_line(1) << "// after the old tree, or it is not known." << std::endl
+       << indent_line(1) << "wds_uint32 const NEXT_AFTER_TREE = static_cast<wds_uint32>(-1);" << std::endl
+       << indent_line(1) << "wds_uint32 const NEXT_UNKNOWN = static_cast<wds_uint32>(-2);" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "pt_" << starting_rule << "_node_t *" << std::endl
+       << "frontend::incremental_parse(" << std::endl
+       << indent_line(1) << "pt_" << starting_rule << "_node_t * const old_tree," << std::endl
+       << indent_line(1) << "edit_t const &edit," << std::endl
+       << indent_line(1) << "char const * const begin," << std::endl
+       << indent_line(1) << "char const * const end)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "assert(old_tree != 0);" << std::endl
+       << indent_line(1) << "assert(edit.m_offset + edit.m_new_length <= static_cast<wds_uint32>(end - begin));" << std::endl
+       << std::endl
+       << indent_line(1) << "reset_input(begin, end);" << std::endl
+       << std::endl
+       << indent_line(1) << "m_reuse_edit_begin = edit.m_offset;" << std::endl
+       << indent_line(1) << "m_reuse_edit_end = edit.m_offset + edit.m_old_length;" << std::endl
+       << indent_line(1) << "m_reuse_new_end = edit.m_offset + edit.m_new_length;" << std::endl
+       << indent_line(1) << "m_next_after_tree = NEXT_AFTER_TREE;" << std::endl
+       << std::endl
+       << indent_line(1) << "incremental_find_path(old_tree);" << std::endl
+       << std::endl
+       << indent_line(1) << "// Parse the deepest node of the path again, or the" << std::endl
+       << indent_line(1) << "// node above it if the new node does not fit where the" << std::endl
+       << indent_line(1) << "// old one was. The root always fits." << std::endl
+       << indent_line(1) << "for (size_t depth = m_edit_path.size(); depth-- > 0; )" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "pt_node_t * const node = incremental_reparse(depth);" << std::endl
+       << std::endl
+       << indent_line(2) << "if (node != 0)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "return static_cast<pt_" << starting_rule << "_node_t *>(incremental_splice(depth, node));" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "assert(0);" << std::endl
+       << indent_line(1) << "return 0;" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "void" << std::endl
+       << "frontend::incremental_find_path(" << std::endl
+       << indent_line(1) << "pt_node_t * const old_tree)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "edit_path_entry_t entry;" << std::endl
+       << std::endl
+       << indent_line(1) << "entry.mp_node = old_tree;" << std::endl
+       << indent_line(1) << "entry.m_begin = old_tree->offset();" << std::endl
+       << indent_line(1) << "entry.m_child = 0;" << std::endl
+       << indent_line(1) << "entry.m_head = 0;" << std::endl
+       << indent_line(1) << "entry.m_next = NEXT_AFTER_TREE;" << std::endl
+       << indent_line(1) << "entry.m_prev_end = 0;" << std::endl
+       << indent_line(1) << "entry.m_after_token = false;" << std::endl
+       << std::endl
+       << indent_line(1) << "m_edit_path.assign(1, entry);" << std::endl
+       << std::endl
+       << indent_line(1) << "// Go down to the last child which starts before the" << std::endl
+       << indent_line(1) << "// edit, while the parser had not looked at the edit" << std::endl
+       << indent_line(1) << "// when it started the child, and the first token after" << std::endl
+       << indent_line(1) << "// the child is not in the edit, so that parsing the" << std::endl
+       << indent_line(1) << "// child again from the same offset has to stop at the" << std::endl
+       << indent_line(1) << "// same token to fit in its parent." << std::endl
+       << indent_line(1) << "for (;;)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "edit_path_entry_t const parent = m_edit_path.back();" << std::endl
+       << indent_line(2) << "unsigned int const child_count = parent.mp_node->child_count();" << std::endl
+       << std::endl
+       << indent_line(2) << "entry.mp_node = 0;" << std::endl
+       << indent_line(2) << "entry.m_prev_end = parent.m_prev_end;" << std::endl
+       << indent_line(2) << "entry.m_after_token = false;" << std::endl
+       << std::endl
+       << indent_line(2) << "for (unsigned int i = 0; i < child_count; ++i)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "pt_node_t * const child = parent.mp_node->child(i);" << std::endl
+       << std::endl
+       << indent_line(3) << "if (0 == child)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "continue;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl
+       << indent_line(3) << "if ((parent.m_begin + child->offset()) > m_reuse_edit_begin)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "break;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl
+       << indent_line(3) << "if ((entry.mp_node != 0) && (entry.mp_node->length() != 0))" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "entry.m_prev_end = entry.m_begin + entry.mp_node->length();" << std::endl
+       << indent_line(4) << "entry.m_after_token = true;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl
+       << indent_line(3) << "entry.mp_node = child;" << std::endl
+       << indent_line(3) << "entry.m_begin = parent.m_begin + child->offset();" << std::endl
+       << indent_line(3) << "entry.m_child = i;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "if ((0 == entry.mp_node) ||" << std::endl
+       << indent_line(4) << "(static_cast<wds_uint32>(-1) == entry.mp_node->rule_id()))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "return;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "entry.m_head = entry.m_begin + entry.mp_node->head();" << std::endl
+       << std::endl
+       << indent_line(2) << "if (parent.m_head > entry.m_head)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "entry.m_head = parent.m_head;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "if (entry.m_head > m_reuse_edit_begin)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "return;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "// The first token after the child is the first one of" << std::endl
+       << indent_line(2) << "// a sibling after it, or the one after the parent." << std::endl
+       << indent_line(2) << "entry.m_next = parent.m_next;" << std::endl
+       << std::endl
+       << indent_line(2) << "for (unsigned int i = entry.m_child + 1; i < child_count; ++i)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "pt_node_t const * const sibling = parent.mp_node->child(i);" << std::endl
+       << std::endl
+       << indent_line(3) << "if ((sibling != 0) && (sibling->length() != 0))" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "entry.m_next = parent.m_begin + sibling->offset();" << std::endl
+       << std::endl
+       << indent_line(4) << "if (entry.m_next < m_reuse_edit_end)" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "return;" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << std::endl
+       << indent_line(4) << "entry.m_next = incremental_map(entry.m_next);" << std::endl
+       << indent_line(4) << "break;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "m_edit_path.push_back(entry);" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "pt_node_t *" << std::endl
+       << "frontend::incremental_reparse(" << std::endl
+       << indent_line(1) << "size_t const depth)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "edit_path_entry_t const entry = m_edit_path[depth];" << std::endl
+       << indent_line(1) << "wds_uint32 next = entry.m_next;" << std::endl
+       << std::endl
+       << indent_line(1) << "if ((depth != 0) && (NEXT_AFTER_TREE == next))" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "if (NEXT_AFTER_TREE == m_next_after_tree)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "wds_uint32 const tree_end = m_edit_path[0].m_begin + m_edit_path[0].mp_node->length();" << std::endl
+       << std::endl
+       << indent_line(3) << "m_next_after_tree = NEXT_UNKNOWN;" << std::endl
+       << std::endl
+       << indent_line(3) << "// The input after the tree is not edited, so that" << std::endl
+       << indent_line(3) << "// the same token follows it." << std::endl
+       << indent_line(3) << "if (tree_end >= m_reuse_edit_end)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "mp_input_curr = mp_input_begin + incremental_map(tree_end);" << std::endl
+       << indent_line(4) << "m_lookahead_count = 0;" << std::endl
+       << std::endl
+       << indent_line(4) << "// The old parse may not have scanned so far." << std::endl
+       << indent_line(4) << "try" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "m_next_after_tree = lexer_peek_token(1)->get_offset();" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << indent_line(4) << "catch (...)" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "next = m_next_after_tree;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "if ((depth != 0) && (NEXT_UNKNOWN == next))" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "return 0;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "// Scan from the node as the old parse did, the root from" << std::endl
+       << indent_line(1) << "// the beginning of the input." << std::endl
+       << indent_line(1) << "mp_input_curr = mp_input_begin + ((0 == depth) ? 0 : entry.m_begin);" << std::endl
+       << indent_line(1) << "m_lookahead_count = 0;" << std::endl
+       << indent_line(1) << "m_consumed_end = entry.m_prev_end;" << std::endl
+       << indent_line(1) << "m_examined_end = entry.m_head;" << std::endl
+       << std::endl
+       << indent_line(1) << "reuse_entry_t const reuse_entry = { entry.mp_node, entry.m_begin, 0 };" << std::endl
+       << std::endl
+       << indent_line(1) << "m_reuse_path.assign(1, reuse_entry);" << std::endl
+       << indent_line(1) << "m_node_arena.start_log();" << std::endl
+       << std::endl
+       << indent_line(1) << "pt_node_t *node = 0;" << std::endl
+       << std::endl
+       << indent_line(1) << "// A syntax error in the node is one in the whole input," << std::endl
+       << indent_line(1) << "// because the parser starts the node at the same offset" << std::endl
+       << indent_line(1) << "// in the same state." << std::endl
+       << indent_line(1) << "try" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "node = incremental_parse_rule(entry.mp_node->rule_id());" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << indent_line(1) << "catch (...)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "incremental_rollback();" << std::endl
+       << indent_line(2) << "throw;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "m_reuse_path.clear();" << std::endl
+       << std::endl
+       << indent_line(1) << "if (depth != 0)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "try" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "if (lexer_peek_token(1)->get_offset() != next)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "node = 0;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(2) << "catch (...)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "node = 0;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "// The parent keeps its offset if it has a token before" << std::endl
+       << indent_line(1) << "// the node, or the node starts where the old one did." << std::endl
+       << indent_line(1) << "if ((node != 0) &&" << std::endl
+       << indent_line(3) << "(depth != 0) &&" << std::endl
+       << indent_line(3) << "(false == entry.m_after_token) &&" << std::endl
+       << indent_line(3) << "(((0 == node->length()) != (0 == entry.mp_node->length())) ||" << std::endl
+       << indent_line(3) << " ((node->length() != 0) && (node->offset() != entry.m_begin))))" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "node = 0;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "if (0 == node)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "incremental_rollback();" << std::endl
+       << std::endl
+       << indent_line(2) << "return 0;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "m_node_arena.stop_log();" << std::endl
+       << std::endl
+       << indent_line(1) << "return node;" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "pt_node_t *" << std::endl
+       << "frontend::incremental_parse_rule(" << std::endl
+       << indent_line(1) << "wds_uint32 const rule)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "switch (rule)" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    file << indent_line(1) << "case pt_" << node->name() << "_node_t::RULE_ID:" << std::endl
+         << indent_line(2) << "return parse_" << node->name() << "();" << std::endl
+         << std::endl;
+  }
+  
+  file << indent_line(1) << "default:" << std::endl
+       << indent_line(2) << "assert(0);" << std::endl
+       << indent_line(2) << "return 0;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "pt_node_t *" << std::endl
+       << "frontend::incremental_reuse(" << std::endl
+       << indent_line(1) << "wds_uint32 const rule)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "// The offset of the next token in the old input, a" << std::endl
+       << indent_line(1) << "// token in the inserted text is new." << std::endl
+       << indent_line(1) << "wds_uint32 const offset = lexer_peek_token(1)->get_offset();" << std::endl
+       << indent_line(1) << "wds_uint32 old_offset;" << std::endl
+       << std::endl
+       << indent_line(1) << "if (offset < m_reuse_edit_begin)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "old_offset = offset;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << indent_line(1) << "else if (offset >= m_reuse_new_end)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "old_offset = offset - m_reuse_new_end + m_reuse_edit_end;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << indent_line(1) << "else" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "return 0;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "// Go down to the old token at 'old_offset', the old" << std::endl
+       << indent_line(1) << "// nodes which end before it are not reused." << std::endl
+       << indent_line(1) << "for (;;)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "while ((false == m_reuse_path.empty()) &&" << std::endl
+       << indent_line(5) << " ((m_reuse_path.back().m_begin + m_reuse_path.back().mp_node->length()) <= old_offset))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "m_reuse_path.pop_back();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "if (true == m_reuse_path.empty())" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "return 0;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "reuse_entry_t &entry = m_reuse_path.back();" << std::endl
+       << std::endl
+       << indent_line(2) << "if ((entry.m_begin > old_offset) ||" << std::endl
+       << indent_line(4) << "(entry.m_next_child == entry.mp_node->child_count()))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "break;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "pt_node_t * const child = entry.mp_node->child(entry.m_next_child);" << std::endl
+       << std::endl
+       << indent_line(2) << "++entry.m_next_child;" << std::endl
+       << std::endl
+       << indent_line(2) << "if (child != 0)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "reuse_entry_t const child_entry = { child, entry.m_begin + child->offset(), 0 };" << std::endl
+       << std::endl
+       << indent_line(3) << "m_reuse_path.push_back(child_entry);" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "// The nodes starting at the token are at the end of" << std::endl
+       << indent_line(1) << "// the path, the outer ones first. An empty node is not" << std::endl
+       << indent_line(1) << "// reused, its offset is the end of the token before it." << std::endl
+       << indent_line(1) << "size_t first = m_reuse_path.size();" << std::endl
+       << std::endl
+       << indent_line(1) << "while ((first > 0) && (m_reuse_path[first - 1].m_begin >= old_offset))" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "--first;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "for (size_t i = first; i < m_reuse_path.size(); ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "pt_node_t * const node = m_reuse_path[i].mp_node;" << std::endl
+       << indent_line(2) << "wds_uint32 const old_begin = m_reuse_path[i].m_begin;" << std::endl
+       << std::endl
+       << indent_line(2) << "if ((old_begin != old_offset) ||" << std::endl
+       << indent_line(4) << "(node->rule_id() != rule) ||" << std::endl
+       << indent_line(4) << "(0 == node->length()) ||" << std::endl
+       << indent_line(4) << "(((old_begin + node->lookahead()) > m_reuse_edit_begin) &&" << std::endl
+       << indent_line(4) << " (old_begin < m_reuse_edit_end)))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "continue;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "reused_node_t const reused = { node, node->offset(), node->head() };" << std::endl
+       << std::endl
+       << indent_line(2) << "m_reused_nodes.push_back(reused);" << std::endl
+       << indent_line(2) << "m_reuse_path.resize(i);" << std::endl
+       << std::endl
+       << indent_line(2) << "// The parent rebases the offset in the new input." << std::endl
+       << indent_line(2) << "node->set_offset(offset);" << std::endl
+       << indent_line(2) << "node->set_head((m_examined_end > offset) ? (m_examined_end - offset) : 0);" << std::endl
+       << std::endl
+       << indent_line(2) << "// Scan on after the node." << std::endl
+       << indent_line(2) << "m_lookahead_count = 0;" << std::endl
+       << indent_line(2) << "mp_input_curr = mp_input_begin + offset + node->length();" << std::endl
+       << indent_line(2) << "m_consumed_end = offset + node->length();" << std::endl
+       << std::endl
+       << indent_line(2) << "if ((offset + node->lookahead()) > m_examined_end)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "m_examined_end = offset + node->lookahead();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "return node;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "return 0;" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "void" << std::endl
+       << "frontend::incremental_finish(" << std::endl
+       << indent_line(1) << "pt_node_t * const node," << std::endl
+       << indent_line(1) << "wds_uint32 const head)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "unsigned int const child_count = node->child_count();" << std::endl
+       << std::endl
+       << indent_line(1) << "// The children still have their offsets in the input." << std::endl
+       << indent_line(1) << "// The node starts at its first token, and an empty node" << std::endl
+       << indent_line(1) << "// at the end of the last token before it." << std::endl
+       << indent_line(1) << "wds_uint32 begin = m_consumed_end;" << std::endl
+       << std::endl
+       << indent_line(1) << "for (unsigned int i = 0; i < child_count; ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "pt_node_t const * const child = node->child(i);" << std::endl
+       << std::endl
+       << indent_line(2) << "if ((child != 0) && (child->length() != 0))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "begin = child->offset();" << std::endl
+       << indent_line(3) << "break;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "node->set_offset(begin);" << std::endl
+       << indent_line(1) << "node->set_length(m_consumed_end - begin);" << std::endl
+       << indent_line(1) << "node->set_lookahead(m_examined_end - begin);" << std::endl
+       << indent_line(1) << "node->set_head((head > begin) ? (head - begin) : 0);" << std::endl
+       << std::endl
+       << indent_line(1) << "for (unsigned int i = 0; i < child_count; ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "pt_node_t * const child = node->child(i);" << std::endl
+       << std::endl
+       << indent_line(2) << "if (0 == child)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "continue;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "if (child->offset() >= begin)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "child->set_offset(child->offset() - begin);" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(2) << "else" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "// An empty child before the first token of the node" << std::endl
+       << indent_line(3) << "// is moved to it." << std::endl
+       << indent_line(3) << "wds_uint32 const lookahead = child->offset() + child->lookahead();" << std::endl
+       << indent_line(3) << "wds_uint32 const child_head = child->offset() + child->head();" << std::endl
+       << std::endl
+       << indent_line(3) << "child->set_offset(0);" << std::endl
+       << indent_line(3) << "child->set_lookahead((lookahead > begin) ? (lookahead - begin) : 0);" << std::endl
+       << indent_line(3) << "child->set_head((child_head > begin) ? (child_head - begin) : 0);" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "void" << std::endl
+       << "frontend::incremental_rollback()" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "while (false == m_reused_nodes.empty())" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "reused_node_t const &reused = m_reused_nodes.back();" << std::endl
+       << std::endl
+       << indent_line(2) << "reused.mp_node->set_offset(reused.m_offset);" << std::endl
+       << indent_line(2) << "reused.mp_node->set_head(reused.m_head);" << std::endl
+       << std::endl
+       << indent_line(2) << "m_reused_nodes.pop_back();" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "m_reuse_path.clear();" << std::endl
+       << indent_line(1) << "m_node_arena.recycle_log();" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "pt_node_t *" << std::endl
+       << "frontend::incremental_splice(" << std::endl
+       << indent_line(1) << "size_t const depth," << std::endl
+       << indent_line(1) << "pt_node_t * const node)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "pt_node_t * const old_node = m_edit_path[depth].mp_node;" << std::endl
+       << std::endl
+       << indent_line(1) << "if (depth != 0)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "edit_path_entry_t const &entry = m_edit_path[depth];" << std::endl
+       << indent_line(2) << "wds_uint32 const parent_begin = m_edit_path[depth - 1].m_begin;" << std::endl
+       << std::endl
+       << indent_line(2) << "if (node->offset() < parent_begin)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "// An empty node before the first token of its parent" << std::endl
+       << indent_line(3) << "// is moved to it, see incremental_finish()." << std::endl
+       << indent_line(3) << "wds_uint32 const lookahead = node->offset() + node->lookahead();" << std::endl
+       << indent_line(3) << "wds_uint32 const head = node->offset() + node->head();" << std::endl
+       << std::endl
+       << indent_line(3) << "node->set_offset(parent_begin);" << std::endl
+       << indent_line(3) << "node->set_lookahead((lookahead > parent_begin) ? (lookahead - parent_begin) : 0);" << std::endl
+       << indent_line(3) << "node->set_head((head > parent_begin) ? (head - parent_begin) : 0);" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "// The end and the lookahead of the child on each level," << std::endl
+       << indent_line(2) << "// in the new input, and its end in the old one." << std::endl
+       << indent_line(2) << "wds_uint32 child_end = node->offset() + node->length();" << std::endl
+       << indent_line(2) << "wds_uint32 child_old_end = entry.m_begin + old_node->length();" << std::endl
+       << indent_line(2) << "wds_uint32 child_lookahead = node->offset() + node->lookahead();" << std::endl
+       << indent_line(2) << "wds_uint32 last_end = (node->length() != 0) ? child_end : entry.m_prev_end;" << std::endl
+       << std::endl
+       << indent_line(2) << "node->set_offset(node->offset() - parent_begin);" << std::endl
+       << indent_line(2) << "m_edit_path[depth - 1].mp_node->set_child(entry.m_child, node);" << std::endl
+       << std::endl
+       << indent_line(2) << "// Only the parents on the path and the siblings after" << std::endl
+       << indent_line(2) << "// them move, the offsets of the other nodes are from" << std::endl
+       << indent_line(2) << "// these." << std::endl
+       << indent_line(2) << "for (size_t i = depth; i > 0; --i)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "pt_node_t * const parent = m_edit_path[i - 1].mp_node;" << std::endl
+       << indent_line(3) << "wds_uint32 const begin = m_edit_path[i - 1].m_begin;" << std::endl
+       << indent_line(3) << "unsigned int const child_count = parent->child_count();" << std::endl
+       << std::endl
+       << indent_line(3) << "for (unsigned int j = m_edit_path[i].m_child + 1; j < child_count; ++j)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "pt_node_t * const sibling = parent->child(j);" << std::endl
+       << std::endl
+       << indent_line(4) << "if (0 == sibling)" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "continue;" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << std::endl
+       << indent_line(4) << "wds_uint32 const old_begin = begin + sibling->offset();" << std::endl
+       << indent_line(4) << "wds_uint32 const lookahead = incremental_map(old_begin + sibling->lookahead());" << std::endl
+       << indent_line(4) << "wds_uint32 head = incremental_map(old_begin + sibling->head());" << std::endl
+       << indent_line(4) << "wds_uint32 new_begin;" << std::endl
+       << std::endl
+       << indent_line(4) << "if (sibling->length() != 0)" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "new_begin = incremental_map(old_begin);" << std::endl
+       << indent_line(5) << "last_end = new_begin + sibling->length();" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << indent_line(4) << "else" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "new_begin = (last_end > begin) ? last_end : begin;" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << std::endl
+       << indent_line(4) << "if (child_lookahead > head)" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "head = child_lookahead;" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << std::endl
+       << indent_line(4) << "sibling->set_offset(new_begin - begin);" << std::endl
+       << indent_line(4) << "sibling->set_lookahead((lookahead > new_begin) ? (lookahead - new_begin) : 0);" << std::endl
+       << indent_line(4) << "sibling->set_head((head > new_begin) ? (head - new_begin) : 0);" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl
+       << indent_line(3) << "// The parent ends with the child if it did." << std::endl
+       << indent_line(3) << "wds_uint32 const old_end = begin + parent->length();" << std::endl
+       << indent_line(3) << "wds_uint32 const end = (old_end == child_old_end) ? child_end : incremental_map(old_end);" << std::endl
+       << indent_line(3) << "wds_uint32 lookahead = incremental_map(begin + parent->lookahead());" << std::endl
+       << std::endl
+       << indent_line(3) << "if (child_lookahead > lookahead)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "lookahead = child_lookahead;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl
+       << indent_line(3) << "assert(end >= begin);" << std::endl
+       << std::endl
+       << indent_line(3) << "parent->set_length(end - begin);" << std::endl
+       << indent_line(3) << "parent->set_lookahead(lookahead - begin);" << std::endl
+       << std::endl
+       << indent_line(3) << "child_end = end;" << std::endl
+       << indent_line(3) << "child_old_end = old_end;" << std::endl
+       << indent_line(3) << "child_lookahead = lookahead;" << std::endl
+       << indent_line(3) << "last_end = (end != begin) ? end : m_edit_path[i - 1].m_prev_end;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "incremental_recycle(old_node);" << std::endl
+       << std::endl
+       << indent_line(1) << "return (0 == depth) ? node : m_edit_path[0].mp_node;" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "void" << std::endl
+       << "frontend::incremental_recycle(" << std::endl
+       << indent_line(1) << "pt_node_t * const node)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "// The old nodes which are not in the new tree." << std::endl
+       << indent_line(1) << "m_kept_nodes.clear();" << std::endl
+       << std::endl
+       << indent_line(1) << "for (size_t i = 0; i < m_reused_nodes.size(); ++i)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "m_kept_nodes.push_back(m_reused_nodes[i].mp_node);" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "m_reused_nodes.clear();" << std::endl
+       << indent_line(1) << "std::sort(m_kept_nodes.begin(), m_kept_nodes.end());" << std::endl
+       << std::endl
+       << indent_line(1) << "m_recycled_nodes.assign(1, node);" << std::endl
+       << std::endl
+       << indent_line(1) << "while (false == m_recycled_nodes.empty())" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "pt_node_t * const curr = m_recycled_nodes.back();" << std::endl
+       << std::endl
+       << indent_line(2) << "m_recycled_nodes.pop_back();" << std::endl
+       << std::endl
+       << indent_line(2) << "if (true == std::binary_search(m_kept_nodes.begin(), m_kept_nodes.end(), curr))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "continue;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "for (unsigned int i = 0; i < curr->child_count(); ++i)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "if (curr->child(i) != 0)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "m_recycled_nodes.push_back(curr->child(i));" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "curr->recycle(m_node_arena);" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl
+       << std::endl;
+}
@@ -17,6 +17,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include "ae.hpp"
 #include "node.hpp"
 #include "gen.hpp"
 #include "lookahead.hpp"
@@ -81,7 +82,11 @@ node_t::dump_gen_parser_src_for_not_regex_alternative(
     
     // Check if this alternative is an empty one, if yes, then
     // I don't need to dump any member variables.
-    if (node->name().size() != 0)
+    //
+    // The children in the node arena are freed with the
+    // arena, so that I don't delete them here.
+    if ((node->name().size() != 0) &&
+        (false == mp_ae->use_node_arena()))
     {
       node_t const *curr_node = node;
       while (curr_node->name().size() != 0)
@@ -95,61 +100,110 @@ node_t::dump_gen_parser_src_for_not_regex_alternative(
     
     file << indent_line(0) << "}" << std::endl
          << std::endl;
-
+    
     // ===========================================
-    //       Dump 'fill_nodes' function.
+    //         Dump 'child()' and 'set_child()' for
+    //         '--incremental'
     // ===========================================
-    
-    file << indent_line(0) << "void" << std::endl
-         << indent_line(0) << "pt_" << m_name << "_prod" << i << "_node_t::fill_nodes(std::list<pt_node_t *> const &nodes)" << std::endl
-         << indent_line(0) << "{" << std::endl;
-    
-    // Check if this is an empty alternative.
-    if (node->name().size() != 0)
-    {
-      file << indent_line(1) << "std::list<pt_node_t *>::const_iterator iter = nodes.begin();" << std::endl
-           << std::endl;
-    }
-    
-    node_t const *curr_node = node;
-    while (curr_node->name().size() != 0)
+    if ((true == mp_ae->incremental()) &&
+        (node->name().size() != 0))
     {
-      unsigned int const indent_depth = 1;
+      file << "pt_node_t *" << std::endl
+           << "pt_" << m_name << "_prod" << i << "_node_t::child(" << std::endl
+           << indent_line(1) << "unsigned int const i) const" << std::endl
+           << "{" << std::endl
+           << indent_line(1) << "switch (i)" << std::endl
+           << indent_line(1) << "{" << std::endl;
       
-      file << indent_line(indent_depth) << "assert((*iter) != 0);" << std::endl
-           << indent_line(1) << "mp_" << curr_node->name() << "_node_"
-           << curr_node->name_postfix_by_appear_times();
+      unsigned int child_idx = 0;
       
-      file << " = dynamic_cast<pt_"
-           << curr_node->name() << "_node_t *>(*iter);" << std::endl
-           << indent_line(indent_depth) << "++iter;" << std::endl
-           << indent_line(indent_depth);
-      
-      assert(1 == curr_node->next_nodes().size());
-      curr_node = curr_node->next_nodes().front();
-      
-      if (curr_node->name().size() != 0)
+      for (node_t const *curr_node = node;
+           curr_node->name().size() != 0;
+           curr_node = curr_node->next_nodes().front())
       {
-        file << "assert(iter != nodes.end());" << std::endl
+        file << indent_line(1) << "case " << child_idx << ":" << std::endl
+             << indent_line(2) << "return " << member_variable_name_for_one_node(curr_node) << ";" << std::endl
              << std::endl;
+        
+        ++child_idx;
       }
-      else
+      
+      file << indent_line(1) << "default:" << std::endl
+           << indent_line(2) << "return 0;" << std::endl
+           << indent_line(1) << "}" << std::endl
+           << "}" << std::endl
+           << std::endl;
+      
+      file << "void" << std::endl
+           << "pt_" << m_name << "_prod" << i << "_node_t::set_child(" << std::endl
+           << indent_line(1) << "unsigned int const i," << std::endl
+           << indent_line(1) << "pt_node_t * const node)" << std::endl
+           << "{" << std::endl
+           << indent_line(1) << "switch (i)" << std::endl
+           << indent_line(1) << "{" << std::endl;
+      
+      child_idx = 0;
+      
+      for (node_t const *curr_node = node;
+           curr_node->name().size() != 0;
+           curr_node = curr_node->next_nodes().front())
       {
-        file << "assert(iter == nodes.end());" << std::endl;
+        file << indent_line(1) << "case " << child_idx << ":" << std::endl
+             << indent_line(2) << member_variable_name_for_one_node(curr_node)
+             << " = static_cast<pt_" << curr_node->name() << "_node_t *>(node);" << std::endl
+             << indent_line(2) << "break;" << std::endl
+             << std::endl;
+        
+        ++child_idx;
       }
+      
+      file << indent_line(1) << "default:" << std::endl
+           << indent_line(2) << "assert(0);" << std::endl
+           << indent_line(2) << "break;" << std::endl
+           << indent_line(1) << "}" << std::endl
+           << "}" << std::endl
+           << std::endl;
     }
     
-    file << "}" << std::endl
-         << std::endl;
-    
     ++i;
   }
   
-  file << "pt_node_t *" << std::endl
-       << "frontend::parse_" << m_name << "(bool const consume)" << std::endl
-       << "{" << std::endl
-       << "  std::list<pt_node_t *> nodes;" << std::endl
-       << "  pt_" << m_name << "_prod_node_t *prod_node = 0;" << std::endl
+  // With '--backend=table', parse_XXX is dumped into
+  // parser_tables.cpp.
+  if (analyser_environment_t::BACKEND_TABLE == mp_ae->backend())
+  {
+    return;
+  }
+  
+  // The production node is constructed as soon as I know
+  // which alternative I am parsing, and each node parsed
+  // after that is assigned to its member directly.
+  file << "pt_" << m_name << "_node_t *" << std::endl
+       << "frontend::parse_" << m_name << "()" << std::endl
+       << "{" << std::endl;
+  
+  dump_stats_rule_counter(file, this);
+  
+  // While frontend::incremental_parse() parses again, a
+  // node of the old tree at the next token may be reused
+  // instead of parsing the rule.
+  if (true == mp_ae->incremental())
+  {
+    file << indent_line(1) << "if (false == m_reuse_path.empty())" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "pt_node_t * const reused_node = incremental_reuse(pt_" << m_name << "_node_t::RULE_ID);" << std::endl
+         << std::endl
+         << indent_line(2) << "if (reused_node != 0)" << std::endl
+         << indent_line(2) << "{" << std::endl
+         << indent_line(3) << "return static_cast<pt_" << m_name << "_node_t *>(reused_node);" << std::endl
+         << indent_line(2) << "}" << std::endl
+         << indent_line(1) << "}" << std::endl
+         << std::endl
+         << indent_line(1) << "wds_uint32 const head = m_examined_end;" << std::endl
+         << std::endl;
+  }
+  
+  file << "  pt_" << m_name << "_prod_node_t *prod_node = 0;" << std::endl
        << std::endl;
   
   if (true == m_contains_ambigious)
@@ -159,7 +213,7 @@ node_t::dump_gen_parser_src_for_not_regex_alternative(
   else
   {
     boost::shared_ptr<node_t> default_node(
-      new node_t(mp_ae, mp_rule_node, std::wstring()));
+      mp_ae->create_node(mp_rule_node));
     assert(default_node.get() != 0);
     
     std::map<node_t *, int> alternative_start_map;
@@ -187,21 +241,19 @@ node_t::dump_gen_parser_src_for_not_regex_alternative(
   }
     
   file << std::endl
-       << indent_line(1) << "if (true == consume)" << std::endl
-       << indent_line(1) << "{" << std::endl
-       << indent_line(2) << "prod_node->fill_nodes(nodes);" << std::endl
+       << indent_line(1) << "pt_" << m_name << "_node_t * const node = " << new_node_expression(mp_ae, L"m_node_arena") << "pt_" << m_name << "_node_t;" << std::endl
+       << indent_line(1) << "assert(node != 0);" << std::endl
        << std::endl
-       << indent_line(2) << "pt_" << m_name << "_node_t * const node = new pt_" << m_name << "_node_t;" << std::endl
-       << indent_line(2) << "assert(node != 0);" << std::endl
-       << std::endl
-       << indent_line(2) << "node->set_prod_node(prod_node);" << std::endl
-       << std::endl
-       << indent_line(2) << "return node;" << std::endl
-       << indent_line(1) << "}" << std::endl
-       << indent_line(1) << "else" << std::endl
-       << indent_line(1) << "{" << std::endl
-       << indent_line(2) << "return 0;" << std::endl
-       << indent_line(1) << "}" << std::endl
+       << indent_line(1) << "node->set_prod_node(prod_node);" << std::endl
+       << std::endl;
+  
+  if (true == mp_ae->incremental())
+  {
+    file << indent_line(1) << "incremental_finish(node, head);" << std::endl
+         << std::endl;
+  }
+  
+  file << indent_line(1) << "return node;" << std::endl
        << "}" << std::endl;
 }
 
@@ -228,5 +280,5 @@ node_t::dump_gen_parser_header_for_not_regex_alternative(
     }
   }
   
-  dump_pt_XXX_prodn_node_t_class_footer(file, rule_node_name, alternative_id);
+  dump_pt_XXX_prodn_node_t_class_footer(file, rule_node_name, alternative_id, alternative_start);
 }
@@ -17,6 +17,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include "ae.hpp"
 #include "node.hpp"
 #include "gen.hpp"
 #include "lookahead.hpp"
@@ -28,43 +29,6 @@
 
 namespace
 {
-  regex_group_id_t
-  check_if_meet_regex_OR_end(
-    node_t const * const curr_node,
-    regex_info_t const * const regex_info,
-    bool &meet_regex_OR_one_end,
-    bool &meet_regex_OR_total_end)
-  {
-    assert(curr_node != 0);
-    assert(regex_info != 0);
-    
-    meet_regex_OR_one_end = false;
-    meet_regex_OR_total_end = false;
-    
-    // Check if this regex contains regex_OR.
-    if (regex_info->mp_regex_OR_info != 0)
-    {
-      BOOST_FOREACH(regex_range_t const &regex_range,
-                    regex_info->mp_regex_OR_info->m_ranges)
-      {
-        if (curr_node == regex_range.mp_end_node)
-        {
-          meet_regex_OR_one_end = true;
-          
-          if (regex_range.m_regex_group_id ==
-              regex_info->mp_regex_OR_info->m_ranges.back().m_regex_group_id)
-          {
-            meet_regex_OR_total_end = true;
-          }
-          
-          return regex_range.m_regex_group_id;
-        }
-      }
-    }
-    
-    return REGEX_GROUP_ID_NONE;
-  }
-  
   regex_group_id_t
   find_regex_group_id_of_regex_OR_range_which_curr_node_reside(
     node_t const * const curr_node,
@@ -84,415 +48,42 @@ namespace
     return REGEX_GROUP_ID_NONE;
   }
   
-  void
-  emit_regex_OR_end_codes(
-    std::wfstream &file,
-    node_t const * const curr_node,
+  /// The expression reaching the members of the object
+  /// which holds the nodes of 'regex_info' at 'node' in
+  /// parse_XXX, ex:
+  ///
+  /// pt_XXX_prod0_regex0.   The struct of a regex.
+  /// pt_XXX_prod0_regex1->  The struct of one range of a
+  ///                        regex_OR.
+  std::wstring
+  regex_member_access(
     std::wstring const &rule_node_name,
     regex_info_t const * const regex_info,
-    bool &emit_empty_line_this_time,
-    unsigned int &indent_depth)
+    node_t const * const node)
   {
-    assert(curr_node != 0);
     assert(regex_info != 0);
     
-    bool meet_regex_OR_one_end;
-    bool meet_regex_OR_total_end;
-    
-    regex_group_id_t const regex_group_id =
-      check_if_meet_regex_OR_end(
-        curr_node,
-        regex_info,
-        meet_regex_OR_one_end,
-        meet_regex_OR_total_end);
-    
-    if (true == meet_regex_OR_one_end)
-    {
-      if (true == emit_empty_line_this_time)
-      {
-        file << std::endl;
-        
-        emit_empty_line_this_time = false;
-      }
-      
-      file << indent_line(indent_depth) << "pt_"
-           << rule_node_name << "_prod0_regex" << regex_info->m_ranges.front().m_regex_group_id
-           << ".mp_regex_OR_node = pt_" << rule_node_name << "_prod0_regex"
-           << regex_group_id << ";" << std::endl
-           << indent_line(indent_depth) << "pt_"
-           << rule_node_name << "_prod0_regex" << regex_info->m_ranges.front().m_regex_group_id
-           << ".regex_OR_type_id = " << regex_group_id << ";" << std::endl;
-      
-      assert(indent_depth > 0);
-      --indent_depth;
-    
-      // Dump the '}' of the above 'case xxx: {'
-      // statement.
-      file << indent_line(indent_depth) << "}" << std::endl
-           << indent_line(indent_depth) << "break;" << std::endl
-           << std::endl;
-          
-      assert(indent_depth > 0);
-      --indent_depth;
-      
-      emit_empty_line_this_time = false;
-    }
-    
-    if (true == meet_regex_OR_total_end)
-    {
-      // Dump the '}' of the 'switch' statement
-      // of regex_OR_groups.
-      file << indent_line(indent_depth) << "default:" << std::endl
-           << indent_line(indent_depth + 1) << "assert(0);" << std::endl
-           << indent_line(indent_depth + 1) << "break;" << std::endl
-           << indent_line(indent_depth) << "}" << std::endl
-           << std::endl;
-          
-      emit_empty_line_this_time = false;
-    }
-  }
-}
-
-void
-node_t::dump_gen_parser_src__fill_nodes__for_node_range(
-  std::wfstream &file) const
-{
-  std::wstring const &rule_node_name = m_name;
-  unsigned int indent_depth = 1;
-  std::list<regex_info_t const *> regex_stack;
-  bool emit_empty_line_this_time;
-  
-  // Loop each node of this node range.
-  node_t const *curr_node = mp_main_regex_alternative;
-  while (curr_node != mp_rule_end_node)
-  {
-    // If this node belongs to at least one regex group.
-    if (curr_node->regex_info().size() != 0)
-    {
-      // Loop each regex from back to front (ie. from outer
-      // most to inner most)
-      for (std::list<regex_info_t>::const_reverse_iterator iter =
-             curr_node->regex_info().rbegin();
-           iter != curr_node->regex_info().rend();
-           ++iter)
-      {
-        assert((*iter).m_type != REGEX_TYPE_OR);
-        assert(1 == (*iter).m_ranges.size());
-        
-        if ((*iter).m_ranges.front().mp_start_node == curr_node)
-        {
-          // I find a regex started at this node.
-          //
-          // 'regex_stack' contains regex_groups where the
-          // curr_node occurs.
-          regex_stack.push_front(&(*iter));
-          
-          // Everytime when I find a regex started at this
-          // node, emit 'for (;;)' codes here.
-          if ((*iter).m_type != REGEX_TYPE_ONE)
-          {
-            file << indent_line(indent_depth) << "for (;;)" << std::endl
-                 << indent_line(indent_depth) << "{" << std::endl;
-            
-            ++indent_depth;
-          }
-          
-          // If I see a regex, whether its type is
-          // REGEX_TYPE_ONE or not, I will emit a local
-          // variable of its type.
-          file << indent_line(indent_depth) << "pt_" << rule_node_name
-               << "_prod0_regex" << (*iter).m_ranges.front().m_regex_group_id << "_t pt_"
-               << rule_node_name << "_prod0_regex" << (*iter).m_ranges.front().m_regex_group_id << ";" << std::endl
-               << std::endl;
-          
-          if ((*iter).m_type != REGEX_TYPE_ONE)
-          {
-            file << indent_line(indent_depth) << "assert(iter != nodes.end());" << std::endl
-                 << indent_line(indent_depth) << "assert((*iter) != 0);" << std::endl
-                 << std::endl
-                 << indent_line(indent_depth) << "pt_regex_chooser_t const * const pt_" << rule_node_name
-                 << "_prod0_regex" << (*iter).m_ranges.front().m_regex_group_id
-                 << "_chooser = dynamic_cast<pt_regex_chooser_t *>(*iter);" << std::endl
-                 << indent_line(indent_depth) << "assert(pt_" << rule_node_name
-                 << "_prod0_regex" << (*iter).m_ranges.front().m_regex_group_id
-                 << "_chooser != 0);" << std::endl
-                 << std::endl;
-            
-            file << indent_line(indent_depth) << "if (true == pt_" << rule_node_name
-                 << "_prod0_regex" << (*iter).m_ranges.front().m_regex_group_id
-                 << "_chooser->bypass)" << std::endl
-                 << indent_line(indent_depth) << "{" << std::endl;
-            
-            ++indent_depth;
-            
-            file << indent_line(indent_depth) << "++iter;" << std::endl
-                 << indent_line(indent_depth) << "break;" << std::endl;
-            
-            --indent_depth;
-            
-            file << indent_line(indent_depth) << "}" << std::endl
-                 << indent_line(indent_depth) << "else" << std::endl
-                 << indent_line(indent_depth) << "{" << std::endl;
-            
-            ++indent_depth;
-          }
-          
-          if ((*iter).mp_regex_OR_info != 0)
-          {
-            // If this regex contains regex_OR, I will
-            // emit a switch statement.
-            file << indent_line(indent_depth) << "assert(iter != nodes.end());" << std::endl
-                 << indent_line(indent_depth) << "assert((*iter) != 0);" << std::endl
-                 << std::endl
-                 << indent_line(indent_depth) << "pt_regex_OR_chooser_t const * const chooser = dynamic_cast<pt_regex_OR_chooser_t *>(*iter);" << std::endl
-                 << indent_line(indent_depth) << "assert(chooser != 0);" << std::endl
-                 << std::endl
-                 << indent_line(indent_depth) << "++iter;" << std::endl
-                 << std::endl
-                 << indent_line(indent_depth) << "switch (chooser->regex_typename_id)" << std::endl
-                 << indent_line(indent_depth) << "{" << std::endl;
-          }
-        }
-      }
-    }
-    
-    // If this node is the starting node of a regex_OR, then
-    // I will emit a 'case xxx:' statement.
-    if (regex_stack.size() != 0)
-    {
-      if (regex_stack.front()->mp_regex_OR_info != 0)
-      {
-        BOOST_FOREACH(regex_range_t const &regex_range,
-                      regex_stack.front()->mp_regex_OR_info->m_ranges)
-        {
-          if (curr_node == regex_range.mp_start_node)
-          {
-            file << indent_line(indent_depth) << "case " << regex_range.m_regex_group_id << ":" << std::endl;
-            
-            ++indent_depth;
-            
-            file << indent_line(indent_depth) << "{" << std::endl;
-            
-            ++indent_depth;
-            
-            file << indent_line(indent_depth) << "pt_" << rule_node_name
-                 << "_prod0_regex" << regex_range.m_regex_group_id << "_t * const pt_"
-                 << rule_node_name << "_prod0_regex" << regex_range.m_regex_group_id << " = new pt_"
-                 << rule_node_name << "_prod0_regex" << regex_range.m_regex_group_id << "_t;"
-                 << std::endl
-                 << indent_line(indent_depth) << "assert(pt_" << rule_node_name << "_prod0_regex"
-                 << regex_range.m_regex_group_id << " != 0);" << std::endl
-                 << std::endl;
-            
-            break;
-          }
-        }
-      }
-    }
+    std::wstringstream ss;
     
-    regex_group_id_t regex_group_id = REGEX_GROUP_ID_NONE;
-    bool this_regex_group_id_represent_regex_OR = false;
+    ss << "pt_" << rule_node_name << "_prod0_regex";
     
-    // Find the correct regex_group_id of the parent regex.
-    if (regex_stack.size() != 0)
+    if (regex_info->mp_regex_OR_info != 0)
     {
-      // Check if this regex contains regex_OR.
-      if (regex_stack.front()->mp_regex_OR_info != 0)
-      {
-        regex_group_id =
-          find_regex_group_id_of_regex_OR_range_which_curr_node_reside(
-            curr_node,
-            regex_stack.front()->mp_regex_OR_info->m_ranges);
-        
-        this_regex_group_id_represent_regex_OR = true;
-      }
-      else
-      {
-        regex_group_id = regex_stack.front()->m_ranges.front().m_regex_group_id;
-        
-        this_regex_group_id_represent_regex_OR = false;
-      }
+      regex_group_id_t const regex_group_id =
+        find_regex_group_id_of_regex_OR_range_which_curr_node_reside(
+          node,
+          regex_info->mp_regex_OR_info->m_ranges);
       
       assert(regex_group_id != REGEX_GROUP_ID_NONE);
-    }
-    
-    // Dump codes for 'curr_node'.
-    {
-      file << indent_line(indent_depth) << "assert(iter != nodes.end());" << std::endl
-           << indent_line(indent_depth) << "assert((*iter) != 0);" << std::endl
-           << std::endl;
-      
-      file << indent_line(indent_depth);
-      
-      if (regex_group_id != REGEX_GROUP_ID_NONE)
-      {
-        file << "pt_" << rule_node_name << "_prod0_regex" << regex_group_id;
-        
-        if (true == this_regex_group_id_represent_regex_OR)
-        {
-          file << "->";
-        }
-        else
-        {
-          file << ".";
-        }
-      }
       
-      file << "mp_" << curr_node->name() << "_node_"
-           << curr_node->name_postfix_by_appear_times();
-      
-      file << " = dynamic_cast<pt_"
-           << curr_node->name() << "_node_t *>(*iter);" << std::endl
-           << indent_line(indent_depth) << "++iter;" << std::endl;
-    }
-    
-    emit_empty_line_this_time = true;
-    
-    if (regex_stack.size() != 0)
-    {
-      for (std::list<regex_info_t const *>::iterator iter = regex_stack.begin();
-           iter != regex_stack.end();
-           )
-      {
-        assert(1 == (*iter)->m_ranges.size());
-        
-        // Check if this regex contains regex_OR, and
-        // 'curr_node' is the end of one of them.
-        if ((*iter)->mp_regex_OR_info != 0)
-        {
-          emit_regex_OR_end_codes(file,
-                                  curr_node,
-                                  rule_node_name,
-                                  *iter,
-                                  emit_empty_line_this_time,
-                                  indent_depth);
-        }
-        
-        // Check if 'curr_node' is the end node of some regex.
-        if ((*iter)->m_ranges.front().mp_end_node == curr_node)
-        {
-          if (true == emit_empty_line_this_time)
-          {
-            file << std::endl;
-            
-            emit_empty_line_this_time = false;
-          }
-          
-          regex_info_t const * const used_regex_info = regex_stack.front();
-          
-          iter = regex_stack.erase(iter);
-          
-          file << indent_line(indent_depth);
-          
-          if (iter != regex_stack.end())
-          {
-            regex_group_id_t regex_group_id = REGEX_GROUP_ID_NONE;
-            bool this_regex_group_id_represent_regex_OR;
-            
-            if ((*iter)->mp_regex_OR_info != 0)
-            {
-              regex_group_id = find_regex_group_id_of_regex_OR_range_which_curr_node_reside(
-                curr_node,
-                (*iter)->mp_regex_OR_info->m_ranges);
-              
-              this_regex_group_id_represent_regex_OR = true;
-            }
-            else
-            {
-              regex_group_id = (*iter)->m_ranges.front().m_regex_group_id;
-              
-              this_regex_group_id_represent_regex_OR = false;
-            }
-            
-            assert(regex_group_id != REGEX_GROUP_ID_NONE);
-            
-            file << "pt_" << rule_node_name << "_prod0_regex" << regex_group_id;
-            
-            if (true == this_regex_group_id_represent_regex_OR)
-            {
-              file << "->";
-            }
-            else
-            {
-              file << ".";
-            }
-          }
-          
-          file << "m_regex" << used_regex_info->m_ranges.front().m_regex_group_id;
-          
-          switch (used_regex_info->m_type)
-          {
-          case REGEX_TYPE_ZERO_OR_MORE:
-          case REGEX_TYPE_ZERO_OR_ONE:
-          case REGEX_TYPE_ONE_OR_MORE:
-            file << ".push_back(";
-            break;
-            
-          case REGEX_TYPE_ONE:
-            file << " = ";
-            break;
-            
-          default:
-            assert(0);
-            break;
-          }
-          
-          file << "pt_" << rule_node_name << "_prod0_regex" << used_regex_info->m_ranges.front().m_regex_group_id;
-          
-          switch (used_regex_info->m_type)
-          {
-          case REGEX_TYPE_ZERO_OR_MORE:
-          case REGEX_TYPE_ZERO_OR_ONE:
-          case REGEX_TYPE_ONE_OR_MORE:
-            file << ")";
-            break;
-            
-          case REGEX_TYPE_ONE:
-            break;
-            
-          default:
-            assert(0);
-            break;
-          }
-          
-          file << ";" << std::endl;
-          
-          emit_empty_line_this_time = true;
-          
-          if (used_regex_info->m_type != REGEX_TYPE_ONE)
-          {
-            assert(indent_depth > 0);
-            --indent_depth;
-            
-            // Dump '}' for the 'if (true ==
-            // pt_X_prod0_regexX_chooser->bypass)' above.
-            file << indent_line(indent_depth) << "}" << std::endl;
-            
-            assert(indent_depth > 0);
-            --indent_depth;
-            
-            // Dump the '}' of the 'for (;;) {'
-            // statement of each regex group.
-            file << indent_line(indent_depth) << "}" << std::endl
-                 << std::endl;
-            
-            emit_empty_line_this_time = false;
-          }
-        }
-        else
-        {
-          ++iter;
-        }
-      }
+      ss << regex_group_id << "->";
     }
-    
-    if (true == emit_empty_line_this_time)
+    else
     {
-      file << std::endl;
+      ss << regex_info->m_ranges.front().m_regex_group_id << ".";
     }
     
-    assert(1 == curr_node->next_nodes().size());
-    curr_node = curr_node->next_nodes().front();
+    return ss.str();
   }
 }
 
@@ -609,29 +200,31 @@ node_t::dump_gen_parser_src__parse_XXX__each_regex_level_header_codes(
   if (regex_stack.back().m_arranged_lookahead_tree_iter ==
       regex_stack.back().mp_arranged_lookahead_tree->begin())
   {
+    regex_group_id_t const regex_group_id =
+      regex_stack.back().mp_regex_info->m_ranges.front().m_regex_group_id;
+    
     if (regex_stack.back().mp_regex_info->m_type != REGEX_TYPE_ONE)
     {
       file << indent_line(indent_depth) << "for (;;)" << std::endl
            << indent_line(indent_depth) << "{" << std::endl;
       
       ++indent_depth;
-      
-      file << indent_line(indent_depth) << "pt_regex_chooser_t * const pt_" << rule_node_name
-           << "_prod0_regex" << regex_stack.back().mp_regex_info->m_ranges.front().m_regex_group_id
-           << "_chooser = new pt_regex_chooser_t();" << std::endl
-           << indent_line(indent_depth) << "assert(pt_" << rule_node_name
-           << "_prod0_regex" << regex_stack.back().mp_regex_info->m_ranges.front().m_regex_group_id
-           << "_chooser != 0);" << std::endl
-           << std::endl
-           << indent_line(indent_depth) << "pt_" << rule_node_name
-           << "_prod0_regex" << regex_stack.back().mp_regex_info->m_ranges.front().m_regex_group_id
-           << "_chooser->bypass = false;" << std::endl
-           << std::endl
-           << indent_line(indent_depth) << "add_node_to_nodes(nodes, pt_" << rule_node_name
-           << "_prod0_regex" << regex_stack.back().mp_regex_info->m_ranges.front().m_regex_group_id
-           << "_chooser);" << std::endl
-           << std::endl;
     }
+    
+    // The nodes parsed in this regex are assigned to the
+    // members of a local struct, which is pushed into the
+    // vector of its parent at the end of each loop.
+    file << indent_line(indent_depth) << "pt_" << rule_node_name
+         << "_prod0_regex" << regex_group_id << "_t pt_"
+         << rule_node_name << "_prod0_regex" << regex_group_id << ";" << std::endl;
+    
+    if (regex_stack.back().mp_regex_info->m_type != REGEX_TYPE_ONE)
+    {
+      file << indent_line(indent_depth) << "bool pt_" << rule_node_name
+           << "_prod0_regex" << regex_group_id << "_bypass = false;" << std::endl;
+    }
+    
+    file << std::endl;
   }
       
   // I have already found a new leaf node of this
@@ -794,6 +387,26 @@ node_t::dump_gen_parser_src__parse_XXX__each_regex_level_header_codes(
       
       ++indent_depth;
       
+      // A leaf of the lookahead tree is a case of the
+      // decision of this regex level, except the
+      // 'default' one, which throws.
+      if ((0 == arranged_lookahead->children().size()) &&
+          (arranged_lookahead->lookahead_nodes().front() != default_node))
+      {
+        std::wstringstream decision_name;
+        
+        decision_name << rule_node_name << " (regex "
+                      << regex_stack.back().mp_regex_info->m_ranges.front().m_regex_group_id
+                      << ")";
+        
+        dump_stats_case_counter(file,
+                                mp_ae,
+                                decision_name.str(),
+                                arranged_lookahead,
+                                default_node,
+                                indent_depth);
+      }
+      
       ++i;
     }
   }
@@ -806,105 +419,6 @@ node_t::dump_gen_parser_src__parse_XXX__each_regex_level_header_codes(
          target_nodes().size() <= 1);
 }
 
-namespace
-{
-  /// Ex:
-  ///
-  /// ((a)* (b)* c)
-  /// ^           ^
-  ///
-  /// The previous successive inner regexes before node 'c' at
-  /// regex pointed by '^' are:
-  /// 
-  /// (a)* & (b)*
-  ///
-  /// Ex:
-  ///
-  /// (a (b)* c)
-  /// ^           ^
-  ///
-  /// The previous successive inner regexes before node 'c' at
-  /// regex pointed by '^' are empty.
-  ///
-  /// \param node 
-  /// \param node_regex_info_iter 
-  /// \param nodes 
-  ///
-  void
-  find_previous_successive_inner_regex(
-    node_t * const node,
-    regex_info_t const * const regex_info,
-    std::list<regex_info_t const *> &prev_regex_info_list)
-  {
-    assert(node != 0);
-    assert(regex_info != 0);
-    
-    node_t * const regex_start_node = regex_info->m_ranges.front().mp_start_node;
-    node_t * const regex_end_node = regex_info->m_ranges.front().mp_end_node;
-    
-    bool is_regex_OR_range;
-    
-    regex_range_t const *regex_range = 
-      find_regex_range_which_this_node_belongs_to(
-        regex_info,
-        node,
-        &is_regex_OR_range);
-    
-    assert(regex_range != 0);
-    
-    node_t *checking_node = regex_range->mp_start_node;
-    
-    for (;;)
-    {
-      std::list<regex_info_t>::const_reverse_iterator checking_node_iter =
-        find_regex_info_using_its_begin_and_end_node(
-          checking_node->regex_info(),
-          regex_start_node,
-          regex_end_node);
-      
-      std::list<regex_info_t>::const_reverse_iterator end_iter =
-        checking_node->regex_info().rend();
-      
-      assert(checking_node_iter != end_iter);
-      
-      --end_iter;
-      
-      if (checking_node_iter != end_iter)
-      {
-        ++checking_node_iter;
-        
-        node_t const * const checking_node_inner_regex_start_node =
-          (*checking_node_iter).m_ranges.front().mp_start_node;
-        
-        node_t const * const checking_node_inner_regex_end_node =
-          (*checking_node_iter).m_ranges.front().mp_end_node;
-        
-        if (true == check_if_node_in_node_range(
-              node,
-              checking_node_inner_regex_start_node,
-              checking_node_inner_regex_end_node))
-        {
-          // I have already found that node.
-          return;
-        }
-        else
-        {
-          prev_regex_info_list.push_back(&(*checking_node_iter));
-          
-          assert(checking_node_inner_regex_end_node->name().size() != 0);
-          assert(1 == checking_node_inner_regex_end_node->next_nodes().size());
-          
-          checking_node = checking_node_inner_regex_end_node->next_nodes().front();
-        }
-      }
-      else
-      {
-        return;
-      }
-    }
-  }
-}
-
 void
 node_t::dump_gen_parser_src__parse_XXX__real(
   std::wfstream &file) const
@@ -916,7 +430,7 @@ node_t::dump_gen_parser_src__parse_XXX__real(
   
   // Used in arranged_lookahead tree.
   boost::shared_ptr<node_t> default_node(
-    new node_t(mp_ae, mp_rule_node, std::wstring()));
+    mp_ae->create_node(mp_rule_node));
   assert(default_node.get() != 0);
   
   node_t const *curr_node = mp_main_regex_alternative;
@@ -934,7 +448,11 @@ node_t::dump_gen_parser_src__parse_XXX__real(
       }
       else
       {
-        dump_add_node_to_nodes_for_one_node_in_parse_XXX(file, curr_node, indent_depth);
+        dump_parse_one_node_in_parse_XXX(
+          file,
+          curr_node,
+          L"prod_node->" + member_variable_name_for_one_node(curr_node),
+          indent_depth);
         
         has_node_before_any_regex = true;
       }
@@ -1015,8 +533,6 @@ node_t::dump_gen_parser_src__parse_XXX__real(
                 regex_stack.back().mp_regex_info->m_ranges.front().mp_start_node,
                 regex_stack.back().mp_regex_info->m_ranges.front().mp_end_node))
           {
-            assert(regex_stack.back().mp_curr_node != 0);
-            
             if (true == regex_stack.back().m_first_enter_this_regex)
             {
               // Remember where am I in this regex.
@@ -1040,6 +556,8 @@ node_t::dump_gen_parser_src__parse_XXX__real(
               // 'regex_stack'.
             }
             
+            assert(regex_stack.back().mp_curr_node != 0);
+            
             // I don't need to do anything about the rule end
             // node.
             if (regex_stack.back().mp_curr_node->name().size() != 0)
@@ -1065,20 +583,41 @@ node_t::dump_gen_parser_src__parse_XXX__real(
               {
                 if (regex_stack.back().mp_curr_node == regex_range->mp_start_node)
                 {
-                  file << indent_line(indent_depth) << "pt_regex_OR_chooser_t * const chooser = new pt_regex_OR_chooser_t();" << std::endl
-                       << indent_line(indent_depth) << "assert(chooser != 0);" << std::endl
-                       << std::endl
-                       << indent_line(indent_depth) << "chooser->regex_typename_id = " << regex_range->m_regex_group_id << ";" << std::endl
+                  // Construct the struct of this range of the
+                  // regex_OR, and link it to the struct of
+                  // the regex.
+                  regex_group_id_t const regex_group_id =
+                    regex_stack.back().mp_regex_info->m_ranges.front().m_regex_group_id;
+                  
+                  file << indent_line(indent_depth) << "pt_" << rule_node_name
+                       << "_prod0_regex" << regex_range->m_regex_group_id << "_t * const pt_"
+                       << rule_node_name << "_prod0_regex" << regex_range->m_regex_group_id << " = "
+                       << new_node_expression(mp_ae, L"m_node_arena") << "pt_"
+                       << rule_node_name << "_prod0_regex" << regex_range->m_regex_group_id << "_t;"
                        << std::endl
-                       << indent_line(indent_depth) << "add_node_to_nodes(nodes, chooser);" << std::endl
+                       << indent_line(indent_depth) << "assert(pt_" << rule_node_name << "_prod0_regex"
+                       << regex_range->m_regex_group_id << " != 0);" << std::endl;
+                  
+                  // The regex may own a std::vector, so that
+                  // the arena has to destroy it.
+                  if (true == mp_ae->use_node_arena())
+                  {
+                    file << indent_line(indent_depth) << "m_node_arena.destroy_on_reset(pt_" << rule_node_name
+                         << "_prod0_regex" << regex_range->m_regex_group_id << ");" << std::endl;
+                  }
+                  
+                  file << std::endl
+                       << indent_line(indent_depth) << "pt_" << rule_node_name << "_prod0_regex" << regex_group_id
+                       << ".mp_regex_OR_node = pt_" << rule_node_name << "_prod0_regex"
+                       << regex_range->m_regex_group_id << ";" << std::endl
+                       << indent_line(indent_depth) << "pt_" << rule_node_name << "_prod0_regex" << regex_group_id
+                       << ".regex_OR_type_id = " << regex_range->m_regex_group_id << ";" << std::endl
                        << std::endl;
                 }
               }
               
               node_t * const real_end_node = regex_range->mp_end_node->next_nodes().front();
               
-              bool has_dumpped_prev_skip_regex_when_first_enter_this_regex = false;
-              
               // Start to dump codes for each node.
               while (regex_stack.back().mp_curr_node != real_end_node)
               {
@@ -1159,57 +698,24 @@ node_t::dump_gen_parser_src__parse_XXX__real(
                   }
                   else
                   {
-                    if ((true == regex_stack.back().m_first_enter_this_regex) &&
-                        (false == has_dumpped_prev_skip_regex_when_first_enter_this_regex))
-                    {
-                      // Ex:
-                      //
-                      // ((a b)* (c d)* e)
-                      // ^               ^
-                      // When I dump codes for the regex
-                      // pointed by '^', I have to consider
-                      // if the first token is node 'e'. If
-                      // it is, then I have to emit codes to
-                      // bypass the first regex (ie. (a b)*)
-                      // and the second regex (ie. (c d)*)
-                      std::list<regex_info_t const *> prev_regex_info_list;
-                      
-                      find_previous_successive_inner_regex(
-                        regex_stack.back().mp_curr_node,
-                        regex_stack.back().mp_regex_info,
-                        prev_regex_info_list);
-                      
-                      BOOST_FOREACH(regex_info_t const * const passed_regex_info,
-                                    prev_regex_info_list)
-                      {
-                        file << indent_line(indent_depth) << "{" << std::endl;
-                        
-                        ++indent_depth;
-                        
-                        file << indent_line(indent_depth) << "pt_regex_chooser_t * const pt_" << rule_node_name
-                             << "_prod0_regex" << passed_regex_info->m_ranges.front().m_regex_group_id
-                             << "_chooser = new pt_regex_chooser_t();" << std::endl
-                             << indent_line(indent_depth) << "assert(pt_" << rule_node_name << "_prod0_regex"
-                             << passed_regex_info->m_ranges.front().m_regex_group_id << "_chooser != 0);"
-                             << std::endl
-                             << std::endl
-                             << indent_line(indent_depth) << "pt_" << rule_node_name << "_prod0_regex"
-                             << passed_regex_info->m_ranges.front().m_regex_group_id << "_chooser->bypass = true;"
-                             << std::endl
-                             << std::endl
-                             << indent_line(indent_depth) << "add_node_to_nodes(nodes, pt_" << rule_node_name << "_prod0_regex"
-                             << passed_regex_info->m_ranges.front().m_regex_group_id << "_chooser);" << std::endl;
-                        
-                        --indent_depth;
-                        
-                        file << indent_line(indent_depth) << "}" << std::endl
-                             << std::endl;
-                      }
-                      
-                      has_dumpped_prev_skip_regex_when_first_enter_this_regex = true;                      
-                    }
-                    
-                    dump_add_node_to_nodes_for_one_node_in_parse_XXX(file, regex_stack.back().mp_curr_node, indent_depth);
+                    // Ex:
+                    //
+                    // ((a b)* (c d)* e)
+                    // ^               ^
+                    // When I dump codes for the regex
+                    // pointed by '^', and the first token
+                    // is node 'e', the first regex (ie.
+                    // (a b)*) and the second regex (ie.
+                    // (c d)*) are bypassed, and their
+                    // vectors are just left empty.
+                    dump_parse_one_node_in_parse_XXX(
+                      file,
+                      regex_stack.back().mp_curr_node,
+                      regex_member_access(rule_node_name,
+                                          regex_stack.back().mp_regex_info,
+                                          regex_stack.back().mp_curr_node)
+                      + member_variable_name_for_one_node(regex_stack.back().mp_curr_node),
+                      indent_depth);
                   }
                   
                   assert(1 == regex_stack.back().mp_curr_node->next_nodes().size());
@@ -1230,7 +736,14 @@ node_t::dump_gen_parser_src__parse_XXX__real(
                   }
                   else
                   {
-                    dump_add_node_to_nodes_for_one_node_in_parse_XXX(file, regex_stack.back().mp_curr_node, indent_depth);
+                    dump_parse_one_node_in_parse_XXX(
+                      file,
+                      regex_stack.back().mp_curr_node,
+                      regex_member_access(rule_node_name,
+                                          regex_stack.back().mp_regex_info,
+                                          regex_stack.back().mp_curr_node)
+                      + member_variable_name_for_one_node(regex_stack.back().mp_curr_node),
+                      indent_depth);
                     
                     assert(1 == regex_stack.back().mp_curr_node->next_nodes().size());
                     regex_stack.back().mp_curr_node = regex_stack.back().mp_curr_node->next_nodes().front();
@@ -1250,7 +763,7 @@ node_t::dump_gen_parser_src__parse_XXX__real(
             case REGEX_TYPE_ZERO_OR_MORE:
               file << indent_line(indent_depth) << "pt_" << rule_node_name
                    << "_prod0_regex" << regex_stack.back().mp_regex_info->m_ranges.front().m_regex_group_id
-                   << "_chooser->bypass = true;" << std::endl;
+                   << "_bypass = true;" << std::endl;
               break;
               
             case REGEX_TYPE_ONE:
@@ -1291,12 +804,32 @@ node_t::dump_gen_parser_src__parse_XXX__real(
         // others are in 'tmp_regex_stack' (if any).
         assert(1 == regex_stack.size());
         
+        regex_group_id_t const regex_group_id =
+          regex_stack.back().mp_regex_info->m_ranges.front().m_regex_group_id;
+        
+        // The struct of this regex is put into its parent,
+        // which is the struct of the outer regex, or the
+        // production node.
+        std::wstring parent;
+        
+        if (tmp_regex_stack.size() != 0)
+        {
+          parent = regex_member_access(
+            rule_node_name,
+            tmp_regex_stack.front().mp_regex_info,
+            regex_stack.back().mp_regex_info->m_ranges.front().mp_start_node);
+        }
+        else
+        {
+          parent = L"prod_node->";
+        }
+        
+        file << std::endl;
+        
         if (regex_stack.back().mp_regex_info->m_type != REGEX_TYPE_ONE)
         {
-          file << std::endl
-               << indent_line(indent_depth) << "if (true == pt_" << rule_node_name
-               << "_prod0_regex" << regex_stack.back().mp_regex_info->m_ranges.front().m_regex_group_id
-               << "_chooser->bypass)" << std::endl
+          file << indent_line(indent_depth) << "if (true == pt_" << rule_node_name
+               << "_prod0_regex" << regex_group_id << "_bypass)" << std::endl
                << indent_line(indent_depth) << "{" << std::endl;
           
           ++indent_depth;
@@ -1305,7 +838,10 @@ node_t::dump_gen_parser_src__parse_XXX__real(
         
           --indent_depth;
         
-          file << indent_line(indent_depth) << "}" << std::endl;
+          file << indent_line(indent_depth) << "}" << std::endl
+               << std::endl
+               << indent_line(indent_depth) << parent << "m_regex" << regex_group_id
+               << ".push_back(pt_" << rule_node_name << "_prod0_regex" << regex_group_id << ");" << std::endl;
         
           assert(indent_depth > 0);
           --indent_depth;
@@ -1331,6 +867,16 @@ node_t::dump_gen_parser_src__parse_XXX__real(
             }                
           }
         }
+        else
+        {
+          file << indent_line(indent_depth) << parent << "m_regex" << regex_group_id
+               << " = pt_" << rule_node_name << "_prod0_regex" << regex_group_id << ";" << std::endl;
+          
+          if (0 == tmp_regex_stack.size())
+          {
+            file << std::endl;
+          }
+        }
         
         // If there are other outer regex, then I have to
         // handle it now.
@@ -1398,36 +944,33 @@ node_t::dump_gen_parser_src__parse_XXX__real(
 }
 
 void
-node_t::dump_gen_parser_src__fill_nodes__for_regex_alternative(
+node_t::dump_gen_parser_src__parse_XXX__for_regex_alternative(
   std::wfstream &file) const
 {
-  // Dump function header for the 'fill_nodes' function.
-  file << indent_line(0) << "void" << std::endl
-       << indent_line(0) << "pt_" << m_name << "_prod0" << "_node_t::fill_nodes(std::list<pt_node_t *> const &nodes)" << std::endl
-       << indent_line(0) << "{" << std::endl
-       << indent_line(1) << "std::list<pt_node_t *>::const_iterator iter = nodes.begin();" << std::endl
-       << std::endl;
+  // The production node is constructed first, and each
+  // node is assigned to its member (or to the member of a
+  // regex struct) as soon as it is parsed.
+  file << "pt_" << m_name << "_node_t *" << std::endl
+       << "frontend::parse_" << m_name << "()" << std::endl
+       << "{" << std::endl;
   
-  dump_gen_parser_src__fill_nodes__for_node_range(file);
+  dump_stats_rule_counter(file, this);
   
-  // Dump function footer for the 'fill_nodes' function.
-  file << indent_line(1) << "assert(iter == nodes.end());" << std::endl
-       << "}" << std::endl;
-}
-
-void
-node_t::dump_gen_parser_src__parse_XXX__for_regex_alternative(
-  std::wfstream &file) const
-{
-  file << "pt_node_t *" << std::endl
-       << "frontend::parse_" << m_name << "(bool const consume)" << std::endl
-       << "{" << std::endl
-       << "  std::list<pt_node_t *> nodes;" << std::endl
-       << "  pt_" << m_name << "_prod_node_t *prod_node = new pt_" << m_name << "_prod0_node_t;" << std::endl
+  file << "  pt_" << m_name << "_prod0_node_t * const prod_node = "
+       << new_node_expression(mp_ae, L"m_node_arena") << "pt_" << m_name << "_prod0_node_t;" << std::endl
        << std::endl
        << "  assert(prod_node != 0);" << std::endl
        << std::endl;
   
+  // The production node of a regex alternative owns
+  // std::vector members, so that the arena has to destroy
+  // it.
+  if (true == mp_ae->use_node_arena())
+  {
+    file << "  m_node_arena.destroy_on_reset(prod_node);" << std::endl
+         << std::endl;
+  }
+  
   if (true == m_contains_ambigious)
   {
     file << indent_line(1) << "// ambiguity" << std::endl;
@@ -1437,21 +980,12 @@ node_t::dump_gen_parser_src__parse_XXX__for_regex_alternative(
     dump_gen_parser_src__parse_XXX__real(file);
   }
   
-  file << indent_line(1) << "if (true == consume)" << std::endl
-       << indent_line(1) << "{" << std::endl
-       << indent_line(2) << "prod_node->fill_nodes(nodes);" << std::endl
+  file << indent_line(1) << "pt_" << m_name << "_node_t * const node = " << new_node_expression(mp_ae, L"m_node_arena") << "pt_" << m_name << "_node_t;" << std::endl
+       << indent_line(1) << "assert(node != 0);" << std::endl
        << std::endl
-       << indent_line(2) << "pt_" << m_name << "_node_t * const node = new pt_" << m_name << "_node_t;" << std::endl
-       << indent_line(2) << "assert(node != 0);" << std::endl
+       << indent_line(1) << "node->set_prod_node(prod_node);" << std::endl
        << std::endl
-       << indent_line(2) << "node->set_prod_node(prod_node);" << std::endl
-       << std::endl
-       << indent_line(2) << "return node;" << std::endl
-       << indent_line(1) << "}" << std::endl
-       << indent_line(1) << "else" << std::endl
-       << indent_line(1) << "{" << std::endl
-       << indent_line(2) << "return 0;" << std::endl
-       << indent_line(1) << "}" << std::endl
+       << indent_line(1) << "return node;" << std::endl
        << "}" << std::endl;
 }
 
@@ -1564,8 +1098,12 @@ node_t::dump_gen_parser_src_for_regex_alternative(
       {
         // If this node isn't the starting node of
         // any regex, then I will emit its codes
-        // normally and directly.
-        dump_class_destructor_for_one_node(file, curr_node, 0, 1);
+        // normally and directly. The children in the node
+        // arena are freed with the arena.
+        if (false == mp_ae->use_node_arena())
+        {
+          dump_class_destructor_for_one_node(file, curr_node, 0, 1);
+        }
       }
       
       assert(1 == curr_node->next_nodes().size());
@@ -1576,13 +1114,6 @@ node_t::dump_gen_parser_src_for_regex_alternative(
   file << indent_line(0) << "}" << std::endl
        << std::endl;
   
-  // ===========================================
-  //         Dump 'fill_nodes'
-  // ===========================================
-  dump_gen_parser_src__fill_nodes__for_regex_alternative(file);
-  
-  file << std::endl;
-  
   // ===========================================
   //         Dump 'parse_XXX'
   // ===========================================
@@ -1822,10 +1353,10 @@ namespace
       assert(1 == curr_node->next_nodes().size());
       curr_node = curr_node->next_nodes().front();
       
-      find = false;
-      
       while (curr_node != real_end_node)
       {
+        find = false;
+        
         for (r_iter = curr_node->tmp_regex_info().rbegin();
              r_iter != curr_node->tmp_regex_info().rend();
              ++r_iter)
@@ -1985,5 +1516,5 @@ node_t::dump_gen_parser_header_for_regex_alternative(
   }
   
   // Dump class footer for this alternative.
-  dump_pt_XXX_prodn_node_t_class_footer(file, rule_node_name, 0);
+  dump_pt_XXX_prodn_node_t_class_footer(file, rule_node_name, 0, 0);
 }
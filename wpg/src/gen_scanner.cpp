@@ -0,0 +1,461 @@
+#include "precompiled_header.hpp"
+
+// wpg - an LL(k) parser generator
+// Copyright (C) <2007>  Wei Hu <wei.hu.tw@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "ae.hpp"
+#include "gen.hpp"
+#include "scanner.hpp"
+
+#include "wcl_memory_debugger\memory_debugger.h"
+
+namespace
+{
+  /// The number of table entries in one line of the
+  /// generated tables.
+  size_t const TABLE_ENTRIES_PER_LINE = 16;
+  
+  std::wstring
+  token_type_name(
+    std::wstring const &terminal_name)
+  {
+    std::wstring name(terminal_name);
+    
+    std::transform(name.begin(), name.end(),
+                   name.begin(),
+                   towupper);
+    
+    return L"WDS_TOKEN_TYPE_" + name;
+  }
+}
+
+/// The smallest integral type of the generated code
+/// holding the values in [0, 'count').
+wchar_t const *
+table_entry_type(
+  size_t const count)
+{
+  if (count <= 0x100)
+  {
+    return L"wds_uint8";
+  }
+  else if (count <= 0x10000)
+  {
+    return L"wds_uint16";
+  }
+  else
+  {
+    return L"wds_uint32";
+  }
+}
+
+/// Dump 'entries' as the initializer of a generated
+/// table, TABLE_ENTRIES_PER_LINE entries in one line.
+void
+dump_table_row(
+  std::wfstream &file,
+  std::vector<size_t> const &entries,
+  unsigned int const indent_level)
+{
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    if (0 == (i % TABLE_ENTRIES_PER_LINE))
+    {
+      if (i != 0)
+      {
+        file << std::endl;
+      }
+      
+      file << indent_line(indent_level);
+    }
+    else
+    {
+      file << " ";
+    }
+    
+    file << entries[i];
+    
+    if (i != (entries.size() - 1))
+    {
+      file << ",";
+    }
+  }
+  
+  file << std::endl;
+}
+
+/// Dump the tables of the scanner DFA into frontend.cpp.
+void
+analyser_environment_t::dump_gen_scanner_tables(
+  std::wfstream &file) const
+{
+  assert(mp_scanner_dfa.get() != 0);
+  
+  scanner_dfa_t const &dfa = *mp_scanner_dfa;
+  
+  file << "namespace" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "typedef " << table_entry_type(dfa.state_count())
+       << " lexer_state_type;" << std::endl
+       << std::endl
+       << indent_line(1) << "enum" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "LEXER_DEAD_STATE = " << static_cast<int>(scanner_dfa_t::DEAD_STATE) << "," << std::endl
+       << indent_line(2) << "LEXER_START_STATE = " << static_cast<int>(scanner_dfa_t::START_STATE) << "," << std::endl
+       << indent_line(2) << "LEXER_NO_TOKEN = -1," << std::endl
+       << indent_line(2) << "LEXER_SKIPPED_TOKEN = -2" << std::endl
+       << indent_line(1) << "};" << std::endl
+       << std::endl;
+  
+  // Dump the character class of each byte.
+  {
+    std::vector<size_t> char_classes;
+    
+    for (size_t c = 0; c < 256; ++c)
+    {
+      char_classes.push_back(dfa.char_class(static_cast<unsigned char>(c)));
+    }
+    
+    file << indent_line(1) << "// The character class of each input byte." << std::endl
+         << indent_line(1) << table_entry_type(dfa.char_class_count())
+         << " const lexer_char_class[256] =" << std::endl
+         << indent_line(1) << "{" << std::endl;
+    
+    dump_table_row(file, char_classes, 2);
+    
+    file << indent_line(1) << "};" << std::endl
+         << std::endl;
+  }
+  
+  // Dump the transition table, one row per state.
+  file << indent_line(1) << "// lexer_transition[state][character class]" << std::endl
+       << indent_line(1) << "lexer_state_type const lexer_transition["
+       << dfa.state_count() << "][" << dfa.char_class_count() << "] =" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  for (size_t state = 0; state < dfa.state_count(); ++state)
+  {
+    std::vector<size_t> row;
+    
+    for (size_t char_class = 0; char_class < dfa.char_class_count(); ++char_class)
+    {
+      row.push_back(dfa.transition(state, char_class));
+    }
+    
+    file << indent_line(2) << "{" << std::endl;
+    
+    dump_table_row(file, row, 3);
+    
+    file << indent_line(2) << "}";
+    
+    if (state != (dfa.state_count() - 1))
+    {
+      file << ",";
+    }
+    
+    file << std::endl;
+  }
+  
+  file << indent_line(1) << "};" << std::endl
+       << std::endl;
+  
+  // Dump the token accepted in each state.
+  std::vector<token_pattern_t const *> patterns;
+  
+  BOOST_FOREACH(token_pattern_t const &pattern, m_token_patterns)
+  {
+    patterns.push_back(&pattern);
+  }
+  
+  file << indent_line(1) << "// The token accepted in each state." << std::endl
+       << indent_line(1) << "wds_int32 const lexer_accept[" << dfa.state_count() << "] =" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  for (size_t state = 0; state < dfa.state_count(); ++state)
+  {
+    int const accept = dfa.accept(state);
+    
+    file << indent_line(2);
+    
+    if (scanner_dfa_t::NO_TOKEN == accept)
+    {
+      file << "LEXER_NO_TOKEN";
+    }
+    else if (true == patterns[accept]->m_skip)
+    {
+      file << "LEXER_SKIPPED_TOKEN";
+    }
+    else
+    {
+      file << token_type_name(patterns[accept]->m_terminal_name);
+    }
+    
+    if (state != (dfa.state_count() - 1))
+    {
+      file << ",";
+    }
+    
+    file << std::endl;
+  }
+  
+  file << indent_line(1) << "};" << std::endl
+       << "}" << std::endl;
+}
+
+/// Dump the constructors of 'frontend', and the scanner
+/// running the DFA, which fills the slots of the
+/// lookahead window.
+///
+/// With the '--push-parser' option, the input may end in
+/// the middle of a token until finish() is called, so
+/// that the scanner is lexer_try_scan_token(), which
+/// returns false instead of a token it can not complete
+/// yet.
+void
+analyser_environment_t::dump_gen_scanner_functions(
+  std::wfstream &file) const
+{
+  assert(mp_scanner_dfa.get() != 0);
+  
+  std::wstring const input_finished_initializer =
+    (true == m_push_parser) ? L"    m_input_finished(true),\n" : L"";
+  std::wstring const tokens_initializer =
+    (true == m_benchmark) ? L",\n    mp_token_curr(0),\n    mp_token_end(0)" : L"";
+  std::wstring const spans_initializer =
+    (true == m_incremental) ? L",\n    m_consumed_end(0),\n    m_examined_end(0)" : L"";
+  std::wstring const push_tree_initializer =
+    (true == m_push_parser) ? L",\n    mp_push_tree(0)" : L"";
+  std::wstring const reset_stats_call =
+    (true == m_stats) ? L"  reset_stats();\n" : L"";
+  
+  file << "frontend::frontend(" << std::endl
+       << indent_line(1) << "std::istream &input)" << std::endl
+       << indent_line(1) << ": m_input(std::istreambuf_iterator<char>(input)," << std::endl
+       << indent_line(1) << "          std::istreambuf_iterator<char>())," << std::endl
+       << input_finished_initializer
+       << indent_line(1) << "  m_lookahead_first(0)," << std::endl
+       << indent_line(1) << "  m_lookahead_count(0)," << std::endl
+       << indent_line(1) << "  m_consumed_token_count(0)" << tokens_initializer << spans_initializer << push_tree_initializer << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "mp_input_begin = m_input.data();" << std::endl
+       << indent_line(1) << "mp_input_curr = mp_input_begin;" << std::endl
+       << indent_line(1) << "mp_input_end = mp_input_begin + m_input.size();" << std::endl
+       << reset_stats_call
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "frontend::frontend(" << std::endl
+       << indent_line(1) << "char const * const begin," << std::endl
+       << indent_line(1) << "char const * const end)" << std::endl
+       << indent_line(1) << ": mp_input_begin(begin)," << std::endl
+       << indent_line(1) << "  mp_input_curr(begin)," << std::endl
+       << indent_line(1) << "  mp_input_end(end)," << std::endl
+       << input_finished_initializer
+       << indent_line(1) << "  m_lookahead_first(0)," << std::endl
+       << indent_line(1) << "  m_lookahead_count(0)," << std::endl
+       << indent_line(1) << "  m_consumed_token_count(0)" << tokens_initializer << spans_initializer << push_tree_initializer << std::endl
+       << "{" << std::endl
+       << reset_stats_call
+       << "}" << std::endl
+       << std::endl;
+  
+  if (true == m_push_parser)
+  {
+    file << "frontend::frontend()" << std::endl
+         << indent_line(1) << ": m_input_finished(false)," << std::endl
+         << indent_line(1) << "  m_lookahead_first(0)," << std::endl
+         << indent_line(1) << "  m_lookahead_count(0)," << std::endl
+         << indent_line(1) << "  m_consumed_token_count(0)" << tokens_initializer << spans_initializer << "," << std::endl
+         << indent_line(1) << "  mp_push_tree(0)" << std::endl
+         << "{" << std::endl
+         << indent_line(1) << "mp_input_begin = m_input.data();" << std::endl
+         << indent_line(1) << "mp_input_curr = mp_input_begin;" << std::endl
+         << indent_line(1) << "mp_input_end = mp_input_begin;" << std::endl
+         << reset_stats_call
+         << "}" << std::endl
+         << std::endl;
+    
+    file << "bool" << std::endl
+         << "frontend::lexer_fill_window()" << std::endl
+         << "{" << std::endl
+         << indent_line(1) << "while (m_lookahead_count < LOOKAHEAD_DEPTH)" << std::endl
+         << indent_line(1) << "{" << std::endl;
+    
+    if (true == m_benchmark)
+    {
+      // The tokens of reset_tokens() are all there, like
+      // a finished input.
+      file << indent_line(2) << "token_t &token = m_lookahead_window[(m_lookahead_first + m_lookahead_count) & LOOKAHEAD_WINDOW_MASK];" << std::endl
+           << std::endl
+           << indent_line(2) << "if (0 == mp_token_curr)" << std::endl
+           << indent_line(2) << "{" << std::endl
+           << indent_line(3) << "if (false == lexer_try_scan_token(token))" << std::endl
+           << indent_line(3) << "{" << std::endl
+           << indent_line(4) << "return false;" << std::endl
+           << indent_line(3) << "}" << std::endl
+           << indent_line(2) << "}" << std::endl
+           << indent_line(2) << "else if (mp_token_curr != mp_token_end)" << std::endl
+           << indent_line(2) << "{" << std::endl
+           << indent_line(3) << "token = *mp_token_curr;" << std::endl
+           << indent_line(3) << "++mp_token_curr;" << std::endl
+           << indent_line(2) << "}" << std::endl
+           << indent_line(2) << "else" << std::endl
+           << indent_line(2) << "{" << std::endl
+           << indent_line(3) << "token = token_t(WDS_TOKEN_TYPE_EOF);" << std::endl
+           << indent_line(2) << "}" << std::endl;
+    }
+    else
+    {
+      file << indent_line(2) << "if (false == lexer_try_scan_token(" << std::endl
+           << indent_line(2) << "      m_lookahead_window[(m_lookahead_first + m_lookahead_count) & LOOKAHEAD_WINDOW_MASK]))" << std::endl
+           << indent_line(2) << "{" << std::endl
+           << indent_line(3) << "return false;" << std::endl
+           << indent_line(2) << "}" << std::endl;
+    }
+    
+    file << std::endl
+         << indent_line(2) << "++m_lookahead_count;" << std::endl
+         << indent_line(1) << "}" << std::endl
+         << std::endl
+         << indent_line(1) << "return true;" << std::endl
+         << "}" << std::endl
+         << std::endl;
+    
+    // The parser fills the window before it looks at the
+    // tokens, so that only a caller peeking the tokens in
+    // the middle of a push parse gets here.
+    file << "void" << std::endl
+         << "frontend::lexer_scan_token(" << std::endl
+         << indent_line(1) << "token_t &token)" << std::endl
+         << "{" << std::endl
+         << indent_line(1) << "if (false == lexer_try_scan_token(token))" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "throw std::exception();" << std::endl
+         << indent_line(1) << "}" << std::endl
+         << "}" << std::endl
+         << std::endl;
+    
+    file << "bool" << std::endl
+         << "frontend::lexer_try_scan_token(" << std::endl;
+  }
+  else
+  {
+    file << "void" << std::endl
+         << "frontend::lexer_scan_token(" << std::endl;
+  }
+  
+  std::wstring const scanned = (true == m_push_parser) ? L"return true;" : L"return;";
+  
+  file << indent_line(1) << "token_t &token)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "for (;;)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "if (mp_input_curr == mp_input_end)" << std::endl
+       << indent_line(2) << "{" << std::endl;
+  
+  if (true == m_push_parser)
+  {
+    file << indent_line(3) << "if (false == m_input_finished)" << std::endl
+         << indent_line(3) << "{" << std::endl
+         << indent_line(4) << "return false;" << std::endl
+         << indent_line(3) << "}" << std::endl
+         << std::endl;
+  }
+  
+  if (true == m_incremental)
+  {
+    file << indent_line(3) << "m_examined_end = static_cast<wds_uint32>(mp_input_end - mp_input_begin) + 1;" << std::endl
+         << std::endl;
+  }
+  
+  file << indent_line(3) << "token.assign(WDS_TOKEN_TYPE_EOF," << std::endl
+       << indent_line(3) << "             static_cast<wds_uint32>(mp_input_end - mp_input_begin), 0);" << std::endl
+       << indent_line(3) << scanned << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "char const *curr = mp_input_curr;" << std::endl
+       << indent_line(2) << "char const *token_end = 0;" << std::endl
+       << indent_line(2) << "wds_int32 token_type = LEXER_NO_TOKEN;" << std::endl
+       << indent_line(2) << "lexer_state_type state = LEXER_START_STATE;" << std::endl
+       << std::endl
+       << indent_line(2) << "// Run the DFA as far as it goes, and remember the" << std::endl
+       << indent_line(2) << "// longest token seen." << std::endl
+       << indent_line(2) << "while (curr != mp_input_end)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "state = lexer_transition[state][lexer_char_class[static_cast<unsigned char>(*curr)]];" << std::endl
+       << std::endl
+       << indent_line(3) << "if (LEXER_DEAD_STATE == state)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "break;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl
+       << indent_line(3) << "++curr;" << std::endl
+       << std::endl
+       << indent_line(3) << "if (lexer_accept[state] != LEXER_NO_TOKEN)" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "token_type = lexer_accept[state];" << std::endl
+       << indent_line(4) << "token_end = curr;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl;
+  
+  if (true == m_push_parser)
+  {
+    file << indent_line(2) << "// The DFA is still alive at the end of the input so" << std::endl
+         << indent_line(2) << "// far, the next chunk may make a longer token." << std::endl
+         << indent_line(2) << "if ((curr == mp_input_end) && (false == m_input_finished))" << std::endl
+         << indent_line(2) << "{" << std::endl
+         << indent_line(3) << "return false;" << std::endl
+         << indent_line(2) << "}" << std::endl
+         << std::endl;
+  }
+  
+  if (true == m_incremental)
+  {
+    // The DFA has looked at the character which stopped
+    // it, or at the end of the input.
+    file << indent_line(2) << "wds_uint32 const examined_end = (curr == mp_input_end)" << std::endl
+         << indent_line(2) << "  ? static_cast<wds_uint32>(mp_input_end - mp_input_begin) + 1" << std::endl
+         << indent_line(2) << "  : static_cast<wds_uint32>(curr - mp_input_begin) + 1;" << std::endl
+         << std::endl
+         << indent_line(2) << "if (examined_end > m_examined_end)" << std::endl
+         << indent_line(2) << "{" << std::endl
+         << indent_line(3) << "m_examined_end = examined_end;" << std::endl
+         << indent_line(2) << "}" << std::endl
+         << std::endl;
+  }
+  
+  file << indent_line(2) << "if (LEXER_NO_TOKEN == token_type)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "throw std::exception();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "char const * const token_start = mp_input_curr;" << std::endl
+       << std::endl
+       << indent_line(2) << "mp_input_curr = token_end;" << std::endl
+       << std::endl
+       << indent_line(2) << "if (token_type != LEXER_SKIPPED_TOKEN)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "token.assign(static_cast<wds_token_type>(token_type)," << std::endl
+       << indent_line(3) << "             static_cast<wds_uint32>(token_start - mp_input_begin)," << std::endl
+       << indent_line(3) << "             static_cast<wds_uint32>(token_end - token_start));" << std::endl
+       << indent_line(3) << scanned << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl;
+}
@@ -0,0 +1,970 @@
+#include "precompiled_header.hpp"
+
+// wpg - an LL(k) parser generator
+// Copyright (C) <2007>  Wei Hu <wei.hu.tw@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// 
+
+#include "ae.hpp"
+#include "node.hpp"
+#include "gen.hpp"
+#include "lookahead.hpp"
+#include "arranged_lookahead.hpp"
+#include "ga_exception.hpp"
+
+#include "wcl_memory_debugger\memory_debugger.h"
+
+namespace
+{
+  /// The operations of the generated table driver. Each
+  /// word of 'parser_code' is (argument << PARSER_OP_BITS) |
+  /// operation.
+  enum parser_op_t
+  {
+    /// Consume the terminal 'argument'.
+    PARSER_OP_TOKEN,
+    
+    /// Parse the rule 'argument'.
+    PARSER_OP_RULE,
+    
+    /// I know the production of this rule is 'argument'.
+    PARSER_OP_PRODUCTION,
+    
+    /// Jump to the code chosen by the decision 'argument'.
+    PARSER_OP_DECIDE,
+    
+    /// Build the node of this rule from its children.
+    PARSER_OP_RETURN,
+    
+    /// This rule is ambiguous.
+    PARSER_OP_FAIL
+  };
+  typedef enum parser_op_t parser_op_t;
+  
+  size_t const PARSER_OP_BITS = 3;
+  
+  /// I walk the alternatives of each rule in the same way
+  /// as dump_gen_parser_src_real() does, but I emit the
+  /// operations into 'm_code' and the arranged lookahead
+  /// trees into 'm_lookahead' instead of the nested
+  /// switches.
+  ///
+  /// Each level of a lookahead tree is a block in
+  /// 'm_lookahead':
+  ///
+  ///   count, (token, target) * count
+  ///
+  /// where 'target' is (block << 1) | 1 if the next token
+  /// has to be peeked, otherwise (code address << 1). A
+  /// token not in the block is a syntax error, which is the
+  /// 'default' of the nested switches.
+  ///
+  /// With the '--stats' option, 'm_stats_case' is as long
+  /// as 'm_lookahead', and the entry of each token whose
+  /// target is code holds the counter of that case.
+  class parser_table_compiler_t
+  {
+  private:
+    
+    std::map<std::wstring, size_t> const &m_token_ids;
+    std::map<node_t const *, size_t> const &m_rule_ids;
+    
+    node_t const *mp_rule_node;
+    node_t const *mp_default_node;
+    
+    /// The production id of the first alternative of the
+    /// rule I am compiling.
+    size_t m_first_production;
+  
+  public:
+    
+    std::vector<size_t> m_code;
+    std::vector<size_t> m_rule_start;
+    std::vector<size_t> m_decisions;
+    std::vector<size_t> m_lookahead;
+    std::vector<size_t> m_stats_case;
+    
+    parser_table_compiler_t(
+      std::map<std::wstring, size_t> const &token_ids,
+      std::map<node_t const *, size_t> const &rule_ids)
+      : m_token_ids(token_ids),
+        m_rule_ids(rule_ids),
+        mp_rule_node(0),
+        mp_default_node(0),
+        m_first_production(0)
+    { }
+    
+    void
+    compile_rule(
+      node_t * const rule_node,
+      size_t const first_production)
+    {
+      m_rule_start.push_back(m_code.size());
+      
+      if (true == rule_node->contains_ambigious())
+      {
+        emit(PARSER_OP_FAIL, 0);
+        
+        return;
+      }
+      
+      boost::shared_ptr<node_t> default_node(
+        rule_node->ae()->create_node(rule_node));
+      assert(default_node.get() != 0);
+      
+      mp_rule_node = rule_node;
+      mp_default_node = default_node.get();
+      m_first_production = first_production;
+      
+      std::list<node_with_order_t> nodes;
+      unsigned int idx = 0;
+      
+      BOOST_FOREACH(node_t * const node, rule_node->next_nodes())
+      {
+        nodes.push_back(node_with_order_t(idx, node));
+        
+        ++idx;
+      }
+      
+      check_ambiguity(nodes);
+      
+      // If this rule has only one alternative, I know its
+      // production at the beginning.
+      if (1 == nodes.size())
+      {
+        emit(PARSER_OP_PRODUCTION, m_first_production + nodes.front().m_idx);
+      }
+      
+      compile_nodes(nodes);
+      
+      mp_rule_node = 0;
+      mp_default_node = 0;
+    }
+  
+  private:
+    
+    void
+    emit(
+      parser_op_t const op,
+      size_t const argument)
+    {
+      m_code.push_back((argument << PARSER_OP_BITS) | op);
+    }
+    
+    void
+    emit_one_node(
+      node_t const * const node)
+    {
+      if (true == node->is_terminal())
+      {
+        std::map<std::wstring, size_t>::const_iterator const iter =
+          m_token_ids.find(node->name());
+        assert(iter != m_token_ids.end());
+        
+        emit(PARSER_OP_TOKEN, iter->second);
+      }
+      else
+      {
+        std::map<node_t const *, size_t>::const_iterator const iter =
+          m_rule_ids.find(node->nonterminal_rule_node());
+        assert(iter != m_rule_ids.end());
+        
+        emit(PARSER_OP_RULE, iter->second);
+      }
+    }
+    
+    /// Emit the nodes shared by all the alternatives in
+    /// 'nodes' one by one, until the alternative finishes
+    /// or the alternatives have to be decided by the
+    /// lookahead.
+    void
+    compile_nodes(
+      std::list<node_with_order_t> &nodes)
+    {
+      for (;;)
+      {
+        assert(nodes.size() != 0);
+        
+        if ((1 == nodes.size()) &&
+            (0 == nodes.front().mp_node->name().size()))
+        {
+          emit(PARSER_OP_RETURN, 0);
+          
+          return;
+        }
+        
+        if ((nodes.size() > 1) &&
+            (ALL_NODES_HAVE_LOOKAHEAD == all_nodes_have_lookahead(nodes)))
+        {
+          compile_decision(nodes);
+          
+          return;
+        }
+        
+        assert(PART_NODES_HAVE_LOOKAHEAD != all_nodes_have_lookahead(nodes));
+        
+        emit_one_node(nodes.front().mp_node);
+        
+        go_further_one_node(nodes);
+      }
+    }
+    
+    void
+    compile_decision(
+      std::list<node_with_order_t> &nodes)
+    {
+      boost::shared_ptr<arranged_lookahead_t> arranged_lookahead(
+        collect_lookahead_into_arrange_lookahead(nodes, mp_default_node));
+      
+      merge_arranged_lookahead_tree_leaf_node_if_they_have_same_target_node(
+        arranged_lookahead.get(),
+        mp_default_node);
+      
+      // The hot entries first, table_decide() scans them in
+      // order.
+      order_arranged_lookahead_by_profile(mp_rule_node->ae(),
+                                          mp_rule_node->name(),
+                                          arranged_lookahead.get(),
+                                          mp_default_node);
+      
+      size_t const decision = m_decisions.size();
+      
+      m_decisions.push_back(0);
+      emit(PARSER_OP_DECIDE, decision);
+      
+      // The leaves compile their own decisions, which grow
+      // m_decisions, so that I do not hold an element of it
+      // across the call.
+      size_t const block = compile_lookahead_level(nodes, *arranged_lookahead);
+      
+      m_decisions[decision] = block;
+    }
+    
+    /// Emit one level of the arranged lookahead tree, and
+    /// return its block.
+    size_t
+    compile_lookahead_level(
+      std::list<node_with_order_t> const &nodes,
+      arranged_lookahead_t const &arranged_lookahead)
+    {
+      check_ambiguity(nodes);
+      
+      size_t count = 0;
+      
+      BOOST_FOREACH(arranged_lookahead_t const &child_arranged_lookahead,
+                    arranged_lookahead.children())
+      {
+        if (child_arranged_lookahead.lookahead_nodes().front() != mp_default_node)
+        {
+          count += child_arranged_lookahead.lookahead_nodes().size();
+        }
+      }
+      
+      // Reserve the whole block first, the blocks of the
+      // next levels are appended after it.
+      size_t const block = m_lookahead.size();
+      size_t entry = block + 1;
+      
+      m_lookahead.push_back(count);
+      m_lookahead.resize(m_lookahead.size() + (count * 2), 0);
+      
+      if (true == mp_rule_node->ae()->stats())
+      {
+        m_stats_case.resize(m_lookahead.size(), 0);
+      }
+      
+      BOOST_FOREACH(arranged_lookahead_t const &child_arranged_lookahead,
+                    arranged_lookahead.children())
+      {
+        if (child_arranged_lookahead.lookahead_nodes().front() == mp_default_node)
+        {
+          assert(1 == child_arranged_lookahead.lookahead_nodes().size());
+          
+          continue;
+        }
+        
+        size_t target;
+        size_t stats_case = 0;
+        
+        if (child_arranged_lookahead.children().size() > 0)
+        {
+          assert(0 == child_arranged_lookahead.target_nodes().size());
+          
+          target = (compile_lookahead_level(nodes, child_arranged_lookahead) << 1) | 1;
+        }
+        else
+        {
+          target = m_code.size() << 1;
+          
+          if (true == mp_rule_node->ae()->stats())
+          {
+            stats_case = mp_rule_node->ae()->add_stats_case(
+              stats_case_description(mp_rule_node->name(),
+                                     &child_arranged_lookahead,
+                                     mp_default_node));
+          }
+          
+          std::list<node_with_order_t> same_lookahead_nodes =
+            child_arranged_lookahead.target_nodes();
+          
+          compile_leaf(same_lookahead_nodes);
+        }
+        
+        BOOST_FOREACH(node_t const * const node, child_arranged_lookahead.lookahead_nodes())
+        {
+          // An empty name is EOF.
+          std::map<std::wstring, size_t>::const_iterator iter =
+            m_token_ids.find(node->name());
+          assert(iter != m_token_ids.end());
+          
+          if (true == mp_rule_node->ae()->stats())
+          {
+            m_stats_case[entry] = stats_case;
+          }
+          
+          m_lookahead[entry++] = iter->second;
+          m_lookahead[entry++] = target;
+        }
+      }
+      
+      assert(entry == (block + 1 + (count * 2)));
+      
+      return block;
+    }
+    
+    /// The lookahead tokens have chosen 'nodes', emit the
+    /// code parsing them.
+    void
+    compile_leaf(
+      std::list<node_with_order_t> &nodes)
+    {
+      assert(nodes.size() > 0);
+      
+      // The lookahead symbols have decided the
+      // alternative.
+      if (1 == nodes.size())
+      {
+        emit(PARSER_OP_PRODUCTION, m_first_production + nodes.front().m_idx);
+        
+        if (0 == nodes.front().mp_node->name().size())
+        {
+          emit(PARSER_OP_RETURN, 0);
+          
+          return;
+        }
+      }
+      
+      // The nodes left have to be the same symbol,
+      // otherwise the grammar is ambiguous.
+      BOOST_FOREACH(node_with_order_t const &node, nodes)
+      {
+        if (node.mp_node->name().compare(nodes.front().mp_node->name()) != 0)
+        {
+          throw ga_exception_meet_ambiguity_t();
+        }
+      }
+      
+      // The lookahead of these nodes has been used to come
+      // here, so that I parse the first one without
+      // deciding again.
+      emit_one_node(nodes.front().mp_node);
+      
+      go_further_one_node(nodes);
+      
+      compile_nodes(nodes);
+    }
+  };
+  
+  /// Dump a table of the generated code. C++ does not allow
+  /// an empty array, so that an empty table has one unused
+  /// entry.
+  void
+  dump_parser_table(
+    std::wfstream &file,
+    wchar_t const * const comment,
+    wchar_t const * const name,
+    std::vector<size_t> entries)
+  {
+    if (0 == entries.size())
+    {
+      entries.push_back(0);
+    }
+    
+    size_t const max_entry = *std::max_element(entries.begin(), entries.end());
+    
+    file << indent_line(1) << "// " << comment << std::endl
+         << indent_line(1) << table_entry_type(max_entry + 1)
+         << " const " << name << "[" << entries.size() << "] =" << std::endl
+         << indent_line(1) << "{" << std::endl;
+    
+    dump_table_row(file, entries, 2);
+    
+    file << indent_line(1) << "};" << std::endl
+         << std::endl;
+  }
+}
+
+/// Dump parser_tables.cpp for the '--backend=table'
+/// option. Each parse_XXX runs the same driver over the
+/// tables compiled from the arranged lookahead trees, and
+/// table_build_node() constructs the production node of
+/// each alternative from the children the driver keeps on
+/// its stack.
+void
+analyser_environment_t::dump_gen_parser_tables_cpp(
+  std::wfstream &file) const
+{
+  assert(true == m_using_pure_BNF);
+  
+  // The token ids are the values of wds_token_type, see
+  // dump_gen_parser_basic_types_hpp().
+  std::map<std::wstring, size_t> token_ids;
+  
+  token_ids[std::wstring()] = 0;
+  
+  {
+    typedef terminal_hash_table_t::index<terminal_name>::type node_by_name;
+    
+    size_t id = 1;
+    
+    for (node_by_name::iterator iter = m_terminal_hash_table.get<terminal_name>().begin();
+         iter != m_terminal_hash_table.get<terminal_name>().end();
+         ++iter)
+    {
+      token_ids[*iter] = id;
+      
+      ++id;
+    }
+  }
+  
+  std::map<node_t const *, size_t> rule_ids;
+  
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    size_t const id = rule_ids.size();
+    
+    rule_ids[node] = id;
+  }
+  
+  parser_table_compiler_t compiler(token_ids, rule_ids);
+  size_t production_count = 0;
+  
+  BOOST_FOREACH(node_t * const node, m_top_level_nodes)
+  {
+    compiler.compile_rule(node, production_count);
+    
+    production_count += node->next_nodes().size();
+  }
+  
+  file << "#include <cassert>" << std::endl
+       << "#include <exception>" << std::endl
+       << "#include <string>" << std::endl
+       << "#include <vector>" << std::endl
+       << "#include \"parser_nodes.hpp\"" << std::endl
+       << "#include \"parser_basic_types.hpp\"" << std::endl
+       << "#include \"frontend.hpp\"" << std::endl
+       << "#include \"token.hpp\"" << std::endl
+       << std::endl;
+  
+  file << "namespace" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "enum" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "PARSER_OP_TOKEN = " << static_cast<int>(PARSER_OP_TOKEN) << "," << std::endl
+       << indent_line(2) << "PARSER_OP_RULE = " << static_cast<int>(PARSER_OP_RULE) << "," << std::endl
+       << indent_line(2) << "PARSER_OP_PRODUCTION = " << static_cast<int>(PARSER_OP_PRODUCTION) << "," << std::endl
+       << indent_line(2) << "PARSER_OP_DECIDE = " << static_cast<int>(PARSER_OP_DECIDE) << "," << std::endl
+       << indent_line(2) << "PARSER_OP_RETURN = " << static_cast<int>(PARSER_OP_RETURN) << "," << std::endl
+       << indent_line(2) << "PARSER_OP_FAIL = " << static_cast<int>(PARSER_OP_FAIL) << "," << std::endl
+       << indent_line(2) << "PARSER_OP_BITS = " << PARSER_OP_BITS << "," << std::endl
+       << indent_line(2) << "PARSER_OP_MASK = (1 << PARSER_OP_BITS) - 1" << std::endl
+       << indent_line(1) << "};" << std::endl
+       << std::endl;
+  
+  file << indent_line(1) << "enum" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    file << indent_line(2) << "PARSER_RULE_" << node->name() << " = " << rule_ids[node];
+    
+    if (node != m_top_level_nodes.back())
+    {
+      file << ",";
+    }
+    
+    file << std::endl;
+  }
+  
+  file << indent_line(1) << "};" << std::endl
+       << std::endl;
+  
+  dump_parser_table(file,
+                    L"(argument << PARSER_OP_BITS) | operation",
+                    L"parser_code",
+                    compiler.m_code);
+  dump_parser_table(file,
+                    L"The first operation of each rule.",
+                    L"parser_rule_start",
+                    compiler.m_rule_start);
+  dump_parser_table(file,
+                    L"The first lookahead block of each decision.",
+                    L"parser_decision",
+                    compiler.m_decisions);
+  dump_parser_table(file,
+                    L"count, (token, (block << 1) | 1 or (code << 1)) * count",
+                    L"parser_lookahead",
+                    compiler.m_lookahead);
+  
+  if (m_stats_cases.size() != 0)
+  {
+    dump_parser_table(file,
+                      L"The case counter of each token in parser_lookahead.",
+                      L"parser_stats_case",
+                      compiler.m_stats_case);
+  }
+  
+  file << "}" << std::endl
+       << std::endl;
+  
+  // ===========================================
+  //         Dump the driver
+  // ===========================================
+  file << "pt_node_t *" << std::endl
+       << "frontend::table_parse(" << std::endl
+       << indent_line(1) << "wds_uint32 const rule)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "table_start(rule);" << std::endl
+       << std::endl
+       << indent_line(1) << "return table_run();" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "void" << std::endl
+       << "frontend::table_start(" << std::endl
+       << indent_line(1) << "wds_uint32 const rule)" << std::endl
+       << "{" << std::endl;
+  
+  if (true == m_stats)
+  {
+    file << indent_line(1) << "++m_stats_rule_calls[rule];" << std::endl
+         << std::endl;
+  }
+  
+  if (true == use_node_arena())
+  {
+    // The arena owns the children which a parse which
+    // threw leaves here.
+    file << indent_line(1) << "// A parse which threw leaves its frames here." << std::endl
+         << indent_line(1) << "m_table_frames.clear();" << std::endl
+         << indent_line(1) << "m_table_children.clear();" << std::endl
+         << std::endl;
+  }
+  else
+  {
+    // A push parse which is left waiting for tokens
+    // still owns its children.
+    file << indent_line(1) << "table_discard();" << std::endl
+         << std::endl;
+  }
+  
+  file << indent_line(1) << "table_frame_t frame;" << std::endl
+       << indent_line(1) << "frame.m_pc = parser_rule_start[rule];" << std::endl
+       << indent_line(1) << "frame.m_children_base = 0;" << std::endl
+       << indent_line(1) << "frame.m_production = 0;" << std::endl;
+  
+  if (true == m_incremental)
+  {
+    file << indent_line(1) << "frame.m_head = m_examined_end;" << std::endl;
+  }
+  
+  file << std::endl
+       << indent_line(1) << "m_table_frames.push_back(frame);" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  // The whole state of a parse is on the 2 stacks, so
+  // that the push parser can leave the loop when it runs
+  // out of tokens, and come back with the next chunk.
+  std::wstring wait_for_tokens;
+  
+  if (true == m_push_parser)
+  {
+    std::wstringstream ss;
+    
+    ss << indent_line(3) << "if (false == lexer_fill_window())" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "// Wait for the next chunk." << std::endl
+       << indent_line(4) << "--top.m_pc;" << std::endl
+       << indent_line(4) << "return 0;" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl;
+    
+    wait_for_tokens = ss.str();
+  }
+  
+  // The counters of the '--stats' option.
+  std::wstring count_rule_call;
+  std::wstring count_case;
+  
+  if (true == m_stats)
+  {
+    std::wstringstream ss;
+    
+    ss << indent_line(3) << "++m_stats_rule_calls[argument];" << std::endl;
+    
+    count_rule_call = ss.str();
+  }
+  
+  if (m_stats_cases.size() != 0)
+  {
+    std::wstringstream ss;
+    
+    ss << indent_line(3) << "++m_stats_cases[parser_stats_case[block + 1 + (i * 2)]];" << std::endl;
+    
+    count_case = ss.str();
+  }
+  
+  // The '--incremental' option. A frame keeps how far
+  // the scanner had looked when the rule started, and a
+  // node of the old tree may be reused instead of parsing
+  // a rule.
+  std::wstring reuse_node;
+  std::wstring frame_head;
+  std::wstring finish_node;
+  
+  if (true == m_incremental)
+  {
+    std::wstringstream ss;
+    
+    ss << indent_line(3) << "if (false == m_reuse_path.empty())" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "pt_node_t * const node = incremental_reuse(argument);" << std::endl
+       << std::endl
+       << indent_line(4) << "if (node != 0)" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "m_table_children.push_back(node);" << std::endl
+       << indent_line(5) << "break;" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << std::endl;
+    
+    reuse_node = ss.str();
+    ss.str(L"");
+    
+    ss << indent_line(3) << "frame.m_head = m_examined_end;" << std::endl;
+    
+    frame_head = ss.str();
+    ss.str(L"");
+    
+    ss << indent_line(4) << "incremental_finish(node, top.m_head);" << std::endl;
+    
+    finish_node = ss.str();
+  }
+  
+  if (false == use_node_arena())
+  {
+    // Without the node arena, the children on the stack
+    // are only owned by the stack until their production
+    // node is built, so that I delete them when the parse
+    // fails.
+    file << "void" << std::endl
+         << "frontend::table_discard()" << std::endl
+         << "{" << std::endl
+         << indent_line(1) << "for (std::vector<pt_node_t *>::const_iterator iter = m_table_children.begin();" << std::endl
+         << indent_line(1) << "     iter != m_table_children.end();" << std::endl
+         << indent_line(1) << "     ++iter)" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "delete (*iter);" << std::endl
+         << indent_line(1) << "}" << std::endl
+         << std::endl
+         << indent_line(1) << "m_table_frames.clear();" << std::endl
+         << indent_line(1) << "m_table_children.clear();" << std::endl
+         << "}" << std::endl
+         << std::endl;
+    
+    file << "pt_node_t *" << std::endl
+         << "frontend::table_run()" << std::endl
+         << "{" << std::endl
+         << indent_line(1) << "try" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "return table_loop();" << std::endl
+         << indent_line(1) << "}" << std::endl
+         << indent_line(1) << "catch (...)" << std::endl
+         << indent_line(1) << "{" << std::endl
+         << indent_line(2) << "table_discard();" << std::endl
+         << indent_line(2) << "throw;" << std::endl
+         << indent_line(1) << "}" << std::endl
+         << "}" << std::endl
+         << std::endl;
+  }
+  
+  file << "pt_node_t *" << std::endl
+       << ((true == use_node_arena()) ? "frontend::table_run()" : "frontend::table_loop()") << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "table_frame_t frame;" << std::endl
+       << std::endl
+       << indent_line(1) << "for (;;)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "table_frame_t &top = m_table_frames.back();" << std::endl
+       << indent_line(2) << "wds_uint32 const word = parser_code[top.m_pc++];" << std::endl
+       << indent_line(2) << "wds_uint32 const argument = word >> PARSER_OP_BITS;" << std::endl
+       << std::endl
+       << indent_line(2) << "switch (word & PARSER_OP_MASK)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(2) << "case PARSER_OP_TOKEN:" << std::endl
+       << wait_for_tokens
+       << indent_line(3) << "m_table_children.push_back(" << std::endl
+       << indent_line(4) << "ensure_next_token_is(static_cast<wds_token_type>(argument)));" << std::endl
+       << indent_line(3) << "break;" << std::endl
+       << std::endl
+       << indent_line(2) << "case PARSER_OP_RULE:" << std::endl
+       << count_rule_call
+       << reuse_node
+       << indent_line(3) << "frame.m_pc = parser_rule_start[argument];" << std::endl
+       << indent_line(3) << "frame.m_children_base = static_cast<wds_uint32>(m_table_children.size());" << std::endl
+       << indent_line(3) << "frame.m_production = 0;" << std::endl
+       << frame_head
+       << std::endl
+       << indent_line(3) << "m_table_frames.push_back(frame);" << std::endl
+       << indent_line(3) << "break;" << std::endl
+       << std::endl
+       << indent_line(2) << "case PARSER_OP_PRODUCTION:" << std::endl
+       << indent_line(3) << "top.m_production = argument;" << std::endl
+       << indent_line(3) << "break;" << std::endl
+       << std::endl
+       << indent_line(2) << "case PARSER_OP_DECIDE:" << std::endl
+       << wait_for_tokens
+       << indent_line(3) << "top.m_pc = table_decide(argument);" << std::endl
+       << indent_line(3) << "break;" << std::endl
+       << std::endl
+       << indent_line(2) << "case PARSER_OP_RETURN:" << std::endl
+       << indent_line(3) << "{" << std::endl
+       << indent_line(4) << "wds_uint32 const children_base = top.m_children_base;" << std::endl
+       << indent_line(4) << "pt_node_t * const node = table_build_node(top.m_production, children_base);" << std::endl
+       << finish_node
+       << std::endl
+       << indent_line(4) << "m_table_frames.pop_back();" << std::endl
+       << indent_line(4) << "m_table_children.resize(children_base);" << std::endl
+       << std::endl
+       << indent_line(4) << "if (0 == m_table_frames.size())" << std::endl
+       << indent_line(4) << "{" << std::endl
+       << indent_line(5) << "return node;" << std::endl
+       << indent_line(4) << "}" << std::endl
+       << std::endl
+       << indent_line(4) << "m_table_children.push_back(node);" << std::endl
+       << indent_line(3) << "}" << std::endl
+       << indent_line(3) << "break;" << std::endl
+       << std::endl
+       << indent_line(2) << "case PARSER_OP_FAIL:" << std::endl
+       << indent_line(2) << "default:" << std::endl
+       << indent_line(3) << "throw std::exception();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  file << "wds_uint32" << std::endl
+       << "frontend::table_decide(" << std::endl
+       << indent_line(1) << "wds_uint32 const decision)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "wds_uint32 block = parser_decision[decision];" << std::endl
+       << std::endl
+       << indent_line(1) << "for (unsigned int depth = 1; ; ++depth)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "wds_uint32 const type = lexer_peek_token(depth)->get_type();" << std::endl
+       << indent_line(2) << "wds_uint32 const count = parser_lookahead[block];" << std::endl
+       << indent_line(2) << "wds_uint32 i = 0;" << std::endl
+       << std::endl
+       << indent_line(2) << "while ((i < count) && (parser_lookahead[block + 1 + (i * 2)] != type))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "++i;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "if (i == count)" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << indent_line(3) << "throw std::exception();" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "wds_uint32 const target = parser_lookahead[block + 2 + (i * 2)];" << std::endl
+       << std::endl
+       << indent_line(2) << "if (0 == (target & 1))" << std::endl
+       << indent_line(2) << "{" << std::endl
+       << count_case
+       << indent_line(3) << "return target >> 1;" << std::endl
+       << indent_line(2) << "}" << std::endl
+       << std::endl
+       << indent_line(2) << "block = target >> 1;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl
+       << std::endl;
+  
+  // ===========================================
+  //         Dump the production nodes
+  // ===========================================
+  file << "pt_node_t *" << std::endl
+       << "frontend::table_build_node(" << std::endl
+       << indent_line(1) << "wds_uint32 const production," << std::endl
+       << indent_line(1) << "wds_uint32 const children_base)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "switch (production)" << std::endl
+       << indent_line(1) << "{" << std::endl;
+  
+  size_t production = 0;
+  
+  BOOST_FOREACH(node_t const * const rule_node, m_top_level_nodes)
+  {
+    unsigned int alternative_id = 0;
+    
+    BOOST_FOREACH(node_t const * const alternative_start, rule_node->next_nodes())
+    {
+      std::wstringstream prod_type;
+      
+      prod_type << "pt_" << rule_node->name() << "_prod" << alternative_id << "_node_t";
+      
+      file << indent_line(1) << "case " << production << ":" << std::endl
+           << indent_line(2) << "{" << std::endl
+           << indent_line(3) << prod_type.str() << " * const prod_node = "
+           << new_node_expression(this, L"m_node_arena") << prod_type.str() << ";" << std::endl
+           << indent_line(3) << "assert(prod_node != 0);" << std::endl
+           << std::endl;
+      
+      unsigned int child = 0;
+      
+      for (node_t const *curr_node = alternative_start;
+           curr_node->name().size() != 0;
+           curr_node = curr_node->next_nodes().front())
+      {
+        assert(1 == curr_node->next_nodes().size());
+        
+        file << indent_line(3) << "prod_node->" << member_variable_name_for_one_node(curr_node)
+             << " = static_cast<pt_" << curr_node->name() << "_node_t *>(m_table_children[children_base";
+        
+        if (child != 0)
+        {
+          file << " + " << child;
+        }
+        
+        file << "]);" << std::endl;
+        
+        ++child;
+      }
+      
+      if (child != 0)
+      {
+        file << std::endl;
+      }
+      
+      file << indent_line(3) << "pt_" << rule_node->name() << "_node_t * const node = "
+           << new_node_expression(this, L"m_node_arena") << "pt_" << rule_node->name() << "_node_t;" << std::endl
+           << indent_line(3) << "assert(node != 0);" << std::endl
+           << std::endl
+           << indent_line(3) << "node->set_prod_node(prod_node);" << std::endl
+           << std::endl
+           << indent_line(3) << "return node;" << std::endl
+           << indent_line(2) << "}" << std::endl
+           << std::endl;
+      
+      ++alternative_id;
+      ++production;
+    }
+  }
+  
+  assert(production == production_count);
+  
+  file << indent_line(1) << "default:" << std::endl
+       << indent_line(2) << "assert(0);" << std::endl
+       << indent_line(2) << "return 0;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << "}" << std::endl;
+  
+  // ===========================================
+  //         Dump parse_XXX
+  // ===========================================
+  BOOST_FOREACH(node_t const * const node, m_top_level_nodes)
+  {
+    file << std::endl
+         << "pt_" << node->name() << "_node_t *" << std::endl
+         << "frontend::parse_" << node->name() << "()" << std::endl
+         << "{" << std::endl
+         << indent_line(1) << "return static_cast<pt_" << node->name()
+         << "_node_t *>(table_parse(PARSER_RULE_" << node->name() << "));" << std::endl
+         << "}" << std::endl;
+  }
+  
+  if (false == m_push_parser)
+  {
+    return;
+  }
+  
+  // ===========================================
+  //         Dump feed() and finish()
+  // ===========================================
+  std::wstring const &starting_rule = starting_rule_node()->name();
+  
+  // The tokens are offsets into 'm_input', so that they
+  // stay valid when a chunk moves it.
+  file << std::endl
+       << "void" << std::endl
+       << "frontend::feed(" << std::endl
+       << indent_line(1) << "char const * const begin," << std::endl
+       << indent_line(1) << "char const * const end)" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "assert(false == m_input_finished);" << std::endl
+       << std::endl
+       << indent_line(1) << "std::string::size_type const curr = mp_input_curr - mp_input_begin;" << std::endl
+       << std::endl
+       << indent_line(1) << "m_input.append(begin, end);" << std::endl
+       << std::endl
+       << indent_line(1) << "mp_input_begin = m_input.data();" << std::endl
+       << indent_line(1) << "mp_input_curr = mp_input_begin + curr;" << std::endl
+       << indent_line(1) << "mp_input_end = mp_input_begin + m_input.size();" << std::endl
+       << std::endl
+       << indent_line(1) << "table_push();" << std::endl
+       << "}" << std::endl;
+  
+  file << std::endl
+       << "pt_" << starting_rule << "_node_t *" << std::endl
+       << "frontend::finish()" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "m_input_finished = true;" << std::endl
+       << std::endl
+       << indent_line(1) << "// The scanner does not wait any more, so that the" << std::endl
+       << indent_line(1) << "// parse ends here." << std::endl
+       << indent_line(1) << "table_push();" << std::endl
+       << indent_line(1) << "assert(mp_push_tree != 0);" << std::endl
+       << std::endl
+       << indent_line(1) << "return static_cast<pt_" << starting_rule << "_node_t *>(mp_push_tree);" << std::endl
+       << "}" << std::endl;
+  
+  // Like parse_XXX(), the push parser stops at the end of
+  // the starting rule, and leaves the rest of the input.
+  file << std::endl
+       << "void" << std::endl
+       << "frontend::table_push()" << std::endl
+       << "{" << std::endl
+       << indent_line(1) << "if (mp_push_tree != 0)" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "return;" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "if (0 == m_table_frames.size())" << std::endl
+       << indent_line(1) << "{" << std::endl
+       << indent_line(2) << "table_start(PARSER_RULE_" << starting_rule << ");" << std::endl
+       << indent_line(1) << "}" << std::endl
+       << std::endl
+       << indent_line(1) << "mp_push_tree = table_run();" << std::endl
+       << "}" << std::endl;
+}
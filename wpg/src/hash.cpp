@@ -51,6 +51,8 @@ analyser_environment_t::hash_rule_head(node_t * const node)
   std::pair<node_by_name::iterator, bool> result = 
     m_rule_head_hash_table.insert(node);
   assert(true == result.second);
+  
+  assert(node->symbol_id() == intern_symbol(node->name()));
 }
 
 void
@@ -127,4 +129,45 @@ analyser_environment_t::hash_terminal(std::wstring const &str)
     log(L"<ERROR>: duplicate terminal symbol: %s\n", str.c_str());
     throw ga_exception_t();
   }
+  
+  m_token_patterns.push_back(token_pattern_t(str));
+  
+  (void)intern_symbol(str);
+}
+
+/// Return the ID of the symbol named 'str', assigning the
+/// next dense ID if this is the first time I see it.
+///
+/// Terminals get their IDs in 'hash_terminal', so that all
+/// terminals occupy the lowest IDs (right after the EOF
+/// symbol, which is always 0). Nonterminals get theirs
+/// when the first node_t of that name is constructed (or
+/// renamed, see node_t::set_name() and append_name()),
+/// and the rules created later (ex: the '_apostrophe'
+/// rules) just continue the numbering.
+///
+/// \param str 
+///
+/// \return 
+///
+symbol_id_t
+analyser_environment_t::intern_symbol(std::wstring const &str)
+{
+  typedef symbol_hash_table_t::index<symbol_name>::type symbol_by_name;
+  
+  symbol_by_name::iterator iter =
+    m_symbol_hash_table.get<symbol_name>().find(str);
+  
+  if (iter != m_symbol_hash_table.get<symbol_name>().end())
+  {
+    return (*iter).m_id;
+  }
+  
+  symbol_id_t const id = static_cast<symbol_id_t>(m_symbol_hash_table.size());
+  
+  std::pair<symbol_by_name::iterator, bool> result =
+    m_symbol_hash_table.insert(symbol_t(str, id));
+  assert(true == result.second);
+  
+  return id;
 }
@@ -19,7 +19,7 @@
 
 #include "ae.hpp"
 #include "node.hpp"
-#include "stack_elem_for_left_recursion_detection.hpp"
+#include "scc.hpp"
 
 #include "wcl_memory_debugger\memory_debugger.h"
 
@@ -42,7 +42,7 @@ namespace
       }
       else
       {
-        node_t * const node = new node_t(*iter);
+        node_t * const node = (*iter)->ae()->create_node_copy(*iter);
         assert(node != 0);
         
         node->set_rule_node(node1->rule_node());
@@ -108,7 +108,7 @@ analyser_environment_t::replace_first_smaller_index_nonterminal(
         node_t *curr_node = (*iter)->next_nodes().front();
         while (false == curr_node->name().empty())
         {
-          node_t * const copy_node = new node_t(curr_node);
+          node_t * const copy_node = curr_node->ae()->create_node_copy(curr_node);
           assert(copy_node != 0);
           
           copy_node->set_rule_node(curr_node->rule_node());
@@ -269,7 +269,7 @@ namespace
     {
       /// find the last node of this alternative.
       node_t * const curr_node = (*iter)->find_alternative_last_node();
-      node_t * const new_node = new node_t(apostrophe_node);
+      node_t * const new_node = apostrophe_node->ae()->create_node_copy(apostrophe_node);
       assert(new_node != 0);
       
       new_node->set_is_rule_head(false);
@@ -346,11 +346,11 @@ analyser_environment_t::remove_immediate_left_recursion(
         apostrophe_name.append(L"_apostrophe");
         
         node_t * const apostrophe_node =
-          new node_t(this, 0, apostrophe_name);
+          create_node(0, apostrophe_name);
         assert(apostrophe_node != 0);
         
         node_t * const rule_end_node =
-          new node_t(this, apostrophe_node);
+          create_node(apostrophe_node);
         assert(rule_end_node != 0);
         
         apostrophe_node->set_is_rule_head(true);
@@ -424,253 +424,67 @@ analyser_environment_t::remove_immediate_left_recursion(
   }
 }
 
-namespace
-{
-  bool
-  find_left_recursion_in_stack(
-    node_t * const node,
-    std::list<stack_elem_for_left_recursion_detection> &stack,
-    std::list<std::list<node_t *> > &left_recursion_set)
-  {
-    bool find_a_left_recursion = false;
-    
-    for (std::list<stack_elem_for_left_recursion_detection>::const_iterator iter2 = stack.begin();
-         iter2 != stack.end();
-         ++iter2)
-    {
-      assert(true == (*iter2).mp_rule_node->is_rule_head());
-      
-      if ((*iter2).mp_rule_node == node->nonterminal_rule_node())
-      {
-        // If yes, this means:
-        //
-        // Ex:
-        //
-        // The current rule and the alternative are of
-        // the form 'A->B x ...', and the stack contains
-        // node 'B'.
-        //
-        // This means I found a left recursion.
-        //
-        // Ex:
-        // 
-        // A -> B   ------ put 'B' into the stack
-        //   -> D e
-        // B -> C   ------ put 'C' into the stack.
-        // C -> B   ------ find a left recursion
-        //                 between 'B' & 'C'
-        std::list<node_t *> left_recursion;
-        
-        for (std::list<stack_elem_for_left_recursion_detection>::const_iterator iter3 = iter2;
-             iter3 != stack.end();
-             ++iter3)
-        {
-          left_recursion.push_back((*iter3).mp_rule_node);
-        }
-        
-        left_recursion_set.push_back(left_recursion);
-        
-        find_a_left_recursion = true;
-      }
-    }
-    
-    return find_a_left_recursion;
-  }
-}
-
-void
-analyser_environment_t::detect_left_recursion_nonterminal_for_one_rule(
-  node_t * const node,
-  std::list<stack_elem_for_left_recursion_detection> &stack,
+/// A nonterminal 'B' is a left corner of 'A' if there is
+/// an alternative 'A -> X1 ... Xn B ...' where 'X1 ... Xn'
+/// can derive the empty string. Every left corner is an
+/// edge 'A->B' of the rule graph, thus the left recursive
+/// nonterminals are exactly the rules of the recursive
+/// strongly connected components of that graph.
+bool
+analyser_environment_t::detect_left_recursion(
   std::list<std::list<node_t *> > &left_recursion_set)
 {
-  assert(true == node->is_rule_head());
+  // The left recursion detection runs before
+  // detect_nullable_nonterminal(), thus I can not use
+  // node_t::is_nullable() here.
+  std::vector<bool> nullable;
+  
+  find_nullable_rules(nullable);
   
-  BOOST_FOREACH(node_t * const alternative_start, node->next_nodes())
+  rule_graph_t graph(m_top_level_nodes);
+  
+  BOOST_FOREACH(node_t * const rule_node, m_top_level_nodes)
   {
-    if (0 == alternative_start->name().size())
+    BOOST_FOREACH(node_t * const alternative_start, rule_node->next_nodes())
     {
-      assert(stack.size() != 0);
+      node_t *curr_node = alternative_start;
       
-      if (0 == stack.back().mp_source_node)
-      {
-        assert(1 == stack.size());
-        
-        continue;
-      }
-      else
+      while ((curr_node != rule_node->rule_end_node()) &&
+             (false == curr_node->is_terminal()))
       {
-        assert(1 == stack.back().mp_source_node->next_nodes().size());
+        assert(curr_node->nonterminal_rule_node() != 0);
         
-        std::list<stack_elem_for_left_recursion_detection> tmp_stack;
+        graph.add_edge(rule_node, curr_node->nonterminal_rule_node());
         
-        bool can_not_find_meaningful_node = false;
-        node_t *next_meaningful_node = 0;
-      
-        for (;;)
-        {
-          if (1 == stack.size())
-          {
-            assert(0 == stack.back().mp_source_node);
-            
-            stack.splice(stack.end(), tmp_stack);
-            
-            can_not_find_meaningful_node = true;
-            
-            break;
-          }
-          else
-          {
-            tmp_stack.push_front(stack.back());
-            stack.pop_back();
-            
-            next_meaningful_node = tmp_stack.front().mp_source_node->next_nodes().front();
-            
-            if (next_meaningful_node->name().size() != 0)
-            {
-              break;
-            }
-          }
-        }
-      
-        if (true == can_not_find_meaningful_node)
-        {
-          continue;
-        }
-        
-        assert(next_meaningful_node != 0);
-        
-        if (false == next_meaningful_node->is_terminal())
-        {
-          assert(next_meaningful_node->nonterminal_rule_node() != 0);
-        
-          bool const find_a_left_recursion = find_left_recursion_in_stack(
-            next_meaningful_node, stack, left_recursion_set);
-        
-          if (true == find_a_left_recursion)
-          {
-            stack.splice(stack.end(), tmp_stack);
-          
-            continue;
-          }
-          else
-          {
-            stack.push_back(stack_elem_for_left_recursion_detection(
-                              next_meaningful_node->nonterminal_rule_node(),
-                              next_meaningful_node));
-          
-            detect_left_recursion_nonterminal_for_one_rule(
-              next_meaningful_node->nonterminal_rule_node(),
-              stack,
-              left_recursion_set);
-          
-            assert(stack.back().mp_rule_node == next_meaningful_node->nonterminal_rule_node());
-          
-            stack.pop_back();
-          
-            stack.splice(stack.end(), tmp_stack);
-          }
-        }
-        else
+        if (false == nullable[curr_node->nonterminal_rule_node()->symbol_id()])
         {
-          stack.splice(stack.end(), tmp_stack);
-        
-          continue;
+          break;
         }
-      }
-    }
-    else
-    {
-      // Try to find an alternative whose first node is
-      // non-terminal.
-      if (false == alternative_start->is_terminal())
-      {
-        assert(alternative_start->nonterminal_rule_node() != 0);
         
-        // search the nodes in 'stack' to see if one of
-        // them is the nonterminal node of the current
-        // alternative start node.
-        bool const find_a_left_recursion = find_left_recursion_in_stack(
-          alternative_start, stack, left_recursion_set);
-        
-        if (true == find_a_left_recursion)
-        {
-          // continue to scan the next alternative of this
-          // rule.
-          continue;
-        }
-        else
-        {
-          // If I traverse a _new_ nonterminal alternative
-          // start node, then put this node into the stack.
-          //
-          // Ex:
-          //
-          // A -> B   ------ put 'B' into the stack
-          //   -> D e
-          // B -> C   ------ put 'C' into the stack.
-          stack.push_back(stack_elem_for_left_recursion_detection(
-                            alternative_start->nonterminal_rule_node(),
-                            alternative_start));
-          
-          detect_left_recursion_nonterminal_for_one_rule(
-            alternative_start->nonterminal_rule_node(),
-            stack,
-            left_recursion_set);
-          
-          assert(stack.back().mp_rule_node == alternative_start->nonterminal_rule_node());
-          
-          stack.pop_back();
-        }
-      }
-      else
-      {
-        continue;
+        assert(1 == curr_node->next_nodes().size());
+        curr_node = curr_node->next_nodes().front();
       }
     }
   }
-}
-
-bool
-analyser_environment_t::detect_left_recursion(
-  std::list<std::list<node_t *> > &left_recursion_set)
-{
-  bool has_left_recursion = false;
   
-  BOOST_FOREACH(node_t * const rule_node, m_top_level_nodes)
+  std::list<std::list<node_t *> > components;
+  
+  graph.find_recursive_components(components);
+  
+  BOOST_FOREACH(std::list<node_t *> &left_recursion, components)
   {
-    if (false == rule_node->is_left_recursion())
+    BOOST_FOREACH(node_t * const node, left_recursion)
     {
-      {
-        std::list<stack_elem_for_left_recursion_detection> stack;
-        
-        stack.push_back(stack_elem_for_left_recursion_detection(rule_node, 0));
-        
-        (void)detect_left_recursion_nonterminal_for_one_rule(rule_node, stack, left_recursion_set);
-      }
-      
-      merge_relative_set_into_final_set(left_recursion_set);
+      assert(true == node->is_rule_head());
       
-      if (0 == left_recursion_set.size())
-      {
-        // It is not a left_recursion.
-      }
-      else
-      {
-        BOOST_FOREACH(std::list<node_t *> &left_recursion, left_recursion_set)
-        {
-          BOOST_FOREACH(node_t * const node, left_recursion)
-          {
-            assert(true == node->is_rule_head());
-            
-            node->assign_left_recursion_set(left_recursion);
-          }
-        }
-        
-        has_left_recursion = true;
-      }
+      node->clear_left_recursion_set();
+      node->assign_left_recursion_set(left_recursion);
     }
   }
   
+  bool const has_left_recursion = (components.size() != 0);
+  
+  left_recursion_set.splice(left_recursion_set.end(), components);
+  
   return has_left_recursion;
 }
@@ -45,3 +45,57 @@ analyser_environment_t::lexer_get_grammar_string(
   
   return result_str;
 }
+
+/// Read a quoted token pattern, ex: "[0-9]+". A '"' after
+/// an odd number of '\' belongs to the pattern.
+///
+/// Because the grammar lexer skips the white spaces, a
+/// space in a pattern has to be written as '\x20' or '\s'.
+boost::shared_ptr<std::wstring>
+analyser_environment_t::lexer_get_token_pattern_string()
+{
+  std::list<wchar_t> delimiter;
+  boost::shared_ptr<std::wstring> result_str(::new std::wstring);
+  
+  delimiter.push_back(L'"');
+  
+  try
+  {
+    if (lexer_get_grammar_string(delimiter)->compare(L"\"") != 0)
+    {
+      log(L"<ERROR>: a token pattern should be quoted.\n");
+      throw ga_exception_t();
+    }
+    
+    for (;;)
+    {
+      boost::shared_ptr<std::wstring> const str =
+        lexer_get_grammar_string(delimiter);
+      
+      if (0 == str->compare(L"\""))
+      {
+        std::wstring::size_type backslash_count = 0;
+        
+        while ((backslash_count < result_str->size()) &&
+               (L'\\' == (*result_str)[result_str->size() - backslash_count - 1]))
+        {
+          ++backslash_count;
+        }
+        
+        if (0 == (backslash_count % 2))
+        {
+          break;
+        }
+      }
+      
+      result_str->append(*str);
+    }
+  }
+  catch (Wcl::Lexerlib::EndOfSourceException &)
+  {
+    log(L"<ERROR>: unterminated token pattern.\n");
+    throw ga_exception_t();
+  }
+  
+  return result_str;
+}
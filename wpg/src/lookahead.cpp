@@ -21,26 +21,95 @@
 #include "node.hpp"
 #include "global.hpp"
 #include "lookahead.hpp"
+#include "ga_exception.hpp"
 
 #include "wcl_memory_debugger\memory_debugger.h"
 
+void
+lookahead_level_t::push_back(lookahead_set_t * const lookahead_set)
+{
+  assert(lookahead_set != 0);
+  assert(0 == lookahead_set->mp_next_sibling);
+  
+  if (0 == mp_last)
+  {
+    assert(0 == mp_first);
+    
+    mp_first = lookahead_set;
+  }
+  else
+  {
+    mp_last->mp_next_sibling = lookahead_set;
+  }
+  
+  mp_last = lookahead_set;
+  ++m_size;
+  
+  m_id_mask |= id_bit(lookahead_set->mp_node->symbol_id());
+}
+
 lookahead_set_t *
-lookahead_set_t::find_lookahead(node_t * const node)
+lookahead_level_t::find(symbol_id_t const id) const
 {
-  for (std::list<lookahead_set_t>::iterator iter = m_next_level.begin();
-       iter != m_next_level.end();
-       ++iter)
+  if (0 == (m_id_mask & id_bit(id)))
   {
-    if (0 == (*iter).mp_node->name().compare(node->name()))
+    return 0;
+  }
+  
+  for (lookahead_set_t *curr = mp_first; curr != 0; curr = curr->mp_next_sibling)
+  {
+    if (curr->mp_node->symbol_id() == id)
     {
-      return &(*iter);
+      return curr;
     }
   }
   return 0;
 }
 
+lookahead_arena_t::~lookahead_arena_t()
+{
+  BOOST_FOREACH(lookahead_set_t * const block, m_blocks)
+  {
+    boost::checked_array_delete(block);
+  }
+}
+
 lookahead_set_t *
-lookahead_set_t::insert_lookahead(node_t * const node)
+lookahead_arena_t::allocate(
+  node_t * const orig_node,
+  node_t * const node,
+  unsigned int const level)
+{
+  if (BLOCK_SIZE == m_used_in_last_block)
+  {
+    lookahead_set_t * const block = new lookahead_set_t[BLOCK_SIZE];
+    assert(block != 0);
+    
+    m_blocks.push_back(block);
+    m_used_in_last_block = 0;
+  }
+  
+  lookahead_set_t * const lookahead_set =
+    &(m_blocks.back()[m_used_in_last_block]);
+  
+  ++m_used_in_last_block;
+  ++m_size;
+  
+  lookahead_set->reset(orig_node, node, level);
+  
+  return lookahead_set;
+}
+
+lookahead_set_t *
+lookahead_set_t::find_lookahead(node_t * const node)
+{
+  return m_next_level.find(node->symbol_id());
+}
+
+lookahead_set_t *
+lookahead_set_t::insert_lookahead(
+  lookahead_arena_t &arena,
+  node_t * const node)
 {
 #if defined(_DEBUG)
   if (node->name().size() != 0)
@@ -49,8 +118,11 @@ lookahead_set_t::insert_lookahead(node_t * const node)
   }
 #endif
   
-  m_next_level.push_back(lookahead_set_t(0, node, 0));
-  return &(m_next_level.back());
+  lookahead_set_t * const lookahead_set = arena.allocate(0, node, 0);
+  assert(lookahead_set != 0);
+  
+  m_next_level.push_back(lookahead_set);
+  return lookahead_set;
 }
 
 namespace
@@ -96,12 +168,12 @@ namespace
     // 'lookahead_set->m_next_level', then I don't add this node to
     // it, just return.
     //
-    for (std::list<lookahead_set_t>::iterator iter =
+#if defined(_DEBUG)
+    for (lookahead_level_t::const_iterator iter =
            lookahead_set->m_next_level.begin();
          iter != lookahead_set->m_next_level.end();
          ++iter)
     {
-#if defined(_DEBUG)
       if ((*iter).mp_node->name().size() != 0)
       {
         if (false == (*iter).mp_node->is_terminal())
@@ -123,23 +195,32 @@ namespace
           assert(true == find);
         }
       }
+    }
 #endif
+    
+    // Don't insert it if there has been a node with the same name in it.
+    {
+      lookahead_set_t * const existed_lookahead_set =
+        lookahead_set->m_next_level.find(node->symbol_id());
       
-      // Don't insert it if there has been a node with the same name in it.
-      if (0 == (*iter).mp_node->name().compare(node->name()))
+      if (existed_lookahead_set != 0)
       {
-        return &(*iter);
+        return existed_lookahead_set;
       }
     }
     
-    lookahead_set->m_next_level.push_back(
-      lookahead_set_t(lookahead_set->mp_orig_node,
-                      node,
-                      lookahead_set->m_level + 1));
+    lookahead_set_t * const new_lookahead_set =
+      lookahead_set->mp_orig_node->rule_node()->lookahead_arena().allocate(
+        lookahead_set->mp_orig_node,
+        node,
+        lookahead_set->m_level + 1);
+    assert(new_lookahead_set != 0);
+    
+    lookahead_set->m_next_level.push_back(new_lookahead_set);
     
     lookahead_set->mp_orig_node->set_lookahead_depth(lookahead_set->m_level + 1);
     
-    return &(lookahead_set->m_next_level.back());
+    return new_lookahead_set;
   }
 }
 
@@ -672,6 +753,33 @@ analyser_environment_t::compute_lookahead_set(
       }
       else
       {
+        // The 'as_terminal' feature changes what can be
+        // derived from a rule depending on which rule I am
+        // computing lookahead terminals for, so that the
+        // cached FIRST_k fragments can not be used in that
+        // case.
+        lookahead_set_t const * const fragments =
+          (true == lookahead_set->mp_orig_node->rule_node()->
+           token_name_as_terminal_during_lookahead().empty())
+          ? first_k_fragments(node->nonterminal_rule_node(), max_level - cur_level)
+          : 0;
+        
+        if (fragments != 0)
+        {
+          append_first_k_fragments(
+            node,
+            fragments,
+            lookahead_set,
+            prev_level_walk_count,
+            cur_level,
+            max_level,
+            recur_parent_stack,
+            last_symbol_stack,
+            curr_last_symbol_level);
+          
+          return;
+        }
+        
 #if defined(TRACING_LOOKAHEAD)
         log(L"<INFO>: trace to rule - %s[%d]\n",
             node->nonterminal_rule_node()->name().c_str(),
@@ -766,6 +874,258 @@ analyser_environment_t::compute_lookahead_set(
   }
 }
 
+/// @brief Get the FIRST_k fragments of a rule.
+///
+/// Return the cached FIRST_@p depth fragments of
+/// @p rule_node (see first_k_cache_t), computing them on
+/// the first request.
+///
+/// If computing the fragments of a rule needs the fragments
+/// of the same rule at the same depth (i.e. the rule is
+/// left recursive through some nullable prefix), I give up
+/// caching that rule, and the caller has to walk into that
+/// rule by compute_lookahead_set() as before.
+///
+/// @param rule_node 
+/// @param depth 
+///
+/// @return 0 if the fragments can not be cached.
+///
+lookahead_set_t const *
+analyser_environment_t::first_k_fragments(
+  node_t * const rule_node,
+  size_t const depth) const
+{
+  assert(true == rule_node->is_rule_head());
+  assert(depth >= 1);
+  
+  first_k_cache_t::entry_t &entry = first_k_cache().entry(
+    rule_node, static_cast<unsigned int>(depth));
+  
+  switch (entry.m_state)
+  {
+  case first_k_cache_t::STATE_DONE:
+    ++(first_k_cache().hit_count());
+    return entry.mp_fragments;
+    
+  case first_k_cache_t::STATE_COMPUTING:
+  case first_k_cache_t::STATE_UNCACHABLE:
+    return 0;
+    
+  case first_k_cache_t::STATE_NONE:
+    break;
+    
+  default:
+    assert(0);
+    break;
+  }
+  
+  entry.m_state = first_k_cache_t::STATE_COMPUTING;
+  
+  lookahead_set_t * const fragments = first_k_cache().arena().allocate(0, 0, 0);
+  assert(fragments != 0);
+  
+  for (std::list<node_t *>::const_iterator iter =
+         rule_node->next_nodes().begin();
+       iter != rule_node->next_nodes().end();
+       ++iter)
+  {
+    if (false == collect_first_k_fragments(*iter, fragments, depth))
+    {
+      entry.m_state = first_k_cache_t::STATE_UNCACHABLE;
+      
+      return 0;
+    }
+  }
+  
+  entry.m_state = first_k_cache_t::STATE_DONE;
+  entry.mp_fragments = fragments;
+  
+  return fragments;
+}
+
+/// @brief Collect the FIRST_k fragments of one alternative.
+///
+/// Walk from @p node to the end of its alternative, and put
+/// the terminal sequences (at most @p depth terminals) into
+/// @p fragments.
+///
+/// @param node 
+/// @param fragments 
+/// @param depth 
+///
+/// @return false if some nonterminal on the way can not be
+/// cached.
+///
+bool
+analyser_environment_t::collect_first_k_fragments(
+  node_t * const node,
+  lookahead_set_t * const fragments,
+  size_t const depth) const
+{
+  assert(depth >= 1);
+  
+  if (true == node->name().empty())
+  {
+    // I reach the rule end node, remember it as the end of
+    // this fragment.
+    assert(0 == node->next_nodes().size());
+    
+    if (0 == fragments->find_lookahead(node))
+    {
+      (void)fragments->insert_lookahead(first_k_cache().arena(), node);
+    }
+    return true;
+  }
+  
+  assert(false == node->is_rule_head());
+  assert(1 == node->next_nodes().size());
+  
+  if (true == node->is_terminal())
+  {
+    lookahead_set_t *child = fragments->find_lookahead(node);
+    
+    if (0 == child)
+    {
+      child = fragments->insert_lookahead(first_k_cache().arena(), node);
+    }
+    assert(child != 0);
+    
+    if (depth > 1)
+    {
+      return collect_first_k_fragments(node->next_nodes().front(), child, depth - 1);
+    }
+    return true;
+  }
+  else
+  {
+    assert(node->nonterminal_rule_node() != 0);
+    
+    lookahead_set_t const * const rule_fragments =
+      first_k_fragments(node->nonterminal_rule_node(), depth);
+    
+    if (0 == rule_fragments)
+    {
+      return false;
+    }
+    
+    return splice_first_k_fragments(node, rule_fragments, fragments, depth);
+  }
+}
+
+/// @brief Copy the fragments of the rule referred by
+/// @p node into @p fragments, and continue collecting after
+/// @p node wherever that rule ends.
+///
+/// @param node 
+/// @param rule_fragments 
+/// @param fragments 
+/// @param depth 
+///
+/// @return 
+///
+bool
+analyser_environment_t::splice_first_k_fragments(
+  node_t * const node,
+  lookahead_set_t const * const rule_fragments,
+  lookahead_set_t * const fragments,
+  size_t const depth) const
+{
+  BOOST_FOREACH(lookahead_set_t const &fragment, rule_fragments->m_next_level)
+  {
+    if (true == fragment.mp_node->name().empty())
+    {
+      if (false == collect_first_k_fragments(node->next_nodes().front(), fragments, depth))
+      {
+        return false;
+      }
+    }
+    else
+    {
+      lookahead_set_t *child = fragments->find_lookahead(fragment.mp_node);
+      
+      if (0 == child)
+      {
+        child = fragments->insert_lookahead(first_k_cache().arena(), fragment.mp_node);
+      }
+      assert(child != 0);
+      
+      if (fragment.m_next_level.size() != 0)
+      {
+        assert(depth > 1);
+        
+        if (false == splice_first_k_fragments(node, &fragment, child, depth - 1))
+        {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/// @brief Add the FIRST_k fragments of the rule referred by
+/// @p node into @p lookahead_set.
+///
+/// This gives the same lookahead terminals as tracing into
+/// the rule of @p node by compute_lookahead_set(). When a
+/// fragment reaches the end of that rule, I continue
+/// tracing from the node after @p node, just like returning
+/// from the rule end node through 'recur_parent_stack'.
+///
+void
+analyser_environment_t::append_first_k_fragments(
+  node_t * const node,
+  lookahead_set_t const * const fragments,
+  lookahead_set_t * const lookahead_set,
+  unsigned int * const prev_level_walk_count,
+  size_t const cur_level,
+  size_t const max_level,
+  std::list<recur_lookahead_t> &recur_parent_stack,
+  std::list<last_symbol_t> &last_symbol_stack,
+  unsigned int const curr_last_symbol_level) const
+{
+  assert(cur_level < max_level);
+  
+  BOOST_FOREACH(lookahead_set_t const &fragment, fragments->m_next_level)
+  {
+    if (true == fragment.mp_node->name().empty())
+    {
+      assert(1 == node->next_nodes().size());
+      
+      compute_lookahead_set(node->next_nodes().front(),
+                            lookahead_set,
+                            prev_level_walk_count,
+                            cur_level,
+                            max_level,
+                            recur_parent_stack,
+                            last_symbol_stack,
+                            curr_last_symbol_level);
+    }
+    else
+    {
+      lookahead_set_t * const new_lookahead_set =
+        insert_lookahead(lookahead_set, fragment.mp_node);
+      assert(new_lookahead_set != 0);
+      
+      if (fragment.m_next_level.size() != 0)
+      {
+        assert(cur_level < (max_level - 1));
+        
+        append_first_k_fragments(node,
+                                 &fragment,
+                                 new_lookahead_set,
+                                 prev_level_walk_count,
+                                 cur_level + 1,
+                                 max_level,
+                                 recur_parent_stack,
+                                 last_symbol_stack,
+                                 curr_last_symbol_level + 1);
+      }
+    }
+  }
+}
+
 void
 analyser_environment_t::compute_lookahead_terminal_for_node(
   node_t * const node,
@@ -826,7 +1186,7 @@ namespace
       
       if (false == (*iter)->is_terminal())
       {
-        if (0 == pivot_node->name().compare((*iter)->name()))
+        if (pivot_node->symbol_id() == (*iter)->symbol_id())
         {
           return true;
         }
@@ -952,8 +1312,8 @@ node_t::calculate_lookahead_waiting_pool_for_pure_BNF_rule(
     {
       todo_nodes_t &todo_nodes = todo_nodes_set.front();
       
-      if (0 == todo_nodes.mp_node_a->name().compare(
-            todo_nodes.mp_node_b->name()))
+      if (todo_nodes.mp_node_a->symbol_id() ==
+          todo_nodes.mp_node_b->symbol_id())
       {
         // Two nodes with same name.
         // I will find lookahead terminals for the children of these 2 nodes.
@@ -1068,145 +1428,302 @@ node_t::calculate_lookahead_waiting_pool_for_EBNF_rule(
 }
 
 void
-analyser_environment_t::compute_lookahead_set()
+analyser_environment_t::compute_lookahead_set_for_one_rule(
+  node_t * const rule_node)
 {
-  // traverse each grammar rule.
-  for (std::list<node_t *>::const_iterator iter = m_top_level_nodes.begin();
-       iter != m_top_level_nodes.end();
-       ++iter)
+  assert(true == rule_node->is_rule_head());
+  assert(rule_node->next_nodes().size() > 1);
+  
+  std::list<todo_nodes_t> todo_nodes_set;
+  
+  if (true == m_using_pure_BNF)
   {
-    // If there are more than 1 alternative node of this rule node,
-    // then I will look for lookahead terminals.
-    // Otherwise, I don't need to do this because there is only one way to
-    // derive.
-    //
-    if ((*iter)->next_nodes().size() > 1)
+    rule_node->calculate_lookahead_waiting_pool_for_pure_BNF_rule(todo_nodes_set);
+  }
+  else
+  {
+    rule_node->calculate_lookahead_waiting_pool_for_EBNF_rule(todo_nodes_set);
+  }
+  
+  while (todo_nodes_set.size() != 0)
+  {
+    // I will find lookahead terminals for these 2 nodes now.
+    todo_nodes_t &todo_nodes = todo_nodes_set.front();
+    
+    // In the EBNF form, because all nodes in the
+    // lookahead tree is changed to those in the main
+    // regex alternative, so that it is possible that
+    // the 2 comparison nodes are already ambiguity.
+    if (true == todo_nodes.mp_node_a->is_ambigious_to(todo_nodes.mp_node_b))
     {
-      std::list<todo_nodes_t> todo_nodes_set;
-      
-      if (true == m_using_pure_BNF)
-      {
-        (*iter)->calculate_lookahead_waiting_pool_for_pure_BNF_rule(todo_nodes_set);
-      }
-      else
-      {
-        (*iter)->calculate_lookahead_waiting_pool_for_EBNF_rule(todo_nodes_set);
-      }
+      assert(true == todo_nodes.mp_node_b->is_ambigious_to(todo_nodes.mp_node_a));
+    }
+    else
+    {
+      assert(false == todo_nodes.mp_node_b->is_ambigious_to(todo_nodes.mp_node_a));
       
-      mark_number_for_all_nodes();
+      LOOKAHEAD_COMPARE_RESULT result;
       
-      while (todo_nodes_set.size() != 0)
+      while ((result = compare_lookahead_set_for_node(
+                todo_nodes.mp_node_a,
+                todo_nodes.mp_node_b))
+             != LOOKAHEAD_OK)
       {
-        // I will find lookahead terminals for these 2 nodes now.
-        todo_nodes_t &todo_nodes = todo_nodes_set.front();
-        
-        // In the EBNF form, because all nodes in the
-        // lookahead tree is changed to those in the main
-        // regex alternative, so that it is possible that
-        // the 2 comparison nodes are already ambiguity.
-        if (true == todo_nodes.mp_node_a->is_ambigious_to(todo_nodes.mp_node_b))
+        if (LOOKAHEAD_AMBIGIOUS == result)
         {
-          assert(true == todo_nodes.mp_node_b->is_ambigious_to(todo_nodes.mp_node_a));
+          log(L"<INFO>: %s[%d] is ambigious to %s[%d]\n",
+              todo_nodes.mp_node_a->name().c_str(),
+              todo_nodes.mp_node_a->overall_idx(),
+              todo_nodes.mp_node_b->name().c_str(),
+              todo_nodes.mp_node_b->overall_idx());
+        
+          todo_nodes.mp_node_a->add_ambigious_set(todo_nodes.mp_node_b);
+          todo_nodes.mp_node_b->add_ambigious_set(todo_nodes.mp_node_a);
+        
+          assert(todo_nodes.mp_node_a->rule_node() == todo_nodes.mp_node_b->rule_node());
+        
+          todo_nodes.mp_node_a->rule_node()->contains_ambigious() = true;
+        
+          break;
         }
         else
         {
-          assert(false == todo_nodes.mp_node_b->is_ambigious_to(todo_nodes.mp_node_a));
+          assert(LOOKAHEAD_NEED_MORE_SEARCH == result);
+        
+          // 2 lookahead terminals set are not different,
+          // I have to find more in deeper depth.
+          if (todo_nodes.mp_node_a->lookahead_depth() == 
+              todo_nodes.mp_node_b->lookahead_depth())
+          {
+            unsigned int needed_depth =
+              todo_nodes.mp_node_a->lookahead_depth() + 1;
           
-          LOOKAHEAD_COMPARE_RESULT result;
+            compute_lookahead_terminal_for_node(
+              todo_nodes.mp_node_a,
+              needed_depth);
           
-          while ((result = compare_lookahead_set_for_node(
-                    todo_nodes.mp_node_a,
-                    todo_nodes.mp_node_b))
-                 != LOOKAHEAD_OK)
+            compute_lookahead_terminal_for_node(
+              todo_nodes.mp_node_b,
+              needed_depth);
+          }
+          else if (todo_nodes.mp_node_a->lookahead_depth() <
+                   todo_nodes.mp_node_b->lookahead_depth())
           {
-            if (LOOKAHEAD_AMBIGIOUS == result)
-            {
-              log(L"<INFO>: %s[%d] is ambigious to %s[%d]\n",
-                  todo_nodes.mp_node_a->name().c_str(),
-                  todo_nodes.mp_node_a->overall_idx(),
-                  todo_nodes.mp_node_b->name().c_str(),
-                  todo_nodes.mp_node_b->overall_idx());
-            
-              todo_nodes.mp_node_a->add_ambigious_set(todo_nodes.mp_node_b);
-              todo_nodes.mp_node_b->add_ambigious_set(todo_nodes.mp_node_a);
-            
-              assert(todo_nodes.mp_node_a->rule_node() == todo_nodes.mp_node_b->rule_node());
-            
-              todo_nodes.mp_node_a->rule_node()->contains_ambigious() = true;
-            
-              break;
-            }
-            else
-            {
-              assert(LOOKAHEAD_NEED_MORE_SEARCH == result);
-            
-              // 2 lookahead terminals set are not different,
-              // I have to find more in deeper depth.
-              if (todo_nodes.mp_node_a->lookahead_depth() == 
-                  todo_nodes.mp_node_b->lookahead_depth())
-              {
-                unsigned int needed_depth =
-                  todo_nodes.mp_node_a->lookahead_depth() + 1;
-              
-                compute_lookahead_terminal_for_node(
-                  todo_nodes.mp_node_a,
-                  needed_depth);
-              
-                compute_lookahead_terminal_for_node(
-                  todo_nodes.mp_node_b,
-                  needed_depth);
-              }
-              else if (todo_nodes.mp_node_a->lookahead_depth() <
-                       todo_nodes.mp_node_b->lookahead_depth())
-              {
-                unsigned int needed_depth =
-                  todo_nodes.mp_node_a->lookahead_depth() + 1;
-              
-                compute_lookahead_terminal_for_node(
-                  todo_nodes.mp_node_a,
-                  needed_depth);
-              }
-              else
-              {
-                unsigned int needed_depth =
-                  todo_nodes.mp_node_b->lookahead_depth() + 1;
-              
-                compute_lookahead_terminal_for_node(
-                  todo_nodes.mp_node_b,
-                  needed_depth);
-              }
-            }
+            unsigned int needed_depth =
+              todo_nodes.mp_node_a->lookahead_depth() + 1;
+          
+            compute_lookahead_terminal_for_node(
+              todo_nodes.mp_node_a,
+              needed_depth);
+          }
+          else
+          {
+            unsigned int needed_depth =
+              todo_nodes.mp_node_b->lookahead_depth() + 1;
+          
+            compute_lookahead_terminal_for_node(
+              todo_nodes.mp_node_b,
+              needed_depth);
           }
         }
-        
-        todo_nodes_set.pop_front();
       }
     }
+    
+    todo_nodes_set.pop_front();
+  }
+}
+
+/// @brief The body of each thread of the parallel
+/// lookahead computation.
+///
+/// Each thread takes the next rule not yet handled from
+/// @p rules until all of them are done. Every rule is only
+/// touched by the thread handling it: the lookahead trie
+/// and the ambiguity sets are stored in the nodes of that
+/// rule. The FIRST_k cache is per thread, and the log
+/// messages of each rule are kept in @p logs, so that they
+/// can be written in the rule order after all threads
+/// finish.
+///
+/// When a rule fails, no thread takes a new rule, and
+/// @p first_failed_rule becomes the smallest index of the
+/// failed rules. The entries and the hits of the FIRST_k
+/// cache of each thread are added to
+/// @p first_k_cache_count.
+///
+/// @param rules 
+/// @param logs 
+/// @param next_rule 
+/// @param first_failed_rule 
+/// @param first_k_cache_count 
+/// @param mutex 
+///
+void
+analyser_environment_t::compute_lookahead_set_worker(
+  std::vector<node_t *> const &rules,
+  std::vector<std::wstring> &logs,
+  size_t &next_rule,
+  size_t &first_failed_rule,
+  std::pair<size_t, unsigned int> &first_k_cache_count,
+  boost::mutex &mutex)
+{
+  first_k_cache_t first_k_cache;
+  
+  m_thread_first_k_cache.reset(&first_k_cache);
+  
+  for (;;)
+  {
+    size_t idx;
+    
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      
+      if ((next_rule == rules.size()) || (first_failed_rule != rules.size()))
+      {
+        break;
+      }
+      
+      idx = next_rule;
+      ++next_rule;
+    }
+    
+    m_thread_log_buffer.reset(&(logs[idx]));
+    
+    try
+    {
+      compute_lookahead_set_for_one_rule(rules[idx]);
+    }
+    catch (ga_exception_t const &)
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      
+      first_failed_rule = std::min(first_failed_rule, idx);
+    }
+  }
+  
+  {
+    boost::mutex::scoped_lock lock(mutex);
+    
+    first_k_cache_count.first += first_k_cache.size();
+    first_k_cache_count.second += first_k_cache.hit_count();
+  }
+  
+  m_thread_log_buffer.reset(0);
+  m_thread_first_k_cache.reset(0);
+}
+
+void
+analyser_environment_t::compute_lookahead_set()
+{
+  // If there are more than 1 alternative node of a rule node,
+  // then I will look for lookahead terminals.
+  // Otherwise, I don't need to do this because there is only one way to
+  // derive.
+  //
+  std::vector<node_t *> rules;
+  
+  BOOST_FOREACH(node_t * const rule_node, m_top_level_nodes)
+  {
+    if (rule_node->next_nodes().size() > 1)
+    {
+      rules.push_back(rule_node);
+    }
+  }
+  
+  if (0 == rules.size())
+  {
+    return;
+  }
+  
+  // The search itself doesn't change the grammar, so that
+  // numbering all nodes once here is enough.
+  mark_number_for_all_nodes();
+  
+  if (m_job_count <= 1)
+  {
+    BOOST_FOREACH(node_t * const rule_node, rules)
+    {
+      compute_lookahead_set_for_one_rule(rule_node);
+    }
+    
+    log(L"<INFO>: FIRST_k cache: %u entries, %u hits\n",
+        static_cast<unsigned int>(m_first_k_cache.size()),
+        m_first_k_cache.hit_count());
+  }
+  else
+  {
+    std::vector<std::wstring> logs(rules.size());
+    size_t next_rule = 0;
+    size_t first_failed_rule = rules.size();
+    std::pair<size_t, unsigned int> first_k_cache_count(0, 0);
+    boost::mutex mutex;
+    boost::thread_group threads;
+    
+    for (unsigned int i = 0; i < m_job_count; ++i)
+    {
+      threads.create_thread(
+        boost::bind(&analyser_environment_t::compute_lookahead_set_worker,
+                    this,
+                    boost::cref(rules),
+                    boost::ref(logs),
+                    boost::ref(next_rule),
+                    boost::ref(first_failed_rule),
+                    boost::ref(first_k_cache_count),
+                    boost::ref(mutex)));
+    }
+    
+    threads.join_all();
+    
+    // Write the log messages in the same order as the
+    // serial search would, which stops at the first failed
+    // rule. The rules before it are all done, because the
+    // threads take the rules in order.
+    for (size_t i = 0; (i < rules.size()) && (i <= first_failed_rule); ++i)
+    {
+      if (logs[i].size() != 0)
+      {
+        log(L"%s", logs[i].c_str());
+      }
+    }
+    
+    if (first_failed_rule != rules.size())
+    {
+      throw ga_exception_t();
+    }
+    
+    log(L"<INFO>: FIRST_k cache: %u entries, %u hits\n",
+        static_cast<unsigned int>(first_k_cache_count.first),
+        first_k_cache_count.second);
   }
 }
 
 LOOKAHEAD_COMPARE_RESULT
 analyser_environment_t::compare_lookahead_set(
-  std::list<lookahead_set_t> const &lookahead_a,
-  std::list<lookahead_set_t> const &lookahead_b) const
+  lookahead_level_t const &lookahead_a,
+  lookahead_level_t const &lookahead_b) const
 {
   assert(lookahead_a.size() != 0);
   assert(lookahead_b.size() != 0);
   
-  for (std::list<lookahead_set_t>::const_iterator iter_a =
+  for (lookahead_level_t::const_iterator iter_a =
          lookahead_a.begin();
        iter_a != lookahead_a.end();
        ++iter_a)
   {
-    for (std::list<lookahead_set_t>::const_iterator iter_b =
-           lookahead_b.begin();
-         iter_b != lookahead_b.end();
-         ++iter_b)
+    // There is at most one node with the same symbol in
+    // 'lookahead_b', because 'insert_lookahead' never
+    // inserts a symbol twice into one level.
+    lookahead_set_t const * const lookahead_set_b =
+      lookahead_b.find((*iter_a).mp_node->symbol_id());
+    
+    if (lookahead_set_b != 0)
     {
+      lookahead_level_t::const_iterator const iter_b(lookahead_set_b);
+      
       assert((*iter_a).mp_orig_node->rule_node() ==
              (*iter_b).mp_orig_node->rule_node());
       
-      if (0 == (*iter_a).mp_node->name().compare((*iter_b).mp_node->name()))
+      if ((*iter_a).mp_node->symbol_id() == (*iter_b).mp_node->symbol_id())
       {
         // equal name
         if (0 == (*iter_a).mp_node->name().size())
@@ -1315,7 +1832,7 @@ analyser_environment_t::is_duplicated_alternatives(
     
     while (walk_count > 0)
     {
-      if (begin_node->name().compare(end_node->name()) != 0)
+      if (begin_node->symbol_id() != end_node->symbol_id())
       {
         break;
       }
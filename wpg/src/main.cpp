@@ -20,6 +20,7 @@
 #include "ae.hpp"
 #include "node.hpp"
 #include "ga_exception.hpp"
+#include "time_report.hpp"
 
 #define USAGE_MESSAGE                               \
   "grammar_analyser.exe [options] grammar_file\n\
@@ -28,7 +29,49 @@
    --help:\n\
       dump this message.\n\
    -o <output file name>:\n\
-      specify a file where output messages will go."
+      specify a file where output messages will go.\n\
+   -j <number of threads>:\n\
+      compute the lookahead sets of different rules in\n\
+      parallel. The default is 1.\n\
+   --backend=<recursive_descent|table>:\n\
+      recursive_descent (the default) generates a parse_XXX\n\
+      function of nested switches for each rule. table\n\
+      generates prediction tables and a generic LL(k)\n\
+      driver with an explicit stack; it needs a pure BNF\n\
+      grammar. An EBNF grammar always gets the recursive\n\
+      descent parser, whose nesting depth is bounded by the\n\
+      C++ stack.\n\
+   --push-parser:\n\
+      generate feed() and finish() in the frontend to parse\n\
+      the starting rule from the input in chunks. It needs\n\
+      --backend=table and token patterns.\n\
+   --incremental:\n\
+      record the span of each parse tree node, and generate\n\
+      incremental_parse() in the frontend to parse again\n\
+      only the rules around an edit of the input, reusing\n\
+      the rest of the old tree. It needs a pure BNF grammar,\n\
+      token patterns, and \"use_node_arena = yes;\".\n\
+   --stats:\n\
+      make the generated parser count the calls of each\n\
+      rule, the peeks at each lookahead depth, and the cases\n\
+      taken by each decision, and generate\n\
+      frontend::dump_stats() to write them.\n\
+   --benchmark:\n\
+      generate benchmark.cpp, which parses random token\n\
+      streams of the grammar, and reports ns/token,\n\
+      allocations/token, and the peak heap size.\n\
+   --profile <file name>:\n\
+      read the output of frontend::dump_stats() of a parser\n\
+      generated with --stats, and put the hot cases of each\n\
+      decision first. The parser chooses the same\n\
+      alternatives. It logs how many cases match a\n\
+      decision, and warns about the others.\n\
+   --time-report:\n\
+      log the wall time, CPU time, peak working set growth,\n\
+      and the number of nodes and alternatives of each phase.\n\
+   --time-report-json <file name>:\n\
+      like --time-report, and write the report to the\n\
+      specified file in JSON, too."
 
 bool
 analyser_environment_t::parse_command_line(int argc, char **argv)
@@ -53,6 +96,81 @@ analyser_environment_t::parse_command_line(int argc, char **argv)
       m_cmp_ans = true;
     }
 #endif
+    else if (0 == wcscmp(L"-j", parm_ptr.get()))
+    {
+      if ((i + 1) >= argc)
+      {
+        fprintf(stderr, "-j needs the number of threads.\n");
+        return false;
+      }
+      
+      int const job_count = atoi(argv[++i]);
+      
+      if (job_count < 1)
+      {
+        fprintf(stderr, "invalid number of threads: %s\n", argv[i]);
+        return false;
+      }
+      
+      m_job_count = static_cast<unsigned int>(job_count);
+    }
+    else if (0 == wcscmp(L"--backend=recursive_descent", parm_ptr.get()))
+    {
+      m_backend = BACKEND_RECURSIVE_DESCENT;
+    }
+    else if (0 == wcscmp(L"--backend=table", parm_ptr.get()))
+    {
+      m_backend = BACKEND_TABLE;
+    }
+    else if (0 == wcscmp(L"--push-parser", parm_ptr.get()))
+    {
+      m_push_parser = true;
+    }
+    else if (0 == wcscmp(L"--incremental", parm_ptr.get()))
+    {
+      m_incremental = true;
+    }
+    else if (0 == wcscmp(L"--stats", parm_ptr.get()))
+    {
+      m_stats = true;
+    }
+    else if (0 == wcscmp(L"--benchmark", parm_ptr.get()))
+    {
+      m_benchmark = true;
+    }
+    else if (0 == wcscmp(L"--profile", parm_ptr.get()))
+    {
+      if ((i + 1) >= argc)
+      {
+        fprintf(stderr, "--profile needs a file name.\n");
+        return false;
+      }
+      
+      if (false == read_profile(argv[++i]))
+      {
+        fprintf(stderr, "Can not read profile: %s\n", argv[i]);
+        return false;
+      }
+    }
+    else if (0 == wcscmp(L"--time-report", parm_ptr.get()))
+    {
+      m_time_report = true;
+    }
+    else if (0 == wcscmp(L"--time-report-json", parm_ptr.get()))
+    {
+      if ((i + 1) >= argc)
+      {
+        fprintf(stderr, "--time-report-json needs a file name.\n");
+        return false;
+      }
+      
+      wchar_t * const tmp = fmtstr_mbstowcs(argv[++i], 0);
+      assert(tmp != 0);
+      parm_ptr.reset(tmp, fmtstr_delete);
+      
+      m_time_report = true;
+      m_time_report_json_filename = parm_ptr.get();
+    }
     else if (0 == wcscmp(L"-o", parm_ptr.get()))
     {
       wchar_t * const tmp = fmtstr_mbstowcs(argv[++i], 0);
@@ -109,6 +227,115 @@ analyser_environment_t::parse_command_line(int argc, char **argv)
   return true;
 }
 
+/// Read the decision cases of the output of dump_stats(),
+/// the lines after 'decision cases:' like
+///
+///   stmt: ident assign: 12
+///
+/// into 'm_profile_cases'. The other lines are skipped, so
+/// that the whole output can be given, but I warn about a
+/// case line without a name or a count.
+bool
+analyser_environment_t::read_profile(
+  char const * const filename)
+{
+  std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
+  
+  if (false == file.is_open())
+  {
+    return false;
+  }
+  
+  std::string line;
+  unsigned int line_number = 0;
+  bool in_cases = false;
+  
+  while (std::getline(file, line))
+  {
+    ++line_number;
+    
+    if ((line.size() != 0) && ('\r' == line[line.size() - 1]))
+    {
+      line.erase(line.size() - 1);
+    }
+    
+    if (0 == line.compare(0, 2, "  "))
+    {
+      if (false == in_cases)
+      {
+        continue;
+      }
+      
+      std::string::size_type const colon = line.rfind(": ");
+      char *count_end = 0;
+      unsigned long count = 0;
+      
+      if ((colon != std::string::npos) && (colon > 2) && (0 != isdigit(line[colon + 2])))
+      {
+        count = strtoul(line.c_str() + colon + 2, &count_end, 10);
+      }
+      
+      // The names are ASCII.
+      if ((0 == count_end) || (*count_end != '\0'))
+      {
+        std::wstring const text(line.begin(), line.end());
+        
+        log(L"<WARN>: profile line %u is not a decision case, skipped: %s\n",
+            line_number, text.c_str());
+        continue;
+      }
+      
+      std::wstring const description(line.begin() + 2, line.begin() + colon);
+      
+      m_profile_cases[description] += count;
+    }
+    else
+    {
+      in_cases = (0 == line.compare("decision cases:"));
+    }
+  }
+  
+  if (true == m_profile_cases.empty())
+  {
+    log(L"<WARN>: the profile has no decision cases.\n");
+  }
+  
+  m_profile = true;
+  
+  return true;
+}
+
+/// Log how many decision cases of the profile were looked
+/// up by a decision of the generated parser, and warn
+/// about the others, ex: the profile of another grammar,
+/// or of a rule renamed since.
+void
+analyser_environment_t::log_profile_matches() const
+{
+  assert(true == m_profile);
+  
+  unsigned int matched_count = 0;
+  
+  for (std::map<std::wstring, unsigned long>::const_iterator iter = m_profile_cases.begin();
+       iter != m_profile_cases.end();
+       ++iter)
+  {
+    if (m_matched_profile_cases.find(iter->first) != m_matched_profile_cases.end())
+    {
+      ++matched_count;
+    }
+    else
+    {
+      log(L"<WARN>: the profile case '%s' matches no decision.\n",
+          iter->first.c_str());
+    }
+  }
+  
+  log(L"<INFO>: %u of %u profile cases match a decision.\n",
+      matched_count,
+      static_cast<unsigned int>(m_profile_cases.size()));
+}
+
 bool
 check_not_optional(analyser_environment_t const * const /* ae */,
                    node_t * const node,
@@ -195,6 +422,8 @@ main(int argc, char **argv)
       return 1;
     }
     
+    time_report_t time_report(ae.get(), ae->time_report());
+    
     std::list<keyword_t> keywords;
     keywords.push_back(keyword_t(L"_apostrophe", KEYWORD_POS_BACK));
     
@@ -203,6 +432,7 @@ main(int argc, char **argv)
       // ====================================================
       //                    read grammar
       // ====================================================
+      time_report.start_phase(L"read_grammar");
       ae->read_grammar(keywords);
       
       //ae->dump_tree(L"1_orig_tree.dot");
@@ -211,6 +441,8 @@ main(int argc, char **argv)
       // ====================================================
       //                  link non-terminal
       // ====================================================
+      time_report.start_phase(L"link_nonterminal");
+      
       if (false == ae->traverse_all_nodes(link_nonterminal, 0, 0))
       {
         return 1;
@@ -227,6 +459,50 @@ main(int argc, char **argv)
         ae->log(L"<ERROR>: grammar checking failed.\n");
         return 1;
       }
+      
+      // The tables only describe the alternatives of pure
+      // BNF rules, the repetitions of EBNF rules are
+      // parsed by loops in parse_XXX. So that there is no
+      // explicit stack parser for an EBNF grammar, its
+      // nested rules recurse on the C++ stack.
+      if ((analyser_environment_t::BACKEND_TABLE == ae->backend()) &&
+          (false == ae->using_pure_BNF()))
+      {
+        ae->log(L"<ERROR>: --backend=table needs a pure BNF grammar.\n");
+        ae->log(L"<ERROR>: An EBNF grammar only has the recursive descent parser, whose nesting depth is bounded by the C++ stack.\n");
+        return 1;
+      }
+      
+      // ====================================================
+      //                    build scanner
+      // ====================================================
+      time_report.start_phase(L"build_scanner");
+      ae->build_scanner();
+      
+      // The push parser suspends the table driver when the
+      // generated scanner can not fill the lookahead window
+      // from the input so far; the recursive descent parser
+      // can not be suspended.
+      if ((true == ae->push_parser()) &&
+          ((ae->backend() != analyser_environment_t::BACKEND_TABLE) ||
+           (0 == ae->scanner_dfa())))
+      {
+        ae->log(L"<ERROR>: --push-parser needs --backend=table and token patterns.\n");
+        return 1;
+      }
+      
+      // The parser finds the subtrees to reuse by the rule
+      // it is about to parse, which is a node of a BNF
+      // alternative, and the nodes replaced by an edit are
+      // recycled into the node arena.
+      if ((true == ae->incremental()) &&
+          ((false == ae->using_pure_BNF()) ||
+           (0 == ae->scanner_dfa()) ||
+           (false == ae->use_node_arena())))
+      {
+        ae->log(L"<ERROR>: --incremental needs a pure BNF grammar, token patterns, and \"use_node_arena = yes;\".\n");
+        return 1;
+      }
     }
     catch (ga_exception_t const &)
     {
@@ -234,6 +510,8 @@ main(int argc, char **argv)
       return 1;
     }
     
+    time_report.start_phase(L"expand_regex_info");
+    
     assert(true == ae->traverse_all_nodes(check_if_regex_info_is_empty, 0, 0));
     assert(true == ae->traverse_all_nodes(check_if_regex_info_is_correct_for_traverse_all_nodes, 0, 0));
     
@@ -307,6 +585,7 @@ main(int argc, char **argv)
     // ====================================================
     //               remove useless rules
     // ====================================================
+    time_report.start_phase(L"remove_useless_rule");
     ae->log(L"<INFO>: Removing useless rules.\n");
     ae->remove_useless_rule();
     if (0 == ae->top_level_nodes().size())
@@ -319,6 +598,8 @@ main(int argc, char **argv)
     // ====================================================
     //                detect left recursion
     // ====================================================
+    time_report.start_phase(L"detect_left_recursion");
+    
     std::list<std::list<node_t *> > left_recursion_set;
     
     bool const has_left_recursion = ae->detect_left_recursion(left_recursion_set);
@@ -332,6 +613,7 @@ main(int argc, char **argv)
         // ====================================================
         //            detect nullable non-terminals
         // ====================================================
+        time_report.start_phase(L"detect_nullable");
         ae->log(L"<INFO>: Detect nullable nonterminals.\n");
         ae->detect_nullable_nonterminal();
         //ae->dump_tree(L"3_detect_nullable.dot");
@@ -341,6 +623,7 @@ main(int argc, char **argv)
         // ====================================================
         //           remove epsilon production
         // ====================================================
+        time_report.start_phase(L"remove_epsilon");
         ae->remove_epsilon_production();
         if (false == ae->check_grammar())
         {
@@ -358,6 +641,7 @@ main(int argc, char **argv)
         // ====================================================
         //              remove direct cyclic
         // ====================================================
+        time_report.start_phase(L"remove_direct_cyclic");
         ae->log(L"<INFO>: Removing direct cyclic.\n");
         ae->remove_direct_cyclic();
     
@@ -377,6 +661,7 @@ main(int argc, char **argv)
         // ====================================================
         //              detect cyclic non-terminals
         // ====================================================
+        time_report.start_phase(L"detect_cyclic");
         ae->log(L"<INFO>: Detect cyclic nonterminals.\n");
         ae->detect_cyclic_nonterminal();
         //ae->dump_tree(L"6_detect_cyclic.dot");
@@ -386,6 +671,7 @@ main(int argc, char **argv)
         // ====================================================
         //               remove cyclic
         // ====================================================
+        time_report.start_phase(L"remove_cyclic");
         ae->log(L"<INFO>: Removing cyclic.\n");
         ae->remove_cyclic();
     
@@ -408,6 +694,7 @@ main(int argc, char **argv)
         // ====================================================
         //               find left corners
         // ====================================================
+        time_report.start_phase(L"find_left_corners");
         ae->find_left_corners();
         ae->order_nonterminal_decrease_number_of_distinct_left_corner();
       
@@ -416,6 +703,7 @@ main(int argc, char **argv)
         // ====================================================
         //               remove left recursion
         // ====================================================
+        time_report.start_phase(L"remove_left_recursion");
         ae->log(L"<INFO>: Removing left recursion.\n");
         ae->remove_left_recur();
       
@@ -427,6 +715,7 @@ main(int argc, char **argv)
         // ====================================================
         //               remove useless rule
         // ====================================================
+        time_report.start_phase(L"remove_useless_rule_after_paull");
         ae->log(L"<INFO>: Removing useless rule.\n");
         ae->remove_useless_rule();
         
@@ -465,22 +754,29 @@ main(int argc, char **argv)
       }
     }
     
+    time_report.start_phase(L"dump_final_grammar");
+    
     std::wstring final_grammar_filename(L"final_grammar.gra");
     
     ae->dump_grammar(final_grammar_filename.c_str());
         
+    time_report.start_phase(L"determine_node_position");
     ae->log(L"<INFO>: Determine the position of each node.\n");
     ae->determine_node_position();
     
+    time_report.start_phase(L"find_eof");
     ae->log(L"<INFO>: Finding EOF situation.\n");
     ae->find_eof();
     
     // ====================================================
     //               compute lookahead set
     // ====================================================
+    time_report.start_phase(L"compute_lookahead_set");
     ae->log(L"<INFO>: Compute lookahead terminals for each node.\n");
     ae->compute_lookahead_set();
     
+    time_report.start_phase(L"dump_final_grammar_lookahead");
+    
     std::wstring final_grammar_lookahead_filename(L"final_grammar_lookahead.gra");
     
     ae->dump_grammar(final_grammar_lookahead_filename.c_str());
@@ -492,6 +788,8 @@ main(int argc, char **argv)
     //               compare answer
     // ====================================================
 #if defined(_DEBUG)
+    time_report.start_phase(L"compare_answer");
+    
     if (true == ae->cmp_ans())
     {
       if (true == ae->read_answer_file())
@@ -518,6 +816,8 @@ main(int argc, char **argv)
     //        calculate appear times for each node in
     //                   each alternative
     // ====================================================
+    time_report.start_phase(L"count_appear_times");
+    
     {
       BOOST_FOREACH(node_t const * const node, ae->top_level_nodes())
       {
@@ -546,6 +846,7 @@ main(int argc, char **argv)
     //               dump generated codes
     // ====================================================
     {
+      time_report.start_phase(L"dump_parser_basic_types_hpp");
       ae->log(L"<INFO>: Dump parser_basic_types.hpp\n");
       
       std::wstring filename(L"parser_basic_types.hpp");
@@ -558,6 +859,7 @@ main(int argc, char **argv)
     }
     
     {
+      time_report.start_phase(L"dump_parser_nodes_hpp");
       ae->log(L"<INFO>: Dump parser_nodes.hpp\n");
       
       std::wstring filename(L"parser_nodes.hpp");
@@ -570,11 +872,28 @@ main(int argc, char **argv)
     }
     
     {
+      time_report.start_phase(L"dump_parser_cpp");
       ae->log(L"<INFO>: Dump parser.cpp\n");
       ae->dump_gen_parser_cpp();
     }
     
+    if (analyser_environment_t::BACKEND_TABLE == ae->backend())
     {
+      time_report.start_phase(L"dump_parser_tables_cpp");
+      ae->log(L"<INFO>: Dump parser_tables.cpp\n");
+      
+      std::wstring filename(L"parser_tables.cpp");
+      
+      std::auto_ptr<std::wfstream> const file(
+        new std::wfstream(filename.c_str(),
+                          std::ios_base::out | std::ios_base::binary));
+      
+      ae->dump_gen_parser_tables_cpp(*file);
+      file->close();
+    }
+    
+    {
+      time_report.start_phase(L"dump_frontend_hpp");
       ae->log(L"<INFO>: Dump frontend.hpp\n");
       
       std::wstring filename(L"frontend.hpp");
@@ -588,6 +907,7 @@ main(int argc, char **argv)
     }
     
     {
+      time_report.start_phase(L"dump_frontend_cpp");
       ae->log(L"<INFO>: Dump frontend.cpp\n");
       
       std::wstring filename(L"frontend.cpp");
@@ -601,6 +921,7 @@ main(int argc, char **argv)
     }
     
     {
+      time_report.start_phase(L"dump_token_hpp");
       ae->log(L"<INFO>: Dump token.hpp\n");
       
       std::wstring filename(L"token.hpp");
@@ -614,6 +935,21 @@ main(int argc, char **argv)
     }
     
     {
+      time_report.start_phase(L"dump_mapped_file_hpp");
+      ae->log(L"<INFO>: Dump mapped_file.hpp\n");
+      
+      std::wstring filename(L"mapped_file.hpp");
+      
+      std::auto_ptr<std::wfstream> const file(
+        new std::wfstream(filename.c_str(),
+                          std::ios_base::out | std::ios_base::binary));
+      
+      ae->dump_gen_mapped_file_hpp(*file);
+      file->close();
+    }
+    
+    {
+      time_report.start_phase(L"dump_main_cpp");
       ae->log(L"<INFO>: Dump main.cpp\n");
       
       std::wstring filename(L"main.cpp");
@@ -626,6 +962,39 @@ main(int argc, char **argv)
       file->close();
     }
     
+    if (true == ae->benchmark())
+    {
+      time_report.start_phase(L"dump_benchmark_cpp");
+      ae->log(L"<INFO>: Dump benchmark.cpp\n");
+      
+      std::wstring filename(L"benchmark.cpp");
+      
+      std::auto_ptr<std::wfstream> const file(
+        new std::wfstream(filename.c_str(),
+                          std::ios_base::out | std::ios_base::binary));
+      
+      ae->dump_gen_benchmark_cpp(*file);
+      file->close();
+    }
+    
+    time_report.stop();
+    
+    if (true == ae->profile())
+    {
+      ae->log_profile_matches();
+    }
+    
+    ae->log_node_pool_statistics();
+    
+    time_report.log();
+    
+    if ((false == ae->time_report_json_filename().empty()) &&
+        (false == time_report.dump_json(ae->time_report_json_filename())))
+    {
+      ae->log(L"<ERROR>: Can not write the time report to %s.\n",
+              ae->time_report_json_filename().c_str());
+    }
+    
 #if defined(_DEBUG)
   }
   if (false == dump_unfreed())
@@ -25,6 +25,115 @@
 
 #include "wcl_memory_debugger\memory_debugger.h"
 
+namespace
+{
+  /// Round up to a multiple of the strictest fundamental
+  /// alignment, so that every slot is suitably aligned
+  /// for a node_t.
+  size_t
+  align_slot_size(size_t const size)
+  {
+    size_t const alignment = 2 * sizeof(double);
+    
+    return ((size + alignment - 1) / alignment) * alignment;
+  }
+}
+
+node_pool_t::node_pool_t()
+  : m_slot_size(align_slot_size(sizeof(slot_header_t)) +
+                align_slot_size(sizeof(node_t))),
+    m_used_in_last_slab(SLOTS_PER_SLAB),
+    mp_free_list(0),
+    m_allocation_count(0),
+    m_free_count(0),
+    m_peak_live_count(0)
+{
+}
+
+node_pool_t::~node_pool_t()
+{
+  BOOST_FOREACH(char * const slab, m_slabs)
+  {
+    boost::checked_array_delete(slab);
+  }
+}
+
+void *
+node_pool_t::allocate(size_t const size)
+{
+  assert(align_slot_size(sizeof(slot_header_t)) + align_slot_size(size) <= m_slot_size);
+  (void)size;
+  
+  slot_header_t *header;
+  
+  if (mp_free_list != 0)
+  {
+    header = mp_free_list;
+    mp_free_list = header->mp_next_free;
+  }
+  else
+  {
+    if (SLOTS_PER_SLAB == m_used_in_last_slab)
+    {
+      char * const slab = new char[SLOTS_PER_SLAB * m_slot_size];
+      assert(slab != 0);
+      
+      m_slabs.push_back(slab);
+      m_used_in_last_slab = 0;
+    }
+    
+    header = reinterpret_cast<slot_header_t *>(
+      m_slabs.back() + (m_used_in_last_slab * m_slot_size));
+    
+    ++m_used_in_last_slab;
+  }
+  
+  header->mp_pool = this;
+  header->mp_next_free = 0;
+  
+  ++m_allocation_count;
+  m_peak_live_count = std::max(m_peak_live_count, live_count());
+  
+  return reinterpret_cast<char *>(header) + align_slot_size(sizeof(slot_header_t));
+}
+
+void
+node_pool_t::deallocate(void * const ptr)
+{
+  slot_header_t * const header = reinterpret_cast<slot_header_t *>(
+    static_cast<char *>(ptr) - align_slot_size(sizeof(slot_header_t)));
+  node_pool_t * const pool = header->mp_pool;
+  
+  assert(pool != 0);
+  assert(pool->live_count() > 0);
+  
+  header->mp_next_free = pool->mp_free_list;
+  pool->mp_free_list = header;
+  
+  ++pool->m_free_count;
+}
+
+void *
+node_t::operator new(size_t const size, node_pool_t &pool)
+{
+  return pool.allocate(size);
+}
+
+void
+node_t::operator delete(void * const ptr, node_pool_t & /* pool */)
+{
+  node_pool_t::deallocate(ptr);
+}
+
+void
+node_t::operator delete(void * const ptr)
+{
+  if (ptr != 0)
+  {
+    node_pool_t::deallocate(ptr);
+  }
+}
+
 void
 node_t::init()
 {
@@ -57,15 +166,15 @@ node_t::node_t(analyser_environment_t * const ae,
                node_t * const rule_node,
                std::wstring const &str)
   : mp_ae(ae),
-    m_is_rule_head(false),
-    m_name(str),
-    mp_last_edge_last_node(0),
     mp_rule_end_node(0),
     mp_nonterminal_rule_node(0),
+    m_symbol_id(ae->intern_symbol(str)),
+    m_is_rule_head(false),
     m_optional(false),
-    m_lookahead_set(0, 0, 0),
+    m_is_in_regex_OR_group(false),
     m_overall_idx(0),
-    m_is_in_regex_OR_group(false)
+    m_name(str),
+    m_lookahead_set(0, 0, 0)
 {
   init();
   
@@ -94,14 +203,15 @@ node_t::node_t(analyser_environment_t * const ae,
 ///
 node_t::node_t(node_t const * const node)
   : mp_ae(node->ae()),
+    mp_nonterminal_rule_node(node->nonterminal_rule_node()),
+    m_symbol_id(node->symbol_id()),
     m_is_rule_head(node->is_rule_head()),
     m_is_terminal(node->is_terminal()),
-    m_name(node->name()),
-    mp_nonterminal_rule_node(node->nonterminal_rule_node()),
     m_optional(node->is_optional()),
-    m_lookahead_set(0, 0, 0),
+    m_is_in_regex_OR_group(node->is_in_regex_OR_group()),
     m_overall_idx(node->overall_idx()),
-    m_is_in_regex_OR_group(node->is_in_regex_OR_group())
+    m_name(node->name()),
+    m_lookahead_set(0, 0, 0)
 {
   init();
 }
@@ -180,7 +290,7 @@ node_t::is_refer_to_me_node(node_t const * const node) const
   assert(true == m_is_rule_head);
   
   BOOST_FOREACH(node_t * const refer_to_me_node,
-                m_refer_to_me_nodes)
+                cold_part().m_refer_to_me_nodes)
   {
     if (refer_to_me_node == node)
     {
@@ -302,19 +412,21 @@ node_t::set_create_dot_node_line(bool const status)
 void
 node_t::add_same_rule_node(node_t * const node)
 {
-  m_same_rule_nodes.push_back(node);
+  mutable_cold_part().m_same_rule_nodes.push_back(node);
 }
 
 void
 node_t::remove_refer_to_me_node(node_t * const node)
 {
-  for (std::list<node_t *>::iterator iter = m_refer_to_me_nodes.begin();
-       iter != m_refer_to_me_nodes.end();
+  std::list<node_t *> &refer_to_me_nodes = mutable_cold_part().m_refer_to_me_nodes;
+  
+  for (std::list<node_t *>::iterator iter = refer_to_me_nodes.begin();
+       iter != refer_to_me_nodes.end();
        ++iter)
   {
     if ((*iter) == node)
     {
-      m_refer_to_me_nodes.erase(iter);
+      refer_to_me_nodes.erase(iter);
       return;
     }
   }
@@ -326,19 +438,21 @@ node_t::add_refer_to_me_node(node_t * const node)
 {
   assert(this != node);
   
-  m_refer_to_me_nodes.push_back(node);
+  std::list<node_t *> &refer_to_me_nodes = mutable_cold_part().m_refer_to_me_nodes;
+  
+  refer_to_me_nodes.push_back(node);
   
 #if defined(_DEBUG)
   // Check to see there are no two equal nodes could be
   // stored in the 'refer_to_me_nodes' set.
-  for (std::list<node_t *>::const_iterator iter = m_refer_to_me_nodes.begin();
-       iter != m_refer_to_me_nodes.end();
+  for (std::list<node_t *>::const_iterator iter = refer_to_me_nodes.begin();
+       iter != refer_to_me_nodes.end();
        ++iter)
   {
     std::list<node_t *>::const_iterator tmp = iter;
     ++tmp;
     for (std::list<node_t *>::const_iterator iter2 = tmp;
-         iter2 != m_refer_to_me_nodes.end();
+         iter2 != refer_to_me_nodes.end();
          ++iter2)
     {
       assert((*iter) != (*iter2));
@@ -350,18 +464,22 @@ node_t::add_refer_to_me_node(node_t * const node)
 void
 node_t::assign_cyclic_set(std::list<node_t *> const &set)
 {
+  std::list<node_t *> &cyclic_set = mutable_cold_part().m_cyclic_set;
+  
   BOOST_FOREACH(node_t * const node, set)
   {
-    m_cyclic_set.push_back(node);
+    cyclic_set.push_back(node);
   }
 }
 
 void
 node_t::assign_left_recursion_set(std::list<node_t *> const &set)
 {
+  std::list<node_t *> &left_recursion_set = mutable_cold_part().m_left_recursion_set;
+  
   BOOST_FOREACH(node_t * const node, set)
   {
-    m_left_recursion_set.push_back(node);
+    left_recursion_set.push_back(node);
   }
 }
 
@@ -396,8 +514,10 @@ node_t::add_ambigious_set(
 {
   assert(node != this);
   
-  for (std::list<node_t *>::const_iterator iter = m_ambigious_set.begin();
-       iter != m_ambigious_set.end();
+  std::list<node_t *> &ambigious_set = mutable_cold_part().m_ambigious_set;
+  
+  for (std::list<node_t *>::const_iterator iter = ambigious_set.begin();
+       iter != ambigious_set.end();
        ++iter)
   {
     if ((*iter) == node)
@@ -406,15 +526,18 @@ node_t::add_ambigious_set(
     }
   }
   
-  m_ambigious_set.push_back(node);
+  ambigious_set.push_back(node);
 }
 
 bool
 node_t::is_ambigious_to(node_t * const node) const
 {
   assert(node != this);
-  for (std::list<node_t *>::const_iterator iter = m_ambigious_set.begin();
-       iter != m_ambigious_set.end();
+  
+  std::list<node_t *> const &ambigious_set = cold_part().m_ambigious_set;
+  
+  for (std::list<node_t *>::const_iterator iter = ambigious_set.begin();
+       iter != ambigious_set.end();
        ++iter)
   {
     if ((*iter) == node)
@@ -431,6 +554,43 @@ node_t::append_name(wchar_t const * const str)
   assert(str != 0);
   
   m_name += str;
+  m_symbol_id = mp_ae->intern_symbol(m_name);
+}
+
+void
+node_t::set_name(std::wstring const &str)
+{
+  m_name = str;
+  m_symbol_id = mp_ae->intern_symbol(m_name);
+}
+
+node_t::cold_part_t const node_t::s_empty_cold_part = node_t::cold_part_t();
+
+node_t::cold_part_t &
+node_t::mutable_cold_part()
+{
+  if (0 == mp_cold_part.get())
+  {
+    mp_cold_part.reset(new cold_part_t);
+  }
+  
+  return *mp_cold_part;
+}
+
+/// The arena holding the lookahead trie nodes of this
+/// rule. It is created on the first use, and released
+/// together with the rule head.
+lookahead_arena_t &
+node_t::lookahead_arena()
+{
+  assert(this == mp_rule_node);
+  
+  if (0 == mp_lookahead_arena.get())
+  {
+    mp_lookahead_arena.reset(new lookahead_arena_t);
+  }
+  
+  return *mp_lookahead_arena;
 }
 
 namespace
@@ -446,56 +606,29 @@ namespace
       return false;
     }
     
-    std::list<lookahead_set_t const *> pool_a;
-    for (std::list<lookahead_set_t>::const_iterator iter =
+    // Every symbol occurs at most once in one level, so
+    // that two levels with the same size are equal iff each
+    // child of 'lookahead_set_a' has an equal counterpart in
+    // 'lookahead_set_b'.
+    for (lookahead_level_t::const_iterator iter =
            lookahead_set_a.m_next_level.begin();
          iter != lookahead_set_a.m_next_level.end();
          ++iter)
     {
-      pool_a.push_back(&(*iter));
-    }
-    std::list<lookahead_set_t const *> pool_b;
-    for (std::list<lookahead_set_t>::const_iterator iter =
-           lookahead_set_b.m_next_level.begin();
-         iter != lookahead_set_b.m_next_level.end();
-         ++iter)
-    {
-      pool_b.push_back(&(*iter));
-    }
-    
-    while (pool_a.size() != 0)
-    {
-      bool find_in_pool_b = false;
+      lookahead_set_t const * const lookahead_set_in_b =
+        lookahead_set_b.m_next_level.find((*iter).mp_node->symbol_id());
       
-      lookahead_set_t const * const lookahead_set_pool_a = pool_a.front();
-      for (std::list<lookahead_set_t const *>::iterator iter =
-             pool_b.begin();
-           iter != pool_b.end();
-           ++iter)
+      if (0 == lookahead_set_in_b)
       {
-        if (0 == lookahead_set_pool_a->mp_node->name().compare(
-              (*iter)->mp_node->name()))
-        {
-          find_in_pool_b = true;
-          
-          if (false == compare_lookahead_set_for_each_lookahead_set(
-                *lookahead_set_pool_a,
-                **iter))
-          {
-            return false;
-          }
-          else
-          {
-            pool_b.erase(iter);
-          }
-          break;
-        }
+        return false;
       }
-      if (false == find_in_pool_b)
+      
+      if (false == compare_lookahead_set_for_each_lookahead_set(
+            *iter,
+            *lookahead_set_in_b))
       {
         return false;
       }
-      pool_a.pop_front();
     }
     
     return true;
@@ -517,7 +650,7 @@ node_t::add_token_name_as_terminal_during_lookahead(std::wstring const &str)
   {
     throw ga_exception_t();
   }
-  m_token_name_as_terminal_during_lookahead.push_back(str);
+  mutable_cold_part().m_token_name_as_terminal_during_lookahead.push_back(str);
 }
 
 std::list<std::wstring> const &
@@ -527,7 +660,7 @@ node_t::token_name_as_terminal_during_lookahead() const
   {
     throw ga_exception_t();
   }
-  return m_token_name_as_terminal_during_lookahead;
+  return cold_part().m_token_name_as_terminal_during_lookahead;
 }
 
 unsigned int
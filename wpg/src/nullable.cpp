@@ -61,99 +61,142 @@
 /// 
 /// A -> a
 /// B -> A C | C
-bool
-analyser_environment_t::detect_nullable_nonterminal_for_one_alternative(
-  node_t * const node) const
+
+/// Find the nullable rules with a worklist.
+///
+/// Every alternative which contains no terminal keeps a
+/// counter of its nonterminal nodes which are not known to
+/// be nullable yet. When a rule becomes nullable, I walk
+/// its 'refer_to_me_nodes' and decrement the counter of
+/// the alternatives containing them. An alternative whose
+/// counter drops to 0 makes its rule nullable, which is
+/// then put into the worklist. Thus each nonterminal node
+/// is visited at most once. The alternative of a node is
+/// indexed by its 'overall_idx()'.
+///
+/// \param nullable The result, indexed by symbol ID.
+///
+void
+analyser_environment_t::find_nullable_rules(
+  std::vector<bool> &nullable) const
 {
-  if (node == node->rule_node()->rule_end_node())
-  {
-    // This is the direct definition of nullable productions.
-    return true;
-  }
-  else
+  nullable.assign(symbol_count(), false);
+  
+  std::vector<node_t *> worklist;
+  
+  // the alternative index of each nonterminal node in an
+  // alternative which contains no terminal, with the node
+  // itself, because a node in 'refer_to_me_nodes' may be
+  // out of the rules, and keep an old number.
+  std::vector<std::pair<node_t const *, size_t> > alternative_of_node(
+    mark_number_for_all_nodes(),
+    std::pair<node_t const *, size_t>(0, 0));
+  std::vector<size_t> remaining_count;
+  std::vector<node_t *> rule_of_alternative;
+  
+  BOOST_FOREACH(node_t * const rule_node, m_top_level_nodes)
   {
-    assert(node->alternative_start() == node);
-    
-    node_t *curr_node = node;
-    
-    // first to check if this production contains terminal symbols.
-    // If it is, then this production can not be a nullable production.
-    while (curr_node != node->rule_node()->rule_end_node())
+    BOOST_FOREACH(node_t * const alternative_start, rule_node->next_nodes())
     {
-      if (curr_node->is_terminal())
+      if (alternative_start == rule_node->rule_end_node())
       {
-        return false;
+        // This is the direct definition of nullable
+        // productions.
+        if (false == nullable[rule_node->symbol_id()])
+        {
+          nullable[rule_node->symbol_id()] = true;
+          worklist.push_back(rule_node);
+        }
+        
+        continue;
       }
-      assert(1 == curr_node->next_nodes().size());
-      curr_node = curr_node->next_nodes().front();
-    }
-    
-    // If reach here, this production contains all nonterminal symbols.
-    curr_node = node;
-    
-    while (curr_node != node->rule_node()->rule_end_node())
-    {
-      assert(curr_node->nonterminal_rule_node() != 0);
       
-      if (false == detect_nullable_nonterminal_for_one_rule(
-            curr_node->nonterminal_rule_node()))
+      // first to check if this production contains
+      // terminal symbols. If it is, then this production
+      // can not be a nullable production.
+      bool has_terminal = false;
+      
+      for (node_t *curr_node = alternative_start;
+           curr_node != rule_node->rule_end_node();
+           curr_node = curr_node->next_nodes().front())
       {
-        return false;
+        assert(1 == curr_node->next_nodes().size());
+        
+        if (true == curr_node->is_terminal())
+        {
+          has_terminal = true;
+          break;
+        }
       }
-      else
+      
+      if (true == has_terminal)
       {
-        curr_node->nonterminal_rule_node()->set_nullable(true);
+        continue;
       }
       
-      assert(1 == curr_node->next_nodes().size());
-      curr_node = curr_node->next_nodes().front();
+      size_t const alternative = remaining_count.size();
+      size_t count = 0;
+      
+      for (node_t *curr_node = alternative_start;
+           curr_node != rule_node->rule_end_node();
+           curr_node = curr_node->next_nodes().front())
+      {
+        assert(curr_node->nonterminal_rule_node() != 0);
+        
+        alternative_of_node[curr_node->overall_idx()] = std::make_pair(curr_node, alternative);
+        ++count;
+      }
+      
+      remaining_count.push_back(count);
+      rule_of_alternative.push_back(rule_node);
     }
-    
-    return true;
   }
-}
-
-bool
-analyser_environment_t::detect_nullable_nonterminal_for_one_rule(
-  node_t * const rule_node) const
-{
-  assert(true == rule_node->is_rule_head());
   
-  if (true == rule_node->is_nullable())
-  {
-    return true;
-  }
-  else
+  while (false == worklist.empty())
   {
-    if (false == rule_node->traversed())
+    node_t * const rule_node = worklist.back();
+    worklist.pop_back();
+    
+    assert(true == nullable[rule_node->symbol_id()]);
+    
+    BOOST_FOREACH(node_t * const node, rule_node->refer_to_me_nodes())
     {
-      rule_node->set_traversed(true);
+      if ((node->overall_idx() >= alternative_of_node.size()) ||
+          (alternative_of_node[node->overall_idx()].first != node))
+      {
+        // This node is in an alternative which contains
+        // terminal symbols.
+        continue;
+      }
+      
+      size_t const alternative = alternative_of_node[node->overall_idx()].second;
       
-      BOOST_FOREACH(node_t * const node, rule_node->next_nodes())
+      assert(remaining_count[alternative] > 0);
+      
+      if (0 == --remaining_count[alternative])
       {
-        if (true == detect_nullable_nonterminal_for_one_alternative(node))
+        node_t * const dependent = rule_of_alternative[alternative];
+        
+        if (false == nullable[dependent->symbol_id()])
         {
-          return true;
+          nullable[dependent->symbol_id()] = true;
+          worklist.push_back(dependent);
         }
       }
     }
-    return false;
   }
 }
 
 void
 analyser_environment_t::detect_nullable_nonterminal()
 {
+  std::vector<bool> nullable;
+  
+  find_nullable_rules(nullable);
+  
   BOOST_FOREACH(node_t * const node, m_top_level_nodes)
   {
-    (void)traverse_all_nodes(clear_node_state, 0, 0);
-    
-    if (true == node->is_nullable())
-    {
-      continue;
-    }
-    
-    if (true == detect_nullable_nonterminal_for_one_rule(node))
+    if (true == nullable[node->symbol_id()])
     {
       node->set_nullable(true);
     }
@@ -0,0 +1,845 @@
+#include "precompiled_header.hpp"
+
+// wpg - an LL(k) parser generator
+// Copyright (C) <2007>  Wei Hu <wei.hu.tw@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "scanner.hpp"
+#include "ae.hpp"
+#include "ga_exception.hpp"
+
+#include "wcl_memory_debugger\memory_debugger.h"
+
+namespace
+{
+  typedef std::bitset<256> char_set_t;
+  
+  size_t const NO_STATE = static_cast<size_t>(-1);
+  
+  /// A state of the NFA built from the patterns. It moves
+  /// to 'm_next' on the bytes in 'm_chars', and to each
+  /// state in 'm_epsilon' without reading anything.
+  struct nfa_state_t
+  {
+    char_set_t m_chars;
+    size_t m_next;
+    std::vector<size_t> m_epsilon;
+    
+    /// The index of the pattern this state accepts, or
+    /// scanner_dfa_t::NO_TOKEN.
+    int m_accept;
+    
+    nfa_state_t()
+      : m_next(NO_STATE),
+        m_accept(scanner_dfa_t::NO_TOKEN)
+    { }
+  };
+  typedef struct nfa_state_t nfa_state_t;
+  
+  struct nfa_fragment_t
+  {
+    size_t m_start;
+    size_t m_end;
+    
+    nfa_fragment_t(
+      size_t const start,
+      size_t const end)
+      : m_start(start),
+        m_end(end)
+    { }
+  };
+  typedef struct nfa_fragment_t nfa_fragment_t;
+  
+  /// Build the NFA of one pattern by Thompson's
+  /// construction. The pattern syntax is:
+  ///
+  /// a|b   alternation
+  /// ab    concatenation
+  /// a* a+ a?
+  /// (a)   grouping
+  /// [a-z] [^a-z]  character class
+  /// .     any byte except '\n'
+  /// \n \r \t \f \v \xHH  control and hexadecimal bytes
+  /// \s \d \w  white space, digit and word characters
+  /// \c    the character 'c' itself for any other 'c'
+  class pattern_parser_t
+  {
+  public:
+    
+    pattern_parser_t(
+      analyser_environment_t const * const ae,
+      token_pattern_t const &pattern,
+      std::vector<nfa_state_t> &states)
+      : mp_ae(ae),
+        m_pattern(pattern),
+        m_states(states),
+        m_pos(0)
+    { }
+    
+    nfa_fragment_t parse()
+    {
+      nfa_fragment_t const fragment = parse_alternation();
+      
+      if (m_pos != m_pattern.m_pattern.size())
+      {
+        fail(L"unbalanced ')'");
+      }
+      
+      return fragment;
+    }
+    
+  private:
+    
+    analyser_environment_t const * const mp_ae;
+    token_pattern_t const &m_pattern;
+    std::vector<nfa_state_t> &m_states;
+    std::wstring::size_type m_pos;
+    
+    pattern_parser_t &operator=(pattern_parser_t const &);
+    
+    void fail(
+      wchar_t const * const reason) const
+    {
+      mp_ae->log(L"<ERROR>: malformed pattern \"%s\" of the terminal \"%s\": %s.\n",
+                 m_pattern.m_pattern.c_str(),
+                 m_pattern.m_terminal_name.c_str(),
+                 reason);
+      throw ga_exception_t();
+    }
+    
+    bool at_end() const
+    { return m_pos == m_pattern.m_pattern.size(); }
+    
+    wchar_t peek() const
+    { return m_pattern.m_pattern[m_pos]; }
+    
+    size_t new_state()
+    {
+      m_states.push_back(nfa_state_t());
+      
+      return m_states.size() - 1;
+    }
+    
+    void add_epsilon(
+      size_t const from,
+      size_t const to)
+    {
+      m_states[from].m_epsilon.push_back(to);
+    }
+    
+    nfa_fragment_t parse_alternation()
+    {
+      nfa_fragment_t fragment = parse_concatenation();
+      
+      if ((false == at_end()) && (L'|' == peek()))
+      {
+        nfa_fragment_t const alternation(new_state(), new_state());
+        
+        add_epsilon(alternation.m_start, fragment.m_start);
+        add_epsilon(fragment.m_end, alternation.m_end);
+        
+        while ((false == at_end()) && (L'|' == peek()))
+        {
+          ++m_pos;
+          
+          fragment = parse_concatenation();
+          
+          add_epsilon(alternation.m_start, fragment.m_start);
+          add_epsilon(fragment.m_end, alternation.m_end);
+        }
+        
+        return alternation;
+      }
+      
+      return fragment;
+    }
+    
+    nfa_fragment_t parse_concatenation()
+    {
+      size_t const start = new_state();
+      nfa_fragment_t concatenation(start, start);
+      
+      while ((false == at_end()) &&
+             (peek() != L'|') &&
+             (peek() != L')'))
+      {
+        nfa_fragment_t const fragment = parse_repetition();
+        
+        add_epsilon(concatenation.m_end, fragment.m_start);
+        concatenation.m_end = fragment.m_end;
+      }
+      
+      return concatenation;
+    }
+    
+    nfa_fragment_t parse_repetition()
+    {
+      nfa_fragment_t fragment = parse_atom();
+      
+      while ((false == at_end()) &&
+             ((L'*' == peek()) || (L'+' == peek()) || (L'?' == peek())))
+      {
+        nfa_fragment_t const repetition(new_state(), new_state());
+        
+        add_epsilon(repetition.m_start, fragment.m_start);
+        add_epsilon(fragment.m_end, repetition.m_end);
+        
+        switch (peek())
+        {
+        case L'*':
+          add_epsilon(repetition.m_start, repetition.m_end);
+          add_epsilon(fragment.m_end, fragment.m_start);
+          break;
+          
+        case L'+':
+          add_epsilon(fragment.m_end, fragment.m_start);
+          break;
+          
+        case L'?':
+          add_epsilon(repetition.m_start, repetition.m_end);
+          break;
+          
+        default:
+          assert(0);
+          break;
+        }
+        
+        ++m_pos;
+        fragment = repetition;
+      }
+      
+      return fragment;
+    }
+    
+    nfa_fragment_t parse_atom()
+    {
+      char_set_t chars;
+      
+      switch (peek())
+      {
+      case L'(':
+        {
+          ++m_pos;
+          
+          nfa_fragment_t const fragment = parse_alternation();
+          
+          if (true == at_end())
+          {
+            fail(L"missing ')'");
+          }
+          
+          assert(L')' == peek());
+          ++m_pos;
+          
+          return fragment;
+        }
+        
+      case L'*':
+      case L'+':
+      case L'?':
+        fail(L"nothing to repeat");
+        break;
+        
+      case L'[':
+        ++m_pos;
+        parse_char_class(chars);
+        break;
+        
+      case L'.':
+        ++m_pos;
+        chars.set();
+        chars.reset('\n');
+        break;
+        
+      case L'\\':
+        ++m_pos;
+        parse_escape(chars);
+        break;
+        
+      default:
+        chars.set(to_byte(peek()));
+        ++m_pos;
+        break;
+      }
+      
+      nfa_fragment_t const fragment(new_state(), new_state());
+      
+      m_states[fragment.m_start].m_chars = chars;
+      m_states[fragment.m_start].m_next = fragment.m_end;
+      
+      return fragment;
+    }
+    
+    void parse_char_class(
+      char_set_t &chars)
+    {
+      bool negate = false;
+      
+      if ((false == at_end()) && (L'^' == peek()))
+      {
+        negate = true;
+        ++m_pos;
+      }
+      
+      for (;;)
+      {
+        if (true == at_end())
+        {
+          fail(L"missing ']'");
+        }
+        
+        if (L']' == peek())
+        {
+          ++m_pos;
+          break;
+        }
+        
+        char_set_t item;
+        bool const is_single_char = parse_class_item(item);
+        
+        if ((true == is_single_char) &&
+            ((m_pos + 1) < m_pattern.m_pattern.size()) &&
+            (L'-' == peek()) &&
+            (m_pattern.m_pattern[m_pos + 1] != L']'))
+        {
+          ++m_pos;
+          
+          char_set_t last;
+          
+          if (false == parse_class_item(last))
+          {
+            fail(L"a range can not end with a character class");
+          }
+          
+          size_t first_char = 0;
+          size_t last_char = 0;
+          
+          while (false == item.test(first_char)) { ++first_char; }
+          while (false == last.test(last_char)) { ++last_char; }
+          
+          if (first_char > last_char)
+          {
+            fail(L"the range is out of order");
+          }
+          
+          for (size_t c = first_char; c <= last_char; ++c)
+          {
+            chars.set(c);
+          }
+        }
+        else
+        {
+          chars |= item;
+        }
+      }
+      
+      if (true == negate)
+      {
+        chars.flip();
+      }
+    }
+    
+    /// Return true if 'chars' is a single character, which
+    /// can start or end a range.
+    bool parse_class_item(
+      char_set_t &chars)
+    {
+      if (L'\\' == peek())
+      {
+        ++m_pos;
+        
+        return parse_escape(chars);
+      }
+      else
+      {
+        chars.set(to_byte(peek()));
+        ++m_pos;
+        
+        return true;
+      }
+    }
+    
+    /// Return true if the escape sequence is a single
+    /// character.
+    bool parse_escape(
+      char_set_t &chars)
+    {
+      if (true == at_end())
+      {
+        fail(L"the pattern ends with '\\'");
+      }
+      
+      wchar_t const c = peek();
+      ++m_pos;
+      
+      switch (c)
+      {
+      case L'n': chars.set('\n'); return true;
+      case L'r': chars.set('\r'); return true;
+      case L't': chars.set('\t'); return true;
+      case L'f': chars.set('\f'); return true;
+      case L'v': chars.set('\v'); return true;
+        
+      case L's':
+        chars.set(' ');
+        chars.set('\t');
+        chars.set('\n');
+        chars.set('\r');
+        chars.set('\f');
+        chars.set('\v');
+        return false;
+        
+      case L'd':
+        for (size_t i = '0'; i <= '9'; ++i) { chars.set(i); }
+        return false;
+        
+      case L'w':
+        for (size_t i = '0'; i <= '9'; ++i) { chars.set(i); }
+        for (size_t i = 'a'; i <= 'z'; ++i) { chars.set(i); }
+        for (size_t i = 'A'; i <= 'Z'; ++i) { chars.set(i); }
+        chars.set('_');
+        return false;
+        
+      case L'x':
+        {
+          size_t value = 0;
+          
+          for (int i = 0; i < 2; ++i)
+          {
+            if ((true == at_end()) || (0 == iswxdigit(peek())))
+            {
+              fail(L"'\\x' needs 2 hexadecimal digits");
+            }
+            
+            wchar_t const digit = towlower(peek());
+            
+            value = (value * 16) + (iswdigit(digit) ? (digit - L'0') : (digit - L'a' + 10));
+            ++m_pos;
+          }
+          
+          chars.set(value);
+          return true;
+        }
+        
+      default:
+        chars.set(to_byte(c));
+        return true;
+      }
+    }
+    
+    size_t to_byte(
+      wchar_t const c) const
+    {
+      if (static_cast<unsigned int>(c) > 0xFF)
+      {
+        fail(L"only 8-bit characters are supported, use '\\xHH' for bytes");
+      }
+      
+      return static_cast<size_t>(c);
+    }
+  };
+  typedef class pattern_parser_t pattern_parser_t;
+  
+  void
+  epsilon_closure(
+    std::vector<nfa_state_t> const &nfa,
+    std::vector<size_t> &states)
+  {
+    std::vector<bool> in_closure(nfa.size(), false);
+    std::vector<size_t> stack(states);
+    
+    BOOST_FOREACH(size_t const state, states)
+    {
+      in_closure[state] = true;
+    }
+    
+    while (false == stack.empty())
+    {
+      size_t const state = stack.back();
+      stack.pop_back();
+      
+      BOOST_FOREACH(size_t const next, nfa[state].m_epsilon)
+      {
+        if (false == in_closure[next])
+        {
+          in_closure[next] = true;
+          states.push_back(next);
+          stack.push_back(next);
+        }
+      }
+    }
+    
+    std::sort(states.begin(), states.end());
+  }
+  
+  /// Group the bytes which no state of the NFA tells apart.
+  size_t
+  split_char_classes(
+    std::vector<nfa_state_t> const &nfa,
+    size_t char_class[256])
+  {
+    size_t class_count = 1;
+    
+    std::fill(char_class, char_class + 256, 0);
+    
+    BOOST_FOREACH(nfa_state_t const &state, nfa)
+    {
+      if (state.m_chars.none())
+      {
+        continue;
+      }
+      
+      // (old class, in 'm_chars') -> new class
+      std::map<std::pair<size_t, bool>, size_t> new_class;
+      
+      for (size_t c = 0; c < 256; ++c)
+      {
+        std::pair<size_t, bool> const key(char_class[c], state.m_chars.test(c));
+        std::map<std::pair<size_t, bool>, size_t>::const_iterator const iter =
+          new_class.find(key);
+        
+        if (iter == new_class.end())
+        {
+          size_t const id = new_class.size();
+          
+          new_class[key] = id;
+          char_class[c] = id;
+        }
+        else
+        {
+          char_class[c] = iter->second;
+        }
+      }
+      
+      class_count = new_class.size();
+    }
+    
+    return class_count;
+  }
+}
+
+scanner_dfa_t::scanner_dfa_t(
+  analyser_environment_t const * const ae,
+  std::list<token_pattern_t> const &patterns)
+{
+  assert(ae != 0);
+  
+  // ====================================================
+  //            patterns -> NFA (Thompson)
+  // ====================================================
+  std::vector<nfa_state_t> nfa;
+  
+  nfa.push_back(nfa_state_t());
+  size_t const nfa_start = 0;
+  
+  {
+    int pattern_idx = 0;
+    
+    BOOST_FOREACH(token_pattern_t const &pattern, patterns)
+    {
+      if (false == pattern.m_pattern.empty())
+      {
+        pattern_parser_t parser(ae, pattern, nfa);
+        nfa_fragment_t const fragment = parser.parse();
+        
+        nfa[nfa_start].m_epsilon.push_back(fragment.m_start);
+        nfa[fragment.m_end].m_accept = pattern_idx;
+      }
+      
+      ++pattern_idx;
+    }
+  }
+  
+  // ====================================================
+  //            NFA -> DFA (subset construction)
+  // ====================================================
+  size_t nfa_char_class[256];
+  size_t const nfa_char_class_count = split_char_classes(nfa, nfa_char_class);
+  
+  // A representative byte of each character class.
+  std::vector<size_t> class_char(nfa_char_class_count);
+  
+  for (size_t c = 256; c > 0; --c)
+  {
+    class_char[nfa_char_class[c - 1]] = c - 1;
+  }
+  
+  std::vector<std::vector<size_t> > dfa_states;
+  std::map<std::vector<size_t>, size_t> dfa_state_of;
+  std::vector<size_t> dfa_transition;
+  
+  // The dead state is the empty set.
+  dfa_states.push_back(std::vector<size_t>());
+  dfa_state_of[dfa_states.back()] = DEAD_STATE;
+  
+  {
+    std::vector<size_t> start(1, nfa_start);
+    
+    epsilon_closure(nfa, start);
+    dfa_states.push_back(start);
+    dfa_state_of[start] = START_STATE;
+  }
+  
+  for (size_t state = 0; state < dfa_states.size(); ++state)
+  {
+    for (size_t char_class = 0; char_class < nfa_char_class_count; ++char_class)
+    {
+      std::vector<size_t> next_states;
+      
+      BOOST_FOREACH(size_t const nfa_state, dfa_states[state])
+      {
+        if (true == nfa[nfa_state].m_chars.test(class_char[char_class]))
+        {
+          next_states.push_back(nfa[nfa_state].m_next);
+        }
+      }
+      
+      epsilon_closure(nfa, next_states);
+      
+      std::map<std::vector<size_t>, size_t>::const_iterator const iter =
+        dfa_state_of.find(next_states);
+      
+      if (iter == dfa_state_of.end())
+      {
+        dfa_state_of[next_states] = dfa_states.size();
+        dfa_transition.push_back(dfa_states.size());
+        dfa_states.push_back(next_states);
+      }
+      else
+      {
+        dfa_transition.push_back(iter->second);
+      }
+    }
+  }
+  
+  std::vector<int> dfa_accept(dfa_states.size(), NO_TOKEN);
+  
+  for (size_t state = 0; state < dfa_states.size(); ++state)
+  {
+    BOOST_FOREACH(size_t const nfa_state, dfa_states[state])
+    {
+      if ((nfa[nfa_state].m_accept != NO_TOKEN) &&
+          ((NO_TOKEN == dfa_accept[state]) ||
+           (nfa[nfa_state].m_accept < dfa_accept[state])))
+      {
+        dfa_accept[state] = nfa[nfa_state].m_accept;
+      }
+    }
+  }
+  
+  if (dfa_accept[START_STATE] != NO_TOKEN)
+  {
+    std::list<token_pattern_t>::const_iterator iter = patterns.begin();
+    
+    std::advance(iter, dfa_accept[START_STATE]);
+    
+    ae->log(L"<ERROR>: the pattern \"%s\" of the terminal \"%s\" matches the empty string.\n",
+            (*iter).m_pattern.c_str(),
+            (*iter).m_terminal_name.c_str());
+    throw ga_exception_t();
+  }
+  
+  // ====================================================
+  //        minimize the DFA (partition refinement)
+  // ====================================================
+  
+  // Start from the partition by the accepted pattern, and
+  // split each block by the blocks its states move to,
+  // until no block splits any more.
+  std::vector<size_t> block(dfa_states.size());
+  size_t block_count = 0;
+  
+  {
+    std::map<int, size_t> block_of_accept;
+    
+    for (size_t state = 0; state < dfa_states.size(); ++state)
+    {
+      std::map<int, size_t>::const_iterator const iter =
+        block_of_accept.find(dfa_accept[state]);
+      
+      if (iter == block_of_accept.end())
+      {
+        block[state] = block_of_accept.size();
+        block_of_accept[dfa_accept[state]] = block[state];
+      }
+      else
+      {
+        block[state] = iter->second;
+      }
+    }
+    
+    block_count = block_of_accept.size();
+  }
+  
+  for (;;)
+  {
+    std::map<std::vector<size_t>, size_t> block_of_signature;
+    std::vector<size_t> new_block(dfa_states.size());
+    
+    for (size_t state = 0; state < dfa_states.size(); ++state)
+    {
+      std::vector<size_t> signature;
+      
+      signature.reserve(nfa_char_class_count + 1);
+      signature.push_back(block[state]);
+      
+      for (size_t char_class = 0; char_class < nfa_char_class_count; ++char_class)
+      {
+        signature.push_back(
+          block[dfa_transition[(state * nfa_char_class_count) + char_class]]);
+      }
+      
+      std::map<std::vector<size_t>, size_t>::const_iterator const iter =
+        block_of_signature.find(signature);
+      
+      if (iter == block_of_signature.end())
+      {
+        new_block[state] = block_of_signature.size();
+        block_of_signature[signature] = new_block[state];
+      }
+      else
+      {
+        new_block[state] = iter->second;
+      }
+    }
+    
+    block.swap(new_block);
+    
+    if (block_of_signature.size() == block_count)
+    {
+      break;
+    }
+    
+    block_count = block_of_signature.size();
+  }
+  
+  if (block[DEAD_STATE] == block[START_STATE])
+  {
+    ae->log(L"<ERROR>: no token pattern matches any input.\n");
+    throw ga_exception_t();
+  }
+  
+  // Number the blocks, so that the dead state and the start
+  // state keep their numbers.
+  std::vector<size_t> new_state_of_block(block_count, NO_STATE);
+  std::vector<size_t> state_of_new_state;
+  
+  new_state_of_block[block[DEAD_STATE]] = DEAD_STATE;
+  state_of_new_state.push_back(DEAD_STATE);
+  new_state_of_block[block[START_STATE]] = START_STATE;
+  state_of_new_state.push_back(START_STATE);
+  
+  for (size_t state = 0; state < dfa_states.size(); ++state)
+  {
+    if (NO_STATE == new_state_of_block[block[state]])
+    {
+      new_state_of_block[block[state]] = state_of_new_state.size();
+      state_of_new_state.push_back(state);
+    }
+  }
+  
+  // ====================================================
+  //   merge the character classes the minimized DFA does
+  //                    not tell apart
+  // ====================================================
+  std::vector<size_t> new_char_class(nfa_char_class_count);
+  std::vector<size_t> char_class_of_new_char_class;
+  
+  {
+    std::map<std::vector<size_t>, size_t> char_class_of_column;
+    
+    for (size_t char_class = 0; char_class < nfa_char_class_count; ++char_class)
+    {
+      std::vector<size_t> column;
+      
+      BOOST_FOREACH(size_t const state, state_of_new_state)
+      {
+        column.push_back(block[dfa_transition[(state * nfa_char_class_count) + char_class]]);
+      }
+      
+      std::map<std::vector<size_t>, size_t>::const_iterator const iter =
+        char_class_of_column.find(column);
+      
+      if (iter == char_class_of_column.end())
+      {
+        new_char_class[char_class] = char_class_of_new_char_class.size();
+        char_class_of_column[column] = new_char_class[char_class];
+        char_class_of_new_char_class.push_back(char_class);
+      }
+      else
+      {
+        new_char_class[char_class] = iter->second;
+      }
+    }
+  }
+  
+  m_char_class_count = char_class_of_new_char_class.size();
+  
+  for (size_t c = 0; c < 256; ++c)
+  {
+    m_char_class[c] = new_char_class[nfa_char_class[c]];
+  }
+  
+  BOOST_FOREACH(size_t const state, state_of_new_state)
+  {
+    m_accept.push_back(dfa_accept[state]);
+    
+    BOOST_FOREACH(size_t const char_class, char_class_of_new_char_class)
+    {
+      m_transition.push_back(
+        new_state_of_block[block[dfa_transition[(state * nfa_char_class_count) + char_class]]]);
+    }
+  }
+  
+  assert(DEAD_STATE == transition(DEAD_STATE, char_class('a')));
+}
+
+void
+analyser_environment_t::build_scanner()
+{
+  bool has_pattern = false;
+  
+  BOOST_FOREACH(token_pattern_t const &pattern, m_token_patterns)
+  {
+    if (false == pattern.m_pattern.empty())
+    {
+      has_pattern = true;
+      break;
+    }
+  }
+  
+  if (false == has_pattern)
+  {
+    // The user will write the scanner.
+    return;
+  }
+  
+  BOOST_FOREACH(token_pattern_t const &pattern, m_token_patterns)
+  {
+    if (true == pattern.m_pattern.empty())
+    {
+      log(L"<WARNING>: the terminal \"%s\" has no pattern, the generated scanner will never return it.\n",
+          pattern.m_terminal_name.c_str());
+    }
+  }
+  
+  mp_scanner_dfa.reset(new scanner_dfa_t(this, m_token_patterns));
+  
+  log(L"<INFO>: scanner DFA: %u states, %u character classes.\n",
+      static_cast<unsigned int>(mp_scanner_dfa->state_count()),
+      static_cast<unsigned int>(mp_scanner_dfa->char_class_count()));
+}
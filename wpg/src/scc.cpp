@@ -0,0 +1,233 @@
+#include "precompiled_header.hpp"
+
+// wpg - an LL(k) parser generator
+// Copyright (C) <2007>  Wei Hu <wei.hu.tw@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "scc.hpp"
+#include "node.hpp"
+
+#include "wcl_memory_debugger\memory_debugger.h"
+
+namespace
+{
+  size_t const NO_VERTEX = static_cast<size_t>(-1);
+  
+  /// One frame of the explicit DFS stack used by Tarjan's
+  /// algorithm, so that a long chain of rules can not
+  /// overflow the native stack.
+  struct tarjan_frame_t
+  {
+    size_t m_vertex;
+    size_t m_next_edge;
+    
+    explicit tarjan_frame_t(
+      size_t const vertex)
+      : m_vertex(vertex),
+        m_next_edge(0)
+    { }
+  };
+  typedef struct tarjan_frame_t tarjan_frame_t;
+}
+
+rule_graph_t::rule_graph_t(
+  std::list<node_t *> const &rule_nodes)
+  : m_rule_nodes(rule_nodes.begin(), rule_nodes.end()),
+    m_edges(rule_nodes.size()),
+    m_self_loop(rule_nodes.size(), false)
+{
+  symbol_id_t max_id = 0;
+  
+  BOOST_FOREACH(node_t * const rule_node, m_rule_nodes)
+  {
+    assert(true == rule_node->is_rule_head());
+    
+    max_id = std::max(max_id, rule_node->symbol_id());
+  }
+  
+  m_vertex_of_symbol.resize(max_id + 1, NO_VERTEX);
+  
+  for (size_t i = 0; i < m_rule_nodes.size(); ++i)
+  {
+    m_vertex_of_symbol[m_rule_nodes[i]->symbol_id()] = i;
+  }
+}
+
+size_t
+rule_graph_t::vertex_of(
+  node_t * const rule_node) const
+{
+  assert(true == rule_node->is_rule_head());
+  assert(rule_node->symbol_id() < m_vertex_of_symbol.size());
+  
+  size_t const vertex = m_vertex_of_symbol[rule_node->symbol_id()];
+  
+  assert(vertex != NO_VERTEX);
+  assert(m_rule_nodes[vertex] == rule_node);
+  
+  return vertex;
+}
+
+void
+rule_graph_t::add_edge(
+  node_t * const from,
+  node_t * const to)
+{
+  size_t const from_vertex = vertex_of(from);
+  size_t const to_vertex = vertex_of(to);
+  
+  if (from_vertex == to_vertex)
+  {
+    m_self_loop[from_vertex] = true;
+  }
+  else
+  {
+    m_edges[from_vertex].push_back(to_vertex);
+  }
+}
+
+void
+rule_graph_t::find_recursive_components(
+  std::list<std::list<node_t *> > &components) const
+{
+  size_t const vertex_count = m_rule_nodes.size();
+  
+  std::vector<size_t> index(vertex_count, NO_VERTEX);
+  std::vector<size_t> lowlink(vertex_count, 0);
+  std::vector<bool> on_stack(vertex_count, false);
+  
+  // component ID of each vertex, NO_VERTEX if it does not
+  // belong to a recursive component.
+  std::vector<size_t> component_of(vertex_count, NO_VERTEX);
+  size_t component_count = 0;
+  
+  std::vector<size_t> scc_stack;
+  std::vector<tarjan_frame_t> dfs_stack;
+  size_t next_index = 0;
+  
+  for (size_t root = 0; root < vertex_count; ++root)
+  {
+    if (index[root] != NO_VERTEX)
+    {
+      continue;
+    }
+    
+    dfs_stack.push_back(tarjan_frame_t(root));
+    
+    while (false == dfs_stack.empty())
+    {
+      tarjan_frame_t &frame = dfs_stack.back();
+      size_t const v = frame.m_vertex;
+      
+      if (0 == frame.m_next_edge)
+      {
+        if (NO_VERTEX == index[v])
+        {
+          index[v] = next_index;
+          lowlink[v] = next_index;
+          ++next_index;
+          
+          scc_stack.push_back(v);
+          on_stack[v] = true;
+        }
+      }
+      
+      if (frame.m_next_edge < m_edges[v].size())
+      {
+        size_t const w = m_edges[v][frame.m_next_edge];
+        
+        ++frame.m_next_edge;
+        
+        if (NO_VERTEX == index[w])
+        {
+          // 'frame' is invalidated by this push_back.
+          dfs_stack.push_back(tarjan_frame_t(w));
+        }
+        else if (true == on_stack[w])
+        {
+          lowlink[v] = std::min(lowlink[v], index[w]);
+        }
+        
+        continue;
+      }
+      
+      // All the edges of 'v' are visited.
+      if (lowlink[v] == index[v])
+      {
+        // 'v' is the deepest vertex of its component on the
+        // stack, search it from the top.
+        std::vector<size_t>::iterator first = scc_stack.end();
+        
+        do
+        {
+          --first;
+        } while ((*first) != v);
+        
+        bool const recursive =
+          ((scc_stack.end() - first) > 1) || (true == m_self_loop[v]);
+        
+        for (std::vector<size_t>::iterator iter = first;
+             iter != scc_stack.end();
+             ++iter)
+        {
+          on_stack[*iter] = false;
+          
+          if (true == recursive)
+          {
+            component_of[*iter] = component_count;
+          }
+        }
+        
+        if (true == recursive)
+        {
+          ++component_count;
+        }
+        
+        scc_stack.erase(first, scc_stack.end());
+      }
+      
+      dfs_stack.pop_back();
+      
+      if (false == dfs_stack.empty())
+      {
+        size_t const parent = dfs_stack.back().m_vertex;
+        
+        lowlink[parent] = std::min(lowlink[parent], lowlink[v]);
+      }
+    }
+  }
+  
+  // Emit the components ordered by their first rule, and
+  // each component in the rule order.
+  std::vector<std::list<node_t *> *> emitted(component_count, 0);
+  
+  for (size_t v = 0; v < vertex_count; ++v)
+  {
+    size_t const component = component_of[v];
+    
+    if (component != NO_VERTEX)
+    {
+      if (0 == emitted[component])
+      {
+        components.push_back(std::list<node_t *>());
+        emitted[component] = &(components.back());
+      }
+      
+      emitted[component]->push_back(m_rule_nodes[v]);
+    }
+  }
+}
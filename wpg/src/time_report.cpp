@@ -0,0 +1,247 @@
+#include "precompiled_header.hpp"
+
+// wpg - an LL(k) parser generator
+// Copyright (C) <2007>  Wei Hu <wei.hu.tw@gmail.com>
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "time_report.hpp"
+#include "ae.hpp"
+#include "node.hpp"
+
+#include "wcl_memory_debugger\memory_debugger.h"
+
+namespace
+{
+  bool
+  count_one_node(
+    analyser_environment_t const * const /* ae */,
+    node_t * const /* node */,
+    void * const param)
+  {
+    ++(*reinterpret_cast<size_t *>(param));
+    
+    return true;
+  }
+  
+  double
+  to_ms(
+    boost::posix_time::time_duration const &duration)
+  {
+    return static_cast<double>(duration.total_microseconds()) / 1000.0;
+  }
+}
+
+time_report_t::time_report_t(
+  analyser_environment_t const * const ae,
+  bool const enabled)
+  : mp_ae(ae),
+    m_enabled(enabled)
+{
+  assert(ae != 0);
+}
+
+void
+time_report_t::take_sample(sample_t &sample)
+{
+  sample.m_wall_time = boost::posix_time::microsec_clock::universal_time();
+  
+  FILETIME creation_time;
+  FILETIME exit_time;
+  FILETIME kernel_time;
+  FILETIME user_time;
+  
+  sample.m_cpu_time = 0;
+  
+  if (GetProcessTimes(GetCurrentProcess(),
+                      &creation_time,
+                      &exit_time,
+                      &kernel_time,
+                      &user_time) != 0)
+  {
+    sample.m_cpu_time =
+      ((static_cast<boost::uint64_t>(kernel_time.dwHighDateTime) << 32) | kernel_time.dwLowDateTime) +
+      ((static_cast<boost::uint64_t>(user_time.dwHighDateTime) << 32) | user_time.dwLowDateTime);
+  }
+  
+  PROCESS_MEMORY_COUNTERS memory_counters;
+  
+  sample.m_peak_working_set = 0;
+  
+  if (GetProcessMemoryInfo(GetCurrentProcess(),
+                           &memory_counters,
+                           sizeof(memory_counters)) != 0)
+  {
+    sample.m_peak_working_set = memory_counters.PeakWorkingSetSize;
+  }
+}
+
+void
+time_report_t::start_phase(wchar_t const * const name)
+{
+  if (false == m_enabled)
+  {
+    return;
+  }
+  
+  assert(name != 0);
+  assert(name[0] != 0);
+  
+  stop();
+  
+  m_curr_phase_name = name;
+  take_sample(m_curr_phase_start);
+}
+
+void
+time_report_t::stop()
+{
+  if ((false == m_enabled) ||
+      (true == m_curr_phase_name.empty()))
+  {
+    return;
+  }
+  
+  sample_t end;
+  take_sample(end);
+  
+  phase_t phase;
+  
+  phase.m_name = m_curr_phase_name;
+  phase.m_wall_ms = to_ms(end.m_wall_time - m_curr_phase_start.m_wall_time);
+  phase.m_cpu_ms = static_cast<double>(end.m_cpu_time - m_curr_phase_start.m_cpu_time) / 10000.0;
+  phase.m_peak_working_set_delta = end.m_peak_working_set - m_curr_phase_start.m_peak_working_set;
+  phase.m_peak_working_set = end.m_peak_working_set;
+  
+  // The sampling above is done before counting, so that
+  // the counting is not charged to this phase.
+  phase.m_node_count = 0;
+  mp_ae->traverse_all_nodes(count_one_node, 0, &(phase.m_node_count));
+  
+  phase.m_alternative_count = 0;
+  BOOST_FOREACH(node_t const * const rule_node, mp_ae->top_level_nodes())
+  {
+    phase.m_alternative_count += rule_node->next_nodes().size();
+  }
+  
+  m_phases.push_back(phase);
+  m_curr_phase_name.clear();
+}
+
+void
+time_report_t::log() const
+{
+  if (false == m_enabled)
+  {
+    return;
+  }
+  
+  // fmtstr does not know about field widths, thus I lay
+  // out the table by a stream, and log it line by line.
+  std::wostringstream line;
+  
+  line << std::fixed << std::setprecision(3);
+  
+  line << std::left << std::setw(32) << L"phase" << std::right
+       << std::setw(12) << L"wall (ms)"
+       << std::setw(12) << L"cpu (ms)"
+       << std::setw(16) << L"peak RSS +(KB)"
+       << std::setw(10) << L"nodes"
+       << std::setw(14) << L"alternatives";
+  
+  mp_ae->log(L"<INFO>: time report:\n");
+  mp_ae->log(L"%s\n", line.str().c_str());
+  
+  double total_wall_ms = 0;
+  double total_cpu_ms = 0;
+  
+  BOOST_FOREACH(phase_t const &phase, m_phases)
+  {
+    line.str(std::wstring());
+    line << std::left << std::setw(32) << phase.m_name << std::right
+         << std::setw(12) << phase.m_wall_ms
+         << std::setw(12) << phase.m_cpu_ms
+         << std::setw(16) << (phase.m_peak_working_set_delta / 1024)
+         << std::setw(10) << phase.m_node_count
+         << std::setw(14) << phase.m_alternative_count;
+    
+    mp_ae->log(L"%s\n", line.str().c_str());
+    
+    total_wall_ms += phase.m_wall_ms;
+    total_cpu_ms += phase.m_cpu_ms;
+  }
+  
+  line.str(std::wstring());
+  line << std::left << std::setw(32) << L"total" << std::right
+       << std::setw(12) << total_wall_ms
+       << std::setw(12) << total_cpu_ms
+       << std::setw(16) << ((true == m_phases.empty()) ? 0 : (m_phases.back().m_peak_working_set / 1024));
+  
+  mp_ae->log(L"%s\n", line.str().c_str());
+}
+
+/// The phase names are plain identifiers, so that they do
+/// not need to be escaped.
+bool
+time_report_t::dump_json(std::wstring const &filename) const
+{
+  if (false == m_enabled)
+  {
+    return true;
+  }
+  
+  std::wfstream file(filename.c_str(),
+                     std::ios_base::out | std::ios_base::binary);
+  
+  if (false == file.is_open())
+  {
+    return false;
+  }
+  
+  file << L"{" << std::endl;
+  file << L"  \"phases\": [" << std::endl;
+  
+  for (std::list<phase_t>::const_iterator iter = m_phases.begin();
+       iter != m_phases.end();
+       ++iter)
+  {
+    file << L"    {"
+         << L"\"name\": \"" << (*iter).m_name << L"\", "
+         << L"\"wall_ms\": " << (*iter).m_wall_ms << L", "
+         << L"\"cpu_ms\": " << (*iter).m_cpu_ms << L", "
+         << L"\"peak_rss_delta_bytes\": " << (*iter).m_peak_working_set_delta << L", "
+         << L"\"peak_rss_bytes\": " << (*iter).m_peak_working_set << L", "
+         << L"\"nodes\": " << (*iter).m_node_count << L", "
+         << L"\"alternatives\": " << (*iter).m_alternative_count
+         << L"}";
+    
+    std::list<phase_t>::const_iterator next = iter;
+    ++next;
+    
+    if (next != m_phases.end())
+    {
+      file << L",";
+    }
+    
+    file << std::endl;
+  }
+  
+  file << L"  ]" << std::endl;
+  file << L"}" << std::endl;
+  
+  file.close();
+  
+  return true;
+}